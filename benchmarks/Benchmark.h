@@ -0,0 +1,184 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file Benchmark.h
+ *
+ * A small timing and reporting helper shared by the benchmark programs.
+ * Each program times a series of named cases with a Benchmark object,
+ * which prints a line per case as it goes and, when the program is
+ * given a --json option, also writes every result to a JSON file so
+ * that runs can be compared across releases (see compare.py).
+ *
+ * The command line understood by every benchmark program is
+ *
+ *     program [repetitions] [--json FILE]
+ *
+ * and the JSON written has the form
+ *
+ *     { "program": "parsePaf", "repetitions": 200,
+ *       "results": [ { "name": "examples.buffer", "iterations": 200,
+ *                      "seconds": 0.52, "seconds_per_iteration": 0.0026,
+ *                      "items": 123400, "items_per_second": 237307.7,
+ *                      "bytes_per_second": 91233412.2 }, ... ] }
+ *
+ * where bytes_per_second is only given for cases that process a known
+ * amount of data.
+ */
+#ifndef LSST_PEX_POLICY_BENCHMARKS_BENCHMARK_H
+#define LSST_PEX_POLICY_BENCHMARKS_BENCHMARK_H
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+class Benchmark {
+public:
+    /**
+     * read the command line of a benchmark program
+     * @param program   the name of the program, for the JSON results
+     * @param argc      the argument count given to main()
+     * @param argv      the arguments given to main()
+     * @param reps      the default number of repetitions
+     */
+    Benchmark(const std::string& program, int argc, char** argv, int reps)
+        : _program(program), _reps(reps), _json(), _section(), _results() {
+        for (int i = 1; i < argc; ++i) {
+            if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+                _json = argv[++i];
+            else if (std::strncmp(argv[i], "--json=", 7) == 0)
+                _json = argv[i] + 7;
+            else
+                _reps = std::atoi(argv[i]);
+        }
+        if (_reps < 1) _reps = 1;
+    }
+
+    /**
+     * return the number of repetitions asked for
+     */
+    int getReps() const { return _reps; }
+
+    /**
+     * start a group of cases.  The results of the cases that follow are
+     * named "<name>.<case>".
+     * @param name    an identifier for the group
+     * @param about   a description to print, or "" to print the name
+     */
+    void section(const std::string& name, const std::string& about = "") {
+        _section = name;
+        std::cout << (about.empty() ? name : about) << std::endl;
+    }
+
+    /**
+     * time reps calls to run(), which returns the number of items (e.g.
+     * values loaded) it processed, and record the result
+     * @param name    the name of the case
+     * @param reps    the number of calls to time
+     * @param bytes   the bytes of data processed by each call, or 0
+     * @param run     the function to time
+     * @return the mean time per call in seconds
+     */
+    template <typename Run>
+    double time(const std::string& name, int reps, double bytes, Run run) {
+        long items = 0;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (int i = 0; i < reps; ++i) items += run();
+        std::chrono::duration<double> secs = std::chrono::steady_clock::now() - start;
+        record(name, reps, secs.count(), bytes * reps, items);
+        return secs.count() / reps;
+    }
+
+    /**
+     * record the result of a case timed by the caller
+     * @param name    the name of the case
+     * @param reps    the number of iterations timed
+     * @param secs    the total time taken
+     * @param bytes   the total bytes of data processed, or 0
+     * @param items   the total number of items processed
+     */
+    void record(const std::string& name, int reps, double secs, double bytes, long items) {
+        Result r;
+        r.name = _section.empty() ? name : _section + "." + name;
+        r.iterations = reps;
+        r.seconds = secs;
+        r.bytes = bytes;
+        r.items = items;
+        _results.push_back(r);
+
+        std::cout << "  " << name << ": " << items << " items in " << secs << " s, "
+                  << secs / reps * 1.0e3 << " ms each";
+        if (bytes > 0) std::cout << ", " << bytes / secs / 1.0e6 << " MB/s";
+        std::cout << std::endl;
+    }
+
+    /**
+     * write the JSON results, if they were asked for
+     * @return the exit status for the program
+     */
+    int finish() const {
+        if (_json.empty()) return 0;
+        std::ofstream out(_json.c_str());
+        out.precision(9);
+        out << "{ \"program\": \"" << _program << "\", \"repetitions\": " << _reps
+            << ",\n  \"results\": [";
+        for (std::size_t i = 0; i < _results.size(); ++i) {
+            const Result& r = _results[i];
+            double secs = (r.seconds > 0) ? r.seconds : 1.0e-9;
+            out << ((i == 0) ? "\n" : ",\n") << "    { \"name\": \"" << r.name
+                << "\", \"iterations\": " << r.iterations << ", \"seconds\": " << r.seconds
+                << ", \"seconds_per_iteration\": " << r.seconds / r.iterations
+                << ", \"items\": " << r.items << ", \"items_per_second\": " << r.items / secs;
+            if (r.bytes > 0) out << ", \"bytes_per_second\": " << r.bytes / secs;
+            out << " }";
+        }
+        out << "\n  ]\n}\n";
+        out.close();
+        if (out.fail()) {
+            std::cerr << _program << ": failed to write " << _json << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+private:
+    struct Result {
+        std::string name;
+        int iterations;
+        double seconds;
+        double bytes;
+        long items;
+    };
+
+    std::string _program;
+    int _reps;
+    std::string _json;              // the file to write results to
+    std::string _section;
+    std::vector<Result> _results;
+};
+
+#endif // LSST_PEX_POLICY_BENCHMARKS_BENCHMARK_H
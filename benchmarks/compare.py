@@ -0,0 +1,78 @@
+#! /usr/bin/env python
+
+#
+# LSST Data Management System
+# Copyright 2008, 2009, 2010 LSST Corporation.
+#
+# This product includes software developed by the
+# LSST Project (http://www.lsst.org/).
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the LSST License Statement and
+# the GNU General Public License along with this program.  If not,
+# see <http://www.lsstcorp.org/LegalNotices/>.
+#
+
+#
+
+"""Compare two sets of benchmark results written with --json.
+
+usage: compare.py [--threshold PERCENT] BASELINE.json CURRENT.json
+
+Every case found in both files is listed with the ratio of its time per
+iteration in CURRENT to that in BASELINE.  The exit status is 1 if any case
+is slower by more than the threshold (10% by default).
+"""
+from __future__ import print_function
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        data = json.load(f)
+    return data["program"], dict((r["name"], r) for r in data["results"])
+
+
+def main():
+    parser = argparse.ArgumentParser(description="compare two sets of benchmark results")
+    parser.add_argument("baseline", help="the results to compare against")
+    parser.add_argument("current", help="the new results")
+    parser.add_argument("--threshold", type=float, default=10.0,
+                        help="the slow-down, in percent, reported as a regression")
+    args = parser.parse_args()
+
+    program, baseline = load(args.baseline)
+    current_program, current = load(args.current)
+    if program != current_program:
+        print("warning: comparing results of %s with %s" % (program, current_program))
+
+    regressions = 0
+    for name in sorted(set(baseline) & set(current)):
+        before = baseline[name]["seconds_per_iteration"]
+        after = current[name]["seconds_per_iteration"]
+        ratio = after / before if before > 0 else float("inf")
+        flag = ""
+        if ratio > 1.0 + args.threshold / 100.0:
+            flag = "  REGRESSION"
+            regressions += 1
+        print("%-32s %12.6g s %12.6g s %7.3fx%s" % (name, before, after, ratio, flag))
+    for name in sorted(set(baseline) ^ set(current)):
+        print("%-32s only in %s" % (name, args.baseline if name in baseline else args.current))
+
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,113 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file loadBinary.cc
+ *
+ * Compare loading a Policy from compiled (binary) data with parsing the
+ * PAF text it was compiled from, on generated documents: a
+ * configuration-like policy of nested blocks with scalar values of every
+ * type, and a table of long numeric arrays.  The times are per load, as
+ * the two forms differ in size.
+ *
+ * usage: loadBinary [repetitions] [--json FILE]
+ */
+
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "lsst/pex/policy/Policy.h"
+#include "lsst/pex/policy/paf/PAFParser.h"
+#include "lsst/pex/policy/binary/BinaryParser.h"
+#include "lsst/pex/policy/binary/BinaryWriter.h"
+#include "Benchmark.h"
+
+using namespace std;
+using lsst::pex::policy::Policy;
+using lsst::pex::policy::paf::PAFParser;
+using lsst::pex::policy::binary::BinaryParser;
+using lsst::pex::policy::binary::BinaryWriter;
+
+template <typename Parser>
+int load(const string& data) {
+    Policy p;
+    Parser parser(p);
+    return parser.parse(data.data(), data.size());
+}
+
+
+// a policy of many stage blocks
+string stages(int n) {
+    ostringstream p;
+    for (int i = 0; i < n; ++i) {
+        p << "stage" << i << ": {\n"
+          << "    name: \"lsst.pipeline.Stage" << i << "\"\n"
+          << "    enabled: " << ((i % 2) ? "true" : "false") << "\n"
+          << "    threshold: " << i + 0.25 << "\n"
+          << "    offsets: " << i << " " << i + 1 << " " << i + 2 << "\n"
+          << "    output: {\n"
+          << "        format: \"fits\"\n"
+          << "        verbosity: " << i % 5 << "\n"
+          << "    }\n"
+          << "}\n";
+    }
+    return p.str();
+}
+
+// a policy holding long arrays of numbers
+string numericTable() {
+    ostringstream p;
+    p.precision(12);
+    for (int row = 0; row < 200; ++row) {
+        p << "coeff" << row << ":";
+        for (int i = 0; i < 50; ++i) p << ' ' << (row * 50 + i + 0.5) * 1.000123e-3;
+        p << "\nindex" << row << ":";
+        for (int i = 0; i < 50; ++i) p << ' ' << row * 50 - i;
+        p << '\n';
+    }
+    return p.str();
+}
+
+void compare(Benchmark& bench, const string& section, const string& paf, int reps) {
+    Policy p;
+    PAFParser(p).parse(paf.data(), paf.size());
+    BinaryWriter writer;
+    writer.write(p);
+    string compiled = writer.toString();
+
+    bench.section(section, section + ": PAF " + to_string(paf.size()) + " bytes, compiled " +
+                  to_string(compiled.size()) + " bytes");
+    double text = bench.time("paf_load", reps, paf.size(), [&]() { return load<PAFParser>(paf); });
+    double binary = bench.time("compiled_load", reps, compiled.size(),
+                               [&]() { return load<BinaryParser>(compiled); });
+    cout << "  speed-up: " << text / binary << endl;
+}
+
+int main(int argc, char** argv) {
+    Benchmark bench("loadBinary", argc, argv, 20);
+    int reps = bench.getReps();
+
+    compare(bench, "stages", stages(2000), reps);
+    compare(bench, "table", numericTable(), reps * 5);
+    return bench.finish();
+}
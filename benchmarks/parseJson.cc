@@ -0,0 +1,165 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file parseJson.cc
+ *
+ * Compare JSON parsing throughput with PAF parsing on equivalent
+ * generated documents: a configuration-like policy of nested blocks with
+ * scalar values of every type, and a table of long numeric arrays.  Each
+ * is parsed into a Policy and, to show the cost of scanning alone, sent
+ * to a PolicyHandler that ignores it.
+ *
+ * usage: parseJson [repetitions] [--json FILE]
+ */
+
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "lsst/pex/policy/Policy.h"
+#include "lsst/pex/policy/PolicyHandler.h"
+#include "lsst/pex/policy/PolicyParser.h"
+#include "lsst/pex/policy/json/JSONParser.h"
+#include "Benchmark.h"
+#include "lsst/pex/policy/paf/PAFParser.h"
+
+using namespace std;
+using lsst::pex::policy::Policy;
+using lsst::pex::policy::PolicyHandler;
+using lsst::pex::policy::PolicyParser;
+using lsst::pex::policy::json::JSONParser;
+using lsst::pex::policy::paf::PAFParser;
+
+// a handler that ignores what it is sent
+class Ignore : public PolicyHandler {
+public:
+    virtual void beginPolicy(const string&, int) {}
+    virtual void endPolicy(const string&, int) {}
+    virtual void onBool(const string&, bool, int) {}
+    virtual void onInt(const string&, int, int) {}
+    virtual void onDouble(const string&, double, int) {}
+    virtual void onString(const string&, const string&, int) {}
+    virtual void onFile(const string&, const Policy::FilePtr&, int) {}
+};
+
+template <typename Parser>
+int load(const string& data) {
+    Policy p;
+    Parser parser(p);
+    return parser.parse(data.data(), data.size());
+}
+
+template <typename Parser>
+int scan(const string& data) {
+    Policy p;
+    Ignore ignore;
+    Parser parser(p);
+    parser.setHandler(&ignore);
+    return parser.parse(data.data(), data.size());
+}
+
+void report(Benchmark& bench, const char* mode, int (*parse)(const string&), const string& doc,
+            int reps) {
+    bench.time(mode, reps, doc.size(), [&]() { return parse(doc); });
+}
+
+// a policy of many stage blocks, written as PAF and as JSON
+void stages(int n, string& paf, string& json) {
+    ostringstream p, j;
+    j << "{\n";
+    for (int i = 0; i < n; ++i) {
+        p << "stage" << i << ": {\n"
+          << "    name: \"lsst.pipeline.Stage" << i << "\"\n"
+          << "    enabled: " << ((i % 2) ? "true" : "false") << "\n"
+          << "    threshold: " << i + 0.25 << "\n"
+          << "    offsets: " << i << " " << i + 1 << " " << i + 2 << "\n"
+          << "    output: {\n"
+          << "        format: \"fits\"\n"
+          << "        verbosity: " << i % 5 << "\n"
+          << "    }\n"
+          << "}\n";
+        j << ((i) ? ",\n" : "")
+          << "  \"stage" << i << "\": {\n"
+          << "    \"name\": \"lsst.pipeline.Stage" << i << "\",\n"
+          << "    \"enabled\": " << ((i % 2) ? "true" : "false") << ",\n"
+          << "    \"threshold\": " << i + 0.25 << ",\n"
+          << "    \"offsets\": [" << i << ", " << i + 1 << ", " << i + 2 << "],\n"
+          << "    \"output\": {\n"
+          << "        \"format\": \"fits\",\n"
+          << "        \"verbosity\": " << i % 5 << "\n"
+          << "    }\n"
+          << "  }";
+    }
+    j << "\n}\n";
+    paf = p.str();
+    json = j.str();
+}
+
+// a policy holding long arrays of numbers, written as PAF and as JSON
+void numericTable(string& paf, string& json) {
+    ostringstream p, j;
+    p.precision(12);
+    j.precision(12);
+    j << "{\n";
+    for (int row = 0; row < 200; ++row) {
+        p << "coeff" << row << ":";
+        j << ((row) ? ",\n" : "") << "\"coeff" << row << "\": [";
+        for (int i = 0; i < 50; ++i) {
+            p << ' ' << (row * 50 + i + 0.5) * 1.000123e-3;
+            j << ((i) ? ", " : "") << (row * 50 + i + 0.5) * 1.000123e-3;
+        }
+        p << "\nindex" << row << ":";
+        j << "],\n\"index" << row << "\": [";
+        for (int i = 0; i < 50; ++i) {
+            p << ' ' << row * 50 - i;
+            j << ((i) ? ", " : "") << row * 50 - i;
+        }
+        p << '\n';
+        j << "]";
+    }
+    j << "\n}\n";
+    paf = p.str();
+    json = j.str();
+}
+
+void compare(Benchmark& bench, const string& section, const string& paf, const string& json, int reps) {
+    bench.section(section, section + ": PAF " + to_string(paf.size()) + " bytes, JSON " +
+                  to_string(json.size()) + " bytes");
+    report(bench, "paf_load", load<PAFParser>, paf, reps);
+    report(bench, "json_load", load<JSONParser>, json, reps);
+    report(bench, "paf_scan", scan<PAFParser>, paf, reps);
+    report(bench, "json_scan", scan<JSONParser>, json, reps);
+}
+
+int main(int argc, char** argv) {
+    Benchmark bench("parseJson", argc, argv, 20);
+    int reps = bench.getReps();
+
+    string paf, json;
+    stages(2000, paf, json);
+    compare(bench, "stages", paf, json, reps);
+
+    numericTable(paf, json);
+    compare(bench, "table", paf, json, reps * 5);
+    return bench.finish();
+}
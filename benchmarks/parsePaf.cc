@@ -0,0 +1,263 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file parsePaf.cc
+ *
+ * Measure PAF parsing throughput over the policy files shipped in
+ * examples/ and tests/dictionary, reading from an istream and directly
+ * from a memory buffer.  Files that do not parse cleanly are skipped.
+ * A generated table of long numeric arrays is timed separately.  The
+ * "events" mode sends the values to a PolicyHandler that ignores them,
+ * showing the cost of parsing without building a Policy.  Copies of the
+ * files with syntax errors added are checked by catching the first
+ * exception and by collecting every problem with a ParserDiagnostics.
+ * The "arena" mode loads each document into a Policy using a PolicyArena
+ * of its own; the allocation cases report, as their item count, the
+ * calls made to the heap to load a document and destroy it, with and
+ * without one.
+ *
+ * usage: parsePaf [repetitions] [--json FILE]
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "boost/filesystem.hpp"
+
+#include "lsst/utils/Utils.h"
+#include "lsst/pex/policy/Policy.h"
+#include "lsst/pex/policy/PolicyHandler.h"
+#include "lsst/pex/policy/ParserDiagnostics.h"
+#include "lsst/pex/policy/paf/PAFParser.h"
+#include "Benchmark.h"
+
+using namespace std;
+using lsst::pex::policy::Policy;
+using lsst::pex::policy::PolicyArena;
+using lsst::pex::policy::PolicyHandler;
+using lsst::pex::policy::ParserDiagnostics;
+using lsst::pex::policy::paf::PAFParser;
+namespace fs = boost::filesystem;
+
+// the calls made to allocate memory from the heap
+static atomic<long> heapCalls(0);
+
+void* operator new(size_t size) {
+    heapCalls.fetch_add(1, memory_order_relaxed);
+    void* p = malloc(size ? size : 1);
+    if (! p) throw bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept { free(p); }
+
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+int parseStream(const string& data) {
+    Policy p;
+    PAFParser parser(p);
+    istringstream is(data);
+    return parser.parse(is);
+}
+
+int parseBuffer(const string& data) {
+    Policy p;
+    PAFParser parser(p);
+    return parser.parse(data.data(), data.size());
+}
+
+int parseArena(const string& data) {
+    Policy p(PolicyArena::Ptr(new PolicyArena()));
+    PAFParser parser(p);
+    return parser.parse(data.data(), data.size());
+}
+
+// a handler that only looks at names, as a filter would
+class NameCounter : public PolicyHandler {
+public:
+    NameCounter() : chars(0) {}
+    virtual void beginPolicy(const string& name, int) { chars += name.size(); }
+    virtual void endPolicy(const string&, int) {}
+    virtual void onBool(const string& name, bool, int) { chars += name.size(); }
+    virtual void onInt(const string& name, int, int) { chars += name.size(); }
+    virtual void onDouble(const string& name, double, int) { chars += name.size(); }
+    virtual void onString(const string& name, const string&, int) { chars += name.size(); }
+    virtual void onFile(const string& name, const Policy::FilePtr&, int) { chars += name.size(); }
+    size_t chars;
+};
+
+int parseEvents(const string& data) {
+    Policy p;
+    NameCounter counter;
+    PAFParser parser(p);
+    parser.setHandler(&counter);
+    return parser.parse(data.data(), data.size());
+}
+
+// check a document, catching the first error
+int checkThrow(const string& data) {
+    Policy p;
+    PAFParser parser(p);
+    try {
+        return parser.parse(data.data(), data.size());
+    } catch (std::exception&) {
+        return 1;
+    }
+}
+
+// check a document, collecting all its errors
+int checkDiagnostics(const string& data) {
+    Policy p;
+    ParserDiagnostics diag;
+    PAFParser parser(p);
+    parser.setDiagnostics(&diag);
+    parser.parse(data.data(), data.size());
+    return diag.getCount();
+}
+
+int parseParallel(const string& data) {
+    Policy p;
+    PAFParser parser(p);
+    parser.setThreads(0);
+    return parser.parse(data.data(), data.size());
+}
+
+void report(Benchmark& bench, const char* mode, int (*parse)(const string&), const vector<string>& docs,
+            size_t bytes, int reps) {
+    bench.time(mode, reps, bytes, [&]() {
+        long values = 0;
+        for (const string& doc : docs) values += parse(doc);
+        return values;
+    });
+}
+
+// record the calls made to the heap to load each document and destroy it
+void countAllocations(Benchmark& bench, const char* mode, int (*parse)(const string&),
+                      const vector<string>& docs, size_t bytes) {
+    long before = heapCalls.load();
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (const string& doc : docs) parse(doc);
+    chrono::duration<double> secs = chrono::steady_clock::now() - start;
+    bench.record(mode, 1, secs.count(), bytes, heapCalls.load() - before);
+}
+
+// a policy holding long arrays of numbers, like a calibration table
+string numericTable() {
+    ostringstream out;
+    out.precision(12);
+    for (int row = 0; row < 200; ++row) {
+        out << "coeff" << row << ":";
+        for (int i = 0; i < 50; ++i) out << ' ' << (row * 50 + i + 0.5) * 1.000123e-3;
+        out << "\nindex" << row << ":";
+        for (int i = 0; i < 50; ++i) out << ' ' << row * 50 - i;
+        out << '\n';
+    }
+    return out.str();
+}
+
+// a copy of a policy with a syntax error after every eighth line
+string withErrors(const string& doc) {
+    istringstream in(doc);
+    string out;
+    int n = 0;
+    for (string line; getline(in, line);) {
+        out += line + "\n";
+        if (++n % 8 == 0) out += "not a parameter\n";
+    }
+    return out;
+}
+
+// a large policy made of many top-level blocks, one per pipeline stage
+string stages(const vector<string>& docs, size_t size) {
+    string out;
+    for (int i = 0; out.size() < size; ++i) {
+        out += "stage" + to_string(i) + ": {\n";
+        istringstream in(docs[i % docs.size()]);
+        for (string line; getline(in, line);) out += "    " + line + "\n";
+        out += "}\n";
+    }
+    return out;
+}
+
+int main(int argc, char** argv) {
+    Benchmark bench("parsePaf", argc, argv, 200);
+    int reps = bench.getReps();
+    fs::path root(lsst::utils::getPackageDir("pex_policy"));
+
+    vector<string> docs;
+    size_t bytes = 0;
+    for (const char* dir : {"examples", "tests/dictionary"}) {
+        for (fs::directory_iterator it(root / dir), end; it != end; ++it) {
+            if (it->path().extension() != ".paf") continue;
+            ifstream in(it->path().string().c_str());
+            ostringstream data;
+            data << in.rdbuf();
+            try {
+                parseStream(data.str());
+            } catch (std::exception&) {
+                continue;
+            }
+            docs.push_back(data.str());
+            bytes += docs.back().size();
+        }
+    }
+
+    bench.section("examples", to_string(docs.size()) + " files, " + to_string(bytes) + " bytes");
+    report(bench, "istream", parseStream, docs, bytes, reps);
+    report(bench, "buffer", parseBuffer, docs, bytes, reps);
+    report(bench, "arena", parseArena, docs, bytes, reps);
+    report(bench, "events", parseEvents, docs, bytes, reps);
+    countAllocations(bench, "allocations.heap", parseBuffer, docs, bytes);
+    countAllocations(bench, "allocations.arena", parseArena, docs, bytes);
+
+    // the values counted here are errors found (or 1 per thrown error)
+    vector<string> broken;
+    size_t brokenBytes = 0;
+    for (const string& doc : docs) {
+        broken.push_back(withErrors(doc));
+        brokenBytes += broken.back().size();
+    }
+    bench.section("errors", "files with errors, " + to_string(brokenBytes) + " bytes");
+    report(bench, "throw", checkThrow, broken, brokenBytes, reps);
+    report(bench, "diagnostics", checkDiagnostics, broken, brokenBytes, reps);
+
+    vector<string> table(1, numericTable());
+    bench.section("table", "numeric table, " + to_string(table[0].size()) + " bytes");
+    report(bench, "buffer", parseBuffer, table, table[0].size(), reps / 10 + 1);
+
+    vector<string> big(1, stages(docs, 32 << 20));
+    bench.section("stages", "stages, " + to_string(big[0].size()) + " bytes");
+    report(bench, "buffer", parseBuffer, big, big[0].size(), 1);
+    report(bench, "arena", parseArena, big, big[0].size(), 1);
+    report(bench, "parallel", parseParallel, big, big[0].size(), 1);
+    countAllocations(bench, "allocations.heap", parseBuffer, big, big[0].size());
+    countAllocations(bench, "allocations.arena", parseArena, big, big[0].size());
+    return bench.finish();
+}
@@ -0,0 +1,164 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file parseXml.cc
+ *
+ * Compare XML parsing throughput with PAF parsing on equivalent
+ * generated documents: a configuration-like policy of nested blocks with
+ * scalar values of every type, and a table of long numeric arrays.  Each
+ * is parsed into a Policy and, to show the cost of scanning alone, sent
+ * to a PolicyHandler that ignores it.
+ *
+ * usage: parseXml [repetitions] [--json FILE]
+ */
+
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "lsst/pex/policy/Policy.h"
+#include "lsst/pex/policy/PolicyHandler.h"
+#include "lsst/pex/policy/PolicyParser.h"
+#include "lsst/pex/policy/paf/PAFParser.h"
+#include "lsst/pex/policy/xml/XMLParser.h"
+#include "Benchmark.h"
+
+using namespace std;
+using lsst::pex::policy::Policy;
+using lsst::pex::policy::PolicyHandler;
+using lsst::pex::policy::PolicyParser;
+using lsst::pex::policy::paf::PAFParser;
+using lsst::pex::policy::xml::XMLParser;
+
+// a handler that ignores what it is sent
+class Ignore : public PolicyHandler {
+public:
+    virtual void beginPolicy(const string&, int) {}
+    virtual void endPolicy(const string&, int) {}
+    virtual void onBool(const string&, bool, int) {}
+    virtual void onInt(const string&, int, int) {}
+    virtual void onDouble(const string&, double, int) {}
+    virtual void onString(const string&, const string&, int) {}
+    virtual void onFile(const string&, const Policy::FilePtr&, int) {}
+};
+
+template <typename Parser>
+int load(const string& data) {
+    Policy p;
+    Parser parser(p);
+    return parser.parse(data.data(), data.size());
+}
+
+template <typename Parser>
+int scan(const string& data) {
+    Policy p;
+    Ignore ignore;
+    Parser parser(p);
+    parser.setHandler(&ignore);
+    return parser.parse(data.data(), data.size());
+}
+
+void report(Benchmark& bench, const char* mode, int (*parse)(const string&), const string& doc,
+            int reps) {
+    bench.time(mode, reps, doc.size(), [&]() { return parse(doc); });
+}
+
+// a policy of many stage blocks, written as PAF and as XML
+void stages(int n, string& paf, string& xml) {
+    ostringstream p, x;
+    x << "<?xml version=\"1.0\"?>\n<Policy>\n";
+    for (int i = 0; i < n; ++i) {
+        p << "stage" << i << ": {\n"
+          << "    name: \"lsst.pipeline.Stage" << i << "\"\n"
+          << "    enabled: " << ((i % 2) ? "true" : "false") << "\n"
+          << "    threshold: " << i + 0.25 << "\n"
+          << "    offsets: " << i << " " << i + 1 << " " << i + 2 << "\n"
+          << "    output: {\n"
+          << "        format: \"fits\"\n"
+          << "        verbosity: " << i % 5 << "\n"
+          << "    }\n"
+          << "}\n";
+        x << "  <stage" << i << ">\n"
+          << "    <name>lsst.pipeline.Stage" << i << "</name>\n"
+          << "    <enabled t=\"b\">" << ((i % 2) ? "true" : "false") << "</enabled>\n"
+          << "    <threshold t=\"d\">" << i + 0.25 << "</threshold>\n"
+          << "    <offsets t=\"i\">" << i << " " << i + 1 << " " << i + 2 << "</offsets>\n"
+          << "    <output>\n"
+          << "        <format>fits</format>\n"
+          << "        <verbosity>" << i % 5 << "</verbosity>\n"
+          << "    </output>\n"
+          << "  </stage" << i << ">\n";
+    }
+    x << "</Policy>\n";
+    paf = p.str();
+    xml = x.str();
+}
+
+// a policy holding long arrays of numbers, written as PAF and as XML
+void numericTable(string& paf, string& xml) {
+    ostringstream p, x;
+    p.precision(12);
+    x.precision(12);
+    x << "<Policy>\n";
+    for (int row = 0; row < 200; ++row) {
+        p << "coeff" << row << ":";
+        x << "<coeff" << row << " t=\"d\">";
+        for (int i = 0; i < 50; ++i) {
+            p << ' ' << (row * 50 + i + 0.5) * 1.000123e-3;
+            x << ' ' << (row * 50 + i + 0.5) * 1.000123e-3;
+        }
+        p << "\nindex" << row << ":";
+        x << "</coeff" << row << ">\n<index" << row << " t=\"i\">";
+        for (int i = 0; i < 50; ++i) {
+            p << ' ' << row * 50 - i;
+            x << ' ' << row * 50 - i;
+        }
+        p << '\n';
+        x << "</index" << row << ">\n";
+    }
+    x << "</Policy>\n";
+    paf = p.str();
+    xml = x.str();
+}
+
+void compare(Benchmark& bench, const string& section, const string& paf, const string& xml, int reps) {
+    bench.section(section, section + ": PAF " + to_string(paf.size()) + " bytes, XML " +
+                  to_string(xml.size()) + " bytes");
+    report(bench, "paf_load", load<PAFParser>, paf, reps);
+    report(bench, "xml_load", load<XMLParser>, xml, reps);
+    report(bench, "paf_scan", scan<PAFParser>, paf, reps);
+    report(bench, "xml_scan", scan<XMLParser>, xml, reps);
+}
+
+int main(int argc, char** argv) {
+    Benchmark bench("parseXml", argc, argv, 20);
+    int reps = bench.getReps();
+
+    string paf, xml;
+    stages(2000, paf, xml);
+    compare(bench, "stages", paf, xml, reps);
+
+    numericTable(paf, xml);
+    compare(bench, "table", paf, xml, reps * 5);
+    return bench.finish();
+}
@@ -0,0 +1,326 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file policyOperations.cc
+ *
+ * Measure the common Policy operations on generated data, as a baseline
+ * for tracking performance across releases:
+ * @li parsing small, medium and huge PAF documents;
+ * @li looking values up with the get*() and get*Array() functions, and in
+ *     a FrozenPolicy;
+ * @li enumerating names with names(), paramNames() and policyNames();
+ * @li resolving deep trees of included files with loadPolicyFiles();
+ * @li validating a Policy against a Dictionary;
+ * @li merging defaults with mergeDefaults();
+ * @li writing a Policy with PAFWriter.
+ *
+ * usage: policyOperations [repetitions] [--json FILE]
+ */
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "boost/filesystem.hpp"
+
+#include "lsst/pex/policy/Policy.h"
+#include "lsst/pex/policy/Dictionary.h"
+#include "lsst/pex/policy/FrozenPolicy.h"
+#include "lsst/pex/policy/PolicyFile.h"
+#include "lsst/pex/policy/paf/PAFParser.h"
+#include "lsst/pex/policy/paf/PAFWriter.h"
+#include "Benchmark.h"
+
+using namespace std;
+using lsst::pex::policy::Dictionary;
+using lsst::pex::policy::FrozenPolicy;
+using lsst::pex::policy::Policy;
+using lsst::pex::policy::PolicyFile;
+using lsst::pex::policy::PolicyKey;
+using lsst::pex::policy::paf::PAFParser;
+using lsst::pex::policy::paf::PAFWriter;
+namespace fs = boost::filesystem;
+
+// where lookup results are sent, so that the lookups are not optimized away
+volatile double sink;
+
+// a policy of n blocks, each holding a value of every type and a
+// sub-policy
+string blocks(int n) {
+    ostringstream out;
+    for (int i = 0; i < n; ++i) {
+        out << "block" << i << ": {\n"
+            << "    name: \"lsst.pipeline.Stage" << i << "\"\n"
+            << "    enabled: " << ((i % 2) ? "true" : "false") << "\n"
+            << "    count: " << i << "\n"
+            << "    scale: " << i + 0.25 << "\n"
+            << "    offsets: " << i << " " << i + 1 << " " << i + 2 << " " << i + 3 << "\n"
+            << "    output: {\n"
+            << "        format: \"fits\"\n"
+            << "        verbosity: " << i % 5 << "\n"
+            << "    }\n"
+            << "}\n";
+    }
+    return out.str();
+}
+
+long parse(const string& data) {
+    Policy p;
+    PAFParser parser(p);
+    return parser.parse(data.data(), data.size());
+}
+
+void parsing(Benchmark& bench, int reps) {
+    const int sizes[] = { 10, 1000, 100000 };
+    const char* names[] = { "small", "medium", "huge" };
+    const int repeat[] = { reps * 50, reps, 1 };
+
+    bench.section("parse", "PAF parsing");
+    for (int i = 0; i < 3; ++i) {
+        string data = blocks(sizes[i]);
+        bench.time(names[i], repeat[i], data.size(), [&]() { return parse(data); });
+    }
+}
+
+void lookups(Benchmark& bench, const Policy& p, int n, int reps) {
+    vector<string> names;
+    for (int i = 0; i < n; ++i) names.push_back("block" + to_string(i) + ".");
+
+    bench.section("get", "value lookups, " + to_string(n) + " blocks");
+    bench.time("getInt", reps, 0, [&]() {
+        long sum = 0;
+        for (const string& name : names) sum += p.getInt(name + "count");
+        sink = sum;
+        return long(names.size());
+    });
+    bench.time("getDouble", reps, 0, [&]() {
+        double sum = 0;
+        for (const string& name : names) sum += p.getDouble(name + "scale");
+        sink = sum;
+        return long(names.size());
+    });
+    bench.time("getBool", reps, 0, [&]() {
+        long count = 0;
+        for (const string& name : names) count += p.getBool(name + "enabled");
+        sink = count;
+        return long(names.size());
+    });
+    bench.time("getString", reps, 0, [&]() {
+        size_t chars = 0;
+        for (const string& name : names) chars += p.getString(name + "name").size();
+        sink = chars;
+        return long(names.size());
+    });
+    bench.time("getNested", reps, 0, [&]() {
+        long sum = 0;
+        for (const string& name : names) sum += p.getInt(name + "output.verbosity");
+        sink = sum;
+        return long(names.size());
+    });
+    // the same lookups with the names built beforehand, and as PolicyKeys
+    vector<string> nested;
+    vector<PolicyKey> keys;
+    for (const string& name : names) {
+        nested.push_back(name + "output.verbosity");
+        keys.push_back(PolicyKey(nested.back()));
+    }
+    bench.time("getNested_name", reps, 0, [&]() {
+        long sum = 0;
+        for (const string& name : nested) sum += p.getInt(name);
+        sink = sum;
+        return long(nested.size());
+    });
+    bench.time("getNested_key", reps, 0, [&]() {
+        long sum = 0;
+        for (const PolicyKey& key : keys) sum += p.getInt(key);
+        sink = sum;
+        return long(keys.size());
+    });
+    // the same lookups in a frozen snapshot
+    FrozenPolicy::ConstPtr frozen = p.freeze();
+    bench.time("getNested_frozen", reps, 0, [&]() {
+        long sum = 0;
+        for (const string& name : nested) sum += frozen->getInt(name);
+        sink = sum;
+        return long(nested.size());
+    });
+    bench.time("getIntArray", reps, 0, [&]() {
+        long count = 0;
+        for (const string& name : names) count += p.getIntArray(name + "offsets").size();
+        return count;
+    });
+    bench.time("getIntArrayView", reps, 0, [&]() {
+        long count = 0;
+        for (const string& name : names) count += p.getIntArrayView(name + "offsets").size();
+        return count;
+    });
+    bench.time("getPolicy", reps, 0, [&]() {
+        long count = 0;
+        for (const string& name : names) count += bool(p.getPolicy(name + "output"));
+        return count;
+    });
+}
+
+void enumeration(Benchmark& bench, const Policy& p, int reps) {
+    bench.section("names", "name enumeration");
+    bench.time("names", reps, 0, [&]() { return long(p.names().size()); });
+    bench.time("names_top", reps, 0, [&]() { return long(p.names(true).size()); });
+    bench.time("paramNames", reps, 0, [&]() { return long(p.paramNames().size()); });
+    bench.time("policyNames", reps, 0, [&]() { return long(p.policyNames().size()); });
+}
+
+// write a tree of policy files, each including two more, to the given
+// depth, and a chain of files each including the next; return the
+// number of files written
+int includeTree(const fs::path& dir, int depth, int chain) {
+    int files = 0;
+    for (int d = 0; d <= depth; ++d) {
+        for (int k = 0; k < (1 << d); ++k, ++files) {
+            ofstream out((dir / ("node_" + to_string(d) + "_" + to_string(k) + ".paf")).string().c_str());
+            out << "depth: " << d << "\nindex: " << k << "\nlabel: \"node\"\n";
+            if (d < depth) {
+                out << "left: @node_" << d + 1 << "_" << 2 * k << ".paf\n"
+                    << "right: @node_" << d + 1 << "_" << 2 * k + 1 << ".paf\n";
+            }
+        }
+    }
+    for (int i = 0; i <= chain; ++i, ++files) {
+        ofstream out((dir / ("chain_" + to_string(i) + ".paf")).string().c_str());
+        out << "link: " << i << "\n";
+        if (i < chain) out << "next: @chain_" << i + 1 << ".paf\n";
+    }
+    return files;
+}
+
+long loadTree(const fs::path& dir, const string& root) {
+    Policy p;
+    PolicyFile((dir / root).string()).load(p);
+    return p.loadPolicyFiles(dir);
+}
+
+void includes(Benchmark& bench, int reps) {
+    fs::path dir = fs::temp_directory_path() / fs::unique_path("pex_policy_bench_%%%%%%%%");
+    fs::create_directories(dir);
+    int files = includeTree(dir, 7, 64);
+
+    bench.section("include", "loadPolicyFiles, " + to_string(files) + " files");
+    bench.time("tree", reps, 0, [&]() { return loadTree(dir, "node_0_0.paf"); });
+    bench.time("chain", reps, 0, [&]() { return loadTree(dir, "chain_0.paf"); });
+    fs::remove_all(dir);
+}
+
+// a dictionary defining n parameters of each type, and a policy that
+// conforms to it
+void dictionary(int n, string& dict, string& pol) {
+    ostringstream d, p;
+    d << "target: bench\ndefinitions: {\n";
+    for (int i = 0; i < n; ++i) {
+        d << "    count" << i << ": {\n        type: int\n        minOccurs: 1\n        maxOccurs: 4\n"
+          << "        default: 1\n        allowed: {\n            min: 0\n            max: 1000\n        }\n    }\n"
+          << "    scale" << i << ": {\n        type: double\n        maxOccurs: 1\n        default: 0.5\n    }\n"
+          << "    mode" << i << ": {\n        type: string\n        default: \"fast\"\n"
+          << "        allowed: {\n            value: \"fast\"\n        }\n"
+          << "        allowed: {\n            value: \"slow\"\n        }\n    }\n"
+          << "    enabled" << i << ": {\n        type: bool\n        default: true\n    }\n";
+        p << "count" << i << ": " << i << " " << i + 1 << "\nscale" << i << ": " << i + 0.25
+          << "\nmode" << i << ": " << ((i % 2) ? "\"fast\"" : "\"slow\"") << "\nenabled" << i << ": true\n";
+    }
+    d << "}\n";
+    dict = d.str();
+    pol = p.str();
+}
+
+void validation(Benchmark& bench, int reps) {
+    const int n = 250;
+    string dictData, polData;
+    dictionary(n, dictData, polData);
+    Policy dictPolicy, p;
+    PAFParser(dictPolicy).parse(dictData.data(), dictData.size());
+    PAFParser(p).parse(polData.data(), polData.size());
+    Dictionary dict(dictPolicy);
+
+    bench.section("dictionary", "Dictionary, " + to_string(4 * n) + " definitions");
+    bench.time("validate", reps, 0, [&]() {
+        dict.validate(p);
+        return long(4 * n);
+    });
+    bench.time("mergeDefaults", reps, 0, [&]() {
+        Policy q;
+        return long(q.mergeDefaults(dict, false));
+    });
+}
+
+void merging(Benchmark& bench, const Policy& defaults, int n, int reps) {
+    Policy partial;
+    for (int i = 0; i < n; i += 2) {
+        string name = "block" + to_string(i);
+        partial.set(name, Policy::Ptr(new Policy(*defaults.getPolicy(name))));
+    }
+
+    bench.section("merge", "mergeDefaults, " + to_string(n / 2) + " of " + to_string(n) + " blocks given");
+    bench.time("copy", reps, 0, [&]() {
+        Policy p(partial);
+        return long(p.names(true).size());
+    });
+    bench.time("copy_and_merge", reps, 0, [&]() {
+        Policy p(partial);
+        return long(p.mergeDefaults(defaults, false));
+    });
+}
+
+void writing(Benchmark& bench, const Policy& p, int reps) {
+    size_t bytes;
+    {
+        PAFWriter writer;
+        writer.write(p);
+        bytes = writer.toString().size();
+    }
+
+    bench.section("write", "PAFWriter");
+    bench.time("string", reps, bytes, [&]() {
+        PAFWriter writer;
+        writer.write(p);
+        return long(writer.toString().size());
+    });
+}
+
+int main(int argc, char** argv) {
+    Benchmark bench("policyOperations", argc, argv, 20);
+    int reps = bench.getReps();
+
+    const int n = 1000;
+    string data = blocks(n);
+    Policy p;
+    PAFParser(p).parse(data.data(), data.size());
+
+    parsing(bench, reps);
+    lookups(bench, p, n, reps * 5);
+    enumeration(bench, p, reps);
+    includes(bench, reps);
+    validation(bench, reps);
+    merging(bench, p, n, reps);
+    writing(bench, p, reps);
+    return bench.finish();
+}
@@ -0,0 +1,150 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file policyReload.cc
+ *
+ * Time many threads reading the configuration of a service while another
+ * thread replaces it by a new version every millisecond, as a service
+ * reconfigured on the fly would.  Each case runs the same reads, split
+ * among a given number of threads, and reports the reads made across all
+ * threads; its time is the wall time for all threads to finish.  The
+ * reads go through a SharedPolicy, which takes no lock to read, or
+ * through a shared pointer to the current Policy guarded by a mutex, as
+ * services did before.  The ".reloads" results count the versions
+ * published while the reads ran.
+ *
+ * usage: policyReload [repetitions] [--json FILE]
+ */
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "lsst/pex/policy/Policy.h"
+#include "lsst/pex/policy/SharedPolicy.h"
+#include "Benchmark.h"
+
+using namespace std;
+using lsst::pex::policy::Policy;
+using lsst::pex::policy::SharedPolicy;
+
+// where read results are sent, so that the reads are not optimized away
+volatile long sink;
+
+// a version of the configuration
+Policy version(int n) {
+    Policy p;
+    for (int i = 0; i < 20; ++i) {
+        string block = "stage" + to_string(i);
+        p.set(block + ".output.verbosity", n % 5);
+        p.set(block + ".output.format", "fits");
+        p.set(block + ".threshold", 0.5 * n);
+    }
+    return p;
+}
+
+// run read() in each of n threads while publish(n) is called every
+// millisecond, recording the wall time taken
+template <typename Read, typename Publish>
+void timeReload(Benchmark& bench, const string& name, int nthreads, long items, Read read, Publish publish) {
+    atomic<bool> done(false);
+    long reloads = 0;
+    vector<long> sums(nthreads, 0);
+    vector<thread> threads;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    thread reloader([&]() {
+        while (! done.load()) {
+            this_thread::sleep_for(chrono::milliseconds(1));
+            publish(int(++reloads));
+        }
+    });
+    for (int t = 0; t < nthreads; ++t) threads.push_back(thread([&sums, &read, t]() { sums[t] = read(); }));
+    for (int t = 0; t < nthreads; ++t) threads[t].join();
+    chrono::duration<double> secs = chrono::steady_clock::now() - start;
+    done.store(true);
+    reloader.join();
+
+    long total = 0;
+    for (int t = 0; t < nthreads; ++t) total += sums[t];
+    sink = total;
+    bench.record(name, 1, secs.count(), 0, items);
+    bench.record(name + ".reloads", 1, secs.count(), 0, reloads);
+}
+
+int main(int argc, char** argv) {
+    Benchmark bench("policyReload", argc, argv, 100);
+    const long reads = long(bench.getReps()) * 10000;
+    const string verbosity("stage7.output.verbosity"), threshold("stage7.threshold");
+
+    // the versions published, made beforehand so that only publishing is timed
+    vector<Policy::Ptr> versions;
+    for (int n = 0; n < 16; ++n) versions.push_back(Policy::Ptr(new Policy(version(n))));
+
+    const int counts[] = { 1, 8, 64 };
+    for (int c = 0; c < 3; ++c) {
+        int nthreads = counts[c];
+        long each = reads / nthreads;
+        long items = each * nthreads;
+        bench.section("threads" + to_string(nthreads),
+                      to_string(nthreads) + " threads, " + to_string(items) + " reads");
+
+        SharedPolicy shared(*versions[0]);
+        timeReload(bench, "sharedPolicy", nthreads, items,
+                   [&]() {
+                       long sum = 0;
+                       for (long r = 0; r < each; ++r) {
+                           SharedPolicy::Snapshot snap = shared.read();
+                           sum += snap->getInt(verbosity) + long(snap->getDouble(threshold));
+                       }
+                       return sum;
+                   },
+                   [&](int n) { shared.publish(*versions[n % versions.size()]); });
+
+        mutex guard;
+        Policy::ConstPtr current(new Policy(*versions[0]));
+        timeReload(bench, "mutex", nthreads, items,
+                   [&]() {
+                       long sum = 0;
+                       for (long r = 0; r < each; ++r) {
+                           Policy::ConstPtr p;
+                           {
+                               lock_guard<mutex> lock(guard);
+                               p = current;
+                           }
+                           sum += p->getInt(verbosity) + long(p->getDouble(threshold));
+                       }
+                       return sum;
+                   },
+                   [&](int n) {
+                       const Policy& next = *versions[n % versions.size()];
+                       Policy::ConstPtr p(new Policy(next));
+                       lock_guard<mutex> lock(guard);
+                       current = p;
+                   });
+    }
+    return bench.finish();
+}
@@ -0,0 +1,245 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file policyStorage.cc
+ *
+ * Compare Policy's flat storage with the PropertySet it used to wrap, on
+ * generated policies with 10^5 or more parameters:  one level of integers
+ * and a hierarchy of blocks holding values of every type.  The PropertySet
+ * compared is the one returned by Policy::asPropertySet(), which holds the
+ * same data.  For each policy the program times looking up every
+ * parameter by name, in a scrambled order, and measures the heap memory
+ * each form holds.  Memory cases report the bytes held per parameter as
+ * their item count, and the time taken to fill in the data as their time.
+ * The copy cases time copying the Policy, which shares its data with the
+ * copy, and then changing one value of the copy.  The fingerprint cases
+ * time computing Policy::fingerprint() the first time, again, and after
+ * changing one value of a copy, against the toString() it replaces as a
+ * cache key.
+ *
+ * usage: policyStorage [repetitions] [--json FILE]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "lsst/pex/policy/Policy.h"
+#include "Benchmark.h"
+
+using namespace std;
+using lsst::pex::policy::Policy;
+using lsst::daf::base::PropertySet;
+
+// the bytes of heap memory allocated and not yet freed
+static size_t heapBytes = 0;
+
+void* operator new(size_t size) {
+    // keep the size ahead of the block, at an alignment good for any type
+    void* p = malloc(size + sizeof(max_align_t));
+    if (! p) throw bad_alloc();
+    *static_cast<size_t*>(p) = size;
+    heapBytes += size;
+    return static_cast<char*>(p) + sizeof(max_align_t);
+}
+
+void operator delete(void* p) noexcept {
+    if (! p) return;
+    // (an integer, so that the compiler does not track the block's bounds)
+    uintptr_t block = reinterpret_cast<uintptr_t>(p) - sizeof(max_align_t);
+    heapBytes -= *reinterpret_cast<size_t*>(block);
+    free(reinterpret_cast<void*>(block));
+}
+
+void operator delete(void* p, size_t) noexcept { operator delete(p); }
+
+volatile double sink;
+
+string key(const string& prefix, int i) {
+    ostringstream out;
+    out << prefix << i;
+    return out.str();
+}
+
+// the names of a single level of integers
+vector<string> flat(int n) {
+    vector<string> names;
+    for (int i = 0; i < n; ++i) names.push_back(key("param", i));
+    return names;
+}
+
+// the names of blocks of values of every type, each with a nested block
+vector<string> nested(int n) {
+    vector<string> names;
+    for (int b = 0; b < n / 80; ++b) {
+        string block = key("stage", b) + ".";
+        for (int i = 0; i < 20; ++i) {
+            names.push_back(block + key("count", i));
+            names.push_back(block + key("scale", i));
+            names.push_back(block + key("label", i));
+            names.push_back(block + key("output.enabled", i));
+        }
+    }
+    return names;
+}
+
+// set a value for each name, of a type given by the name's last field
+void fill(Policy& p, const vector<string>& names) {
+    for (size_t i = 0; i < names.size(); ++i) {
+        const string& name = names[i];
+        switch (name[name.rfind('.') + 1]) {
+            case 's':
+                p.set(name, i + 0.25);
+                break;
+            case 'l':
+                p.set(name, "a somewhat longer label value " + name);
+                break;
+            case 'e':
+                p.set(name, i % 2 == 0);
+                break;
+            default:
+                p.set(name, int(i));
+        }
+    }
+}
+
+long lookupPolicy(const Policy& p, const vector<string>& names) {
+    double sum = 0;
+    for (vector<string>::const_iterator it = names.begin(); it != names.end(); ++it)
+        sum += p.valueCount(*it) + p.exists(*it);
+    sink = sum;
+    return names.size();
+}
+
+long lookupPropertySet(const PropertySet& ps, const vector<string>& names) {
+    double sum = 0;
+    for (vector<string>::const_iterator it = names.begin(); it != names.end(); ++it)
+        sum += ps.valueCount(*it) + ps.exists(*it);
+    sink = sum;
+    return names.size();
+}
+
+long getPolicy(const Policy& p, const vector<string>& ints) {
+    long sum = 0;
+    for (vector<string>::const_iterator it = ints.begin(); it != ints.end(); ++it) sum += p.getInt(*it);
+    sink = sum;
+    return ints.size();
+}
+
+long getPropertySet(const PropertySet& ps, const vector<string>& ints) {
+    long sum = 0;
+    for (vector<string>::const_iterator it = ints.begin(); it != ints.end(); ++it)
+        sum += ps.get<int>(*it);
+    sink = sum;
+    return ints.size();
+}
+
+void compare(Benchmark& bench, const string& name, const string& about, const vector<string>& all,
+             int reps) {
+    bench.section(name, about);
+
+    // fill a policy once first, so that the names are already interned
+    {
+        Policy warm;
+        fill(warm, all);
+    }
+
+    size_t before = heapBytes;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    Policy p;
+    fill(p, all);
+    chrono::duration<double> policySecs = chrono::steady_clock::now() - start;
+    size_t policyBytes = heapBytes - before;
+
+    before = heapBytes;
+    start = chrono::steady_clock::now();
+    PropertySet::Ptr ps = p.asPropertySet();
+    chrono::duration<double> psSecs = chrono::steady_clock::now() - start;
+    size_t psBytes = heapBytes - before;
+
+    bench.record("memory.flat", 1, policySecs.count(), 0, policyBytes / all.size());
+    bench.record("memory.propertyset", 1, psSecs.count(), 0, psBytes / all.size());
+
+    vector<string> names(all), ints;
+    for (vector<string>::const_iterator it = names.begin(); it != names.end(); ++it)
+        if (p.isInt(*it)) ints.push_back(*it);
+    mt19937 random(12345);
+    shuffle(names.begin(), names.end(), random);
+    shuffle(ints.begin(), ints.end(), random);
+
+    bench.time("lookup.flat", reps, 0, [&]() { return lookupPolicy(p, names); });
+    bench.time("lookup.propertyset", reps, 0, [&]() { return lookupPropertySet(*ps, names); });
+    bench.time("getInt.flat", reps, 0, [&]() { return getPolicy(p, ints); });
+    bench.time("getInt.propertyset", reps, 0, [&]() { return getPropertySet(*ps, ints); });
+
+    const Policy& original = p;
+    const string& changed = ints.front();
+    bench.time("copy", reps, 0, [&]() {
+        Policy copy(original);
+        sink = copy.valueCount(changed);
+        return 1L;
+    });
+    bench.time("copy.change", reps, 0, [&]() {
+        Policy copy(original);
+        copy.set(changed, 1);
+        sink = copy.getInt(changed);
+        return 1L;
+    });
+
+    start = chrono::steady_clock::now();
+    sink = double(p.fingerprint().getLow());
+    chrono::duration<double> coldSecs = chrono::steady_clock::now() - start;
+    bench.record("fingerprint.cold", 1, coldSecs.count(), 0, all.size());
+    bench.time("fingerprint", reps, 0, [&]() {
+        sink = double(original.fingerprint().getLow());
+        return 1L;
+    });
+    bench.time("fingerprint.change", reps, 0, [&]() {
+        Policy copy(original);
+        copy.set(changed, 1);
+        sink = double(copy.fingerprint().getLow());
+        return 1L;
+    });
+    bench.time("toString", reps, 0, [&]() {
+        sink = double(original.toString().size());
+        return 1L;
+    });
+}
+
+int main(int argc, char** argv) {
+    Benchmark bench("policyStorage", argc, argv, 10);
+    int reps = bench.getReps();
+
+    compare(bench, "flat", "one level of 100000 integers:", flat(100000), reps);
+    compare(bench, "nested", "2000 blocks of 80 values of every type (160000 values):", nested(160000),
+            reps);
+
+    return bench.finish();
+}
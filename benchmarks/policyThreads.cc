@@ -0,0 +1,108 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file policyThreads.cc
+ *
+ * Time many threads reading one Policy at once, descending into its
+ * sub-policies either with getPolicy(), which allocates a Policy and
+ * counts references to the shared sub-policy on every call, or with
+ * getPolicyRef(), which does neither.  Each case runs the same lookups,
+ * split among a given number of threads, and reports the lookups made
+ * across all threads; its time is the wall time for all threads to finish.
+ *
+ * usage: policyThreads [repetitions] [--json FILE]
+ */
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "lsst/pex/policy/Policy.h"
+#include "lsst/pex/policy/PolicyRef.h"
+#include "Benchmark.h"
+
+using namespace std;
+using lsst::pex::policy::ConstPolicyRef;
+using lsst::pex::policy::Policy;
+
+// where lookup results are sent, so that the lookups are not optimized away
+volatile long sink;
+
+// run lookups(t) in each of n threads, recording the wall time taken
+template <typename Lookups>
+void timeThreads(Benchmark& bench, const string& name, int nthreads, long items, Lookups lookups) {
+    vector<long> sums(nthreads, 0);
+    vector<thread> threads;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int t = 0; t < nthreads; ++t) threads.push_back(thread([&sums, &lookups, t]() { sums[t] = lookups(); }));
+    for (int t = 0; t < nthreads; ++t) threads[t].join();
+    chrono::duration<double> secs = chrono::steady_clock::now() - start;
+
+    long total = 0;
+    for (int t = 0; t < nthreads; ++t) total += sums[t];
+    sink = total;
+    bench.record(name, 1, secs.count(), 0, items);
+}
+
+int main(int argc, char** argv) {
+    Benchmark bench("policyThreads", argc, argv, 200);
+    const int nblocks = 100;
+    const long lookups = long(bench.getReps()) * 10000;
+
+    // every thread reads the same few sub-policies, so that their
+    // reference counts are shared
+    Policy p;
+    vector<string> blocks;
+    for (int i = 0; i < nblocks; ++i) {
+        blocks.push_back("block" + to_string(i));
+        p.set(blocks.back() + ".output.verbosity", i % 5);
+        p.set(blocks.back() + ".output.format", "fits");
+    }
+    const Policy& reader = p;
+
+    const int counts[] = { 1, 2, 4, 8, 16, 32, 64 };
+    for (int c = 0; c < 7; ++c) {
+        int nthreads = counts[c];
+        long each = lookups / nthreads / nblocks;
+        long items = each * nblocks * nthreads;
+        bench.section("threads" + to_string(nthreads),
+                      to_string(nthreads) + " threads, " + to_string(items) + " lookups");
+
+        timeThreads(bench, "getPolicy", nthreads, items, [&]() {
+            long sum = 0;
+            for (long r = 0; r < each; ++r)
+                for (int i = 0; i < nblocks; ++i)
+                    sum += reader.getPolicy(blocks[i])->getPolicy("output")->getInt("verbosity");
+            return sum;
+        });
+        timeThreads(bench, "getPolicyRef", nthreads, items, [&]() {
+            long sum = 0;
+            for (long r = 0; r < each; ++r)
+                for (int i = 0; i < nblocks; ++i)
+                    sum += reader.getPolicyRef(blocks[i]).getPolicy("output").getInt("verbosity");
+            return sum;
+        });
+    }
+    return bench.finish();
+}
@@ -0,0 +1,91 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file structuralIndex.cc
+ *
+ * Measure how fast a paf::StructuralIndex can be built with each
+ * instruction set supported by this CPU.  The input is the PAF files in
+ * examples/ and tests/dictionary, repeated to fill an 8 MB buffer.
+ *
+ * usage: structuralIndex [repetitions] [--json FILE]
+ */
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "boost/filesystem.hpp"
+
+#include "lsst/utils/Utils.h"
+#include "lsst/pex/policy/paf/StructuralIndex.h"
+#include "Benchmark.h"
+
+using namespace std;
+using lsst::pex::policy::paf::StructuralIndex;
+namespace fs = boost::filesystem;
+
+int main(int argc, char** argv) {
+    Benchmark bench("structuralIndex", argc, argv, 50);
+    int reps = bench.getReps();
+    fs::path root(lsst::utils::getPackageDir("pex_policy"));
+
+    string corpus;
+    for (const char* dir : {"examples", "tests/dictionary"}) {
+        for (fs::directory_iterator it(root / dir), end; it != end; ++it) {
+            if (it->path().extension() != ".paf") continue;
+            ifstream in(it->path().string().c_str());
+            ostringstream data;
+            data << in.rdbuf();
+            corpus += data.str();
+        }
+    }
+    string buffer;
+    while (buffer.size() < (8u << 20)) buffer += corpus;
+
+    StructuralIndex reference(StructuralIndex::SCALAR);
+    reference.build(buffer.data(), buffer.size());
+
+    bench.section("build", to_string(buffer.size()) + " bytes, " +
+                  to_string(reference.getOffsets().size()) + " structural characters");
+
+    for (int i = StructuralIndex::SCALAR; i <= StructuralIndex::AVX2; ++i) {
+        StructuralIndex::Isa isa = StructuralIndex::Isa(i);
+        if (!StructuralIndex::supports(isa)) {
+            cout << "  " << StructuralIndex::isaName(isa) << ": not supported" << endl;
+            continue;
+        }
+
+        StructuralIndex index(isa);
+        bench.time(StructuralIndex::isaName(isa), reps, buffer.size(), [&]() {
+            index.build(buffer.data(), buffer.size());
+            return long(index.getOffsets().size());
+        });
+
+        if (index.getOffsets() != reference.getOffsets()) {
+            cerr << StructuralIndex::isaName(isa) << ": index differs from scalar result" << endl;
+            return 1;
+        }
+    }
+    return bench.finish();
+}
@@ -25,7 +25,14 @@
 
 #include "lsst/pex/policy/exceptions.h"
 #include "lsst/pex/policy/parserexceptions.h"
+#include "lsst/pex/policy/Fingerprint.h"
+#include "lsst/pex/policy/PolicyArena.h"
 #include "lsst/pex/policy/Policy.h"
+#include "lsst/pex/policy/PolicyRef.h"
+#include "lsst/pex/policy/FrozenPolicy.h"
+#include "lsst/pex/policy/PolicyDiff.h"
+#include "lsst/pex/policy/SharedPolicy.h"
+#include "lsst/pex/policy/PolicyWatcher.h"
 #include "lsst/pex/policy/Dictionary.h"
 #include "lsst/pex/policy/PolicyWriter.h"
 #include "lsst/pex/policy/PolicyString.h"
@@ -0,0 +1,96 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsstcorp.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file ArrayView.h
+ * @ingroup pex
+ * @brief a read-only view of an array of values held elsewhere
+ */
+
+#ifndef LSST_PEX_POLICY_ARRAYVIEW_H
+#define LSST_PEX_POLICY_ARRAYVIEW_H
+
+#include <cstddef>
+#include <vector>
+
+namespace lsst {
+namespace pex {
+namespace policy {
+
+/**
+ * @brief a read-only view of a contiguous array of values that it does
+ * not own.
+ *
+ * An ArrayView is what a Policy returns in place of a copy of its values.
+ * It is only a pair of pointers, so it is cheap to pass by value, but it
+ * is valid only as long as the values it refers to: the view returned by
+ * a Policy must not be used after that Policy has been modified or
+ * destroyed.  Copy the values out, e.g. into a std::vector, to keep them
+ * longer.
+ */
+template <typename T>
+class ArrayView {
+public:
+    typedef T value_type;
+    typedef const T& reference;
+    typedef const T& const_reference;
+    typedef const T* iterator;
+    typedef const T* const_iterator;
+    typedef std::size_t size_type;
+
+    /**
+     * create an empty view
+     */
+    ArrayView() : _begin(0), _end(0) {}
+
+    /**
+     * create a view of the values from begin up to end
+     */
+    ArrayView(const T* begin, const T* end) : _begin(begin), _end(end) {}
+
+    /**
+     * create a view of the values in a vector
+     */
+    ArrayView(const std::vector<T>& values) : _begin(values.data()), _end(values.data() + values.size()) {}
+
+    const_iterator begin() const { return _begin; }
+    const_iterator end() const { return _end; }
+    size_type size() const { return _end - _begin; }
+    bool empty() const { return _begin == _end; }
+    const T* data() const { return _begin; }
+
+    const T& operator[](size_type i) const { return _begin[i]; }
+    const T& front() const { return *_begin; }
+    const T& back() const { return *(_end - 1); }
+
+private:
+    const T* _begin;
+    const T* _end;
+};
+
+}  // namespace policy
+}  // namespace pex
+}  // namespace lsst
+
+#endif  // LSST_PEX_POLICY_ARRAYVIEW_H
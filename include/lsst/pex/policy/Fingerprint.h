@@ -0,0 +1,110 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsstcorp.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file Fingerprint.h
+ * @ingroup pex
+ * @brief a 128-bit hash of the contents of a policy
+ */
+
+#ifndef LSST_PEX_POLICY_FINGERPRINT_H
+#define LSST_PEX_POLICY_FINGERPRINT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace lsst {
+namespace pex {
+namespace policy {
+
+/**
+ * @brief a 128-bit hash of the names, types and values held by a policy,
+ * as returned by Policy::fingerprint().
+ *
+ * Policies holding the same values under the same names have the same
+ * Fingerprint, whatever order the names were added in, and a Fingerprint
+ * is the same from one run or process to the next, so it may be used as
+ * the key of a cache or stored with results derived from a policy.  It
+ * is not a cryptographic hash: policies built to collide can be found,
+ * but policies that differ by chance collide only with a probability of
+ * about 2^-128.
+ */
+class Fingerprint {
+public:
+    Fingerprint() : _high(0), _low(0) {}
+    Fingerprint(std::uint64_t high, std::uint64_t low) : _high(high), _low(low) {}
+
+    //@{
+    /**
+     * return the upper or lower 64 bits
+     */
+    std::uint64_t getHigh() const { return _high; }
+    std::uint64_t getLow() const { return _low; }
+    //@}
+
+    bool operator==(const Fingerprint& other) const { return _high == other._high && _low == other._low; }
+    bool operator!=(const Fingerprint& other) const { return ! (*this == other); }
+    bool operator<(const Fingerprint& other) const {
+        return _high < other._high || (_high == other._high && _low < other._low);
+    }
+
+    /**
+     * return the 32 hexadecimal digits of this fingerprint
+     */
+    std::string toString() const {
+        static const char digits[] = "0123456789abcdef";
+        std::string out(32, '0');
+        for (int i = 0; i < 16; ++i) {
+            out[15 - i] = digits[(_high >> (4 * i)) & 0xf];
+            out[31 - i] = digits[(_low >> (4 * i)) & 0xf];
+        }
+        return out;
+    }
+
+private:
+    std::uint64_t _high;
+    std::uint64_t _low;
+};
+
+}  // namespace policy
+}  // namespace pex
+}  // namespace lsst
+
+namespace std {
+
+/**
+ * hash a Fingerprint, so that it may key an unordered container
+ */
+template <>
+struct hash<lsst::pex::policy::Fingerprint> {
+    std::size_t operator()(const lsst::pex::policy::Fingerprint& fp) const {
+        return std::size_t(fp.getLow() ^ (fp.getHigh() >> 1));
+    }
+};
+
+}  // namespace std
+
+#endif  // LSST_PEX_POLICY_FINGERPRINT_H
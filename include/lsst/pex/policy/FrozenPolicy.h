@@ -0,0 +1,168 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsstcorp.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file FrozenPolicy.h
+ * @ingroup pex
+ * @brief an immutable snapshot of a Policy, laid out for fast reading
+ */
+
+#ifndef LSST_PEX_POLICY_FROZENPOLICY_H
+#define LSST_PEX_POLICY_FROZENPOLICY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "lsst/pex/policy/Policy.h"
+#include "lsst/pex/policy/PolicyRef.h"
+
+namespace lsst {
+namespace pex {
+namespace policy {
+
+/**
+ * @brief an immutable snapshot of the parameters of a Policy.
+ *
+ * A FrozenPolicy is made by Policy::freeze() and cannot be changed
+ * afterwards; later changes to the Policy it was made from are not seen
+ * in it.  Since nothing in it is ever modified, any number of threads may
+ * read one FrozenPolicy at once without locking.  Share it between them
+ * through its ConstPtr.
+ *
+ * Every parameter is indexed under its full hierarchical name by a
+ * perfect hash built over the names present when it was frozen, so a
+ * lookup hashes the name once and compares it with exactly one candidate,
+ * however deep the name is.  None of the functions returning a single
+ * value or a view allocate memory, save those throwing an exception.
+ * A hierarchical name reaches into the last sub-policy of each field, as
+ * with Policy; the functions behave as the Policy functions of the same
+ * names, including the exceptions they throw.
+ */
+class FrozenPolicy {
+public:
+    typedef std::shared_ptr<const FrozenPolicy> ConstPtr;
+
+    /**
+     * take a snapshot of a Policy.  Policy::freeze() is the usual way to
+     * make one.
+     */
+    explicit FrozenPolicy(const Policy& policy);
+
+    FrozenPolicy(const FrozenPolicy&) = delete;
+    FrozenPolicy& operator=(const FrozenPolicy&) = delete;
+
+    /**
+     * return the number of names held, counting those within sub-policies
+     */
+    std::size_t size() const { return _entries.size() - 1; }
+
+    /**
+     * return all the names held, in the order Policy::names() gives them
+     */
+    Policy::StringArray names() const;
+
+    //@{
+    /**
+     * query the parameters held; see the Policy functions of the same names
+     */
+    bool exists(const std::string& name) const { return _find(name).count != 0; }
+    std::size_t valueCount(const std::string& name) const { return _find(name).count; }
+    bool isArray(const std::string& name) const { return _find(name).count > 1; }
+    Policy::ValueType getValueType(const std::string& name) const {
+        return Policy::ValueType(_find(name).type);
+    }
+    //@}
+
+    //@{
+    /**
+     * return the last value of the given name
+     * @exception NameNotFound  if no value is associated with the given name.
+     * @exception TypeError     if the value is not of the requested type.
+     */
+    bool getBool(const std::string& name) const;
+    int getInt(const std::string& name) const;
+    double getDouble(const std::string& name) const;
+    const std::string& getString(const std::string& name) const;
+    Policy::FilePtr getFile(const std::string& name) const;
+    ConstPolicyRef getPolicy(const std::string& name) const;
+    //@}
+
+    //@{
+    /**
+     * return all the values of the given name.  The views remain valid as
+     * long as this FrozenPolicy.
+     * @exception NameNotFound  if no value is associated with the given name.
+     * @exception TypeError     if the values are not of the requested type.
+     */
+    Policy::BoolArray getBoolArray(const std::string& name) const;
+    Policy::IntArrayView getIntArrayView(const std::string& name) const;
+    Policy::DoubleArrayView getDoubleArrayView(const std::string& name) const;
+    Policy::StringArrayView getStringArrayView(const std::string& name) const;
+    PolicyArrayView getPolicyArrayView(const std::string& name) const;
+    //@}
+
+    /**
+     * return a new, modifiable Policy holding a copy of the parameters
+     */
+    Policy::Ptr thaw() const;
+
+    /**
+     * return the fingerprint of the parameters, as Policy::fingerprint()
+     * does; it is computed only the first time.
+     */
+    Fingerprint fingerprint() const;
+
+private:
+    // a parameter under its full name; the last entry matches no name
+    struct Entry {
+        std::uint64_t hash;
+        const char* name;
+        std::size_t size;
+        const void* values;
+        std::uint32_t type;
+        std::uint32_t count;
+    };
+
+    const Entry& _find(const std::string& name) const;
+    const Entry& _require(const std::string& name, Policy::ValueType type) const;
+    void _build();
+
+    detail::PolicyData::Ptr _data;         // never modified
+    std::vector<char> _names;              // the full names, end to end
+    std::vector<Entry> _entries;           // in the order of names()
+    std::vector<std::uint32_t> _displace;  // per bucket of hashes
+    std::vector<std::uint32_t> _slots;     // entry number of each slot
+    std::uint64_t _seed;
+    std::uint64_t _bucketMask;
+    std::uint64_t _slotMask;
+};
+
+}  // namespace policy
+}  // namespace pex
+}  // namespace lsst
+
+#endif  // LSST_PEX_POLICY_FROZENPOLICY_H
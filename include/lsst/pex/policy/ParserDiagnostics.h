@@ -0,0 +1,173 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file ParserDiagnostics.h
+ * @ingroup pex
+ * @brief the definition of the ParserDiagnostics class
+ */
+
+#ifndef LSST_PEX_POLICY_PARSERDIAGNOSTICS_H
+#define LSST_PEX_POLICY_PARSERDIAGNOSTICS_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace lsst {
+namespace pex {
+namespace policy {
+
+/**
+ * @brief a collector of the problems a PolicyParser finds in its input.
+ *
+ * When a ParserDiagnostics is given to a parser with
+ * PolicyParser::setDiagnostics(), the parser records each problem that
+ * strict mode would throw an exception for, skips the offending text as
+ * it would in non-strict mode, and carries on.  A single parse thus
+ * reports every problem in the data.  Each problem is kept as its
+ * location, its kind and a short excerpt of the offending text; the full
+ * message is only formatted on request.
+ */
+class ParserDiagnostics {
+public:
+    /**
+     * the kinds of problem a parser can report
+     */
+    enum Kind {
+        BAD_NAME = 0,         ///< a line not of the form "name: value"
+        EXPECTED_DOUBLE,      ///< a non-number following doubles
+        EXPECTED_INT,         ///< a non-integer following integers
+        EXPECTED_BOOL,        ///< a non-boolean following booleans
+        EXPECTED_STRING,      ///< an unquoted value following quoted strings
+        UNSUPPORTED_LONG,     ///< an integer too large for an int
+        EXTRA_BRACE,          ///< a "}" with no sub-policy open
+        UNTERMINATED_STRING,  ///< data ending inside a quoted string
+        UNEXPECTED_EOF,       ///< a multi-line string closed on the last,
+                              ///<   unterminated line
+        READ_ERROR,           ///< failure reading the input
+        REJECTED_VALUE,       ///< a value that could not be stored, e.g.
+                              ///<   one of a different type than earlier
+                              ///<   values of the parameter
+        SYNTAX_ERROR,         ///< text that breaks the structure of the
+                              ///<   data, e.g. a missing "," in JSON
+        UNSUPPORTED_ARRAY     ///< an array nested within an array
+    };
+
+    /**
+     * a problem found in the data
+     */
+    struct Problem {
+        int line;             ///< the line number, starting at 1
+        int column;           ///< the column, starting at 1, or 0 if unknown
+        Kind kind;            ///< what went wrong
+        std::string excerpt;  ///< the start of the offending text
+
+        /**
+         * return a message describing the problem, as it would appear in
+         * the exception thrown in strict mode (without the location)
+         */
+        std::string getMessage() const;
+    };
+
+    /**
+     * the longest excerpt of offending text that is kept
+     */
+    static const std::size_t EXCERPT_MAX;
+
+    /**
+     * create an empty collector
+     * @param cap        the most problems to keep; further problems are
+     *                     only counted.  The default is 100.
+     * @param failFast   the number of problems after which the parser
+     *                     should give up on the data; 0 (the default)
+     *                     means never.
+     */
+    explicit ParserDiagnostics(std::size_t cap = 100, std::size_t failFast = 0);
+
+    /**
+     * record a problem.  Returns true if the parser should go on, or
+     * false if the fail-fast threshold has been reached.
+     * @param line     the line number the problem was found on
+     * @param column   the column of the offending text, or 0 if unknown
+     * @param kind     the kind of problem
+     * @param b        the start of the offending text
+     * @param e        the end of the offending text
+     */
+    bool report(int line, int column, Kind kind, const char* b = 0, const char* e = 0);
+
+    /**
+     * return the problems kept, in the order they were found
+     */
+    const std::vector<Problem>& getProblems() const { return _problems; }
+
+    /**
+     * return the number of problems reported, including those beyond the
+     * cap that were not kept
+     */
+    std::size_t getCount() const { return _count; }
+
+    /**
+     * return true if the fail-fast threshold was reached
+     */
+    bool failed() const { return _failFast > 0 && _count >= _failFast; }
+
+    //@{
+    /**
+     * the most problems to keep
+     */
+    std::size_t getCap() const { return _cap; }
+    void setCap(std::size_t cap) { _cap = cap; }
+    //@}
+
+    //@{
+    /**
+     * the number of problems after which parsing should stop; 0 means never
+     */
+    std::size_t getFailFast() const { return _failFast; }
+    void setFailFast(std::size_t failFast) { _failFast = failFast; }
+    //@}
+
+    /**
+     * forget all problems reported so far, e.g. before the next file
+     */
+    void clear();
+
+    /**
+     * return the text that starts the message for a kind of problem
+     */
+    static const char* describe(Kind kind);
+
+private:
+    std::vector<Problem> _problems;
+    std::size_t _count;
+    std::size_t _cap;
+    std::size_t _failFast;
+};
+
+}  // namespace policy
+}  // namespace pex
+}  // namespace lsst
+
+#endif  // LSST_PEX_POLICY_PARSERDIAGNOSTICS_H
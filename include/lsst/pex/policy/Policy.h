@@ -37,6 +37,11 @@
 #include "lsst/daf/base/Persistable.h"
 #include "lsst/daf/base/PropertySet.h"
 #include "lsst/pex/policy/exceptions.h"
+#include "lsst/pex/policy/ArrayView.h"
+#include "lsst/pex/policy/Fingerprint.h"
+#include "lsst/pex/policy/PolicyArena.h"
+#include "lsst/pex/policy/PolicyKey.h"
+#include "lsst/pex/policy/detail/PolicyData.h"
 
 namespace lsst {
 namespace pex {
@@ -47,6 +52,11 @@ class PolicySource;
 class PolicyFile;
 class Dictionary;
 class ValidationError;
+class ConstPolicyRef;
+class PolicyRef;
+class PolicyArrayView;
+class FrozenPolicy;
+class PolicyDiff;
 
 #define POL_GETSCALAR(name, type, vtype)                                  \
     try {                                                                 \
@@ -70,6 +80,15 @@ class ValidationError;
         throw LSST_EXCEPT(TypeError, name, std::string(typeName[vtype])); \
     }
 
+#define POL_GETVIEW(name, type, vtype)                                    \
+    try {                                                                 \
+        return _data->getView<type>(name);                                \
+    } catch (lsst::pex::exceptions::NotFoundError&) {                     \
+        throw LSST_EXCEPT(NameNotFound, name);                            \
+    } catch (lsst::pex::exceptions::TypeError&) {                         \
+        throw LSST_EXCEPT(TypeError, name, std::string(typeName[vtype])); \
+    }
+
 /**
  * @brief  a container for holding hierarchical configuration data in memory.
  *
@@ -150,7 +169,14 @@ class ValidationError;
  *
  * \section secPolicyVer Version Notes
  *
- * With version 3.1, support for the JSON format was dropped.
+ * With version 3.1, support for the JSON format was dropped.  It has since
+ * been restored with a new parser (see json::JSONParser); JSON data is
+ * recognized by a ".json" file extension, a leading "{", or a
+ * "#<?cfg JSON ?>" content identifier.  XML data can also be loaded (see
+ * xml::XMLParser); it is recognized by a ".xml" extension or a leading "<".
+ * A loaded Policy may be saved in a compiled form (see binary::BinaryWriter)
+ * that loads without text parsing; compiled data is recognized by a
+ * ".pafc" extension or its "#<?cfg BINARY ?>" content identifier.
  *
  * After version 3.2, Policy's internal implementation was changed to be
  * a wrapper around PropertySet.  Prior to this, it used its own internal
@@ -163,6 +189,14 @@ class ValidationError;
  *
  * After 3.3.3, loading default data (including from Dictionarys) was
  * improved.  This included adding mergeDefaults()
+ *
+ * Policy has since stopped using PropertySet to hold its data, in favor
+ * of a flat store that keeps each level's values in contiguous arrays by
+ * type and finds names through a hash index (see detail::PolicyData).
+ * asPropertySet(), which returned the PropertySet itself, now returns
+ * a copy (also available as toPropertySet()); typeOf() reports
+ * sub-policies and files as PropertySet did.  names() lists names in the
+ * order in which they were first set.
  */
 class Policy : public lsst::daf::base::Persistable {
 public:
@@ -179,6 +213,9 @@ public:
     typedef std::vector<Ptr> PolicyPtrArray;
     typedef std::vector<FilePtr> FilePtrArray;
     typedef std::vector<ConstPtr> ConstPolicyPtrArray;
+    typedef ArrayView<int> IntArrayView;
+    typedef ArrayView<double> DoubleArrayView;
+    typedef ArrayView<std::string> StringArrayView;
 
     /**
      * an enumeration for the supported policy types
@@ -197,6 +234,13 @@ public:
      */
     Policy();
 
+    /**
+     * Create an empty policy whose storage, and that of the sub-policies
+     * added to it by name or by a parser, is taken from an arena; see
+     * PolicyArena.  If the arena is null, the heap is used.
+     */
+    explicit Policy(const PolicyArena::Ptr& arena);
+
     //@{
     /**
      * Create a Policy from a named file or URN of the form
@@ -238,10 +282,22 @@ public:
     Policy(Policy& pol, bool deep = false);
 
     /**
-     * deep-copy a Policy.
+     * deep-copy a Policy.  The sub-policies are shared with pol until
+     * either is changed, except those that a sub-policy returned by
+     * getPolicy() or the like has been taken from, so copying a Policy
+     * takes constant time until such references are taken.  Any number
+     * of threads may copy pol and call its const functions at once.
      */
     Policy(const Policy& pol);
 
+    /**
+     * replace the contents of this Policy with a deep copy of pol's, made
+     * as the copy constructor makes one, and use pol's Dictionary.
+     * Sub-policies obtained from this Policy before the assignment go on
+     * referring to its old contents.
+     */
+    Policy& operator=(const Policy& pol);
+
     //@{
     /**
      * create a Policy from a file.  The caller is responsible for deleting
@@ -391,6 +447,12 @@ public:
      */
     bool isDictionary() const { return exists("definitions"); }
 
+    /**
+     * return the arena this policy's storage is taken from, or null if it
+     * uses the heap
+     */
+    PolicyArena::Ptr getArena() const { return _data->getArena(); }
+
     /**
      * Can this policy validate itself -- that is, does it have a dictionary
      * that it can use to validate itself?  If true, then set() and add()
@@ -539,10 +601,27 @@ public:
      * @exception TypeError     if the value associated the given name is not
      *                             a Policy type.
      */
-    ConstPtr getPolicy(const std::string& name) const;  // inlined below
+    ConstPtr getPolicy(const std::string& name) const;
     Ptr getPolicy(const std::string& name);             // inlined below
     //@}
 
+    //@{
+    /**
+     * return a reference to a "sub-Policy" identified by a given name.
+     * Unlike getPolicy(), this allocates nothing and changes no reference
+     * counts, but the reference is valid only as long as this Policy and
+     * only until the sub-policy is removed or replaced.  ConstPolicyRef and
+     * PolicyRef are defined in PolicyRef.h.
+     * @param name     the name of the parameter.  This can be a hierarchical
+     *                    name with fields delimited with "."
+     * @exception NameNotFound  if no value is associated with the given name.
+     * @exception TypeError     if the value associated the given name is not
+     *                             a Policy type.
+     */
+    ConstPolicyRef getPolicyRef(const std::string& name) const;
+    PolicyRef getPolicyRef(const std::string& name);
+    //@}
+
     /**
      * return a PolicyFile (a reference to a file with "sub-Policy" data)
      * identified by a given name.
@@ -615,6 +694,7 @@ public:
      * @exception TypeError     if the value associated the given name is not
      *                             a Policy type.
      */
+    PolicyPtrArray getPolicyArray(const std::string& name);
     PolicyPtrArray getPolicyArray(const std::string& name) const;
     ConstPolicyPtrArray getConstPolicyArray(const std::string& name) const;
     //@}
@@ -649,6 +729,38 @@ public:
     StringArray getStringArray(const std::string& name) const;  // inlined
     //@}
 
+    //@{
+    /**
+     * return a view of the array of values associated with the given name,
+     * without copying them.  The view is valid only until the Policy
+     * holding the values is next modified; see ArrayView.  Bool values
+     * have no view, as they are not stored as an array of bool.
+     * @param name     the name of the parameter.  This can be a hierarchical
+     *                    name with fields delimited with "."
+     * @exception NameNotFound  if no value is associated with the given name.
+     * @exception TypeError     if the value associated the given name is not
+     *                          the expected type.
+     */
+    IntArrayView getIntArrayView(const std::string& name) const { POL_GETVIEW(name, int, INT) }
+    DoubleArrayView getDoubleArrayView(const std::string& name) const { POL_GETVIEW(name, double, DOUBLE) }
+    StringArrayView getStringArrayView(const std::string& name) const {
+        POL_GETVIEW(name, std::string, STRING)
+    }
+    //@}
+
+    /**
+     * return a view of the sub-policies associated with the given name,
+     * whose elements are ConstPolicyRefs.  Unlike getConstPolicyArray(),
+     * this allocates nothing.  The view is valid only until this Policy is
+     * next modified.  PolicyArrayView is defined in PolicyRef.h.
+     * @param name     the name of the parameter.  This can be a hierarchical
+     *                    name with fields delimited with "."
+     * @exception NameNotFound  if no value is associated with the given name.
+     * @exception TypeError     if the value associated the given name is not
+     *                             a Policy type.
+     */
+    PolicyArrayView getPolicyArrayView(const std::string& name) const;
+
     //@{
     /**
      * Set a value with the given name.
@@ -724,6 +836,25 @@ public:
     void add(const std::string& name, const char* value);         // inlined below
     //@}
 
+    //@{
+    /**
+     * append a sequence of values to the array associated with the given
+     * name.  This is equivalent to calling add() on each value in turn,
+     * and the same checks are applied, but the name is only looked up
+     * once.  Nothing is done if values is empty.
+     * @param name       the name of the parameter.  This can be a hierarchical
+     *                    name with fields delimited with "."
+     * @param values     the values to append
+     * @exception TypeError  if the existing array of values is not of the
+     *                    requested type, or
+     *                    if this Policy is controlled by a Dictionary but
+     *                    the value type does not match the definition
+     *                    associated with the name.
+     */
+    void add(const std::string& name, const IntArray& values);     // inlined below
+    void add(const std::string& name, const DoubleArray& values);  // inlined below
+    //@}
+
     /**
      * Remove all values with a given name.
      * @param name The name of the parameter to remove. Can be hierarchical
@@ -731,6 +862,70 @@ public:
      */
     void remove(const std::string& name);  // inlined below
 
+    //@{
+    /**
+     * the functions above, taking a PolicyKey in place of a name.  These
+     * behave the same but do not split or hash the name again, and so are
+     * faster for names that are looked up repeatedly.
+     */
+    size_t valueCount(const PolicyKey& key) const { return _data->valueCount(key); }
+    bool isArray(const PolicyKey& key) const { return _data->isArray(key); }
+    bool exists(const PolicyKey& key) const { return _data->exists(key); }
+    bool isBool(const PolicyKey& key) const { return getValueType(key) == BOOL; }
+    bool isInt(const PolicyKey& key) const { return getValueType(key) == INT; }
+    bool isDouble(const PolicyKey& key) const { return getValueType(key) == DOUBLE; }
+    bool isString(const PolicyKey& key) const { return getValueType(key) == STRING; }
+    bool isPolicy(const PolicyKey& key) const { return getValueType(key) == POLICY; }
+    bool isFile(const PolicyKey& key) const { return getValueType(key) == FILE; }
+    ValueType getValueType(const PolicyKey& key) const { return ValueType(_data->valueType(key)); }
+
+    ConstPtr getPolicy(const PolicyKey& key) const;
+    Ptr getPolicy(const PolicyKey& key);             // inlined below
+    ConstPolicyRef getPolicyRef(const PolicyKey& key) const;
+    PolicyRef getPolicyRef(const PolicyKey& key);
+    FilePtr getFile(const PolicyKey& key) const;
+    bool getBool(const PolicyKey& key) const { POL_GETSCALAR(key, bool, BOOL) }
+    int getInt(const PolicyKey& key) const { POL_GETSCALAR(key, int, INT) }
+    double getDouble(const PolicyKey& key) const { POL_GETSCALAR(key, double, DOUBLE) }
+    const std::string getString(const PolicyKey& key) const { POL_GETSCALAR(key, std::string, STRING) }
+
+    PolicyPtrArray getPolicyArray(const PolicyKey& key);
+    PolicyPtrArray getPolicyArray(const PolicyKey& key) const;
+    ConstPolicyPtrArray getConstPolicyArray(const PolicyKey& key) const;
+    FilePtrArray getFileArray(const PolicyKey& key) const;
+    BoolArray getBoolArray(const PolicyKey& key) const { POL_GETLIST(key, bool, BOOL) }
+    IntArray getIntArray(const PolicyKey& key) const { POL_GETLIST(key, int, INT) }
+    DoubleArray getDoubleArray(const PolicyKey& key) const { POL_GETLIST(key, double, DOUBLE) }
+    StringArray getStringArray(const PolicyKey& key) const { POL_GETLIST(key, std::string, STRING) }
+    IntArrayView getIntArrayView(const PolicyKey& key) const { POL_GETVIEW(key, int, INT) }
+    DoubleArrayView getDoubleArrayView(const PolicyKey& key) const { POL_GETVIEW(key, double, DOUBLE) }
+    StringArrayView getStringArrayView(const PolicyKey& key) const { POL_GETVIEW(key, std::string, STRING) }
+    PolicyArrayView getPolicyArrayView(const PolicyKey& key) const;
+
+    void set(const PolicyKey& key, const Ptr& value);          // inlined below
+    void set(const PolicyKey& key, const FilePtr& value);
+    void set(const PolicyKey& key, bool value);                // inlined below
+    void set(const PolicyKey& key, int value);                 // inlined below
+    void set(const PolicyKey& key, double value);              // inlined below
+    void set(const PolicyKey& key, const std::string& value);  // inlined below
+    void set(const PolicyKey& key, const char* value);         // inlined below
+
+    void add(const PolicyKey& key, const Ptr& value);          // inlined below
+    void add(const PolicyKey& key, const FilePtr& value);
+    void add(const PolicyKey& key, bool value);                // inlined below
+    void add(const PolicyKey& key, int value);                 // inlined below
+    void add(const PolicyKey& key, double value);              // inlined below
+    void add(const PolicyKey& key, const std::string& value);  // inlined below
+    void add(const PolicyKey& key, const char* value);         // inlined below
+    void add(const PolicyKey& key, const IntArray& values);    // inlined below
+    void add(const PolicyKey& key, const DoubleArray& values); // inlined below
+
+    void remove(const PolicyKey& key) {
+        _detach();
+        _data->remove(key);
+    }
+    //@}
+
     /**
      * Recursively replace all PolicyFile values with the contents of the
      * files they refer to.  The type of a parameter containing a PolicyFile
@@ -805,22 +1000,84 @@ public:
     std::string toString() const;
 
     /**
-     * return the internal policy data as a PropertySet pointer.  All
-     * sub-policy data will appear as PropertySets.
+     * return the policy data as a PropertySet pointer.  All sub-policy
+     * data will appear as PropertySets.  Policy no longer holds its data
+     * in a PropertySet, so this is a copy:  later changes to either one
+     * are not seen by the other; use set() to change the policy.
+     */
+    lsst::daf::base::PropertySet::Ptr asPropertySet() const;  // inlined below
+
+    /**
+     * return a copy of the policy data as a PropertySet pointer.  This
+     * is the same as asPropertySet(), under a name that says it copies.
+     */
+    lsst::daf::base::PropertySet::Ptr toPropertySet() const;  // inlined below
+
+    /**
+     * return an immutable snapshot of this policy.  Any number of threads
+     * may read the snapshot at once without locking, and it finds values
+     * faster than a Policy does; later changes to this policy are not seen
+     * in it.  FrozenPolicy is defined in FrozenPolicy.h.
      */
-    lsst::daf::base::PropertySet::Ptr asPropertySet();  // inlined below
+    std::shared_ptr<const FrozenPolicy> freeze() const;
+
+    /**
+     * return the differences between this policy and another: the names
+     * added, removed or changed in other, with their values on each side.
+     * Both trees are walked once together, skipping the sub-policies they
+     * share, as copies of one another do.  PolicyDiff is defined in
+     * PolicyDiff.h.
+     */
+    PolicyDiff diff(const Policy& other) const;
+
+    /**
+     * make the changes in a PolicyDiff, so that each name it lists takes
+     * the values it has in the newer policy, or is removed.  As with
+     * changes made through a sub-policy, they are not validated against
+     * the Dictionary; call validate() afterwards if needed.
+     */
+    void apply(const PolicyDiff& patch);
+
+    /**
+     * return a 128-bit hash of the names, types and values held, for use
+     * as a cache key in place of toString().  Policies holding the same
+     * values have the same fingerprint, whatever order they were added
+     * in.  The fingerprint of each sub-policy is remembered until it is
+     * changed, so asking again costs next to nothing, and after a change
+     * only the sub-policies along the name changed are hashed again.
+     * The Dictionary is not included.
+     */
+    Fingerprint fingerprint() const;
 
 protected:
     /**
-     * use a PropertySet as the data for a new Policy object
+     * create a Policy holding a copy of the data in a PropertySet
      */
-    Policy(const lsst::daf::base::PropertySet::Ptr ps) : lsst::daf::base::Persistable(), _data(ps) {}
+    Policy(const lsst::daf::base::PropertySet::Ptr ps)
+            : lsst::daf::base::Persistable(), _data(detail::PolicyData::fromPropertySet(*ps)) {}
 
 private:
-    lsst::daf::base::PropertySet::Ptr _data;
+    friend class ConstPolicyRef;
+    friend class PolicyRef;
+    friend class FrozenPolicy;
+
+    // share the data of another Policy, such as a sub-policy
+    explicit Policy(const detail::PolicyData::Ptr& data) : lsst::daf::base::Persistable(), _data(data) {}
+
+    detail::PolicyData::Ptr _data;
 
     DictPtr _dictionary;
 
+    // views of sub-policies handed out while _data was shared with a copy,
+    // to be pinned before it is changed; see PolicyData::pinViews()
+    mutable detail::PolicyData::PendingViews _pending;
+
+    // copy the top level of the data before changing it, if it is shared
+    void _detach() {
+        detail::PolicyData::detach(_data);
+        if (! _pending.empty()) _data->pinViews(_pending);
+    }
+
     int _names(std::list<std::string>& names, bool topLevelOnly = false, bool append = false,
                int want = 3) const;
     int _names(std::vector<std::string>& names, bool topLevelOnly = false, bool append = false,
@@ -833,10 +1090,35 @@ private:
     template <typename T>
     void _validate(const std::string& name, const T& value, int curCount = 0);
 
-    std::vector<lsst::daf::base::Persistable::Ptr> _getPersistList(const std::string& name)
-            const {POL_GETLIST(name, Persistable::Ptr, FILE)} std::vector<
-                    lsst::daf::base::PropertySet::Ptr> _getPropSetList(const std::string& name) const {
-        POL_GETLIST(name, lsst::daf::base::PropertySet::Ptr, POLICY)
+    // implements set() and add() for a name or a PolicyKey
+    template <typename Name, typename T>
+    void _set(const Name& name, const T& value);
+    template <typename Name, typename T>
+    void _add(const Name& name, const T& value);
+    template <typename Name, typename T>
+    void _addAll(const Name& name, const std::vector<T>& values);
+
+    // implement the getters returning files and sub-policies
+    template <typename Name>
+    FilePtr _getFile(const Name& name) const;
+    template <typename Name>
+    FilePtrArray _getFileArray(const Name& name) const;
+    template <typename P, typename Name>
+    std::vector<std::shared_ptr<P> > _getViews(const Name& name, bool lastOnly) const;
+    template <typename P, typename Name>
+    std::vector<std::shared_ptr<P> > _getPolicyArray(const Name& name) const;
+    template <typename Name>
+    PolicyPtrArray _getPolicyArrayForUpdate(const Name& name);
+    template <typename Name>
+    ArrayView<detail::PolicyData::Ptr> _getPolicyView(const Name& name) const;
+
+    template <typename Name>
+    std::vector<lsst::daf::base::Persistable::Ptr> _getPersistList(const Name& name) const {
+        POL_GETLIST(name, Persistable::Ptr, FILE)
+    }
+    template <typename Name>
+    std::vector<detail::PolicyData::Ptr> _getPolicyDataList(const Name& name) const {
+        POL_GETLIST(name, detail::PolicyData::Ptr, POLICY)
     }
 
     static Policy* _createPolicy(PolicySource& input, bool doIncludes, const boost::filesystem::path& repos,
@@ -893,51 +1175,27 @@ inline bool Policy::isArray(const std::string& name) const { return _data->isArr
 inline bool Policy::exists(const std::string& name) const { return _data->exists(name); }
 
 inline bool Policy::isBool(const std::string& name) const {
-    try {
-        return (_data->typeOf(name) == typeid(bool));
-    } catch (...) {
-        return false;
-    }
+    return _data->valueType(name) == detail::PolicyData::BOOL;
 }
 
 inline bool Policy::isInt(const std::string& name) const {
-    try {
-        return (_data->typeOf(name) == typeid(int));
-    } catch (...) {
-        return false;
-    }
+    return _data->valueType(name) == detail::PolicyData::INT;
 }
 
 inline bool Policy::isDouble(const std::string& name) const {
-    try {
-        return (_data->typeOf(name) == typeid(double));
-    } catch (...) {
-        return false;
-    }
+    return _data->valueType(name) == detail::PolicyData::DOUBLE;
 }
 
 inline bool Policy::isString(const std::string& name) const {
-    try {
-        return (_data->typeOf(name) == typeid(std::string));
-    } catch (...) {
-        return false;
-    }
+    return _data->valueType(name) == detail::PolicyData::STRING;
 }
 
 inline bool Policy::isPolicy(const std::string& name) const {
-    try {
-        return _data->isPropertySetPtr(name);
-    } catch (...) {
-        return false;
-    }
+    return _data->valueType(name) == detail::PolicyData::POLICY;
 }
 
 inline bool Policy::isFile(const std::string& name) const {
-    try {
-        return (getValueType(name) == FILE);
-    } catch (...) {
-        return false;
-    }
+    return _data->valueType(name) == detail::PolicyData::FILE;
 }
 
 inline const std::type_info& Policy::getTypeInfo(const std::string& name) const {
@@ -950,11 +1208,14 @@ inline const std::type_info& Policy::getTypeInfo(const std::string& name) const
 
 inline const std::type_info& Policy::typeOf(const std::string& name) const { return getTypeInfo(name); }
 
-inline Policy::ConstPtr Policy::getPolicy(const std::string& name) const {
-    return ConstPtr(new Policy(_data->get<lsst::daf::base::PropertySet::Ptr>(name)));
-}
+// the sub-policies returned are pinned, so that they stay views of this one
 inline Policy::Ptr Policy::getPolicy(const std::string& name) {
-    return Ptr(new Policy(_data->get<lsst::daf::base::PropertySet::Ptr>(name)));
+    _detach();
+    return Ptr(new Policy(_data->pin(name)));
+}
+inline Policy::Ptr Policy::getPolicy(const PolicyKey& key) {
+    _detach();
+    return Ptr(new Policy(_data->pin(key)));
 }
 
 inline Policy::StringArray Policy::getStringArray(const std::string& name) const {
@@ -969,32 +1230,55 @@ inline Policy::DoubleArray Policy::getDoubleArray(const std::string& name) const
     POL_GETLIST(name, double, DOUBLE)
 }
 
-inline void Policy::set(const std::string& name, const Ptr& value) {
-    _validate(name, value);
-    _data->set(name, value->asPropertySet());
-}
-inline void Policy::set(const std::string& name, bool value) {
+template <typename Name, typename T>
+inline void Policy::_set(const Name& name, const T& value) {
     _validate(name, value);
+    _detach();
     _data->set(name, value);
 }
-inline void Policy::set(const std::string& name, int value) {
-    _validate(name, value);
-    _data->set(name, value);
-}
-inline void Policy::set(const std::string& name, double value) {
+// a sub-policy set or added stays shared with the Policy it came from, so
+// is pinned, along with the path to it
+template <>
+inline void Policy::_set(const std::string& name, const Ptr& value) {
     _validate(name, value);
-    _data->set(name, value);
+    value->_detach();
+    value->_data->pinLevel();
+    _detach();
+    _data->set(name, value->_data);
+    _data->pin(name);
 }
-inline void Policy::set(const std::string& name, const std::string& value) {
-    _validate(name, value);
-    _data->set(name, value);
+template <>
+inline void Policy::_set(const PolicyKey& key, const Ptr& value) {
+    _validate(key, value);
+    value->_detach();
+    value->_data->pinLevel();
+    _detach();
+    _data->set(key, value->_data);
+    _data->pin(key);
 }
+
+inline void Policy::set(const std::string& name, const Ptr& value) { _set(name, value); }
+inline void Policy::set(const std::string& name, bool value) { _set(name, value); }
+inline void Policy::set(const std::string& name, int value) { _set(name, value); }
+inline void Policy::set(const std::string& name, double value) { _set(name, value); }
+inline void Policy::set(const std::string& name, const std::string& value) { _set(name, value); }
 inline void Policy::set(const std::string& name, const char* value) {
     if (value == NULL)
         throw LSST_EXCEPT(lsst::pex::exceptions::InvalidParameterError,
                           std::string("Attempted to assign NULL value to ") + name + ".");
-    _validate(name, std::string(value));
-    _data->set(name, std::string(value));
+    _set(name, std::string(value));
+}
+
+inline void Policy::set(const PolicyKey& key, const Ptr& value) { _set(key, value); }
+inline void Policy::set(const PolicyKey& key, bool value) { _set(key, value); }
+inline void Policy::set(const PolicyKey& key, int value) { _set(key, value); }
+inline void Policy::set(const PolicyKey& key, double value) { _set(key, value); }
+inline void Policy::set(const PolicyKey& key, const std::string& value) { _set(key, value); }
+inline void Policy::set(const PolicyKey& key, const char* value) {
+    if (value == NULL)
+        throw LSST_EXCEPT(lsst::pex::exceptions::InvalidParameterError,
+                          std::string("Attempted to assign NULL value to ") + key.getName() + ".");
+    _set(key, std::string(value));
 }
 
 #define POL_ADD(name, value)                                   \
@@ -1004,34 +1288,65 @@ inline void Policy::set(const std::string& name, const char* value) {
         throw LSST_EXCEPT(TypeError, name, getTypeName(name)); \
     }
 
-inline void Policy::add(const std::string& name, const Ptr& value) {
-    _validate(name, value, valueCount(name));
-    POL_ADD(name, value->asPropertySet())
-}
-inline void Policy::add(const std::string& name, bool value) {
+template <typename Name, typename T>
+inline void Policy::_add(const Name& name, const T& value) {
     _validate(name, value, valueCount(name));
-    POL_ADD(name, value);
+    _detach();
+    POL_ADD(name, value)
 }
-inline void Policy::add(const std::string& name, int value) {
-    _validate(name, value, valueCount(name));
-    POL_ADD(name, value);
-}
-inline void Policy::add(const std::string& name, double value) {
+template <>
+inline void Policy::_add(const std::string& name, const Ptr& value) {
     _validate(name, value, valueCount(name));
-    POL_ADD(name, value);
+    value->_detach();
+    value->_data->pinLevel();
+    _detach();
+    POL_ADD(name, value->_data)
+    _data->pin(name);
 }
-inline void Policy::add(const std::string& name, const std::string& value) {
-    _validate(name, value, valueCount(name));
-    POL_ADD(name, value);
+template <>
+inline void Policy::_add(const PolicyKey& key, const Ptr& value) {
+    _validate(key, value, valueCount(key));
+    value->_detach();
+    value->_data->pinLevel();
+    _detach();
+    POL_ADD(key, value->_data)
+    _data->pin(key);
 }
-inline void Policy::add(const std::string& name, const char* value) {
-    std::string v(value);
-    _validate(name, v, valueCount(name));
-    POL_ADD(name, v);
+template <typename Name, typename T>
+inline void Policy::_addAll(const Name& name, const std::vector<T>& values) {
+    if (values.empty()) return;
+    if (_dictionary) {
+        int count = valueCount(name);
+        for (typename std::vector<T>::const_iterator it = values.begin(); it != values.end(); ++it)
+            _validate(name, *it, count++);
+    }
+    _detach();
+    POL_ADD(name, values);
 }
 
+inline void Policy::add(const std::string& name, const Ptr& value) { _add(name, value); }
+inline void Policy::add(const std::string& name, bool value) { _add(name, value); }
+inline void Policy::add(const std::string& name, int value) { _add(name, value); }
+inline void Policy::add(const std::string& name, double value) { _add(name, value); }
+inline void Policy::add(const std::string& name, const std::string& value) { _add(name, value); }
+inline void Policy::add(const std::string& name, const char* value) { _add(name, std::string(value)); }
+inline void Policy::add(const std::string& name, const IntArray& values) { _addAll(name, values); }
+inline void Policy::add(const std::string& name, const DoubleArray& values) { _addAll(name, values); }
+
+inline void Policy::add(const PolicyKey& key, const Ptr& value) { _add(key, value); }
+inline void Policy::add(const PolicyKey& key, bool value) { _add(key, value); }
+inline void Policy::add(const PolicyKey& key, int value) { _add(key, value); }
+inline void Policy::add(const PolicyKey& key, double value) { _add(key, value); }
+inline void Policy::add(const PolicyKey& key, const std::string& value) { _add(key, value); }
+inline void Policy::add(const PolicyKey& key, const char* value) { _add(key, std::string(value)); }
+inline void Policy::add(const PolicyKey& key, const IntArray& values) { _addAll(key, values); }
+inline void Policy::add(const PolicyKey& key, const DoubleArray& values) { _addAll(key, values); }
+
 // TODO: validate if required value?
-inline void Policy::remove(const std::string& name) { _data->remove(name); }
+inline void Policy::remove(const std::string& name) {
+    _detach();
+    _data->remove(name);
+}
 
 inline Policy* Policy::createPolicy(PolicySource& input, bool doIncludes, bool validate) {
     return _createPolicy(input, doIncludes, boost::filesystem::path(), validate);
@@ -1067,7 +1382,8 @@ inline Policy* Policy::createPolicy(const std::string& input, const char* reposi
     return _createPolicy(input, true, boost::filesystem::path(repository), validate);
 }
 
-inline lsst::daf::base::PropertySet::Ptr Policy::asPropertySet() { return _data; }
+inline lsst::daf::base::PropertySet::Ptr Policy::asPropertySet() const { return _data->toPropertySet(); }
+inline lsst::daf::base::PropertySet::Ptr Policy::toPropertySet() const { return _data->toPropertySet(); }
 
 // general case is disallowed; known types are specialized
 template <typename T>
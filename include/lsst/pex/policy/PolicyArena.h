@@ -0,0 +1,121 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsstcorp.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file PolicyArena.h
+ * @ingroup pex
+ * @brief memory from which a loaded policy is allocated, and released at once
+ */
+
+#ifndef LSST_PEX_POLICY_POLICYARENA_H
+#define LSST_PEX_POLICY_POLICYARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace lsst {
+namespace pex {
+namespace policy {
+
+/**
+ * @brief a block of memory that the storage of a Policy is carved out of,
+ * and that is released only as a whole.
+ *
+ * Loading a large policy file makes many small allocations: the arrays
+ * holding the values and names of each sub-policy, grown as values are
+ * added, and each sub-policy itself.  A Policy created with a PolicyArena
+ * takes that memory from it instead, by advancing a pointer through
+ * large chunks, as std::pmr::monotonic_buffer_resource does; what is
+ * freed is not reused, but only released when the arena is destroyed.
+ * So a policy is loaded into one with few calls to the heap, and
+ * destroyed with few more:
+ * @code
+ *     Policy policy(PolicyArena::Ptr(new PolicyArena()));
+ *     PolicyFile(path).load(policy);
+ * @endcode
+ * The sub-policies added to such a Policy, including those made by the
+ * parsers, use the same arena, and each keeps it alive.  Copies of its
+ * sub-policies, such as those made when a copy of the Policy is changed,
+ * use the heap.
+ *
+ * An arena suits a policy that is loaded and then mostly read.  Values
+ * set again and again in a Policy using one leave the memory they held
+ * behind until the arena goes; change a copy of it instead.
+ *
+ * Strings longer than the few characters std::string holds in place
+ * still use the heap.
+ */
+class PolicyArena {
+public:
+    typedef std::shared_ptr<PolicyArena> Ptr;
+
+    /**
+     * create an arena that allocates nothing until it is first used
+     * @param chunkBytes  the size of the first chunk taken from the heap;
+     *                    later chunks double in size, up to 64 times this.
+     */
+    explicit PolicyArena(std::size_t chunkBytes = 64 * 1024);
+
+    /**
+     * release all the memory allocated
+     */
+    ~PolicyArena();
+
+    PolicyArena(const PolicyArena&) = delete;
+    PolicyArena& operator=(const PolicyArena&) = delete;
+
+    /**
+     * return memory for the given number of bytes, aligned as any
+     * fundamental type must be.  Any number of threads may allocate at
+     * once.
+     */
+    void* allocate(std::size_t bytes);
+
+    /**
+     * return the number of bytes handed out by allocate()
+     */
+    std::size_t getBytesAllocated() const;
+
+    /**
+     * return the number of chunks taken from the heap
+     */
+    std::size_t getChunkCount() const;
+
+private:
+    std::size_t _chunkBytes;    // the size of the next chunk
+    std::size_t _maxChunkBytes;
+    char* _next;                // the free part of the current chunk
+    char* _end;
+    std::size_t _allocated;
+    std::vector<char*> _chunks;
+    mutable std::mutex _lock;
+};
+
+}  // namespace policy
+}  // namespace pex
+}  // namespace lsst
+
+#endif  // LSST_PEX_POLICY_POLICYARENA_H
@@ -0,0 +1,106 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsstcorp.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file PolicyDiff.h
+ * @ingroup pex
+ * @brief the differences between two policies
+ */
+
+#ifndef LSST_PEX_POLICY_POLICYDIFF_H
+#define LSST_PEX_POLICY_POLICYDIFF_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "lsst/pex/policy/Policy.h"
+
+namespace lsst {
+namespace pex {
+namespace policy {
+
+/**
+ * @brief the differences between two policies, as found by Policy::diff(),
+ * which Policy::apply() can make to another.
+ *
+ * A PolicyDiff lists each name whose values differ, with whether it was
+ * added, removed or changed, and holds the values on each side in two
+ * policies, under the same names.  A name holding a single sub-policy in
+ * both policies is not listed itself, only the names within it that
+ * differ; so no name listed is a prefix of another.
+ */
+class PolicyDiff {
+public:
+    enum Kind { ADDED, REMOVED, CHANGED };
+
+    /**
+     * a name whose values differ
+     */
+    struct Change {
+        std::string name;
+        Kind kind;
+    };
+    typedef std::vector<Change> ChangeList;
+
+    /**
+     * create an empty diff
+     */
+    PolicyDiff() : _changes(), _old(new Policy()), _new(new Policy()) {}
+
+    /**
+     * return the names whose values differ, in the order Policy::diff()
+     * found them
+     */
+    const ChangeList& getChanges() const { return _changes; }
+
+    /**
+     * return the number of names whose values differ
+     */
+    std::size_t size() const { return _changes.size(); }
+    bool empty() const { return _changes.empty(); }
+
+    //@{
+    /**
+     * return the values of the names listed as they were in the older
+     * policy (for those removed or changed), or as they are in the newer
+     * one (for those added or changed)
+     */
+    const Policy& getOldValues() const { return *_old; }
+    const Policy& getNewValues() const { return *_new; }
+    //@}
+
+private:
+    friend class Policy;
+
+    ChangeList _changes;
+    Policy::Ptr _old;
+    Policy::Ptr _new;
+};
+
+}  // namespace policy
+}  // namespace pex
+}  // namespace lsst
+
+#endif  // LSST_PEX_POLICY_POLICYDIFF_H
@@ -184,7 +184,10 @@ public:
 
     //@{
     /**
-     * load the data from this Policy source into a Policy object
+     * load the data from this Policy source into a Policy object.  The
+     * file is opened once and memory-mapped (where possible); if its
+     * format is not yet known, it is recognized from the mapped data,
+     * which is then parsed in place.
      * @param policy    the policy object to load the data into
      * @exception ParserException  if an error occurs while parsing the data
      * @exception IOError   if an I/O error occurs while reading from the
@@ -196,8 +199,22 @@ public:
     }
     //@}
 
+    /**
+     * load the data from this file into a Policy object as
+     * PolicyFile::load() does, but read into memory rather than
+     * memory-mapped.  Use this for a file that may be changed while it is
+     * read: a mapped file that another process truncates faults when the
+     * parser reaches the pages it no longer has.
+     * @param policy    the policy object to load the data into
+     * @exception ParserException  if an error occurs while parsing the data
+     * @exception IOError   if an I/O error occurs while reading the file
+     */
+    void read(Policy& policy) const;
+
     static const std::string EXT_PAF;  //! the PAF file extension, ".paf"
     static const std::string EXT_XML;  //! the XML file extension,  ".xml"
+    static const std::string EXT_JSON; //! the JSON file extension, ".json"
+    static const std::string EXT_BINARY; //! the compiled file extension, ".pafc"
 
     static const boost::regex SPACE_RE;  //! reg-exp for an empty line
     static const boost::regex COMMENT;   //! reg-exp for the start of a comment
@@ -214,12 +231,21 @@ protected:
     boost::filesystem::path _file;
 
 private:
-    const std::string& cacheName(const std::string& name) {
+    const std::string& cacheName(const std::string& name) const {
         _format = name;
         return _format;
     }
 
-    std::string _format;
+    // return the format given by the file's extension, or an empty string
+    const std::string& formatFromExtension() const;
+
+    // return the format of the file's data, whose start is given
+    const std::string& formatFromData(const char* data, std::size_t size) const;
+
+    // load the file, memory-mapped if map is true and it can be
+    void loadData(Policy& policy, bool map) const;
+
+    mutable std::string _format;
     PolicyParserFactory::Ptr _pfact;
 
     // inherits SupportedFormats _formats from PolicySource
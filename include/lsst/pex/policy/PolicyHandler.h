@@ -0,0 +1,142 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file PolicyHandler.h
+ * @ingroup pex
+ * @brief the definition of the PolicyHandler and PolicyBuilder classes
+ */
+
+#ifndef LSST_PEX_POLICY_POLICYHANDLER_H
+#define LSST_PEX_POLICY_POLICYHANDLER_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "lsst/pex/policy/Policy.h"
+
+namespace lsst {
+namespace pex {
+namespace policy {
+
+/**
+ * @brief an interface for receiving the contents of serialized Policy
+ * data as a parser finds them.
+ *
+ * A PolicyParser sends one call per value, in the order the values appear
+ * in the data, to the handler set with PolicyParser::setHandler().  Each
+ * call gives the hierarchical name of the parameter (e.g.
+ * "transmitter.logVerbosity") and the number of the line it was found on.
+ * A handler can thus filter, count, or convert the data into its own
+ * structures without a Policy being built.  A handler may throw to stop
+ * the parse; the exception is passed on to the caller of parse().
+ */
+class PolicyHandler {
+public:
+    virtual ~PolicyHandler();
+
+    /**
+     * a sub-policy has been opened.  The values that follow, up to the
+     * matching endPolicy(), belong to it; their names start with name
+     * followed by a ".".
+     */
+    virtual void beginPolicy(const std::string& name, int lineno) = 0;
+
+    /**
+     * the sub-policy opened by the matching beginPolicy() has been closed
+     */
+    virtual void endPolicy(const std::string& name, int lineno) = 0;
+
+    //@{
+    /**
+     * a value has been found for the named parameter
+     */
+    virtual void onBool(const std::string& name, bool value, int lineno) = 0;
+    virtual void onInt(const std::string& name, int value, int lineno) = 0;
+    virtual void onDouble(const std::string& name, double value, int lineno) = 0;
+    virtual void onString(const std::string& name, const std::string& value, int lineno) = 0;
+    virtual void onFile(const std::string& name, const Policy::FilePtr& value, int lineno) = 0;
+    //@}
+
+    //@{
+    /**
+     * a run of values has been found for the named parameter.  The
+     * default implementations call onInt() or onDouble() for each value;
+     * handlers that can take the values together should override them.
+     */
+    virtual void onInts(const std::string& name, const Policy::IntArray& values, int lineno);
+    virtual void onDoubles(const std::string& name, const Policy::DoubleArray& values, int lineno);
+    //@}
+};
+
+/**
+ * @brief a PolicyHandler that loads what it receives into a Policy.
+ *
+ * This is the handler a PolicyParser uses unless it is given another.
+ */
+class PolicyBuilder : public PolicyHandler {
+public:
+    /**
+     * create a handler that loads data into the given Policy.  The
+     * sub-policies it creates use the PolicyArena of that Policy, if it
+     * has one.
+     */
+    explicit PolicyBuilder(Policy& policy) : _root(policy), _open(), _name() {}
+
+    virtual ~PolicyBuilder();
+
+    virtual void beginPolicy(const std::string& name, int lineno);
+    virtual void endPolicy(const std::string& name, int lineno);
+    virtual void onBool(const std::string& name, bool value, int lineno);
+    virtual void onInt(const std::string& name, int value, int lineno);
+    virtual void onDouble(const std::string& name, double value, int lineno);
+    virtual void onString(const std::string& name, const std::string& value, int lineno);
+    virtual void onFile(const std::string& name, const Policy::FilePtr& value, int lineno);
+    virtual void onInts(const std::string& name, const Policy::IntArray& values, int lineno);
+    virtual void onDoubles(const std::string& name, const Policy::DoubleArray& values, int lineno);
+
+    /**
+     * return true if no sub-policy is open
+     */
+    bool atTopLevel() const { return _open.empty(); }
+
+private:
+    // add a value to the innermost open policy under its name there
+    template <typename T>
+    void _add(const std::string& name, const T& value);
+
+    Policy& _root;
+
+    // the open sub-policies, each with the length of the prefix that
+    // is removed from a hierarchical name to get its name within it
+    std::vector<std::pair<Policy::Ptr, std::string::size_type> > _open;
+    std::string _name;              // the name within the innermost policy
+};
+
+}  // namespace policy
+}  // namespace pex
+}  // namespace lsst
+
+#endif  // LSST_PEX_POLICY_POLICYHANDLER_H
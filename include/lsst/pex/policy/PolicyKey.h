@@ -0,0 +1,104 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file PolicyKey.h
+ * @ingroup pex
+ * @brief a parameter name prepared for repeated lookups
+ */
+
+#ifndef LSST_PEX_POLICY_POLICYKEY_H
+#define LSST_PEX_POLICY_POLICYKEY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace lsst {
+namespace pex {
+namespace policy {
+
+namespace detail {
+class PolicyData;
+}
+
+/**
+ * @brief a parameter name, split into its fields once so that it can be
+ * looked up many times quickly.
+ *
+ * A Policy function given a name must split it at each "." and find each
+ * field by its characters.  A PolicyKey does the splitting when it is
+ * created, interning and hashing each field, so that the Policy functions
+ * taking a PolicyKey need only compare the fields by address.  Code that
+ * looks up the same names repeatedly can make keys for them once:
+ * @code
+ *     static const PolicyKey sigma("stage.kernel.sigma");
+ *     for (...) total += policy.getDouble(sigma);
+ * @endcode
+ * A PolicyKey converts to its name, so it may also be given to any
+ * function expecting a name.
+ */
+class PolicyKey {
+public:
+    //@{
+    /**
+     * prepare a parameter name
+     * @param name   the name of the parameter.  This can be a hierarchical
+     *                  name with fields delimited with "."
+     */
+    explicit PolicyKey(const std::string& name);
+    explicit PolicyKey(const char* name);
+    //@}
+
+    /**
+     * return the name this key was made from
+     */
+    const std::string& getName() const { return _name; }
+    operator const std::string&() const { return _name; }
+
+    /**
+     * return the number of fields in the name
+     */
+    std::size_t getFieldCount() const { return _fields.size(); }
+
+private:
+    friend class detail::PolicyData;
+
+    struct Field {
+        const std::string* name;   // interned in StringPool::global()
+        std::uint32_t hash;
+    };
+
+    void _split();
+
+    std::string _name;
+    std::vector<Field> _fields;
+};
+
+}  // namespace policy
+}  // namespace pex
+}  // namespace lsst
+
+#endif  // LSST_PEX_POLICY_POLICYKEY_H
@@ -32,7 +32,11 @@
 #ifndef LSST_PEX_POLICY_PARSER_H
 #define LSST_PEX_POLICY_PARSER_H
 
+#include <cstddef>
+
 #include "lsst/pex/policy/Policy.h"
+#include "lsst/pex/policy/PolicyHandler.h"
+#include "lsst/pex/policy/ParserDiagnostics.h"
 #include "lsst/pex/policy/PolicyParserFactory.h"
 
 namespace lsst {
@@ -53,7 +57,8 @@ public:
      *                   ignored if possible; often, such errors will
      *                   result in some data not getting loaded.
      */
-    PolicyParser(Policy& policy, bool strict = true) : _pol(policy), _strict(strict) {}
+    PolicyParser(Policy& policy, bool strict = true)
+            : _pol(policy), _strict(strict), _builder(policy), _handler(0), _diagnostics(0) {}
 
     /**
      * destroy this factory
@@ -83,6 +88,51 @@ public:
      */
     virtual int parse(std::istream& is) = 0;
 
+    /**
+     * parse data held in memory and load results into the attached
+     * Policy.  The default implementation reads the buffer in place
+     * through an input stream; parsers that can scan the buffer directly
+     * should override this.
+     * @param data    the encoded data; it need not be null-terminated
+     * @param size    the number of bytes in data
+     * @returns int   the number of parameters values loaded.  This does not
+     *                   include sub-Policy objects.
+     */
+    virtual int parse(const char* data, std::size_t size);
+
+    /**
+     * send what is parsed to the given handler instead of loading it into
+     * the attached Policy.
+     * @param handler  the handler to receive the data, or 0 to load the
+     *                   Policy again.  The caller keeps ownership of it;
+     *                   it must outlive any parse.
+     */
+    void setHandler(PolicyHandler* handler) { _handler = handler; }
+
+    /**
+     * return the handler that receives what is parsed.  Unless another
+     * was set with setHandler(), this is a PolicyBuilder loading the
+     * attached Policy.
+     */
+    PolicyHandler& getHandler() { return (_handler) ? *_handler : _builder; }
+
+    /**
+     * record problems found in the data in the given collector instead of
+     * throwing exceptions.  Each problem is skipped over as in non-strict
+     * mode and parsing continues until the end of the data or until the
+     * collector's fail-fast threshold is reached; either way, parse()
+     * returns normally.
+     * @param diagnostics  the collector, or 0 to report problems with
+     *                       exceptions again.  The caller keeps ownership
+     *                       of it; it must outlive any parse.
+     */
+    void setDiagnostics(ParserDiagnostics* diagnostics) { _diagnostics = diagnostics; }
+
+    /**
+     * return the collector set with setDiagnostics(), or 0 if there is none
+     */
+    ParserDiagnostics* getDiagnostics() { return _diagnostics; }
+
     //@{
     /**
      * return the policy object
@@ -94,6 +144,9 @@ public:
 protected:
     Policy& _pol;
     bool _strict;
+    PolicyBuilder _builder;
+    PolicyHandler* _handler;
+    ParserDiagnostics* _diagnostics;
 };
 
 }  // namespace policy
@@ -0,0 +1,325 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsstcorp.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file PolicyRef.h
+ * @ingroup pex
+ * @brief borrowed references to the parameters of a Policy
+ */
+
+#ifndef LSST_PEX_POLICY_POLICYREF_H
+#define LSST_PEX_POLICY_POLICYREF_H
+
+#include <cstddef>
+#include <iterator>
+#include <string>
+
+#include "lsst/pex/policy/ArrayView.h"
+#include "lsst/pex/policy/Policy.h"
+
+namespace lsst {
+namespace pex {
+namespace policy {
+
+/**
+ * @brief a read-only reference to the parameters of a Policy or of one of
+ * its sub-policies.
+ *
+ * A ConstPolicyRef does not own what it refers to; it is a single pointer,
+ * so descending into a sub-policy through one allocates nothing and
+ * touches no reference counts.  This makes it the cheaper way to read a
+ * Policy from many threads at once.  It is valid only as long as the
+ * Policy it was made from, and only until the sub-policy it refers to is
+ * removed or replaced.  One made from a Policy that shares its data with a
+ * copy not yet changed is valid only until either of them is changed.
+ *
+ * Its functions behave as the Policy functions of the same names,
+ * including the exceptions they throw; use copy() to obtain a Policy.
+ */
+class ConstPolicyRef {
+public:
+    /**
+     * refer to the parameters of a Policy, which must outlive this
+     * reference
+     */
+    explicit ConstPolicyRef(const Policy& policy);
+
+    //@{
+    /**
+     * return the names of the parameters held, as Policy::names() and
+     * its relatives do
+     */
+    Policy::StringArray names(bool topLevelOnly = false) const { return _names(topLevelOnly, 7); }
+    Policy::StringArray paramNames(bool topLevelOnly = false) const { return _names(topLevelOnly, 4); }
+    Policy::StringArray policyNames(bool topLevelOnly = false) const { return _names(topLevelOnly, 1); }
+    Policy::StringArray fileNames(bool topLevelOnly = false) const { return _names(topLevelOnly, 2); }
+    //@}
+
+    //@{
+    /**
+     * query the parameters held; see the Policy functions of the same names
+     */
+    bool exists(const std::string& name) const { return _data->exists(name); }
+    bool exists(const PolicyKey& key) const { return _data->exists(key); }
+    size_t valueCount(const std::string& name) const { return _data->valueCount(name); }
+    size_t valueCount(const PolicyKey& key) const { return _data->valueCount(key); }
+    bool isArray(const std::string& name) const { return _data->isArray(name); }
+    bool isArray(const PolicyKey& key) const { return _data->isArray(key); }
+    Policy::ValueType getValueType(const std::string& name) const {
+        return Policy::ValueType(_data->valueType(name));
+    }
+    Policy::ValueType getValueType(const PolicyKey& key) const {
+        return Policy::ValueType(_data->valueType(key));
+    }
+    const char* getTypeName(const std::string& name) const { return Policy::typeName[getValueType(name)]; }
+    bool isBool(const std::string& name) const { return getValueType(name) == Policy::BOOL; }
+    bool isInt(const std::string& name) const { return getValueType(name) == Policy::INT; }
+    bool isDouble(const std::string& name) const { return getValueType(name) == Policy::DOUBLE; }
+    bool isString(const std::string& name) const { return getValueType(name) == Policy::STRING; }
+    bool isPolicy(const std::string& name) const { return getValueType(name) == Policy::POLICY; }
+    bool isFile(const std::string& name) const { return getValueType(name) == Policy::FILE; }
+    //@}
+
+    //@{
+    /**
+     * return the last value of the given name
+     * @exception NameNotFound  if no value is associated with the given name.
+     * @exception TypeError     if the value is not of the requested type.
+     */
+    bool getBool(const std::string& name) const;
+    bool getBool(const PolicyKey& key) const;
+    int getInt(const std::string& name) const;
+    int getInt(const PolicyKey& key) const;
+    double getDouble(const std::string& name) const;
+    double getDouble(const PolicyKey& key) const;
+    std::string getString(const std::string& name) const;
+    std::string getString(const PolicyKey& key) const;
+    Policy::FilePtr getFile(const std::string& name) const;
+    Policy::FilePtr getFile(const PolicyKey& key) const;
+    //@}
+
+    //@{
+    /**
+     * return a reference to the last sub-policy of the given name
+     * @exception NameNotFound  if no value is associated with the given name.
+     * @exception TypeError     if the value is not a Policy.
+     */
+    ConstPolicyRef getPolicy(const std::string& name) const;
+    ConstPolicyRef getPolicy(const PolicyKey& key) const;
+    //@}
+
+    //@{
+    /**
+     * return a copy of all the values of the given name
+     */
+    Policy::BoolArray getBoolArray(const std::string& name) const;
+    Policy::BoolArray getBoolArray(const PolicyKey& key) const;
+    Policy::IntArray getIntArray(const std::string& name) const;
+    Policy::IntArray getIntArray(const PolicyKey& key) const;
+    Policy::DoubleArray getDoubleArray(const std::string& name) const;
+    Policy::DoubleArray getDoubleArray(const PolicyKey& key) const;
+    Policy::StringArray getStringArray(const std::string& name) const;
+    Policy::StringArray getStringArray(const PolicyKey& key) const;
+    Policy::FilePtrArray getFileArray(const std::string& name) const;
+    Policy::FilePtrArray getFileArray(const PolicyKey& key) const;
+    //@}
+
+    //@{
+    /**
+     * return a view of all the values of the given name, which is valid
+     * until they are next modified
+     */
+    Policy::IntArrayView getIntArrayView(const std::string& name) const;
+    Policy::IntArrayView getIntArrayView(const PolicyKey& key) const;
+    Policy::DoubleArrayView getDoubleArrayView(const std::string& name) const;
+    Policy::DoubleArrayView getDoubleArrayView(const PolicyKey& key) const;
+    Policy::StringArrayView getStringArrayView(const std::string& name) const;
+    Policy::StringArrayView getStringArrayView(const PolicyKey& key) const;
+    PolicyArrayView getPolicyArrayView(const std::string& name) const;
+    PolicyArrayView getPolicyArrayView(const PolicyKey& key) const;
+    //@}
+
+    /**
+     * return a new Policy holding a copy of the parameters referred to
+     */
+    Policy::Ptr copy() const;
+
+protected:
+    explicit ConstPolicyRef(const detail::PolicyData* data) : _data(data) {}
+
+    const detail::PolicyData* _data;
+
+private:
+    friend class Policy;
+    friend class PolicyArrayView;
+    friend class FrozenPolicy;
+
+    Policy::StringArray _names(bool topLevelOnly, int want) const;
+};
+
+/**
+ * @brief a reference to the parameters of a Policy or of one of its
+ * sub-policies, through which they may also be changed.
+ *
+ * A PolicyRef is a ConstPolicyRef that may also set, add and remove
+ * values; the same limits on its lifetime apply.  As with a sub-policy
+ * returned by Policy::getPolicy(), changes made through it are not
+ * validated against the Dictionary of the Policy it was made from.
+ */
+class PolicyRef : public ConstPolicyRef {
+public:
+    /**
+     * refer to the parameters of a Policy, which must outlive this
+     * reference
+     */
+    explicit PolicyRef(Policy& policy);
+
+    //@{
+    /**
+     * return a reference to the last sub-policy of the given name
+     */
+    PolicyRef getPolicy(const std::string& name) const;
+    PolicyRef getPolicy(const PolicyKey& key) const;
+    //@}
+
+    //@{
+    /**
+     * replace the values of the given name; see Policy::set()
+     */
+    void set(const std::string& name, bool value) const;
+    void set(const std::string& name, int value) const;
+    void set(const std::string& name, double value) const;
+    void set(const std::string& name, const std::string& value) const;
+    void set(const std::string& name, const char* value) const { set(name, std::string(value)); }
+    void set(const PolicyKey& key, bool value) const;
+    void set(const PolicyKey& key, int value) const;
+    void set(const PolicyKey& key, double value) const;
+    void set(const PolicyKey& key, const std::string& value) const;
+    void set(const PolicyKey& key, const char* value) const { set(key, std::string(value)); }
+    //@}
+
+    //@{
+    /**
+     * append a value to those of the given name; see Policy::add()
+     * @exception TypeError  if the existing values are of another type
+     */
+    void add(const std::string& name, bool value) const;
+    void add(const std::string& name, int value) const;
+    void add(const std::string& name, double value) const;
+    void add(const std::string& name, const std::string& value) const;
+    void add(const std::string& name, const char* value) const { add(name, std::string(value)); }
+    void add(const PolicyKey& key, bool value) const;
+    void add(const PolicyKey& key, int value) const;
+    void add(const PolicyKey& key, double value) const;
+    void add(const PolicyKey& key, const std::string& value) const;
+    void add(const PolicyKey& key, const char* value) const { add(key, std::string(value)); }
+    //@}
+
+    //@{
+    /**
+     * remove all values of the given name
+     */
+    void remove(const std::string& name) const { _mutable()->remove(name); }
+    void remove(const PolicyKey& key) const { _mutable()->remove(key); }
+    //@}
+
+private:
+    friend class Policy;
+
+    explicit PolicyRef(detail::PolicyData* data) : ConstPolicyRef(data) {}
+
+    // give policy data of its own, which it will never share with a copy
+    static Policy& _exclusive(Policy& policy);
+
+    // made from a non-const Policy or sub-policy, so may be changed
+    detail::PolicyData* _mutable() const { return const_cast<detail::PolicyData*>(_data); }
+};
+
+/**
+ * @brief a read-only view of the sub-policies held under one name, whose
+ * elements are ConstPolicyRefs.
+ *
+ * Like an ArrayView, it is valid only until the Policy holding the
+ * sub-policies is next modified.
+ */
+class PolicyArrayView {
+public:
+    class const_iterator {
+    public:
+        typedef std::input_iterator_tag iterator_category;
+        typedef ConstPolicyRef value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef void pointer;
+        typedef ConstPolicyRef reference;
+
+        const_iterator() : _at(0) {}
+        ConstPolicyRef operator*() const { return ConstPolicyRef(_at->get()); }
+        const_iterator& operator++() {
+            ++_at;
+            return *this;
+        }
+        const_iterator operator++(int) {
+            const_iterator was(*this);
+            ++_at;
+            return was;
+        }
+        bool operator==(const const_iterator& other) const { return _at == other._at; }
+        bool operator!=(const const_iterator& other) const { return _at != other._at; }
+
+    private:
+        friend class PolicyArrayView;
+        explicit const_iterator(const detail::PolicyData::Ptr* at) : _at(at) {}
+        const detail::PolicyData::Ptr* _at;
+    };
+    typedef const_iterator iterator;
+
+    /**
+     * create an empty view
+     */
+    PolicyArrayView() : _values() {}
+
+    const_iterator begin() const { return const_iterator(_values.begin()); }
+    const_iterator end() const { return const_iterator(_values.end()); }
+    std::size_t size() const { return _values.size(); }
+    bool empty() const { return _values.empty(); }
+
+    ConstPolicyRef operator[](std::size_t i) const { return ConstPolicyRef(_values[i].get()); }
+    ConstPolicyRef front() const { return ConstPolicyRef(_values.front().get()); }
+    ConstPolicyRef back() const { return ConstPolicyRef(_values.back().get()); }
+
+private:
+    friend class Policy;
+    friend class ConstPolicyRef;
+    friend class FrozenPolicy;
+
+    explicit PolicyArrayView(const ArrayView<detail::PolicyData::Ptr>& values) : _values(values) {}
+
+    ArrayView<detail::PolicyData::Ptr> _values;
+};
+
+}  // namespace policy
+}  // namespace pex
+}  // namespace lsst
+
+#endif  // LSST_PEX_POLICY_POLICYREF_H
@@ -132,6 +132,17 @@ public:
     //     static const regex DICTIONARY_CONTENT;
 
 protected:
+    /**
+     * find the line of data that identifies its format: the first line
+     * that is neither blank nor a comment, unless the comment is a
+     * content identifier ("#<?cfg ... ?>").
+     * @param data    the data, or as much of its start as is available
+     * @param size    the number of bytes in data
+     * @param line    set to the identifying line, without its end of line
+     * @return false if there is no such line, i.e. the data is empty
+     */
+    static bool leadingLine(const char* data, std::size_t size, std::string& line);
+
     SupportedFormats::Ptr _formats;
 };
 
@@ -0,0 +1,195 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsstcorp.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file PolicyWatcher.h
+ * @ingroup pex
+ * @brief reloads a policy whenever one of the files it was loaded from changes
+ */
+
+#ifndef LSST_PEX_POLICY_POLICYWATCHER_H
+#define LSST_PEX_POLICY_POLICYWATCHER_H
+
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "boost/filesystem/path.hpp"
+
+#include "lsst/pex/policy/Policy.h"
+
+namespace lsst {
+namespace pex {
+namespace policy {
+
+/**
+ * @brief a Policy loaded from a file, with the files it includes, and
+ * loaded again whenever one of those files is changed.
+ *
+ * A PolicyWatcher loads a policy file as Policy::createPolicy() does,
+ * resolving its file references as Policy::loadPolicyFiles() does, and
+ * remembers every file read along the way: the file itself, the files it
+ * refers to, and those found through a DefaultPolicyFile or UrnPolicyFile.
+ * It then watches them, using inotify where the system provides it and
+ * the files' modification times elsewhere.  The directories holding the
+ * files are watched, so that files replaced by an editor are seen too.
+ *
+ * Edits come in bursts, such as an editor writing a file in pieces, so a
+ * change is acted on only once no file has changed for a short while.
+ * Then only the files that changed are parsed again; the contents of the
+ * others are reused, sharing their data, to assemble a new Policy.  That
+ * Policy becomes the current one and is passed to each callback added.
+ * If a file cannot be read or parsed, the current Policy is kept and the
+ * error handler, if any, is called instead; the next change retries.
+ *
+ * Files are read into memory rather than memory-mapped, so that one
+ * truncated by an editor as it is read gives, at worst, a parse error.
+ *
+ * Changes are looked for by poll(), or by a thread started by start().
+ * Callbacks are called from whichever thread looks; hand the Policy to a
+ * SharedPolicy for threads that read it.  Any number of threads may call
+ * get() and the const functions of the Policy it returns while files are
+ * loaded again: the new Policy shares unchanged levels with the old one
+ * only as copies of a Policy do.
+ */
+class PolicyWatcher {
+public:
+    typedef std::function<void(const Policy::ConstPtr&)> Callback;
+    typedef std::function<void(const std::string&)> ErrorHandler;
+
+    //@{
+    /**
+     * load a policy file and start watching the files it was loaded from
+     * @param file        the file to load
+     * @param repository  the directory to look in for files it refers to
+     *                    by relative paths.  If empty, the directory
+     *                    holding the file, or that of a DefaultPolicyFile,
+     *                    is used.
+     * @param debounceMillis  the milliseconds that must pass without a
+     *                    change before the files are loaded again
+     * @exception IoError      if a file cannot be read
+     * @exception ParserError  if a file cannot be parsed
+     */
+    explicit PolicyWatcher(const std::string& file, const boost::filesystem::path& repository = "",
+                           int debounceMillis = 50);
+    explicit PolicyWatcher(const Policy::FilePtr& file, const boost::filesystem::path& repository = "",
+                           int debounceMillis = 50);
+    //@}
+
+    /**
+     * stop watching, first stopping the thread started by start()
+     */
+    ~PolicyWatcher();
+
+    PolicyWatcher(const PolicyWatcher&) = delete;
+    PolicyWatcher& operator=(const PolicyWatcher&) = delete;
+
+    /**
+     * return the Policy most recently loaded
+     */
+    Policy::ConstPtr get() const;
+
+    /**
+     * return the paths of the files the current Policy was loaded from
+     */
+    std::vector<std::string> getFiles() const;
+
+    /**
+     * return the number of times a file has been parsed, counting the
+     * first load
+     */
+    long getParseCount() const { return _parses.load(); }
+
+    /**
+     * call a function with each Policy loaded from now on
+     */
+    void addCallback(const Callback& callback);
+
+    /**
+     * call a function with the message of each error met loading files
+     * again, in place of the one set before
+     */
+    void setErrorHandler(const ErrorHandler& handler);
+
+    /**
+     * wait up to the given time for a file to change, then load the
+     * policy again if one did.  Only one thread may poll at once, and not
+     * while a thread started by start() is running.
+     * @return true if a new Policy was loaded
+     */
+    bool poll(int timeoutMillis);
+
+    //@{
+    /**
+     * start or stop a thread that polls until it is stopped
+     */
+    void start();
+    void stop();
+    //@}
+
+private:
+    typedef std::map<std::string, Policy::ConstPtr> Parsed;
+
+    Policy::Ptr _load(const PolicyFile& file, const boost::filesystem::path& repository,
+                      std::set<std::string>& files);
+    void _resolve(Policy& policy, const boost::filesystem::path& repository, std::set<std::string>& files);
+    bool _reload(const std::set<std::string>& changed);
+    void _watch();
+    bool _wait(int timeoutMillis, std::set<std::string>& changed);
+
+    Policy::FilePtr _root;
+    boost::filesystem::path _repository;
+    int _debounce;
+
+    Parsed _parsed;                            // the contents of each file, as parsed
+    // without inotify, the modification time and size of each file
+    std::map<std::string, std::pair<std::time_t, std::uintmax_t> > _stamps;
+    std::atomic<long> _parses;
+
+    mutable std::mutex _lock;                  // guards changes to the members below
+    std::set<std::string> _files;              // the files the current Policy was loaded from
+    Policy::ConstPtr _current;
+    std::vector<Callback> _callbacks;
+    ErrorHandler _onError;
+
+    int _fd;                                   // the inotify instance, or -1
+    std::map<int, std::string> _dirs;          // the directory of each inotify watch
+
+    std::thread _thread;
+    std::atomic<bool> _stopping;
+};
+
+}  // namespace policy
+}  // namespace pex
+}  // namespace lsst
+
+#endif  // LSST_PEX_POLICY_POLICYWATCHER_H
@@ -110,6 +110,20 @@ public:
     virtual void writeFiles(const std::string& name, const Policy::FilePtrArray& values) = 0;
     //@}
 
+    //@{
+    /**
+     * write an array of property values, given as a view of them.  write()
+     * calls these, so that values need not be copied out of the Policy.
+     * By default, these copy the values and call the functions above; a
+     * writer may override them to write the values directly.
+     * @param name    the name to save the values as.
+     * @param values   the values to save under that name.
+     */
+    virtual void writeInts(const std::string& name, const Policy::IntArrayView& values);
+    virtual void writeDoubles(const std::string& name, const Policy::DoubleArrayView& values);
+    virtual void writeStrings(const std::string& name, const Policy::StringArrayView& values);
+    //@}
+
     /**
      * close the output stream.  This has no effect if the attached
      * stream is not a file stream.
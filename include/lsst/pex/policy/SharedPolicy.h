@@ -0,0 +1,181 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsstcorp.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file SharedPolicy.h
+ * @ingroup pex
+ * @brief a policy that many threads read while it is replaced by new versions
+ */
+
+#ifndef LSST_PEX_POLICY_SHAREDPOLICY_H
+#define LSST_PEX_POLICY_SHAREDPOLICY_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "lsst/pex/policy/FrozenPolicy.h"
+
+namespace lsst {
+namespace pex {
+namespace policy {
+
+/**
+ * @brief the current version of a policy, read by many threads and
+ * replaced as a whole while they read it.
+ *
+ * A long-running service holds its configuration in a SharedPolicy.
+ * Each version is a FrozenPolicy, so it never changes once published.  To
+ * reconfigure, a writer builds and validates a new Policy, which need not
+ * be visible to anyone else, then calls publish(); readers see either the
+ * old version or the new one, never a mixture.
+ *
+ * Readers take no lock.  read() returns a Snapshot, which keeps the
+ * version it was taken from alive until it is destroyed, and costs two
+ * atomic operations on counters that few threads share, however many
+ * threads read at once.  publish() swaps in the new version with a single
+ * atomic exchange and never waits for readers: the version replaced is
+ * freed by a later publish() once no Snapshot taken before the exchange
+ * remains, as with read-copy-update and epoch-based reclamation.  So that
+ * old versions are freed promptly, Snapshots should be short-lived: take
+ * one per request handled, say, and use get() to hold a version for longer.
+ */
+class SharedPolicy {
+public:
+    typedef std::shared_ptr<SharedPolicy> Ptr;
+
+    /**
+     * @brief a version of a SharedPolicy, held while it is read.
+     *
+     * A Snapshot may be moved but not copied, and must be destroyed before
+     * the SharedPolicy it was taken from.
+     */
+    class Snapshot {
+    public:
+        Snapshot(Snapshot&& other) : _readers(other._readers), _version(other._version) {
+            other._readers = 0;
+        }
+        ~Snapshot() {
+            if (_readers) _readers->fetch_sub(1);
+        }
+
+        Snapshot(const Snapshot&) = delete;
+        Snapshot& operator=(const Snapshot&) = delete;
+
+        const FrozenPolicy& operator*() const { return *_version->policy; }
+        const FrozenPolicy* operator->() const { return _version->policy.get(); }
+
+        /**
+         * return the number of the version held, counting from 1 for the
+         * first
+         */
+        std::uint64_t getVersion() const { return _version->number; }
+
+    private:
+        friend class SharedPolicy;
+
+        struct Version {
+            FrozenPolicy::ConstPtr policy;
+            std::uint64_t number;
+        };
+
+        Snapshot(std::atomic<long>* readers, const Version* version) : _readers(readers), _version(version) {}
+
+        std::atomic<long>* _readers;  // the count of readers this one was counted in
+        const Version* _version;
+    };
+
+    /**
+     * publish the first version, a snapshot of the given Policy
+     */
+    explicit SharedPolicy(const Policy& policy);
+    explicit SharedPolicy(const FrozenPolicy::ConstPtr& policy);
+
+    /**
+     * free the versions held.  No Snapshot may still be held.
+     */
+    ~SharedPolicy();
+
+    SharedPolicy(const SharedPolicy&) = delete;
+    SharedPolicy& operator=(const SharedPolicy&) = delete;
+
+    /**
+     * return a Snapshot of the current version.  This never waits, and
+     * allocates nothing.
+     */
+    Snapshot read() const;
+
+    /**
+     * return the current version, which is kept for as long as the
+     * returned pointer is
+     */
+    FrozenPolicy::ConstPtr get() const { return read()._version->policy; }
+
+    /**
+     * return the number of the current version
+     */
+    std::uint64_t getVersion() const { return read().getVersion(); }
+
+    //@{
+    /**
+     * make the given policy the current version, and return the number of
+     * the new version.  A Policy that has a Dictionary is validated against
+     * it first.  Writers publishing at once are served one at a time.
+     * @exception ValidationError  if the policy is not valid; the current
+     *                             version is then kept.
+     */
+    std::uint64_t publish(const Policy& policy);
+    std::uint64_t publish(const FrozenPolicy::ConstPtr& policy);
+    //@}
+
+private:
+    typedef Snapshot::Version Version;
+
+    // the number of counts readers are spread across in each epoch
+    static const unsigned STRIPES = 32;
+
+    // a count of readers, padded so that no two share a cache line
+    struct Readers {
+        std::atomic<long> count;
+        char pad[64 - sizeof(std::atomic<long>)];
+    };
+
+    bool _drained(unsigned parity) const;
+
+    std::atomic<const Version*> _current;
+    std::atomic<std::uint64_t> _epoch;  // readers count themselves under its parity
+    mutable Readers _readers[2][STRIPES];
+    std::mutex _publishing;
+    // the versions replaced, with the epoch at which they may be freed
+    std::vector<std::pair<const Version*, std::uint64_t> > _retired;
+};
+
+}  // namespace policy
+}  // namespace pex
+}  // namespace lsst
+
+#endif  // LSST_PEX_POLICY_SHAREDPOLICY_H
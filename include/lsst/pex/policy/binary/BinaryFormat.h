@@ -0,0 +1,111 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+
+/**
+ * @file BinaryFormat.h
+ *
+ * @ingroup pex
+ *
+ * @brief the layout of compiled (binary) Policy data.
+ *
+ * This layout is shared by BinaryWriter and BinaryParser and is not
+ * otherwise part of the public interface.
+ */
+#ifndef LSST_PEX_POLICY_BINARY_BINARYFORMAT_H
+#define LSST_PEX_POLICY_BINARY_BINARYFORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace lsst {
+namespace pex {
+namespace policy {
+namespace binary {
+
+/*
+ * Compiled Policy data consists of
+ *  1. a content identifier line, "#<?cfg BINARY policy ?>", padded with
+ *     spaces to HEADER_OFFSET bytes including its newline;
+ *  2. a Header;
+ *  3. the tables it points to: the names (a StringRef per distinct
+ *     parameter name), the policies (a PolicyRecord each; the first is the
+ *     top-level policy) and the entries (an Entry per parameter);
+ *  4. the values, each array aligned for its type: int32 for ints,
+ *     doubles, one byte per bool, StringRefs for strings and file paths,
+ *     and uint32 policy indices for sub-policies;
+ *  5. the string pool, holding each distinct name and string once.
+ *
+ * All offsets are in bytes from the start of the Header, except those in
+ * a StringRef, which are from the start of the string pool.  Numbers are
+ * stored in the byte order of the machine that wrote them; ORDER_MARK
+ * detects a mismatch.
+ */
+
+/** the version of the layout written */
+const std::uint32_t VERSION = 1;
+
+/** the offset of the Header from the start of the data */
+const std::size_t HEADER_OFFSET = 32;
+
+/** the value of Header::byteOrder when read on a machine of the same order */
+const std::uint32_t ORDER_MARK = 0x01020304;
+
+/** the types of Entry */
+enum ValueType { BOOL_TYPE = 1, INT_TYPE, DOUBLE_TYPE, STRING_TYPE, POLICY_TYPE, FILE_TYPE };
+
+struct Header {
+    char magic[4];                 ///< "PLCY"
+    std::uint32_t version;         ///< VERSION
+    std::uint32_t byteOrder;       ///< ORDER_MARK
+    std::uint32_t size;            ///< bytes from here to the end
+    std::uint32_t nameCount;
+    std::uint32_t namesOffset;
+    std::uint32_t policyCount;
+    std::uint32_t policiesOffset;
+    std::uint32_t entryCount;
+    std::uint32_t entriesOffset;
+    std::uint32_t poolSize;
+    std::uint32_t poolOffset;
+};
+
+struct StringRef {
+    std::uint32_t offset;
+    std::uint32_t length;
+};
+
+struct PolicyRecord {
+    std::uint32_t firstEntry;      ///< the index of its first Entry
+    std::uint32_t entryCount;
+};
+
+struct Entry {
+    std::uint32_t name;            ///< the index of its name
+    std::uint32_t type;            ///< a ValueType
+    std::uint32_t count;           ///< the number of values
+    std::uint32_t offset;          ///< where the values are
+};
+
+}}}}   // end lsst::pex::policy::binary
+#endif // LSST_PEX_POLICY_BINARY_BINARYFORMAT_H
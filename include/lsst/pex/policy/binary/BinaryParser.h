@@ -0,0 +1,160 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file BinaryParser.h
+ *
+ * @ingroup pex
+ *
+ * @brief definition of the BinaryParser class
+ */
+#ifndef LSST_PEX_POLICY_BINARY_BINARYPARSER_H
+#define LSST_PEX_POLICY_BINARY_BINARYPARSER_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "lsst/pex/policy/PolicyParser.h"
+#include "lsst/pex/policy/Policy.h"
+#include "lsst/pex/policy/binary/BinaryFormat.h"
+
+namespace lsst {
+namespace pex {
+namespace policy {
+namespace binary {
+
+/**
+ * @brief  a parser for loading compiled (binary) Policy data, as written
+ * by BinaryWriter, into a Policy object
+ *
+ * Compiled data needs no text parsing: the parser checks the layout
+ * described in BinaryFormat.h and then walks its tables, sending each
+ * parameter's values to the parser's PolicyHandler as a typed array read
+ * directly from the data.  When a file is loaded through PolicyFile,
+ * the data is the file's read-only memory mapping, so the only copies
+ * made are into the Policy itself.
+ *
+ * The data is validated as it is walked: every offset and count must lie
+ * within it, so corrupt or truncated data is reported as a
+ * FormatSyntaxError (a SYNTAX_ERROR in ParserDiagnostics) rather than
+ * read out of bounds.  Data written by a different VERSION of the
+ * format or on a machine of different byte order is reported as
+ * UnsupportedSyntax.  Sub-policies may be nested at most MAX_DEPTH
+ * deep; deeper data is reported as corrupt.  As the data has no lines, errors carry no line
+ * number (and are recorded at line 0 in ParserDiagnostics).
+ */
+class BinaryParser : public PolicyParser {
+public:
+
+    /**
+     * the deepest that sub-policies may be nested in data that is loaded
+     */
+    static const int MAX_DEPTH;
+
+    /**
+     * create a parser to load a Policy
+     * @param policy   the Policy object to load the parsed data into
+     */
+    BinaryParser(Policy& policy);
+
+    /**
+     * @copydoc BinaryParser(Policy&)
+     * @param strict   if true, be strict in reporting errors in file
+     *                   contents.  Compiled data is either valid or
+     *                   corrupt, so this has no effect on loading it.
+     */
+    BinaryParser(Policy& policy, bool strict);
+
+    /**
+     * delete this parser
+     */
+    virtual ~BinaryParser();
+
+    /**
+     * parse the data found on the given stream.  The stream is read to
+     * its end and then parsed as a buffer.
+     * @param is      the stream to read compiled data from
+     * @returns int   the number of parameters values loaded.  This does not
+     *                   include sub-Policy objects.
+     */
+    virtual int parse(std::istream& is);
+
+    /**
+     * load compiled data held in memory.  The data is read in place and
+     * need not be aligned.
+     * @param data    the data to load
+     * @param size    the number of bytes in data
+     * @returns int   the number of parameters values loaded.  This does not
+     *                   include sub-Policy objects.
+     */
+    virtual int parse(const char* data, std::size_t size);
+
+private:
+    // send the entries of the policy with the given index; their names
+    // are appended to _name, which holds the name of the policy
+    void _policy(std::uint32_t index);
+
+    // send the values of an entry
+    void _entry(const Entry& entry);
+
+    // return a pointer to the table of count records of the given size
+    // at offset from the Header, checking that it lies within the data
+    const char* _table(std::uint32_t offset, std::uint32_t count, std::size_t size,
+                       const char* what);
+
+    // return the string referred to by a StringRef at p
+    std::string _string(const char* p);
+
+    // report corrupt data, ending the parse
+    void _corrupt(const char* what);
+
+    // report valid data that this parser cannot load, ending the parse
+    void _unsupported(const char* what);
+
+    // send n values to the handler by calling send(handler).  With
+    // diagnostics set, a value the handler will not take is recorded
+    // rather than thrown.  Returns true if sent.
+    template <typename Send>
+    bool _send(Send send, int n);
+
+    // the handler that values are sent to
+    PolicyHandler& _events() { return (_handler) ? *_handler : _builder; }
+
+    // the policy reference, Policy& _pol, is a member of the parent class
+    std::string _name;               // hierarchical name being loaded
+    const char* _data;               // the Header
+    Header _header;
+    const char* _names;              // the tables
+    const char* _policies;
+    const char* _entries;
+    const char* _pool;
+    std::vector<bool> _loaded;       // the policies already sent
+    int _count;
+    int _depth;                      // the policies being sent
+};
+
+
+}}}}   // end lsst::pex::policy::binary
+#endif // LSST_PEX_POLICY_BINARY_BINARYPARSER_H
@@ -0,0 +1,149 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+
+/**
+ * @file BinaryWriter.h
+ * @ingroup pex
+ * @brief definition of the BinaryWriter class
+ */
+
+#ifndef LSST_PEX_POLICY_BINARY_BINARYWRITER_H
+#define LSST_PEX_POLICY_BINARY_BINARYWRITER_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "lsst/pex/policy/PolicyWriter.h"
+#include "lsst/pex/policy/binary/BinaryFormat.h"
+
+namespace lsst {
+namespace pex {
+namespace policy {
+namespace binary {
+
+/**
+ * @brief a writer of Policy data in the compiled (binary) format.
+ *
+ * Compiled data holds a fully loaded Policy in a form that BinaryParser
+ * can load without any text parsing: each distinct name and string is
+ * stored once, values are stored as typed arrays and sub-policies are
+ * referred to by index.  Unlike the text formats, the data cannot be
+ * written piecemeal: write() assembles the whole Policy in memory and
+ * then writes it out.  Values given with the write*() functions before
+ * a call to write() are added to the top level of the Policy it writes.
+ * The data always starts with its content identifier, so the doDecl
+ * argument to write() has no effect.
+ */
+class BinaryWriter : public PolicyWriter {
+public:
+
+    /**
+     * create a writer attached to an output stream
+     * @param out     the output stream to write data to
+     */
+    explicit BinaryWriter(std::ostream *out = 0);
+
+    //@{
+    /**
+     * create a writer attached to an output file
+     * @param file     the output file
+     */
+    explicit BinaryWriter(const std::string& file);
+    explicit BinaryWriter(const char *file);
+    //@}
+
+    /**
+     * delete this writer
+     */
+    virtual ~BinaryWriter();
+
+    /**
+     * write the contents of a policy to the attached stream
+     * @param policy     the policy data to write
+     * @param doDecl     ignored; the content identifier is always written
+     */
+    virtual void write(const Policy& policy, bool doDecl = false);
+
+    //@{
+    /**
+     * add an array of property values with a given name to the Policy
+     * being written
+     * @param name    the name to save the values as
+     * @param values   the values to save under that name.
+     */
+    virtual void writeBools(const std::string& name,
+                            const Policy::BoolArray& values);
+    virtual void writeInts(const std::string& name,
+                           const Policy::IntArray& values);
+    virtual void writeDoubles(const std::string& name,
+                              const Policy::DoubleArray& values);
+    virtual void writeStrings(const std::string& name,
+                              const Policy::StringArray& values);
+    virtual void writePolicies(const std::string& name,
+                              const Policy::PolicyPtrArray& values);
+    virtual void writeFiles(const std::string& name,
+                            const Policy::FilePtrArray& values);
+    virtual void writeInts(const std::string& name,
+                           const Policy::IntArrayView& values);
+    virtual void writeDoubles(const std::string& name,
+                              const Policy::DoubleArrayView& values);
+    virtual void writeStrings(const std::string& name,
+                              const Policy::StringArrayView& values);
+    //@}
+
+    /**
+     * the content identifier that starts compiled data
+     */
+    static const std::string CONTENT_ID;
+
+private:
+    // add an entry to the policy being assembled, with count values of
+    // the given size and alignment copied from data
+    void _add(const std::string& name, ValueType type, std::size_t count,
+              const void* data, std::size_t size, std::size_t align);
+
+    // add strings to the pool, returning references to them
+    void _refs(const Policy::StringArrayView& strs, std::vector<StringRef>& refs);
+
+    // return the reference to a string in the pool, adding it if needed
+    StringRef _intern(const std::string& str);
+
+    // write the assembled data to the stream and start again
+    void _flush();
+
+    std::vector<std::vector<Entry> > _policies;   // the entries of each
+    std::size_t _current;                         // the one being added to
+    std::map<std::string, std::uint32_t> _nameIndex;
+    std::vector<StringRef> _names;
+    std::map<std::string, StringRef> _strings;    // the strings in _pool
+    std::string _pool;
+    std::string _values;                          // offsets relative to
+                                                  //   the start of this
+};
+
+}}}}  // end lsst::pex::policy::binary
+
+#endif // end LSST_PEX_POLICY_BINARY_BINARYWRITER_H
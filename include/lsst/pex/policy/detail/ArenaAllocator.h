@@ -0,0 +1,149 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+
+/**
+ * @file ArenaAllocator.h
+ * @ingroup pex
+ * @brief an allocator drawing from a PolicyArena, or from the heap.
+ *
+ * This class is an implementation detail of the policy classes and is
+ * not part of the public interface.
+ */
+
+#ifndef LSST_PEX_POLICY_DETAIL_ARENAALLOCATOR_H
+#define LSST_PEX_POLICY_DETAIL_ARENAALLOCATOR_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "lsst/pex/policy/PolicyArena.h"
+
+namespace lsst {
+namespace pex {
+namespace policy {
+namespace detail {
+
+/**
+ * @brief a standard allocator that takes memory from a PolicyArena if it
+ * is given one, and from the heap otherwise.
+ *
+ * Memory from an arena is not freed one block at a time, but when the
+ * arena is destroyed, which must not happen before the containers using
+ * it are.  A container copied gets the heap, so that a copy does not
+ * depend on the arena; one moved or swapped takes its allocator along.
+ */
+template <typename T>
+class ArenaAllocator {
+public:
+    typedef T value_type;
+    typedef std::false_type propagate_on_container_copy_assignment;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    template <typename U>
+    struct rebind {
+        typedef ArenaAllocator<U> other;
+    };
+
+    ArenaAllocator() : _arena(0) {}
+    explicit ArenaAllocator(PolicyArena* arena) : _arena(arena) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : _arena(other.getArena()) {}
+
+    T* allocate(std::size_t n) {
+        if (_arena) return static_cast<T*>(_arena->allocate(n * sizeof(T)));
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, std::size_t) {
+        if (! _arena) ::operator delete(p);
+    }
+
+    ArenaAllocator select_on_container_copy_construction() const { return ArenaAllocator(); }
+
+    PolicyArena* getArena() const { return _arena; }
+
+private:
+    PolicyArena* _arena;
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+    return a.getArena() == b.getArena();
+}
+
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+    return a.getArena() != b.getArena();
+}
+
+/**
+ * @brief an ArenaAllocator that also keeps its arena alive, for use with
+ * std::allocate_shared().
+ *
+ * The block allocate_shared() allocates holds the count of references as
+ * well as the object, and is still used as the object is destroyed, which
+ * may release the last other reference to the arena; the copy of this
+ * allocator kept in the block holds the arena until the block is done.
+ */
+template <typename T>
+class SharedArenaAllocator : public ArenaAllocator<T> {
+public:
+    template <typename U>
+    struct rebind {
+        typedef SharedArenaAllocator<U> other;
+    };
+
+    explicit SharedArenaAllocator(const std::shared_ptr<PolicyArena>& arena)
+            : ArenaAllocator<T>(arena.get()), _owner(arena) {}
+    template <typename U>
+    SharedArenaAllocator(const SharedArenaAllocator<U>& other)
+            : ArenaAllocator<T>(other.getArena()), _owner(other.getOwner()) {}
+
+    const std::shared_ptr<PolicyArena>& getOwner() const { return _owner; }
+
+private:
+    std::shared_ptr<PolicyArena> _owner;
+};
+
+/**
+ * create an object shared through a std::shared_ptr, in one block taken
+ * from an arena, or from the heap if the arena is null
+ */
+template <typename T, typename... Args>
+std::shared_ptr<T> allocateShared(const std::shared_ptr<PolicyArena>& arena, Args&&... args) {
+    if (! arena) return std::make_shared<T>(std::forward<Args>(args)...);
+    return std::allocate_shared<T>(SharedArenaAllocator<T>(arena), std::forward<Args>(args)...);
+}
+
+}  // namespace detail
+}  // namespace policy
+}  // namespace pex
+}  // namespace lsst
+
+#endif  // LSST_PEX_POLICY_DETAIL_ARENAALLOCATOR_H
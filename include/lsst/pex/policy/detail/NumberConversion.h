@@ -0,0 +1,61 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file NumberConversion.h
+ * @ingroup pex
+ * @brief numeric conversions shared by the policy parsers.
+ *
+ * These functions are an implementation detail of the parsers and are
+ * not part of the public interface.
+ */
+
+#ifndef LSST_PEX_POLICY_DETAIL_NUMBERCONVERSION_H
+#define LSST_PEX_POLICY_DETAIL_NUMBERCONVERSION_H
+
+namespace lsst {
+namespace pex {
+namespace policy {
+namespace detail {
+
+/**
+ * return the value of the integer numeral [b, e), saturated to the range
+ * of a long just as strtol() does.  The numeral must already have been
+ * checked to be an optional sign followed by decimal digits.
+ */
+long toLong(const char* b, const char* e);
+
+/**
+ * return the value of the floating-point numeral [b, e), correctly
+ * rounded.  The numeral must already have been checked to be an optional
+ * sign, digits with an optional decimal point, and an optional exponent.
+ */
+double toDouble(const char* b, const char* e);
+
+}  // namespace detail
+}  // namespace policy
+}  // namespace pex
+}  // namespace lsst
+
+#endif  // LSST_PEX_POLICY_DETAIL_NUMBERCONVERSION_H
@@ -0,0 +1,545 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file PolicyData.h
+ * @ingroup pex
+ * @brief the storage behind a Policy.
+ *
+ * This class is an implementation detail of the policy classes and is
+ * not part of the public interface.
+ */
+
+#ifndef LSST_PEX_POLICY_DETAIL_POLICYDATA_H
+#define LSST_PEX_POLICY_DETAIL_POLICYDATA_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+#include "lsst/daf/base/Persistable.h"
+#include "lsst/daf/base/PropertySet.h"
+#include "lsst/pex/policy/ArrayView.h"
+#include "lsst/pex/policy/Fingerprint.h"
+#include "lsst/pex/policy/PolicyKey.h"
+#include "lsst/pex/policy/detail/ArenaAllocator.h"
+
+namespace lsst {
+namespace pex {
+namespace policy {
+namespace detail {
+
+/**
+ * @brief the parameters held at one level of a Policy hierarchy.
+ *
+ * The values of each type are kept together in one array, with the values
+ * of a parameter side by side; a parameter is an entry giving its name,
+ * its type, and where its values lie in the array for that type.  Names
+ * are interned in StringPool::global().  A level holding more than a few
+ * names also keeps an open-addressing hash index over them.
+ *
+ * A Policy value is held as a pointer to the PolicyData of the
+ * sub-policy, which may be shared with other policies; a hierarchical
+ * name is looked up by following, at each level, the last Policy value
+ * of the field it names.
+ *
+ * Each function taking a name also accepts a PolicyKey, whose fields are
+ * compared by address rather than by their characters.
+ *
+ * The interface follows PropertySet's, including the exceptions it throws,
+ * so that Policy can use either the same way: a missing name raises
+ * lsst::pex::exceptions::NotFoundError, and a value of the wrong type
+ * raises lsst::pex::exceptions::TypeError.  Typeless queries report
+ * sub-policies as PropertySet::Ptr and files as Persistable::Ptr.
+ *
+ * A sub-policy may also be shared between copies, which is how copying a
+ * Policy is made cheap: share() copies only the levels that must not be
+ * shared, and each change first replaces any shared level it would change
+ * by a copy of that level alone (see detach()).  A level must not be
+ * shared once something outside the tree refers to it, such as a
+ * sub-policy returned by Policy::getPolicy(), or a change made through
+ * that reference would be seen by the copies too.  Such levels, and those
+ * leading to them, are pinned (see pin()): share() copies them, and
+ * changes are made to them in place.  A level stays pinned for good.  A
+ * const Policy may not detach its data, so a view it hands out of a
+ * sub-policy that is shared is instead recorded with the last level along
+ * the name that is pinned, and pinned when that level is next changed
+ * (see pinViews()).
+ *
+ * A level may take the memory for its arrays from a PolicyArena, which it
+ * keeps alive; the sub-policies it creates use the same arena.  Copies of
+ * a level, such as those made by detach(), use the heap.
+ *
+ * Each level remembers its fingerprint once computed, along with its
+ * version: the number of changes made to it, plus, if it is pinned, the
+ * versions of the pinned levels beneath it.  A level that is not pinned
+ * can only be changed from above, through each level along the name
+ * changed, so its own count of changes is enough.  A pinned level may
+ * also be changed through a reference from outside, unseen by the levels
+ * above it, which see the change instead in the versions of the pinned
+ * levels beneath them.  A version never goes back: a level that loses a
+ * pinned sub-policy adds what its version loses to its own count.  So a
+ * level trusts its fingerprint only while its version is the one the
+ * fingerprint was computed at.
+ *
+ * PolicyData may be read from any number of threads at once, but must not
+ * be read while it is being updated.  Pinning on behalf of a const Policy
+ * does not count as an update: it and share() take one lock, so that no
+ * level is shared with a copy while it is being pinned.
+ */
+class PolicyData {
+public:
+    typedef std::shared_ptr<PolicyData> Ptr;
+    typedef std::shared_ptr<lsst::daf::base::Persistable> PersistablePtr;
+
+    /**
+     * the types of values held; these match Policy::ValueType.
+     */
+    enum Type { UNDEF = 0, BOOL, INT, DOUBLE, STRING, POLICY, FILE };
+
+    PolicyData();
+
+    /**
+     * create an empty level whose arrays, and the sub-policies it
+     * creates, take their memory from an arena, or from the heap if it
+     * is null
+     */
+    explicit PolicyData(const std::shared_ptr<PolicyArena>& arena);
+
+    /**
+     * copy this level alone; the copy shares the sub-policies, and is not
+     * pinned
+     */
+    PolicyData(const PolicyData& other);
+
+    /**
+     * return a copy in which each sub-policy is copied in turn
+     */
+    Ptr deepCopy() const;
+
+    /**
+     * return a copy of data that may be changed without affecting data,
+     * and vice versa.  Only the pinned levels are copied; the others are
+     * shared until one of the copies sharing them is changed, so a policy
+     * none of whose levels are pinned is copied in constant time.
+     */
+    static Ptr share(const Ptr& data);
+
+    /**
+     * prepare data to be changed: if it is shared with a copy and not
+     * pinned, replace it by a copy of its own level
+     */
+    static void detach(Ptr& data);
+
+    /**
+     * return true if data is not shared with a copy, so that it may be
+     * pinned
+     */
+    static bool isExclusive(const Ptr& data) { return data->isPinned() || data.use_count() == 1; }
+
+    /**
+     * pin data if it is not shared with a copy, as a const Policy may
+     */
+    static void pinIfExclusive(const Ptr& data);
+
+    /**
+     * return the arena this level takes its memory from, or null if it
+     * uses the heap
+     */
+    const std::shared_ptr<PolicyArena>& getArena() const { return _arena; }
+
+    /**
+     * return true if this level is pinned
+     */
+    bool isPinned() const { return _pinned.load(std::memory_order_relaxed); }
+
+    /**
+     * pin this level, which must not be shared with a copy
+     */
+    void pinLevel() const {
+        if (! isPinned()) _pinned.store(true, std::memory_order_relaxed);
+    }
+
+    //@{
+    /**
+     * pin this level and each level along a name, and the sub-policies
+     * it names, first detaching any of them that are shared, then return
+     * the last of those sub-policies.  This level must not be shared.
+     * @exception NotFoundError  if the name is not found
+     * @exception TypeError      if its values are not sub-policies
+     */
+    const Ptr& pin(const std::string& name);
+    const Ptr& pin(const PolicyKey& key);
+    //@}
+
+    //@{
+    /**
+     * as pin(), but without detaching anything: only the levels that turn
+     * out not to be shared, starting with this level if exclusive is true,
+     * are pinned.  A const reference to a sub-policy that is shared sees
+     * it as it is now, even if the policy it was taken from is changed.
+     */
+    const Ptr& pinIfUnshared(const std::string& name, bool exclusive) const;
+    const Ptr& pinIfUnshared(const PolicyKey& key, bool exclusive) const;
+    //@}
+
+    /**
+     * a view of a sub-policy, handed out by a const Policy, that is to be
+     * pinned before the level it was recorded with is next changed
+     */
+    struct PendingView {
+        std::weak_ptr<Ptr> slot;   // the pointer to its data held by the view
+        std::string name;          // from the level it was recorded with
+        std::size_t index;         // which of the sub-policies of the name
+    };
+    typedef std::vector<PendingView> PendingViews;
+
+    /**
+     * pin the views a const Policy holding data hands out of the
+     * sub-policies of a name, from the one at first on; slots are the
+     * pointers to their data held by the views, which must already point
+     * to those sub-policies.  The levels along the name that are not shared
+     * are pinned as by pinIfUnshared(); each view of a sub-policy that is
+     * shared is recorded with the last pinned level along the name, or, if
+     * data itself is shared, appended to pending, which the Policy must
+     * pass to pinViews() before it next changes data.  Either way the view
+     * is pinned, and pointed to a copy of its own if need be, before the
+     * sub-policy can be changed through data, and so goes on seeing it.
+     */
+    static void pinViews(const Ptr& data, const std::string& name, std::size_t first,
+                         const std::vector<std::shared_ptr<Ptr> >& slots, PendingViews& pending);
+
+    /**
+     * pin the views recorded in pending, whose names are taken from this
+     * level, which must not be shared, and clear it
+     */
+    void pinViews(PendingViews& pending);
+
+    /**
+     * return the number of names held at this level
+     */
+    std::size_t nameCount() const { return _entries.size(); }
+
+    /**
+     * append names held to out, each preceded by prefix, in the order
+     * in which they were added.
+     * @param topLevelOnly  if false, also append the names within the last
+     *                      sub-policy of each Policy parameter.
+     * @param want          a bit field of the kinds of names to append
+     *                      (1=Policies, 2=PolicyFiles, 4=other parameters).
+     * @return the number of names appended
+     */
+    int names(std::vector<std::string>& out, bool topLevelOnly, int want,
+              const std::string& prefix = std::string()) const;
+
+    /**
+     * a parameter under its full hierarchical name, and where its values
+     * lie in the array for its type, as listed by flatten()
+     */
+    struct Flat {
+        std::string name;
+        Type type;
+        const void* values;    // the first; bools are held as chars
+        std::size_t count;
+    };
+
+    /**
+     * append every parameter held to out, each under its full name preceded
+     * by prefix, in the order names() gives them.  The values pointed to
+     * stay valid until this PolicyData or one of its sub-policies is next
+     * modified.
+     */
+    void flatten(std::vector<Flat>& out, const std::string& prefix = std::string()) const;
+
+    /**
+     * a name whose values differ between two PolicyData, as found by diff()
+     */
+    struct Difference {
+        enum Kind { ADDED, REMOVED, CHANGED };
+        std::string name;
+        Kind kind;
+    };
+
+    /**
+     * append to out each name whose values differ between this and
+     * other, preceded by prefix: first those held here, in the order
+     * names() gives them, then at each level those held only by other.
+     * A name holding a single sub-policy on both sides is not reported
+     * itself; the differences within it are.  Sub-policies that both
+     * share are skipped without being looked at, so the time taken grows
+     * with the parts that are not shared.
+     */
+    void diff(const PolicyData& other, std::vector<Difference>& out,
+              const std::string& prefix = std::string()) const;
+
+    /**
+     * return true if other holds the same names as this, with equal
+     * values.  Files are equal if they have the same path.
+     */
+    bool equals(const PolicyData& other) const;
+
+    /**
+     * return a hash of the names, types and values held, which does not
+     * depend on the order the names were added in.  It is remembered,
+     * so asking again costs nothing until this level or one below it is
+     * changed, and a level that changes costs only a pass over its own
+     * entries: those of unchanged sub-policies are not looked at again.
+     * Files are hashed by their paths, as equals() compares them.
+     */
+    Fingerprint fingerprint() const;
+
+    /**
+     * replace the values of a given name by those other holds under the
+     * same name, or remove them if it holds none.  Sub-policies are shared
+     * as share() shares them.
+     */
+    void assign(const std::string& name, const PolicyData& other);
+
+    //@{
+    bool exists(const std::string& name) const { return _lookup(name) != 0; }
+    bool exists(const PolicyKey& key) const { return _lookup(key) != 0; }
+    bool isArray(const std::string& name) const { return _count(_lookup(name)) > 1; }
+    bool isArray(const PolicyKey& key) const { return _count(_lookup(key)) > 1; }
+    std::size_t valueCount(const std::string& name) const { return _count(_lookup(name)); }
+    std::size_t valueCount(const PolicyKey& key) const { return _count(_lookup(key)); }
+    //@}
+
+    //@{
+    /**
+     * return the type of the values with a given name, or UNDEF if there
+     * are none
+     */
+    Type valueType(const std::string& name) const { return _type(_lookup(name)); }
+    Type valueType(const PolicyKey& key) const { return _type(_lookup(key)); }
+    //@}
+
+    /**
+     * return the type of the values with a given name as PropertySet
+     * would report it
+     */
+    const std::type_info& typeOf(const std::string& name) const;
+
+    //@{
+    /**
+     * return the last value, or all the values, of a given name.  T may
+     * be bool, int, double, std::string, Ptr or PersistablePtr.
+     */
+    template <typename T>
+    T get(const std::string& name) const;
+    template <typename T>
+    T get(const PolicyKey& key) const;
+    template <typename T>
+    std::vector<T> getArray(const std::string& name) const;
+    template <typename T>
+    std::vector<T> getArray(const PolicyKey& key) const;
+    //@}
+
+    //@{
+    /**
+     * return a view of all the values of a given name, which is valid
+     * until the level holding them is next modified.  T may be int,
+     * double, std::string or Ptr; bools are stored as chars, so cannot be
+     * viewed.
+     */
+    template <typename T>
+    ArrayView<T> getView(const std::string& name) const;
+    template <typename T>
+    ArrayView<T> getView(const PolicyKey& key) const;
+    //@}
+
+    //@{
+    /**
+     * replace the values of a given name, creating any missing
+     * sub-policies the name runs through.
+     */
+    template <typename T>
+    void set(const std::string& name, const T& value);
+    template <typename T>
+    void set(const PolicyKey& key, const T& value);
+    void set(const std::string& name, const char* value) { set(name, std::string(value)); }
+    //@}
+
+    //@{
+    /**
+     * append values to those of a given name, which must be of the same
+     * type
+     */
+    template <typename T>
+    void add(const std::string& name, const T& value);
+    template <typename T>
+    void add(const PolicyKey& key, const T& value);
+    void add(const std::string& name, const char* value) { add(name, std::string(value)); }
+    template <typename T>
+    void add(const std::string& name, const std::vector<T>& values);
+    template <typename T>
+    void add(const PolicyKey& key, const std::vector<T>& values);
+    //@}
+
+    //@{
+    /**
+     * remove all values of a given name, if there are any
+     */
+    void remove(const std::string& name);
+    void remove(const PolicyKey& key);
+    //@}
+
+    /**
+     * return the number of bytes of memory held, counting each distinct
+     * sub-policy once and leaving out the interned names.
+     */
+    std::size_t memoryUsage() const;
+
+    //@{
+    /**
+     * convert to or from a PropertySet, copying all values
+     */
+    lsst::daf::base::PropertySet::Ptr toPropertySet() const;
+    static Ptr fromPropertySet(const lsst::daf::base::PropertySet& ps);
+    //@}
+
+    /**
+     * return the hash of a name field, as used by the index
+     */
+    static std::uint32_t hash(const char* b, const char* e);
+
+private:
+    // one parameter: its name and where its values are
+    struct Entry {
+        const std::string* name;   // interned
+        std::uint32_t hash;
+        std::uint32_t type;
+        std::uint32_t offset;      // of the first value in its array
+        std::uint32_t count;
+    };
+
+    // an array, taking its memory from the arena if there is one
+    template <typename T>
+    using Vector = std::vector<T, ArenaAllocator<T> >;
+
+    // the array holding the values of type T, and how they are stored
+    template <typename T>
+    struct Column;
+
+    // a field of a name: its characters, its hash, and its interned
+    // copy if it is known
+    struct Field {
+        const char* begin;
+        const char* end;
+        std::uint32_t hash;
+        const std::string* interned;
+    };
+
+    // the largest level searched without an index
+    static const std::size_t LINEAR_MAX = 8;
+
+    static std::size_t _count(const Entry* entry) { return entry ? entry->count : 0; }
+    static Type _type(const Entry* entry) { return entry ? Type(entry->type) : UNDEF; }
+
+    static bool _matches(const Entry& entry, const Field& field);
+    static Field _field(const Entry& entry);
+    static Field _field(const PolicyKey::Field& field);
+
+    static bool _split(const std::string& name, std::size_t& at, Field& field);
+    static bool _split(const PolicyKey& key, std::size_t& at, Field& field);
+    static Ptr _copyPinned(const Ptr& data);
+
+    template <typename Name>
+    const Ptr& _pin(const Name& name);
+    template <typename Name>
+    const Ptr& _pinIfUnshared(const Name& name, bool exclusive) const;
+    PendingViews& _pendingViews() const;
+    static void _record(PendingViews& views, const PendingView& view);
+    void _pinPending() {
+        if (_pending && ! _pending->empty()) pinViews(*_pending);
+    }
+
+    void _advance(std::uint64_t n) { _changes.fetch_add(n, std::memory_order_release); }
+    void _changed() {
+        _pinPending();
+        _advance(1);
+    }
+    void _dropPinned(std::size_t offset, std::size_t count);
+    std::uint64_t _version() const;
+    bool _remembered(Fingerprint& out) const;
+    bool _sameValues(const Entry& entry, const PolicyData& other, const Entry& otherEntry) const;
+    int _find(const Field& field) const;
+    const Entry* _lookup(const std::string& name, const PolicyData** level = 0) const;
+    const Entry* _lookup(const PolicyKey& key, const PolicyData** level = 0) const;
+    template <typename Name>
+    const Entry& _require(const Name& name, const PolicyData*& level) const;
+    const PolicyData* _sub(const Field& field) const;
+    PolicyData* _subForUpdate(const Field& field, const std::string& name, std::size_t prefix,
+                              bool create = true);
+    const PolicyData* _level(const std::string& name, Field& field) const;
+    const PolicyData* _level(const PolicyKey& key, Field& field) const;
+    PolicyData* _levelForUpdate(const std::string& name, Field& field, bool create = true);
+    PolicyData* _levelForUpdate(const PolicyKey& key, Field& field, bool create = true);
+
+    template <typename T>
+    T _last(const Entry& entry, const std::string& name) const;
+    template <typename T>
+    std::vector<T> _all(const Entry& entry, const std::string& name) const;
+    template <typename T>
+    ArrayView<T> _view(const Entry& entry, const std::string& name) const;
+    template <typename T, typename Iter>
+    void _put(const std::string& name, const Field& field, Iter b, Iter e, bool replace);
+    std::size_t _insert(const Field& field, Type type, std::size_t offset);
+    void _erase(const Field& field);
+    void _place(std::size_t i);
+    void _release(Type type, std::size_t offset, std::size_t count);
+    std::size_t _memoryUsage(std::set<const PolicyData*>& seen) const;
+    void _reindex();
+    void _compact();   // only if enough values are dead
+
+    std::shared_ptr<PolicyArena> _arena;   // first, so that it is released last
+    Vector<Entry> _entries;                // in the order they were added
+    Vector<std::uint32_t> _index;          // entry number + 1, or 0 if free
+    Vector<char> _bools;
+    Vector<int> _ints;
+    Vector<double> _doubles;
+    Vector<std::string> _strings;
+    Vector<Ptr> _policies;
+    Vector<PersistablePtr> _files;
+    std::size_t _dead;                     // values no longer referred to
+    mutable std::atomic<bool> _pinned;
+    mutable std::unique_ptr<PendingViews> _pending;   // views to pin before a change
+    std::atomic<std::uint64_t> _changes;   // made to this level
+    // the fingerprint, if _hashStamp is not 0; it is 1 more than the
+    // version it was computed at
+    mutable std::atomic<std::uint64_t> _hashHigh;
+    mutable std::atomic<std::uint64_t> _hashLow;
+    mutable std::atomic<std::uint64_t> _hashStamp;
+};
+
+}  // namespace detail
+}  // namespace policy
+}  // namespace pex
+}  // namespace lsst
+
+#endif  // LSST_PEX_POLICY_DETAIL_POLICYDATA_H
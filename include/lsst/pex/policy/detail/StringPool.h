@@ -0,0 +1,126 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file StringPool.h
+ * @ingroup pex
+ * @brief a pool of interned strings.
+ *
+ * This class is an implementation detail of the policy classes and is
+ * not part of the public interface.
+ */
+
+#ifndef LSST_PEX_POLICY_DETAIL_STRINGPOOL_H
+#define LSST_PEX_POLICY_DETAIL_STRINGPOOL_H
+
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+
+namespace lsst {
+namespace pex {
+namespace policy {
+namespace detail {
+
+/**
+ * @brief a set of strings, each held once, whose storage is shared by
+ * everything that interns an equal string.
+ *
+ * intern() returns a reference to the pool's copy of a string, which stays
+ * valid for the life of the pool; as equal strings give the same copy,
+ * interned strings from one pool can be compared by address.  Names and
+ * keywords repeat heavily across policies and dictionaries, so the
+ * process-wide pool returned by global() is used to hold them.  The
+ * functions may be called from any thread.
+ */
+class StringPool {
+public:
+    StringPool();
+
+    //@{
+    /**
+     * return the pool's copy of a string, adding it if it is not there
+     */
+    const std::string& intern(const char* b, const char* e);
+    const std::string& intern(const std::string& str) {
+        return intern(str.data(), str.data() + str.size());
+    }
+    //@}
+
+    //@{
+    /**
+     * return the pool's copy of a string, or 0 if it has not been interned
+     */
+    const std::string* find(const char* b, const char* e) const;
+    const std::string* find(const std::string& str) const {
+        return find(str.data(), str.data() + str.size());
+    }
+    //@}
+
+    /**
+     * return the number of strings held
+     */
+    std::size_t size() const;
+
+    /**
+     * return the number of characters held
+     */
+    std::size_t chars() const;
+
+    /**
+     * return the pool shared by the whole process
+     */
+    static StringPool& global();
+
+private:
+    StringPool(const StringPool&);
+    StringPool& operator=(const StringPool&);
+
+    // a reference to characters, either held by the pool or being looked up
+    struct Key {
+        const char* data;
+        std::size_t size;
+        const std::string* str;   // the pool's copy, or 0 when looking up
+    };
+    struct Hash {
+        std::size_t operator()(const Key& key) const;
+    };
+    struct Equal {
+        bool operator()(const Key& a, const Key& b) const;
+    };
+
+    mutable std::mutex _mutex;
+    std::unordered_set<Key, Hash, Equal> _index;
+    std::deque<std::string> _strings;   // does not move its elements
+    std::size_t _chars;
+};
+
+}  // namespace detail
+}  // namespace policy
+}  // namespace pex
+}  // namespace lsst
+
+#endif  // LSST_PEX_POLICY_DETAIL_STRINGPOOL_H
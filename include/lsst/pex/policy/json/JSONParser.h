@@ -0,0 +1,182 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+
+/**
+ * @file JSONParser.h
+ *
+ * @ingroup pex
+ *
+ * @brief definition of the JSONParser class
+ */
+#ifndef LSST_PEX_POLICY_JSON_JSONPARSER_H
+#define LSST_PEX_POLICY_JSON_JSONPARSER_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "lsst/pex/policy/PolicyParser.h"
+#include "lsst/pex/policy/Policy.h"
+
+namespace lsst {
+namespace pex {
+namespace policy {
+namespace json {
+
+/**
+ * @brief  a parser for reading JSON-formatted data into a Policy object
+ *
+ * The data must hold a single JSON object; its members become the
+ * parameters of the Policy.  The mapping follows the PAF format:
+ * @li a nested object becomes a sub-policy;
+ * @li an array becomes the multiple values of a parameter, so its
+ *     elements must all be of one type (numbers may mix integers and
+ *     reals, in which case all are loaded as doubles).  An array of
+ *     objects gives an array of sub-policies; nested arrays are not
+ *     supported;
+ * @li a name that appears more than once in an object has its values
+ *     appended, as when a name is repeated in a PAF file;
+ * @li null values are ignored;
+ * @li outside of strings, "#" starts a comment that runs to the end of
+ *     the line, so that a content identifier (e.g. "#<?cfg JSON ?>")
+ *     may be given.
+ *
+ * Names must have the form of a PAF parameter name.  The data is scanned
+ * in a single pass by a recursive-descent parser working directly on the
+ * buffer: no document tree is built, and each value is sent to the
+ * parser's PolicyHandler as soon as it has been read.
+ */
+class JSONParser : public PolicyParser {
+public:
+
+    /**
+     * create a parser to load a Policy
+     * @param policy   the Policy object to load the parsed data into
+     */
+    JSONParser(Policy& policy);
+
+    /**
+     * @copydoc JSONParser(Policy&)
+     * @param strict   if true, be strict in reporting errors in file
+     *                   contents and syntax.  If false, errors will be
+     *                   ignored if possible; often, such errors will
+     *                   result in some data not getting loaded.  The
+     *                   default (set by PolicyParser) is true.
+     */
+    JSONParser(Policy& policy, bool strict);
+
+    /**
+     * delete this parser
+     */
+    virtual ~JSONParser();
+
+    /**
+     * parse the data found on the given stream.  The stream is read to
+     * its end and then parsed as a buffer.
+     * @param is      the stream to read JSON-encoded data from
+     * @returns int   the number of parameters values loaded.  This does not
+     *                   include sub-Policy objects.
+     */
+    virtual int parse(std::istream& is);
+
+    /**
+     * parse JSON-encoded data held in memory.  The buffer is scanned in
+     * place; memory is only allocated for the names and values actually
+     * sent to the handler.
+     * @param data    the data to parse; it need not be null-terminated
+     * @param size    the number of bytes in data
+     * @returns int   the number of parameters values loaded.  This does not
+     *                   include sub-Policy objects.
+     */
+    virtual int parse(const char* data, std::size_t size);
+
+private:
+    // parse the members of an object whose "{" has been read; their names
+    // are appended to _name, which holds the name of the object
+    void _object();
+
+    // parse the value at _p for the parameter named in _name
+    void _value();
+
+    // parse an array whose "[" is at _p
+    void _array();
+
+    // parse a value without sending it to the handler
+    void _skipValue();
+
+    // read the string whose opening quote is at _p into out
+    void _string(std::string& out);
+
+    // return the end of the number at _p, or 0 if there is none; isInt
+    // is set to false if it has a fraction or an exponent
+    const char* _number(bool& isInt);
+
+    // convert the integer [b, e), reporting it as unsupported if it does
+    // not fit in an int.  Returns false if it does not.
+    bool _int(const char* b, const char* e, int& value);
+
+    // skip whitespace and comments, counting lines
+    void _skip();
+
+    // expect the character c at _p (after whitespace) and step past it
+    void _expect(char c, const char* what);
+
+    // report a problem with the value [b, e).  With diagnostics set, it
+    // is recorded and true is returned; otherwise the problem is thrown
+    // in strict mode or ignored (returning false).
+    bool _problem(ParserDiagnostics::Kind kind, const char* b, const char* e);
+
+    // report text that cannot be parsed at all, ending the parse
+    void _syntaxError(const char* what);
+
+    // send n values to the handler by calling send(handler), unless they
+    // are being skipped.  With diagnostics set, a value the handler will
+    // not take is recorded rather than thrown.  Returns true if sent.
+    template <typename Send>
+    bool _send(Send send, int n);
+
+    // the handler that values are sent to
+    PolicyHandler& _events() { return (_handler) ? *_handler : _builder; }
+
+    // the policy reference, Policy& _pol, is a member of the parent class
+    std::string _name;               // hierarchical name being loaded
+    std::string _key;                // the last member name read
+    std::string _str;                // the last string value read
+    Policy::IntArray _ints;          // an array of numbers being loaded
+    Policy::DoubleArray _doubles;
+    std::vector<std::string> _strs;  // an array of strings being loaded
+    std::vector<bool> _bools;
+    const char* _p;                  // the next character to read
+    const char* _e;                  // the end of the data
+    const char* _line;               // start of the current line
+    int _lineno;
+    int _count;
+    int _skipping;                   // > 0 while values are being skipped
+    int _depth;                      // objects and arrays open at _p
+};
+
+
+}}}}   // end lsst::pex::policy::json
+#endif // LSST_PEX_POLICY_JSON_JSONPARSER_H
@@ -32,15 +32,16 @@
  * @author Ray Plante
  *
  */
-#ifndef LSST_PEX_POLICY_PAF_TOKENIZER_H
-#define LSST_PEX_POLICY_PAF_TOKENIZER_H
+#ifndef LSST_PEX_POLICY_PAF_PAFPARSER_H
+#define LSST_PEX_POLICY_PAF_PAFPARSER_H
 
 #include <iostream>
+#include <string>
+#include <vector>
 
 #include "lsst/pex/policy/PolicyParser.h"
 #include "lsst/pex/policy/Policy.h"
-
-#include <boost/regex.hpp>
+#include "lsst/pex/policy/paf/StructuralIndex.h"
 
 namespace lsst {
 namespace pex {
@@ -49,6 +50,15 @@ namespace paf {
 
 /**
  * @brief  a parser for reading PAF-formatted data into a Policy object
+ *
+ * The input is scanned a line at a time in a single pass by a small
+ * state machine; no regular expressions are involved.  Each value is
+ * sent to the parser's PolicyHandler as soon as it is found; by default
+ * this loads it into the Policy.  The only state
+ * carried from one line to the next is the stack of currently open
+ * sub-policies and, when a quoted string spans lines, the partially
+ * assembled string value.  Because of this, a document can also be
+ * pushed into the parser in arbitrary chunks with feed() and finish().
  */
 class PAFParser : public PolicyParser {
 public:
@@ -82,45 +92,128 @@ public:
      */
     virtual int parse(std::istream& is);
 
+    /**
+     * parse PAF-encoded data held in memory.  The buffer is scanned in
+     * place; memory is only allocated for the names and values actually
+     * stored into the Policy.  A StructuralIndex of the buffer is built
+     * first and used to find line and value boundaries.
+     * @param data    the data to parse; it need not be null-terminated
+     * @param size    the number of bytes in data
+     * @returns int   the number of parameters values loaded.  This does not
+     *                   include sub-Policy objects.
+     */
+    virtual int parse(const char* data, std::size_t size);
+
+    /**
+     * parse the next chunk of a document that arrives in pieces, e.g. from
+     * a pipe.  Complete lines are parsed as soon as they arrive; only a
+     * trailing partial line is copied and kept until the rest of it is
+     * fed in.  Multi-line strings and open sub-policies may span any
+     * number of chunks.  Call finish() after the last chunk.  Errors are
+     * reported as they are found, as by parse(); the parser should not be
+     * used further after an error.
+     * @param data    the next chunk of data; it need not be null-terminated
+     *                   nor end on a line boundary.
+     * @param size    the number of bytes in data
+     * @returns int   the number of parameters values loaded so far from
+     *                   the document being fed.
+     */
+    int feed(const char* data, std::size_t size);
+
+    /**
+     * signal the end of a document passed in with feed(), parsing any
+     * final line that was not terminated by a newline.  The parser is
+     * then ready to accept another document with feed().
+     * @returns int   the number of parameters values loaded from the
+     *                   document.  This does not include sub-Policy
+     *                   objects.
+     */
+    int finish();
+
+    /**
+     * set the number of threads to use when parsing data held in memory.
+     * With more than one thread, data of at least PARALLEL_MIN_SIZE bytes
+     * is split at lines that open a top-level sub-policy ("name: {").
+     * The pieces are parsed concurrently and their contents are then
+     * added to the Policy in file order.  The loaded Policy, and any error
+     * reported, is the same as for a serial parse: whenever the pieces
+     * cannot be shown to be independent, the data is parsed serially.
+     * @param nthreads   the number of threads; 0 means one per core.  The
+     *                     default is 1 (serial).
+     */
+    void setThreads(int nthreads) { _threads = nthreads; }
+
+    /**
+     * return the number of threads used to parse data held in memory
+     */
+    int getThreads() const { return _threads; }
+
+    /**
+     * the smallest buffer that will be parsed in parallel
+     */
+    static const std::size_t PARALLEL_MIN_SIZE;
+
 private:
-    // read next line from stream into the line string
-    std::ios::iostate _nextLine(std::istream& is, std::string& line);
-
-    // push a line back onto the stream
-    void _pushBackLine(const std::string& line);
-
-    int _parseIntoPolicy(std::istream& is, Policy& policy);
-    int _addValue(const std::string& propname, std::string& value,
-                  Policy& policy, std::istream& is);
-
-    static const boost::regex COMMENT_LINE;
-    static const boost::regex EMPTY_LINE;
-    static const boost::regex SPACE_SRCH;
-    static const boost::regex PARAM_SRCH;
-    static const boost::regex NAME_MTCH;
-    static const boost::regex OPEN_SRCH;
-    static const boost::regex CLOSE_SRCH;
-    static const boost::regex DOUBLE_VALUE;
-    static const boost::regex INT_VALUE;
-    static const boost::regex ATRUE_VALUE;
-    static const boost::regex AFALSE_VALUE;
-    static const boost::regex QQSTRING_VALUE;
-    static const boost::regex QSTRING_VALUE;
-    static const boost::regex QQSTRING_START;
-    static const boost::regex QSTRING_START;
-    static const boost::regex QQSTRING_EMPTYSTART;
-    static const boost::regex QSTRING_EMPTYSTART;
-    static const boost::regex QQSTRING_END;
-    static const boost::regex QSTRING_END;
-    static const boost::regex BARE_STRING_LINE;
-    static const boost::regex BARE_STRING;
-    static const boost::regex URN_VALUE;
-    static const boost::regex FILE_VALUE;
+    // parse a buffer with several threads.  Returns false, with the
+    // policy untouched, if it should be parsed serially instead.
+    bool _parseParallel(const char* data, std::size_t size);
+
+    // parse the lines in [b, e).  If final is false, a trailing line
+    // without a newline is left unparsed; the start of it is returned.
+    const char* _parseLines(const char* b, const char* e, bool final);
+
+    // scan one line of input, sending the values found to the handler.
+    // atEnd is true when the line was terminated by the end of the
+    // input rather than by a newline.  With diagnostics set, errors
+    // raised by the handler are recorded there.
+    void _parseLine(const char* b, const char* e, bool atEnd);
+    void _scanLine(const char* b, const char* e, bool atEnd);
+
+    // check that the data did not end in the middle of a value
+    void _endOfData();
+
+    // add the value(s) found in [v, e) for the named parameter.  Returns
+    // the position of any trailing text that must be re-scanned as if it
+    // began a new line (e.g. a closing brace), or 0 if the line is done.
+    const char* _addValue(const std::string& propname, const char* v, const char* e);
+
+    // add a sequence of quoted strings starting at v; a string left open
+    // at the end of the line is continued on subsequent lines.
+    const char* _addStrings(const std::string& propname, const char* v, const char* e);
+
+    // report a problem with the text [b, e) of the current line.  With
+    // diagnostics set, it is recorded and true is returned; otherwise
+    // the problem is thrown in strict mode or ignored (returning false).
+    bool _problem(ParserDiagnostics::Kind kind, const char* b, const char* e);
+
+    // return the first c1 or c2 in [p, e), or e if there is none
+    const char* _find(const char* p, const char* e, char c1, char c2) const;
+
+    // the handler that values are sent to
+    PolicyHandler& _events() { return (_handler) ? *_handler : _builder; }
 
     // the policy reference, Policy& _pol, is a member of the parent class
-    std::list<std::string> _buffer;
+    std::string _path;               // hierarchical name of the open policy
+    std::vector<std::string::size_type> _open;  // _path lengths before each
+                                     // sub-policy not yet closed was opened
+    std::string _name;               // hierarchical name being loaded
+    Policy::IntArray _ints;          // a run of numbers being loaded
+    Policy::DoubleArray _doubles;
+    std::string _value;              // a string value being loaded
+    std::string _strName;            // name of a multi-line string value
+    std::string _strValue;           // the text collected for it so far
+    int _strLine;                    // the line it started on
+    char _quote;                     // its quote character, or 0 if none
+    StructuralIndex _index;          // index of the buffer being parsed
+    bool _indexed;                   // true if _index is in use
+    std::string _carry;              // incomplete line held by feed()
+    bool _feeding;                   // true between feed() and finish()
+    int _threads;                    // threads to use, see setThreads()
+    bool _dotted;                    // true if a top-level name had a "."
+    const char* _line;               // start of the line being scanned
     int _lineno;
-    int _depth;
+    int _count;
+    bool _done;
 };
 
 
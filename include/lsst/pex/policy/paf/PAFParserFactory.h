@@ -61,7 +61,7 @@ public:
      *                       file.  The default is "<?cfg JSON ... ?>"
      */
     PAFParserFactory(const boost::regex& contIdPatt=CONTENTID)
-        : PolicyParserFactory(), contentid(contIdPatt) { }
+        : PolicyParserFactory(), contentid(contIdPatt), _threads(1) { }
 
     /**
      * create a new PolicyParser class and return a pointer to it.  The
@@ -77,6 +77,21 @@ public:
     virtual PolicyParser* createParser(Policy& policy,
                                        bool strict=true) const;
 
+    /**
+     * set the number of threads that the PAFParsers created by this
+     * factory should use when parsing data held in memory.
+     * @see PAFParser::setThreads()
+     * @param nthreads   the number of threads; 0 means one per core.  The
+     *                     default is 1 (serial).
+     */
+    void setThreads(int nthreads) { _threads = nthreads; }
+
+    /**
+     * return the number of threads given to the PAFParsers created by this
+     * factory
+     */
+    int getThreads() const { return _threads; }
+
     /**
      * analyze the given string assuming contains the leading characters
      * from the data stream and return true if it is recognized as being in
@@ -109,6 +124,7 @@ public:
 
 private:
     boost::regex contentid;
+    int _threads;
 };
 
 }}}}   // end lsst::pex::policy::paf
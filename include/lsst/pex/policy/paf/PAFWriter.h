@@ -98,6 +98,12 @@ public:
                               const Policy::PolicyPtrArray& values);
     virtual void writeFiles(const std::string& name,
                             const Policy::FilePtrArray& values);
+    virtual void writeInts(const std::string& name,
+                           const Policy::IntArrayView& values);
+    virtual void writeDoubles(const std::string& name,
+                              const Policy::DoubleArrayView& values);
+    virtual void writeStrings(const std::string& name,
+                              const Policy::StringArrayView& values);
     //@}
 
 protected:
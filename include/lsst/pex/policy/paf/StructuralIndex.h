@@ -0,0 +1,142 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+
+/**
+ * @file StructuralIndex.h
+ *
+ * @ingroup pex
+ *
+ * @brief definition of the StructuralIndex class
+ */
+#ifndef LSST_PEX_POLICY_PAF_STRUCTURALINDEX_H
+#define LSST_PEX_POLICY_PAF_STRUCTURALINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace lsst {
+namespace pex {
+namespace policy {
+namespace paf {
+
+/**
+ * @brief  an index of the characters in a PAF buffer that end tokens
+ *
+ * A StructuralIndex records the offset of every newline, comment
+ * character (#), closing brace and quote character in a buffer, in one
+ * pass over the whole buffer.  PAFParser uses it to split its input into
+ * lines and to jump to the end of quoted and bare string values instead
+ * of examining each character in turn.  (Colons and opening braces are
+ * not indexed: the parser only ever looks for them at its current
+ * position.)
+ *
+ * The pass is vectorized with SSE2 or AVX2 when the CPU supports them;
+ * the best available instruction set is chosen at run time.
+ */
+class StructuralIndex {
+public:
+    /**
+     * the instruction sets that an index can be built with
+     */
+    enum Isa {
+        SCALAR = 0,   ///< portable, one character at a time
+        SSE2,         ///< 16 characters at a time
+        AVX2          ///< 32 characters at a time
+    };
+
+    typedef std::uint32_t Offset;
+
+    /**
+     * the size of the largest buffer that can be indexed
+     */
+    static const std::size_t MAX_SIZE;
+
+    /**
+     * return the best instruction set supported by this CPU
+     */
+    static Isa bestIsa();
+
+    /**
+     * return true if the given instruction set can be used on this CPU
+     */
+    static bool supports(Isa isa);
+
+    /**
+     * return the name of an instruction set, e.g. "AVX2"
+     */
+    static std::string isaName(Isa isa);
+
+    /**
+     * create an empty index
+     * @param isa   the instruction set to build with; if it is not
+     *                supported by this CPU, the best one that is will
+     *                be used instead.
+     */
+    explicit StructuralIndex(Isa isa = bestIsa());
+
+    /**
+     * index the given buffer, replacing any previous contents.  The
+     * buffer must outlive any use of find().
+     * @param data   the buffer to index
+     * @param size   the number of bytes in data; must not exceed MAX_SIZE
+     */
+    void build(const char* data, std::size_t size);
+
+    /**
+     * return the position of the first c1 or c2 in [p, e), or e if there
+     * is none.  p and e must lie within the indexed buffer, and c1 and
+     * c2 must be among the indexed characters.
+     *
+     * The index remembers where the previous search started and resumes
+     * scanning from there, so a sequence of searches whose starting
+     * positions move forward through the buffer (as a lexer's do) costs
+     * time linear in the number of indexed characters overall.  A search
+     * that starts behind the previous one is still answered correctly,
+     * by a binary search.
+     */
+    const char* find(const char* p, const char* e, char c1, char c2) const;
+
+    /**
+     * return the offsets of the indexed characters, in increasing order
+     */
+    const std::vector<Offset>& getOffsets() const { return _offsets; }
+
+    /**
+     * return the instruction set used to build this index
+     */
+    Isa getIsa() const { return _isa; }
+
+private:
+    Isa _isa;
+    const char* _data;
+    std::vector<Offset> _offsets;
+    mutable std::size_t _cursor;   // first offset at or after the last p
+};
+
+
+}}}}   // end lsst::pex::policy::paf
+#endif // LSST_PEX_POLICY_PAF_STRUCTURALINDEX_H
@@ -0,0 +1,201 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+
+/**
+ * @file XMLParser.h
+ *
+ * @ingroup pex
+ *
+ * @brief definition of the XMLParser class
+ */
+#ifndef LSST_PEX_POLICY_XML_XMLPARSER_H
+#define LSST_PEX_POLICY_XML_XMLPARSER_H
+
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "lsst/pex/policy/PolicyParser.h"
+#include "lsst/pex/policy/Policy.h"
+
+namespace lsst {
+namespace pex {
+namespace policy {
+namespace xml {
+
+/**
+ * @brief  a parser for reading XML-formatted data into a Policy object
+ *
+ * The children of the root element (usually \<Policy\>) become the
+ * parameters of the Policy:
+ * @li an element containing other elements becomes a sub-policy;
+ * @li the text of any other element gives its value(s).  The optional
+ *     "t" attribute gives the type: "b" (bool), "i" (int), "d" (double),
+ *     "s" (string), "f" (file) or "p" (policy).  Without it, the type is
+ *     guessed as in PAF: whitespace-separated numbers or booleans become
+ *     arrays, "@file" becomes a file, and anything else is a string;
+ * @li an element that appears more than once has its values appended;
+ * @li an element with no text is ignored, unless its type is "p".
+ *
+ * Text is trimmed of leading and trailing whitespace.  Other attributes
+ * are ignored, except in a dictionary: there, the root element is
+ * \<Dictionary\>, whose attributes (e.g. "target") become parameters,
+ * and each \<parameter name="..."\> element becomes the definition of
+ * that name, with its other attributes loaded as parameters of the
+ * definition.
+ *
+ * Element names must have the form of a PAF parameter name.  The data is
+ * read in a single streaming pass: the only state kept is the stack of
+ * open elements, and each value is sent to the parser's PolicyHandler as
+ * soon as its element is closed.  No document tree is built.  DTDs and
+ * entities other than the predefined ones are not supported.
+ */
+class XMLParser : public PolicyParser {
+public:
+
+    /**
+     * create a parser to load a Policy
+     * @param policy   the Policy object to load the parsed data into
+     */
+    XMLParser(Policy& policy);
+
+    /**
+     * @copydoc XMLParser(Policy&)
+     * @param strict   if true, be strict in reporting errors in file
+     *                   contents and syntax.  If false, errors will be
+     *                   ignored if possible; often, such errors will
+     *                   result in some data not getting loaded.  The
+     *                   default (set by PolicyParser) is true.
+     */
+    XMLParser(Policy& policy, bool strict);
+
+    /**
+     * delete this parser
+     */
+    virtual ~XMLParser();
+
+    /**
+     * parse the data found on the given stream.  The stream is read to
+     * its end and then parsed as a buffer.
+     * @param is      the stream to read XML-encoded data from
+     * @returns int   the number of parameters values loaded.  This does not
+     *                   include sub-Policy objects.
+     */
+    virtual int parse(std::istream& is);
+
+    /**
+     * parse XML-encoded data held in memory.  The buffer is scanned in
+     * place; memory is only allocated for the names and values actually
+     * sent to the handler.
+     * @param data    the data to parse; it need not be null-terminated
+     * @param size    the number of bytes in data
+     * @returns int   the number of parameters values loaded.  This does not
+     *                   include sub-Policy objects.
+     */
+    virtual int parse(const char* data, std::size_t size);
+
+private:
+    // an element that has been started but not yet ended
+    struct Element {
+        std::string tag;                 // its tag name
+        std::string::size_type nameLen;  // the length of _name outside it
+        std::string text;                // the text it contains so far
+        int lineno;                      // the line its start tag is on
+        char type;                       // its "t" attribute, or 0
+        bool opened;                     // true once sent as a sub-policy
+        bool skip;                       // true if it is not to be loaded
+    };
+
+    // read a start tag, an end tag or character data at _p
+    void _startTag();
+    void _endTag();
+    void _text(const char* b, const char* e, bool raw);
+
+    // finish the innermost open element
+    void _endElement();
+
+    // send the element as a sub-policy, if it has not been already
+    void _open(Element& el);
+
+    // send the values given by the text [b, e) for the parameter named
+    // in _name; type is a "t" attribute, or 0 to guess the type
+    void _values(const char* b, const char* e, char type, int lineno);
+
+    // read a tag or attribute name at _p into out
+    void _readName(std::string& out);
+
+    // append the text [b, e) to out, replacing character references
+    void _decode(const char* b, const char* e, std::string& out);
+
+    // skip whitespace within a tag
+    void _skipSpace();
+
+    // move _p forward to q, counting lines
+    void _moveTo(const char* q);
+
+    // move _p past the next occurrence of s, which must be there
+    void _skipPast(const char* s);
+
+    // report a problem with the text [b, e).  With diagnostics set, it
+    // is recorded and true is returned; otherwise the problem is thrown
+    // in strict mode or ignored (returning false).
+    bool _problem(ParserDiagnostics::Kind kind, const char* b, const char* e);
+
+    // report text that cannot be parsed at all, ending the parse
+    void _syntaxError(const char* what);
+
+    // send n values to the handler by calling send(handler).  With
+    // diagnostics set, a value the handler will not take is recorded
+    // rather than thrown.  Returns true if sent.
+    template <typename Send>
+    bool _send(Send send, int n);
+
+    // the handler that values are sent to
+    PolicyHandler& _events() { return (_handler) ? *_handler : _builder; }
+
+    // the policy reference, Policy& _pol, is a member of the parent class
+    std::vector<Element> _elements;  // the open elements, outermost first;
+    std::size_t _depth;              //   only the first _depth are in use
+    std::string _name;               // hierarchical name being loaded
+    std::string _tag;                // the last tag name read
+    std::string _attrName;           // the last attribute read
+    std::string _attrValue;
+    std::vector<std::pair<std::string, std::string> > _attrs;
+                                     // the attributes of a definition
+    Policy::IntArray _ints;          // a run of numbers being loaded
+    Policy::DoubleArray _doubles;
+    bool _dictionary;                // true if the root is <Dictionary>
+    bool _rootDone;                  // true once the root element ends
+    const char* _p;                  // the next character to read
+    const char* _e;                  // the end of the data
+    const char* _line;               // start of the current line
+    int _lineno;
+    int _count;
+};
+
+
+}}}}   // end lsst::pex::policy::xml
+#endif // LSST_PEX_POLICY_XML_XMLPARSER_H
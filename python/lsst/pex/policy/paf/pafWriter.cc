@@ -40,9 +40,12 @@ PYBIND11_MODULE(pafWriter, mod) {
     cls.def(py::init<const std::string&>());
 
     cls.def("writeBools", &PAFWriter::writeBools);
-    cls.def("writeInts", &PAFWriter::writeInts);
-    cls.def("writeDoubles", &PAFWriter::writeDoubles);
-    cls.def("writeStrings", &PAFWriter::writeStrings);
+    cls.def("writeInts",
+            (void (PAFWriter::*)(const std::string&, const Policy::IntArray&)) & PAFWriter::writeInts);
+    cls.def("writeDoubles",
+            (void (PAFWriter::*)(const std::string&, const Policy::DoubleArray&)) & PAFWriter::writeDoubles);
+    cls.def("writeStrings",
+            (void (PAFWriter::*)(const std::string&, const Policy::StringArray&)) & PAFWriter::writeStrings);
     cls.def("writePolicies", &PAFWriter::writePolicies);
     cls.def("writeFiles", &PAFWriter::writeFiles);
 
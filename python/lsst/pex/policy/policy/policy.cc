@@ -141,28 +141,34 @@ PYBIND11_MODULE(policy, mod) {
     // Somehow default arguments don't work here
     clsPolicy.def("validate", [](Policy const& self) { return self.validate(); });
     clsPolicy.def("validate", [](Policy const& self, ValidationError* errs) { return self.validate(errs); });
-    clsPolicy.def("valueCount", &Policy::valueCount);
-    clsPolicy.def("isArray", &Policy::isArray);
-    clsPolicy.def("exists", &Policy::exists);
-    clsPolicy.def("isBool", &Policy::isBool);
-    clsPolicy.def("isInt", &Policy::isInt);
-    clsPolicy.def("isDouble", &Policy::isDouble);
-    clsPolicy.def("isString", &Policy::isString);
-    clsPolicy.def("isPolicy", &Policy::isPolicy);
-    clsPolicy.def("isFile", &Policy::isFile);
+    clsPolicy.def("valueCount", (size_t (Policy::*)(const std::string&) const) & Policy::valueCount);
+    clsPolicy.def("isArray", (bool (Policy::*)(const std::string&) const) & Policy::isArray);
+    clsPolicy.def("exists", (bool (Policy::*)(const std::string&) const) & Policy::exists);
+    clsPolicy.def("isBool", (bool (Policy::*)(const std::string&) const) & Policy::isBool);
+    clsPolicy.def("isInt", (bool (Policy::*)(const std::string&) const) & Policy::isInt);
+    clsPolicy.def("isDouble", (bool (Policy::*)(const std::string&) const) & Policy::isDouble);
+    clsPolicy.def("isString", (bool (Policy::*)(const std::string&) const) & Policy::isString);
+    clsPolicy.def("isPolicy", (bool (Policy::*)(const std::string&) const) & Policy::isPolicy);
+    clsPolicy.def("isFile", (bool (Policy::*)(const std::string&) const) & Policy::isFile);
     clsPolicy.def("getTypeInfo", &Policy::getTypeInfo);
     clsPolicy.def("getPolicy", (Policy::Ptr (Policy::*)(const std::string&)) & Policy::getPolicy);
-    clsPolicy.def("getFile", &Policy::getFile);
-    clsPolicy.def("getBool", &Policy::getBool);
-    clsPolicy.def("getInt", &Policy::getInt);
-    clsPolicy.def("getDouble", &Policy::getDouble);
-    clsPolicy.def("getString", &Policy::getString);
-    clsPolicy.def("getPolicyArray", &Policy::getPolicyArray);
-    clsPolicy.def("getFileArray", &Policy::getFileArray);
-    clsPolicy.def("getBoolArray", &Policy::getBoolArray);
-    clsPolicy.def("getIntArray", &Policy::getIntArray);
-    clsPolicy.def("getDoubleArray", &Policy::getDoubleArray);
-    clsPolicy.def("getStringArray", &Policy::getStringArray);
+    clsPolicy.def("getFile", (Policy::FilePtr (Policy::*)(const std::string&) const) & Policy::getFile);
+    clsPolicy.def("getBool", (bool (Policy::*)(const std::string&) const) & Policy::getBool);
+    clsPolicy.def("getInt", (int (Policy::*)(const std::string&) const) & Policy::getInt);
+    clsPolicy.def("getDouble", (double (Policy::*)(const std::string&) const) & Policy::getDouble);
+    clsPolicy.def("getString", (const std::string (Policy::*)(const std::string&) const) & Policy::getString);
+    clsPolicy.def("getPolicyArray",
+                  (Policy::PolicyPtrArray (Policy::*)(const std::string&)) & Policy::getPolicyArray);
+    clsPolicy.def("getFileArray",
+                  (Policy::FilePtrArray (Policy::*)(const std::string&) const) & Policy::getFileArray);
+    clsPolicy.def("getBoolArray",
+                  (Policy::BoolArray (Policy::*)(const std::string&) const) & Policy::getBoolArray);
+    clsPolicy.def("getIntArray",
+                  (Policy::IntArray (Policy::*)(const std::string&) const) & Policy::getIntArray);
+    clsPolicy.def("getDoubleArray",
+                  (Policy::DoubleArray (Policy::*)(const std::string&) const) & Policy::getDoubleArray);
+    clsPolicy.def("getStringArray",
+                  (Policy::StringArray (Policy::*)(const std::string&) const) & Policy::getStringArray);
     // _set is called from Python set
     clsPolicy.def("_set", (void (Policy::*)(const std::string&, const Policy::Ptr&)) & Policy::set);
     clsPolicy.def("_set", (void (Policy::*)(const std::string&, bool)) & Policy::set);
@@ -174,7 +180,7 @@ PYBIND11_MODULE(policy, mod) {
     clsPolicy.def("add", (void (Policy::*)(const std::string&, int)) & Policy::add);
     clsPolicy.def("add", (void (Policy::*)(const std::string&, double)) & Policy::add);
     clsPolicy.def("add", (void (Policy::*)(const std::string&, const std::string&)) & Policy::add);
-    clsPolicy.def("remove", &Policy::remove);
+    clsPolicy.def("remove", (void (Policy::*)(const std::string&)) & Policy::remove);
     clsPolicy.def("loadPolicyFiles", (int (Policy::*)(bool)) & Policy::loadPolicyFiles, "strict"_a = true);
 
     // boost::filesystem::path is equivalent to str in Python
@@ -190,6 +196,7 @@ PYBIND11_MODULE(policy, mod) {
     clsPolicy.def("toString", &Policy::toString);
     clsPolicy.def("__str__", &Policy::toString);  // Cleanup stringification later
     clsPolicy.def("asPropertySet", &Policy::asPropertySet);
+    clsPolicy.def("toPropertySet", &Policy::toPropertySet);
 }
 
 }  // policy
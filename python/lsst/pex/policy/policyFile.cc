@@ -41,6 +41,7 @@ PYBIND11_MODULE(policyFile, mod) {
     cls.def("exists", &PolicyFile::exists);
     cls.def("getFormatName", (const std::string& (PolicyFile::*)()) & PolicyFile::getFormatName);
     cls.def("load", (void (PolicyFile::*)(Policy&)) & PolicyFile::load);
+    cls.def("read", &PolicyFile::read);
 
     cls.def_readonly_static("EXT_PAF", &PolicyFile::EXT_PAF);
     cls.def_readonly_static("EXT_XML", &PolicyFile::EXT_XML);
@@ -25,6 +25,7 @@
  */
 #include "lsst/pex/policy/Dictionary.h"
 #include "lsst/pex/policy/PolicyFile.h"
+#include "lsst/pex/policy/detail/StringPool.h"
 // #include "lsst/pex/utils/Trace.h"
 
 #include <boost/regex.hpp>
@@ -467,24 +468,39 @@ void Definition::validate(const string& name, const Policy::ConstPolicyPtrArray&
     validateRecurse(name, value, errs);
 }
 
-void Definition::check() const {
-    static set<string> okayKeywords;
-    if (okayKeywords.size() == 0) {
-        okayKeywords.insert(Dictionary::KW_TYPE);
-        okayKeywords.insert(Dictionary::KW_DICT);
-        okayKeywords.insert(Dictionary::KW_DICT_FILE);
-        okayKeywords.insert(Policy::typeName[Policy::FILE]);
-        okayKeywords.insert(Dictionary::KW_MIN_OCCUR);
-        okayKeywords.insert(Dictionary::KW_MAX_OCCUR);
-        okayKeywords.insert(Dictionary::KW_MIN);
-        okayKeywords.insert(Dictionary::KW_MAX);
-        okayKeywords.insert(Dictionary::KW_ALLOWED);
-        okayKeywords.insert(Dictionary::KW_DESCRIPTION);
-        okayKeywords.insert(Dictionary::KW_DEFAULT);
+namespace {
+
+// the keywords allowed in a definition, interned in the global pool so that
+// a name can be checked against them by address
+class DefinitionKeywords {
+public:
+    DefinitionKeywords() {
+        const char* keywords[] = {Dictionary::KW_TYPE,      Dictionary::KW_DICT,
+                                  Dictionary::KW_DICT_FILE, Policy::typeName[Policy::FILE],
+                                  Dictionary::KW_MIN_OCCUR, Dictionary::KW_MAX_OCCUR,
+                                  Dictionary::KW_MIN,       Dictionary::KW_MAX,
+                                  Dictionary::KW_ALLOWED,   Dictionary::KW_DESCRIPTION,
+                                  Dictionary::KW_DEFAULT};
+        for (const char* kw : keywords) _words.insert(&detail::StringPool::global().intern(kw));
+    }
+
+    bool contains(const string& name) const {
+        // a name that has never been interned cannot be a keyword
+        const string* word = detail::StringPool::global().find(name);
+        return word && _words.count(word) == 1;
     }
+
+private:
+    set<const string*> _words;
+};
+
+}  // namespace
+
+void Definition::check() const {
+    static const DefinitionKeywords okayKeywords;
     Policy::StringArray terms = _policy->names(true);
     for (Policy::StringArray::const_iterator i = terms.begin(); i != terms.end(); ++i) {
-        if (okayKeywords.count(*i) == 1)
+        if (okayKeywords.contains(*i))
             continue;
         else
             throw LSST_EXCEPT(DictionaryError,
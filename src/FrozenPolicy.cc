@@ -0,0 +1,250 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+
+
+/**
+ * @file FrozenPolicy.cc
+ * @ingroup pex
+ */
+
+#include "lsst/pex/policy/FrozenPolicy.h"
+#include "lsst/pex/policy/PolicyFile.h"
+#include "lsst/pex/policy/exceptions.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace lsst {
+namespace pex {
+namespace policy {
+
+//@cond
+
+using detail::PolicyData;
+
+namespace {
+
+// the displacements tried for one bucket before another seed is tried
+const std::uint32_t DISPLACE_MAX = 4096;
+
+std::uint64_t mix(std::uint64_t h) {
+    // the finalizer of MurmurHash3
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    return h ^ (h >> 33);
+}
+
+std::uint64_t hashName(const char* b, std::size_t size, std::uint64_t seed) {
+    // FNV-1a, starting from a basis that depends on the seed
+    std::uint64_t hash = 14695981039346656037ULL ^ (seed * 0x9e3779b97f4a7c15ULL);
+    for (const char* e = b + size; b < e; ++b) hash = (hash ^ static_cast<unsigned char>(*b)) * 1099511628211ULL;
+    return mix(hash);
+}
+
+std::uint64_t slotOf(std::uint64_t hash, std::uint32_t displace) {
+    return mix(hash ^ (displace * 0x9e3779b97f4a7c15ULL));
+}
+
+}  // namespace
+
+FrozenPolicy::FrozenPolicy(const Policy& policy)
+    : _data(PolicyData::share(policy._data)), _names(), _entries(), _displace(), _slots(), _seed(0),
+      _bucketMask(0), _slotMask(0) {
+    _build();
+}
+
+Policy::StringArray FrozenPolicy::names() const {
+    Policy::StringArray out;
+    out.reserve(size());
+    for (std::size_t i = 0; i < size(); ++i) out.push_back(std::string(_entries[i].name, _entries[i].size));
+    return out;
+}
+
+bool FrozenPolicy::getBool(const std::string& name) const {
+    const Entry& entry = _require(name, Policy::BOOL);
+    return static_cast<const char*>(entry.values)[entry.count - 1];
+}
+
+int FrozenPolicy::getInt(const std::string& name) const {
+    const Entry& entry = _require(name, Policy::INT);
+    return static_cast<const int*>(entry.values)[entry.count - 1];
+}
+
+double FrozenPolicy::getDouble(const std::string& name) const {
+    const Entry& entry = _require(name, Policy::DOUBLE);
+    return static_cast<const double*>(entry.values)[entry.count - 1];
+}
+
+const std::string& FrozenPolicy::getString(const std::string& name) const {
+    const Entry& entry = _require(name, Policy::STRING);
+    return static_cast<const std::string*>(entry.values)[entry.count - 1];
+}
+
+Policy::FilePtr FrozenPolicy::getFile(const std::string& name) const {
+    const Entry& entry = _require(name, Policy::FILE);
+    Policy::FilePtr out = std::dynamic_pointer_cast<PolicyFile>(
+            static_cast<const PolicyData::PersistablePtr*>(entry.values)[entry.count - 1]);
+    if (! out) throw LSST_EXCEPT(TypeError, name, std::string(Policy::typeName[Policy::FILE]));
+    return out;
+}
+
+ConstPolicyRef FrozenPolicy::getPolicy(const std::string& name) const {
+    const Entry& entry = _require(name, Policy::POLICY);
+    const PolicyData* sub = static_cast<const PolicyData::Ptr*>(entry.values)[entry.count - 1].get();
+    if (! sub) throw LSST_EXCEPT(TypeError, name, std::string(Policy::typeName[Policy::POLICY]));
+    return ConstPolicyRef(sub);
+}
+
+Policy::BoolArray FrozenPolicy::getBoolArray(const std::string& name) const {
+    const Entry& entry = _require(name, Policy::BOOL);
+    const char* b = static_cast<const char*>(entry.values);
+    return Policy::BoolArray(b, b + entry.count);
+}
+
+Policy::IntArrayView FrozenPolicy::getIntArrayView(const std::string& name) const {
+    const Entry& entry = _require(name, Policy::INT);
+    const int* b = static_cast<const int*>(entry.values);
+    return Policy::IntArrayView(b, b + entry.count);
+}
+
+Policy::DoubleArrayView FrozenPolicy::getDoubleArrayView(const std::string& name) const {
+    const Entry& entry = _require(name, Policy::DOUBLE);
+    const double* b = static_cast<const double*>(entry.values);
+    return Policy::DoubleArrayView(b, b + entry.count);
+}
+
+Policy::StringArrayView FrozenPolicy::getStringArrayView(const std::string& name) const {
+    const Entry& entry = _require(name, Policy::STRING);
+    const std::string* b = static_cast<const std::string*>(entry.values);
+    return Policy::StringArrayView(b, b + entry.count);
+}
+
+PolicyArrayView FrozenPolicy::getPolicyArrayView(const std::string& name) const {
+    const Entry& entry = _require(name, Policy::POLICY);
+    const PolicyData::Ptr* b = static_cast<const PolicyData::Ptr*>(entry.values);
+    return PolicyArrayView(ArrayView<PolicyData::Ptr>(b, b + entry.count));
+}
+
+Policy::Ptr FrozenPolicy::thaw() const { return Policy::Ptr(new Policy(PolicyData::share(_data))); }
+
+Fingerprint FrozenPolicy::fingerprint() const { return _data->fingerprint(); }
+
+const FrozenPolicy::Entry& FrozenPolicy::_find(const std::string& name) const {
+    std::uint64_t hash = hashName(name.data(), name.size(), _seed);
+    std::uint32_t displace = _displace[hash & _bucketMask];
+    const Entry& entry = _entries[_slots[slotOf(hash, displace) & _slotMask]];
+    // a name not held shares its slot with some other name, or none
+    bool same = entry.hash == hash && entry.size == name.size() &&
+                std::memcmp(entry.name, name.data(), name.size()) == 0;
+    return same ? entry : _entries.back();
+}
+
+const FrozenPolicy::Entry& FrozenPolicy::_require(const std::string& name, Policy::ValueType type) const {
+    const Entry& entry = _find(name);
+    if (entry.type != std::uint32_t(type)) {
+        if (entry.count == 0) throw LSST_EXCEPT(NameNotFound, name);
+        throw LSST_EXCEPT(TypeError, name, std::string(Policy::typeName[type]));
+    }
+    return entry;
+}
+
+void FrozenPolicy::_build() {
+    std::vector<PolicyData::Flat> flat;
+    _data->flatten(flat);
+    const std::uint32_t n = flat.size();
+
+    std::size_t chars = 0;
+    for (std::uint32_t i = 0; i < n; ++i) chars += flat[i].name.size();
+    _names.resize(chars + 1);
+    _entries.reserve(n + 1);
+    char* at = _names.data();
+    for (std::uint32_t i = 0; i < n; ++i) {
+        std::memcpy(at, flat[i].name.data(), flat[i].name.size());
+        Entry entry = {0, at, flat[i].name.size(), flat[i].values, std::uint32_t(flat[i].type),
+                       std::uint32_t(flat[i].count)};
+        _entries.push_back(entry);
+        at += flat[i].name.size();
+    }
+    // the entry found for names not held: no name has its size
+    Entry none = {0, _names.data(), std::size_t(-1), 0, Policy::UNDEF, 0};
+    _entries.push_back(none);
+
+    // hash and displace: the names are split into buckets of about four
+    // by their hash, then, largest bucket first, each bucket is given the
+    // first displacement sending all its names to free slots.  With at
+    // least twice as many slots as names, this rarely takes long; if a
+    // bucket cannot be placed, everything is rehashed with a new seed.
+    std::size_t slots = 1, buckets = 1;
+    while (slots < 2 * std::size_t(n)) slots *= 2;
+    while (4 * buckets < n) buckets *= 2;
+    _slotMask = slots - 1;
+    _bucketMask = buckets - 1;
+
+    std::vector<std::vector<std::uint32_t> > members(buckets);
+    std::vector<std::uint32_t> order(buckets);
+    for (_seed = 0;; ++_seed) {
+        for (std::size_t b = 0; b < buckets; ++b) {
+            members[b].clear();
+            order[b] = b;
+        }
+        for (std::uint32_t i = 0; i < n; ++i) {
+            _entries[i].hash = hashName(_entries[i].name, _entries[i].size, _seed);
+            members[_entries[i].hash & _bucketMask].push_back(i);
+        }
+        std::stable_sort(order.begin(), order.end(), [&members](std::uint32_t a, std::uint32_t b) {
+            return members[a].size() > members[b].size();
+        });
+
+        _displace.assign(buckets, 0);
+        _slots.assign(slots, n);
+        bool placed = true;
+        for (std::size_t k = 0; k < buckets && placed && ! members[order[k]].empty(); ++k) {
+            const std::vector<std::uint32_t>& bucket = members[order[k]];
+            placed = false;
+            for (std::uint32_t d = 0; d < DISPLACE_MAX && ! placed; ++d) {
+                std::size_t done = 0;
+                for (; done < bucket.size(); ++done) {
+                    std::uint64_t slot = slotOf(_entries[bucket[done]].hash, d) & _slotMask;
+                    if (_slots[slot] != n) break;
+                    _slots[slot] = bucket[done];
+                }
+                placed = (done == bucket.size());
+                if (! placed) {
+                    // undo a partial placement
+                    while (done-- > 0) _slots[slotOf(_entries[bucket[done]].hash, d) & _slotMask] = n;
+                } else {
+                    _displace[order[k]] = d;
+                }
+            }
+        }
+        if (placed) return;
+    }
+}
+
+//@endcond
+
+}  // namespace policy
+}  // namespace pex
+}  // namespace lsst
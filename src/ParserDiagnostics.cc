@@ -0,0 +1,101 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file ParserDiagnostics.cc
+ * @ingroup pex
+ */
+
+#include "lsst/pex/policy/ParserDiagnostics.h"
+
+namespace lsst {
+namespace pex {
+namespace policy {
+
+//@cond
+
+using std::size_t;
+using std::string;
+
+const size_t ParserDiagnostics::EXCERPT_MAX = 40;
+
+string ParserDiagnostics::Problem::getMessage() const {
+    return describe(kind) + excerpt;
+}
+
+ParserDiagnostics::ParserDiagnostics(size_t cap, size_t failFast)
+        : _problems(), _count(0), _cap(cap), _failFast(failFast) {}
+
+bool ParserDiagnostics::report(int line, int column, Kind kind, const char* b, const char* e) {
+    ++_count;
+    if (_problems.size() < _cap) {
+        _problems.push_back(Problem());
+        Problem& p = _problems.back();
+        p.line = line;
+        p.column = column;
+        p.kind = kind;
+        if (b && e > b) p.excerpt.assign(b, (size_t(e - b) > EXCERPT_MAX) ? b + EXCERPT_MAX : e);
+    }
+    return ! failed();
+}
+
+void ParserDiagnostics::clear() {
+    _problems.clear();
+    _count = 0;
+}
+
+const char* ParserDiagnostics::describe(Kind kind) {
+    switch (kind) {
+    case BAD_NAME:
+        return "Bad parameter name format: ";
+    case EXPECTED_DOUBLE:
+        return "Expecting double value, found: ";
+    case EXPECTED_INT:
+        return "Expecting integer value, found: ";
+    case EXPECTED_BOOL:
+        return "Expecting boolean value, found: ";
+    case EXPECTED_STRING:
+        return "Expecting quoted string value, found: ";
+    case UNSUPPORTED_LONG:
+        return "unsupported long integer value found: ";
+    case EXTRA_BRACE:
+        return "extra '}' character encountered.";
+    case UNTERMINATED_STRING:
+    case UNEXPECTED_EOF:
+        return "Unexpected end of Policy data stream";
+    case READ_ERROR:
+        return "read error";
+    case REJECTED_VALUE:
+        return "value rejected: ";
+    case SYNTAX_ERROR:
+        return "Syntax error: ";
+    case UNSUPPORTED_ARRAY:
+        return "nested arrays are not supported: ";
+    }
+    return "Unspecified parsing error encountered";
+}
+
+//@endcond
+
+}  // namespace policy
+}  // namespace pex
+}  // namespace lsst
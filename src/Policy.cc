@@ -24,6 +24,9 @@
  * \file Policy.cc
  */
 #include "lsst/pex/policy/Policy.h"
+#include "lsst/pex/policy/PolicyRef.h"
+#include "lsst/pex/policy/FrozenPolicy.h"
+#include "lsst/pex/policy/PolicyDiff.h"
 #include "lsst/pex/policy/PolicyFile.h"
 #include "lsst/pex/policy/UrnPolicyFile.h"
 #include "lsst/pex/policy/PolicySource.h"
@@ -53,31 +56,44 @@ namespace policy {
 
 using dafBase::Persistable;
 using dafBase::PropertySet;
+using detail::PolicyData;
 
 const char* const Policy::typeName[] = {"undefined", "bool",   "int",       "double",
                                         "string",    "Policy", "PolicyFile"};
 
+static_assert(int(Policy::UNDEF) == int(PolicyData::UNDEF) && int(Policy::BOOL) == int(PolicyData::BOOL) &&
+                      int(Policy::INT) == int(PolicyData::INT) &&
+                      int(Policy::DOUBLE) == int(PolicyData::DOUBLE) &&
+                      int(Policy::STRING) == int(PolicyData::STRING) &&
+                      int(Policy::POLICY) == int(PolicyData::POLICY) && int(Policy::FILE) == int(PolicyData::FILE),
+              "Policy::ValueType and PolicyData::Type must match");
+
 /*
  * Create an empty policy
  */
-Policy::Policy() : Persistable(), _data(new PropertySet()) {}
+Policy::Policy() : Persistable(), _data(new PolicyData()) {}
+
+/*
+ * Create an empty policy whose storage comes from an arena
+ */
+Policy::Policy(const PolicyArena::Ptr& arena) : Persistable(), _data(detail::allocateShared<PolicyData>(arena, arena)) {}
 
 /*
  * Create policy
  */
-Policy::Policy(const PolicySource& source) : Persistable(), _data(new PropertySet()) { source.load(*this); }
+Policy::Policy(const PolicySource& source) : Persistable(), _data(new PolicyData()) { source.load(*this); }
 
 /*
  * Create a Policy from a named file or URN.
  */
-Policy::Policy(const string& pathOrUrn) : Persistable(), _data(new PropertySet()) {
+Policy::Policy(const string& pathOrUrn) : Persistable(), _data(new PolicyData()) {
     createPolicyFile(pathOrUrn, true)->load(*this);
 }
 
 /*
  * Create a Policy from a named file or URN.
  */
-Policy::Policy(const char* pathOrUrn) : Persistable(), _data(new PropertySet()) {
+Policy::Policy(const char* pathOrUrn) : Persistable(), _data(new PolicyData()) {
     createPolicyFile(pathOrUrn, true)->load(*this);
 }
 
@@ -129,7 +145,7 @@ void extractDefaults(Policy& target, const Dictionary& dict, ValidationError& ve
  *                    in \c dict.  The default is the current directory.
  */
 Policy::Policy(bool validate, const Dictionary& dict, const fs::path& repository)
-        : Persistable(), _data(new PropertySet()) {
+        : Persistable(), _data(new PolicyData()) {
     DictPtr loadedDict;  // the dictionary that has all policy files loaded
     if (validate) {      // keep loadedDict around for future validation
         setDictionary(dict);
@@ -145,18 +161,34 @@ Policy::Policy(bool validate, const Dictionary& dict, const fs::path& repository
 }
 
 /*
- * copy a Policy.  Sub-policy objects will not be shared.
+ * copy a Policy.  Sub-policy objects are shared only until either is changed.
+ */
+Policy::Policy(const Policy& pol) : Persistable(), _data() { _data = PolicyData::share(pol._data); }
+
+/*
+ * replace the contents of this Policy by a copy of those of another
  */
-Policy::Policy(const Policy& pol) : Persistable(), _data() { _data = pol._data->deepCopy(); }
+Policy& Policy::operator=(const Policy& pol) {
+    if (this != &pol) {
+        _data = PolicyData::share(pol._data);
+        _dictionary = pol._dictionary;
+        _pending.clear();
+    }
+    return *this;
+}
 
 /*
  * copy a Policy.  Sub-policy objects will be shared unless deep is true
  */
 Policy::Policy(Policy& pol, bool deep) : Persistable(), _data() {
-    if (deep)
-        _data = pol._data->deepCopy();
-    else
+    if (deep) {
+        _data = PolicyData::share(pol._data);
+    } else {
+        // both now refer to the same data, so it may not be shared with copies
+        pol._detach();
+        pol._data->pinLevel();
         _data = pol._data;
+    }
 }
 
 Policy* Policy::_createPolicy(PolicySource& source, bool doIncludes, const fs::path& repository,
@@ -282,37 +314,8 @@ Policy::ValueType Policy::getTypeByName(const string& name) {
  * @return int  the number of names added
  */
 int Policy::_names(vector<string>& names, bool topLevelOnly, bool append, int want) const {
-    bool shouldCheck = true;
-    vector<string> src;
-    int have = 0, count = 0;
-    if (want == 1) {
-        src = _data->propertySetNames(topLevelOnly);
-        have = 1;
-        shouldCheck = false;
-    } else if (want == 7)
-        src = _data->names(topLevelOnly);
-    else
-        src = _data->paramNames(topLevelOnly);
-
     if (!append) names.erase(names.begin(), names.end());
-
-    StringArray::iterator i;
-    for (i = src.begin(); i != src.end(); ++i) {
-        if (shouldCheck) {
-            if (isPolicy(*i))
-                have = 1;
-            else if (isFile(*i))
-                have = 2;
-            else
-                have = 4;
-        }
-        if ((have & want) > 0) {
-            names.push_back(*i);
-            count++;
-        }
-    }
-
-    return count;
+    return _data->names(names, topLevelOnly, want);
 }
 
 /*
@@ -330,35 +333,13 @@ int Policy::_names(vector<string>& names, bool topLevelOnly, bool append, int wa
  * @return int  the number of names added
  */
 int Policy::_names(list<string>& names, bool topLevelOnly, bool append, int want) const {
-    bool shouldCheck = true;
     vector<string> src;
-    int have = 0, count = 0;
-    if (want == 1) {
-        src = _data->propertySetNames(topLevelOnly);
-        have = 1;
-        shouldCheck = false;
-    } else if (want == 7)
-        src = _data->names(topLevelOnly);
-    else
-        src = _data->paramNames(topLevelOnly);
+    int count = _data->names(src, topLevelOnly, want);
 
     if (!append) names.erase(names.begin(), names.end());
 
     StringArray::iterator i;
-    for (i = src.begin(); i != src.end(); ++i) {
-        if (shouldCheck) {
-            if (isPolicy(*i))
-                have = 1;
-            else if (isFile(*i))
-                have = 2;
-            else
-                have = 4;
-        }
-        if ((have & want) > 0) {
-            names.push_back(*i);
-            count++;
-        }
-    }
+    for (i = src.begin(); i != src.end(); ++i) names.push_back(std::move(*i));
 
     return count;
 }
@@ -388,35 +369,7 @@ template void Policy::_validate<int>(std::string const&, int const&, int);
  * a given name.
  */
 Policy::ValueType Policy::getValueType(const string& name) const {
-    try {
-        const std::type_info& tp = _data->typeOf(name);
-
-        // handle the special case of FilePtr first
-        if (tp == daf::base::PropertySet::typeOfT<std::shared_ptr<daf::base::Persistable>>()) {
-            try {
-                getFile(name);
-                return FILE;
-            } catch (...) {
-            }
-        }
-
-        if (tp == typeid(bool)) {
-            return BOOL;
-        } else if (tp == typeid(int)) {
-            return INT;
-        } else if (tp == typeid(double)) {
-            return DOUBLE;
-        } else if (tp == typeid(string)) {
-            return STRING;
-        } else if (tp == daf::base::PropertySet::typeOfT<std::shared_ptr<daf::base::PropertySet>>()) {
-            return POLICY;
-        } else {
-            throw LSST_EXCEPT(pexExcept::LogicError,
-                              string("Policy: illegal type held by PropertySet: ") + tp.name());
-        }
-    } catch (pexExcept::NotFoundError&) {
-        return UNDEF;
-    }
+    return ValueType(_data->valueType(name));
 }
 
 template <>
@@ -556,29 +509,141 @@ void Policy::addValue(const string& name, const FilePtr& value) {
     add(name, value);
 }
 
-Policy::ConstPolicyPtrArray Policy::getConstPolicyArray(const string& name) const {
-    ConstPolicyPtrArray out;
-    vector<PropertySet::Ptr> psa = _getPropSetList(name);
-    vector<PropertySet::Ptr>::const_iterator i;
-    for (i = psa.begin(); i != psa.end(); ++i) out.push_back(ConstPtr(new Policy(*i)));
+// the sub-policies returned by a const Policy stay views of it without its
+// data being detached, which would race with other threads reading it: they
+// are pinned now if they are not shared with a copy, and otherwise before
+// they can next be changed through this Policy (see PolicyData::pinViews())
+template <typename P, typename Name>
+vector<std::shared_ptr<P> > Policy::_getViews(const Name& name, bool lastOnly) const {
+    ArrayView<PolicyData::Ptr> subs = _data->getView<PolicyData::Ptr>(name);
+    size_t first = lastOnly ? subs.size() - 1 : 0;
+    vector<std::shared_ptr<P> > out;
+    vector<std::shared_ptr<PolicyData::Ptr> > slots;
+    for (size_t i = first; i < subs.size(); ++i) {
+        Ptr view(new Policy(subs[i]));
+        slots.push_back(std::shared_ptr<PolicyData::Ptr>(view, &view->_data));
+        out.push_back(view);
+    }
+    PolicyData::pinViews(_data, name, first, slots, _pending);
     return out;
 }
 
-Policy::PolicyPtrArray Policy::getPolicyArray(const string& name) const {
+Policy::ConstPtr Policy::getPolicy(const string& name) const { return _getViews<const Policy>(name, true)[0]; }
+
+Policy::ConstPtr Policy::getPolicy(const PolicyKey& key) const { return _getViews<const Policy>(key, true)[0]; }
+
+template <typename P, typename Name>
+vector<std::shared_ptr<P> > Policy::_getPolicyArray(const Name& name) const {
+    try {
+        return _getViews<P>(name, false);
+    } catch (pexExcept::NotFoundError&) {
+        throw LSST_EXCEPT(NameNotFound, name);
+    } catch (pexExcept::TypeError&) {
+        throw LSST_EXCEPT(TypeError, name, string(typeName[POLICY]));
+    }
+}
+
+// the sub-policies returned are pinned, so that they stay views of this one
+template <typename Name>
+Policy::PolicyPtrArray Policy::_getPolicyArrayForUpdate(const Name& name) {
+    _detach();
+    try {
+        _data->pin(name);
+    } catch (pexExcept::NotFoundError&) {
+        throw LSST_EXCEPT(NameNotFound, name);
+    } catch (pexExcept::TypeError&) {
+        throw LSST_EXCEPT(TypeError, name, string(typeName[POLICY]));
+    }
     PolicyPtrArray out;
-    vector<PropertySet::Ptr> psa = _getPropSetList(name);
-    vector<PropertySet::Ptr>::const_iterator i;
+    vector<PolicyData::Ptr> psa = _getPolicyDataList(name);
+    vector<PolicyData::Ptr>::const_iterator i;
     for (i = psa.begin(); i != psa.end(); ++i) out.push_back(Ptr(new Policy(*i)));
     return out;
 }
 
-Policy::FilePtr Policy::getFile(const string& name) const {
-    FilePtr out = std::dynamic_pointer_cast<PolicyFile>(_data->getAsPersistablePtr(name));
+Policy::ConstPolicyPtrArray Policy::getConstPolicyArray(const string& name) const {
+    return _getPolicyArray<const Policy>(name);
+}
+
+Policy::ConstPolicyPtrArray Policy::getConstPolicyArray(const PolicyKey& key) const {
+    return _getPolicyArray<const Policy>(key);
+}
+
+Policy::PolicyPtrArray Policy::getPolicyArray(const string& name) { return _getPolicyArrayForUpdate(name); }
+
+Policy::PolicyPtrArray Policy::getPolicyArray(const PolicyKey& key) { return _getPolicyArrayForUpdate(key); }
+
+Policy::PolicyPtrArray Policy::getPolicyArray(const string& name) const {
+    return _getPolicyArray<Policy>(name);
+}
+
+Policy::PolicyPtrArray Policy::getPolicyArray(const PolicyKey& key) const {
+    return _getPolicyArray<Policy>(key);
+}
+
+template <typename Name>
+ArrayView<PolicyData::Ptr> Policy::_getPolicyView(const Name& name) const {
+    POL_GETVIEW(name, PolicyData::Ptr, POLICY)
+}
+
+std::shared_ptr<const FrozenPolicy> Policy::freeze() const {
+    return FrozenPolicy::ConstPtr(new FrozenPolicy(*this));
+}
+
+PolicyDiff Policy::diff(const Policy& other) const {
+    vector<PolicyData::Difference> found;
+    _data->diff(*other._data, found);
+
+    PolicyDiff patch;
+    patch._changes.reserve(found.size());
+    for (vector<PolicyData::Difference>::const_iterator it = found.begin(); it != found.end(); ++it) {
+        PolicyDiff::Change change = {it->name, PolicyDiff::Kind(it->kind)};
+        patch._changes.push_back(change);
+        if (it->kind != PolicyData::Difference::ADDED) patch._old->_data->assign(it->name, *_data);
+        if (it->kind != PolicyData::Difference::REMOVED) patch._new->_data->assign(it->name, *other._data);
+    }
+    return patch;
+}
+
+void Policy::apply(const PolicyDiff& patch) {
+    _detach();
+    for (PolicyDiff::ChangeList::const_iterator it = patch._changes.begin(); it != patch._changes.end(); ++it)
+        _data->assign(it->name, *patch._new->_data);
+}
+
+Fingerprint Policy::fingerprint() const { return _data->fingerprint(); }
+
+ConstPolicyRef Policy::getPolicyRef(const string& name) const {
+    return ConstPolicyRef(*this).getPolicy(name);
+}
+
+ConstPolicyRef Policy::getPolicyRef(const PolicyKey& key) const { return ConstPolicyRef(*this).getPolicy(key); }
+
+PolicyRef Policy::getPolicyRef(const string& name) { return PolicyRef(*this).getPolicy(name); }
+
+PolicyRef Policy::getPolicyRef(const PolicyKey& key) { return PolicyRef(*this).getPolicy(key); }
+
+PolicyArrayView Policy::getPolicyArrayView(const string& name) const {
+    return PolicyArrayView(_getPolicyView(name));
+}
+
+PolicyArrayView Policy::getPolicyArrayView(const PolicyKey& key) const {
+    return PolicyArrayView(_getPolicyView(key));
+}
+
+template <typename Name>
+Policy::FilePtr Policy::_getFile(const Name& name) const {
+    FilePtr out = std::dynamic_pointer_cast<PolicyFile>(_data->get<Persistable::Ptr>(name));
     if (!out.get()) throw LSST_EXCEPT(TypeError, name, string(typeName[FILE]));
     return out;
 }
 
-Policy::FilePtrArray Policy::getFileArray(const string& name) const {
+Policy::FilePtr Policy::getFile(const string& name) const { return _getFile(name); }
+
+Policy::FilePtr Policy::getFile(const PolicyKey& key) const { return _getFile(key); }
+
+template <typename Name>
+Policy::FilePtrArray Policy::_getFileArray(const Name& name) const {
     FilePtrArray out;
     vector<Persistable::Ptr> pfa = _getPersistList(name);
     vector<Persistable::Ptr>::const_iterator i;
@@ -592,14 +657,30 @@ Policy::FilePtrArray Policy::getFileArray(const string& name) const {
     return out;
 }
 
+Policy::FilePtrArray Policy::getFileArray(const string& name) const { return _getFileArray(name); }
+
+Policy::FilePtrArray Policy::getFileArray(const PolicyKey& key) const { return _getFileArray(key); }
+
 void Policy::set(const string& name, const FilePtr& value) {
+    _detach();
     _data->set(name, std::dynamic_pointer_cast<Persistable>(value));
 }
 
+void Policy::set(const PolicyKey& key, const FilePtr& value) {
+    _detach();
+    _data->set(key, std::dynamic_pointer_cast<Persistable>(value));
+}
+
 void Policy::add(const string& name, const FilePtr& value) {
+    _detach();
     _data->add(name, std::dynamic_pointer_cast<Persistable>(value));
 }
 
+void Policy::add(const PolicyKey& key, const FilePtr& value) {
+    _detach();
+    _data->add(key, std::dynamic_pointer_cast<Persistable>(value));
+}
+
 /**
  * Recursively replace all PolicyFile values with the contents of the
  * files they refer to.  The type of a parameter containing a PolicyFile
@@ -723,16 +804,18 @@ int Policy::mergeDefaults(const Policy& defaultPol, bool keepForValidation, Vali
                 BoolArray::iterator vi;
                 for (vi = a.begin(); vi != a.end(); ++vi) add(*nm, *vi);
             } else if (tp == typeid(int)) {
-                IntArray a = def->getIntArray(*nm);
-                IntArray::iterator vi;
+                // def's values are not changed by adding to this Policy: a
+                // sub-policy shared by both would already hold the name
+                IntArrayView a = def->getIntArrayView(*nm);
+                IntArrayView::iterator vi;
                 for (vi = a.begin(); vi != a.end(); ++vi) add(*nm, *vi);
             } else if (tp == typeid(double)) {
-                DoubleArray a = def->getDoubleArray(*nm);
-                DoubleArray::iterator vi;
+                DoubleArrayView a = def->getDoubleArrayView(*nm);
+                DoubleArrayView::iterator vi;
                 for (vi = a.begin(); vi != a.end(); ++vi) add(*nm, *vi);
             } else if (tp == typeid(string)) {
-                StringArray a = def->getStringArray(*nm);
-                StringArray::iterator vi;
+                StringArrayView a = def->getStringArrayView(*nm);
+                StringArrayView::iterator vi;
                 for (vi = a.begin(); vi != a.end(); ++vi) add(*nm, *vi);
             } else if (def->isFile(*nm)) {
                 FilePtrArray a = def->getFileArray(*nm);
@@ -786,29 +869,29 @@ string Policy::str(const string& name, const string& indent) const {
                 if (vi + 1 != b.end()) out << ", ";
             }
         } else if (tp == typeid(int)) {
-            IntArray i = getIntArray(name);
-            IntArray::iterator vi;
+            IntArrayView i = getIntArrayView(name);
+            IntArrayView::iterator vi;
             for (vi = i.begin(); vi != i.end(); ++vi) {
                 out << *vi;
                 if (vi + 1 != i.end()) out << ", ";
             }
         } else if (tp == typeid(double)) {
-            DoubleArray d = getDoubleArray(name);
-            DoubleArray::iterator vi;
+            DoubleArrayView d = getDoubleArrayView(name);
+            DoubleArrayView::iterator vi;
             for (vi = d.begin(); vi != d.end(); ++vi) {
                 out << *vi;
                 if (vi + 1 != d.end()) out << ", ";
             }
         } else if (tp == typeid(string)) {
-            StringArray s = _data->getArray<string>(name);
-            StringArray::iterator vi;
+            StringArrayView s = getStringArrayView(name);
+            StringArrayView::iterator vi;
             for (vi = s.begin(); vi != s.end(); ++vi) {
                 out << '"' << *vi << '"';
                 if (vi + 1 != s.end()) out << ", ";
             }
         } else if (tp == daf::base::PropertySet::typeOfT<std::shared_ptr<daf::base::PropertySet>>()) {
-            vector<PropertySet::Ptr> p = _data->getArray<PropertySet::Ptr>(name);
-            vector<PropertySet::Ptr>::iterator vi;
+            ArrayView<PolicyData::Ptr> p = _data->getView<PolicyData::Ptr>(name);
+            ArrayView<PolicyData::Ptr>::iterator vi;
             for (vi = p.begin(); vi != p.end(); ++vi) {
                 out << "{\n";
                 Policy(*vi).print(out, "", indent + "  ");
@@ -0,0 +1,92 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+
+/**
+ * @file PolicyArena.cc
+ * @ingroup pex
+ */
+
+#include "lsst/pex/policy/PolicyArena.h"
+
+#include <new>
+
+namespace lsst {
+namespace pex {
+namespace policy {
+
+//@cond
+
+namespace {
+
+// the alignment of every block handed out
+const std::size_t ALIGN = alignof(std::max_align_t);
+
+}  // namespace
+
+PolicyArena::PolicyArena(std::size_t chunkBytes)
+    : _chunkBytes(chunkBytes < 1024 ? 1024 : chunkBytes), _maxChunkBytes(64 * _chunkBytes), _next(0), _end(0),
+      _allocated(0), _chunks(), _lock() {}
+
+PolicyArena::~PolicyArena() {
+    for (std::vector<char*>::iterator it = _chunks.begin(); it != _chunks.end(); ++it) ::operator delete(*it);
+}
+
+void* PolicyArena::allocate(std::size_t bytes) {
+    bytes = (bytes + ALIGN - 1) & ~(ALIGN - 1);
+    std::lock_guard<std::mutex> hold(_lock);
+    _allocated += bytes;
+    if (bytes <= std::size_t(_end - _next)) {
+        char* out = _next;
+        _next += bytes;
+        return out;
+    }
+
+    // a block larger than a quarter of a chunk gets one of its own, so as
+    // not to waste what is left of the current one
+    _chunks.reserve(_chunks.size() + 1);
+    if (4 * bytes > _chunkBytes) {
+        _chunks.push_back(static_cast<char*>(::operator new(bytes)));
+        return _chunks.back();
+    }
+    _chunks.push_back(static_cast<char*>(::operator new(_chunkBytes)));
+    _next = _chunks.back() + bytes;
+    _end = _chunks.back() + _chunkBytes;
+    if (_chunkBytes < _maxChunkBytes) _chunkBytes *= 2;
+    return _chunks.back();
+}
+
+std::size_t PolicyArena::getBytesAllocated() const {
+    std::lock_guard<std::mutex> hold(_lock);
+    return _allocated;
+}
+
+std::size_t PolicyArena::getChunkCount() const {
+    std::lock_guard<std::mutex> hold(_lock);
+    return _chunks.size();
+}
+
+//@endcond
+
+}  // namespace policy
+}  // namespace pex
+}  // namespace lsst
@@ -28,7 +28,13 @@
  * @author Ray Plante
  *
  */
-#include <fstream>
+#include <string>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include <boost/filesystem/convenience.hpp>
 
@@ -37,6 +43,9 @@
 #include "lsst/pex/policy/exceptions.h"
 #include "lsst/pex/policy/parserexceptions.h"
 #include "lsst/pex/policy/paf/PAFParserFactory.h"
+#include "lsst/pex/policy/json/JSONParserFactory.h"
+#include "lsst/pex/policy/xml/XMLParserFactory.h"
+#include "lsst/pex/policy/binary/BinaryParserFactory.h"
 /*
  * Workaround for boost::filesystem v2 (not needed in boost >= 1.46)
  */
@@ -58,17 +67,81 @@ namespace policy {
 //@cond
 
 using boost::regex;
-using boost::regex_match;
-using boost::regex_search;
+using lsst::pex::policy::binary::BinaryParserFactory;
+using lsst::pex::policy::json::JSONParserFactory;
 using lsst::pex::policy::paf::PAFParserFactory;
-using std::ifstream;
+using lsst::pex::policy::xml::XMLParserFactory;
 using std::string;
 using std::unique_ptr;
 
 namespace pexExcept = lsst::pex::exceptions;
 
+namespace {
+
+/*
+ * the contents of a file, memory-mapped when possible and map is true.
+ * Files that cannot be mapped (e.g. empty files or pipes) are read into
+ * memory instead.
+ */
+class FileData {
+public:
+    FileData(const fs::path& file, bool map) : _data(0), _size(0), _mapped(false), _buf() {
+        int fd = ::open(file.string().c_str(), O_RDONLY);
+        if (fd < 0)
+            throw LSST_EXCEPT(pexExcept::IoError, "failure opening Policy file: " + fs::absolute(file).string());
+
+        struct stat st;
+        if (map && ::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+            void* addr = ::mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr != MAP_FAILED) {
+                ::madvise(addr, st.st_size, MADV_SEQUENTIAL);
+                _data = static_cast<const char*>(addr);
+                _size = st.st_size;
+                _mapped = true;
+            }
+        }
+
+        if (!_mapped) {
+            char chunk[8192];
+            ssize_t n;
+            while ((n = ::read(fd, chunk, sizeof(chunk))) != 0) {
+                if (n < 0) {
+                    if (errno == EINTR) continue;
+                    ::close(fd);
+                    throw LSST_EXCEPT(pexExcept::IoError,
+                                      "failure reading Policy file: " + fs::absolute(file).string());
+                }
+                _buf.append(chunk, n);
+            }
+            _data = _buf.data();
+            _size = _buf.size();
+        }
+        ::close(fd);
+    }
+
+    ~FileData() {
+        if (_mapped) ::munmap(const_cast<char*>(_data), _size);
+    }
+
+    const char* data() const { return _data; }
+    std::size_t size() const { return _size; }
+
+private:
+    FileData(const FileData&);
+    FileData& operator=(const FileData&);
+
+    const char* _data;
+    std::size_t _size;
+    bool _mapped;
+    string _buf;
+};
+
+}  // namespace
+
 const string PolicyFile::EXT_PAF(".paf");
 const string PolicyFile::EXT_XML(".xml");
+const string PolicyFile::EXT_JSON(".json");
+const string PolicyFile::EXT_BINARY(".pafc");
 
 const regex PolicyFile::SPACE_RE("^\\s*$");
 const regex PolicyFile::COMMENT("^\\s*#");
@@ -92,12 +165,12 @@ PolicyFile::PolicyFile(const fs::path& filepath, const SupportedFormats::Ptr& fm
 
 PolicyFile::PolicyFile(const string& filepath, const PolicyParserFactory::Ptr& parserFactory)
         : PolicySource(), Persistable(), _file(filepath), _format(), _pfact(parserFactory) {
-    if (!_pfact.get()) _format = _pfact->getFormatName();
+    if (_pfact.get()) _format = _pfact->getFormatName();
 }
 
 PolicyFile::PolicyFile(const fs::path& filepath, const PolicyParserFactory::Ptr& parserFactory)
         : PolicySource(), Persistable(), _file(filepath), _format(), _pfact(parserFactory) {
-    if (!_pfact.get()) _format = _pfact->getFormatName();
+    if (_pfact.get()) _format = _pfact->getFormatName();
 }
 
 PolicyFile::PolicyFile(const string& filepath, const fs::path& reposDir, const SupportedFormats::Ptr& fmts)
@@ -114,14 +187,14 @@ PolicyFile::PolicyFile(const string& filepath, const fs::path& reposDir,
                        const PolicyParserFactory::Ptr& parserFactory)
         : PolicySource(), Persistable(), _file(filepath), _format(), _pfact(parserFactory) {
     if (!_file.has_root_path() && !reposDir.empty()) _file = reposDir / _file;
-    if (!_pfact.get()) _format = _pfact->getFormatName();
+    if (_pfact.get()) _format = _pfact->getFormatName();
 }
 
 PolicyFile::PolicyFile(const fs::path& filepath, const fs::path& reposDir,
                        const PolicyParserFactory::Ptr& parserFactory)
         : PolicySource(), Persistable(), _file(filepath), _format(), _pfact(parserFactory) {
     if (!_file.has_root_path() && !reposDir.empty()) _file = reposDir / _file;
-    if (!_pfact.get()) _format = _pfact->getFormatName();
+    if (_pfact.get()) _format = _pfact->getFormatName();
 }
 
 /*
@@ -135,45 +208,42 @@ const string& PolicyFile::getFormatName() {
     if (_file.empty()) return PolicyParserFactory::UNRECOGNIZED;
 
     // check the extension first
-    string ext = fs::extension(_file);
-    if (!ext.empty()) {
-        if (ext == EXT_PAF) {
-            if (_formats->supports(PAFParserFactory::FORMAT_NAME))
-                return cacheName(PAFParserFactory::FORMAT_NAME);
-        } else if (ext == EXT_XML) {
-            return cacheName("XML");
-        }
-    }
+    const string& byExtension = formatFromExtension();
+    if (!byExtension.empty()) return cacheName(byExtension);
 
     // try reading the initial characters
     if (fs::exists(_file)) {
-        ifstream is(_file.string().c_str());
-        if (is.fail())
-            throw LSST_EXCEPT(pexExcept::IoError,
-                              "failure opening Policy file: " + fs::absolute(_file).string());
-
-        // skip over comments
-        string line;
-        getline(is, line);
-        while (is.good() && (regex_match(line, SPACE_RE) ||
-                             (regex_search(line, COMMENT) && !regex_search(line, COMMENT)))) {
-        }
+        FileData data(_file, true);
+        return formatFromData(data.data(), data.size());
+    }
 
-        if (is.fail())
-            throw LSST_EXCEPT(pexExcept::IoError,
-                              "failure reading Policy file: " + fs::absolute(_file).string());
-        if (is.eof() &&
-            (regex_match(line, SPACE_RE) || (regex_search(line, COMMENT) && !regex_search(line, COMMENT)))) {
-            // empty file; let's just assume PAF (but don't cache the name).
-            return PAFParserFactory::FORMAT_NAME;
-        }
+    return PolicyParserFactory::UNRECOGNIZED;
+}
 
-        return cacheName(_formats->recognizeType(line));
+const string& PolicyFile::formatFromExtension() const {
+    string ext = fs::extension(_file);
+    if (ext == EXT_PAF) {
+        if (_formats->supports(PAFParserFactory::FORMAT_NAME)) return PAFParserFactory::FORMAT_NAME;
+    } else if (ext == EXT_JSON) {
+        if (_formats->supports(JSONParserFactory::FORMAT_NAME)) return JSONParserFactory::FORMAT_NAME;
+    } else if (ext == EXT_XML) {
+        if (_formats->supports(XMLParserFactory::FORMAT_NAME)) return XMLParserFactory::FORMAT_NAME;
+    } else if (ext == EXT_BINARY) {
+        if (_formats->supports(BinaryParserFactory::FORMAT_NAME)) return BinaryParserFactory::FORMAT_NAME;
     }
-
     return PolicyParserFactory::UNRECOGNIZED;
 }
 
+const string& PolicyFile::formatFromData(const char* data, std::size_t size) const {
+    // skip over blank lines and comments
+    string line;
+    if (!leadingLine(data, size, line)) {
+        // empty file; let's just assume PAF (but don't cache the name).
+        return PAFParserFactory::FORMAT_NAME;
+    }
+    return cacheName(_formats->recognizeType(line));
+}
+
 /*
  * load the data from this Policy source into a Policy object
  * @param policy    the policy object to load the data into
@@ -181,23 +251,33 @@ const string& PolicyFile::getFormatName() {
  * @exception IOError   if an I/O error occurs while reading from the
  *                       source stream.
  */
-void PolicyFile::load(Policy& policy) const {
+void PolicyFile::load(Policy& policy) const { loadData(policy, true); }
+
+/*
+ * load the data as load() does, reading it into memory rather than
+ * mapping it
+ */
+void PolicyFile::read(Policy& policy) const { loadData(policy, false); }
+
+void PolicyFile::loadData(Policy& policy, bool map) const {
+    if (!_pfact.get() && _file.empty()) throw LSST_EXCEPT(ParserError, "Unknown Policy format: ");
+
+    // the file is opened once: the parser reads the file in place, and
+    // the format, if not yet known, is recognized from the same data
+    FileData data(_file, map);
+
     PolicyParserFactory::Ptr pfactory = _pfact;
     if (!pfactory.get()) {
-        const string& fmtname = getFormatName();
+        string fmtname = _format;
+        if (fmtname.empty()) fmtname = formatFromExtension();
+        if (fmtname.empty()) fmtname = formatFromData(data.data(), data.size());
         if (fmtname.empty()) throw LSST_EXCEPT(ParserError, "Unknown Policy format: " + _file.string());
 
         pfactory = _formats->getFactory(fmtname);
     }
 
     std::unique_ptr<PolicyParser> parser(pfactory->createParser(policy));
-
-    ifstream fs(_file.string().c_str());
-    if (fs.fail())
-        throw LSST_EXCEPT(pexExcept::IoError, "failure opening Policy file: " + fs::absolute(_file).string());
-
-    parser->parse(fs);
-    fs.close();
+    parser->parse(data.data(), data.size());
 }
 
 //@endcond
@@ -0,0 +1,98 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file PolicyHandler.cc
+ * @ingroup pex
+ */
+
+#include "lsst/pex/policy/PolicyHandler.h"
+#include "lsst/pex/policy/PolicyFile.h"
+
+namespace lsst {
+namespace pex {
+namespace policy {
+
+//@cond
+
+using std::string;
+
+PolicyHandler::~PolicyHandler() {}
+
+void PolicyHandler::onInts(const string& name, const Policy::IntArray& values, int lineno) {
+    for (Policy::IntArray::const_iterator it = values.begin(); it != values.end(); ++it)
+        onInt(name, *it, lineno);
+}
+
+void PolicyHandler::onDoubles(const string& name, const Policy::DoubleArray& values, int lineno) {
+    for (Policy::DoubleArray::const_iterator it = values.begin(); it != values.end(); ++it)
+        onDouble(name, *it, lineno);
+}
+
+PolicyBuilder::~PolicyBuilder() {}
+
+template <typename T>
+void PolicyBuilder::_add(const string& name, const T& value) {
+    if (_open.empty()) {
+        _root.add(name, value);
+        return;
+    }
+    _name.assign(name, _open.back().second, string::npos);
+    _open.back().first->add(_name, value);
+}
+
+void PolicyBuilder::beginPolicy(const string& name, int /*lineno*/) {
+    PolicyArena::Ptr arena = _root.getArena();
+    Policy::Ptr subpolicy = detail::allocateShared<Policy>(arena, arena);
+    _add(name, subpolicy);
+    _open.push_back(std::make_pair(subpolicy, name.size() + 1));
+}
+
+void PolicyBuilder::endPolicy(const string& /*name*/, int /*lineno*/) { _open.pop_back(); }
+
+void PolicyBuilder::onBool(const string& name, bool value, int /*lineno*/) { _add(name, value); }
+
+void PolicyBuilder::onInt(const string& name, int value, int /*lineno*/) { _add(name, value); }
+
+void PolicyBuilder::onDouble(const string& name, double value, int /*lineno*/) { _add(name, value); }
+
+void PolicyBuilder::onString(const string& name, const string& value, int /*lineno*/) {
+    _add(name, value);
+}
+
+void PolicyBuilder::onFile(const string& name, const Policy::FilePtr& value, int /*lineno*/) {
+    _add(name, value);
+}
+
+void PolicyBuilder::onInts(const string& name, const Policy::IntArray& values, int /*lineno*/) {
+    _add(name, values);
+}
+
+void PolicyBuilder::onDoubles(const string& name, const Policy::DoubleArray& values, int /*lineno*/) {
+    _add(name, values);
+}
+
+//@endcond
+
+}  // namespace policy
+}  // namespace pex
+}  // namespace lsst
@@ -0,0 +1,63 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+
+/**
+ * @file PolicyKey.cc
+ * @ingroup pex
+ */
+
+#include "lsst/pex/policy/PolicyKey.h"
+#include "lsst/pex/policy/detail/PolicyData.h"
+#include "lsst/pex/policy/detail/StringPool.h"
+
+#include <cstring>
+
+namespace lsst {
+namespace pex {
+namespace policy {
+
+//@cond
+
+PolicyKey::PolicyKey(const std::string& name) : _name(name), _fields() { _split(); }
+
+PolicyKey::PolicyKey(const char* name) : _name(name), _fields() { _split(); }
+
+void PolicyKey::_split() {
+    detail::StringPool& pool = detail::StringPool::global();
+    const char* b = _name.data();
+    const char* e = b + _name.size();
+    for (;;) {
+        const char* dot = static_cast<const char*>(std::memchr(b, '.', e - b));
+        const char* end = dot ? dot : e;
+        Field field = {&pool.intern(b, end), detail::PolicyData::hash(b, end)};
+        _fields.push_back(field);
+        if (! dot) break;
+        b = dot + 1;
+    }
+}
+
+//@endcond
+
+}  // namespace policy
+}  // namespace pex
+}  // namespace lsst
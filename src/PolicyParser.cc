@@ -26,6 +26,9 @@
  * @author Ray Plante
  */
 
+#include <istream>
+#include <streambuf>
+
 #include "lsst/pex/policy/PolicyParser.h"
 
 namespace lsst {
@@ -42,6 +45,27 @@ static void execTrace( string s, int level = EXEC_TRACE ){
 
 PolicyParser::~PolicyParser() {}
 
+//@cond
+namespace {
+
+// a read-only stream buffer over memory owned by someone else
+class MemoryBuf : public std::streambuf {
+public:
+    MemoryBuf(const char* data, std::size_t size) {
+        char* b = const_cast<char*>(data);
+        setg(b, b, b + size);
+    }
+};
+
+}  // namespace
+
+int PolicyParser::parse(const char* data, std::size_t size) {
+    MemoryBuf buf(data, size);
+    std::istream is(&buf);
+    return parse(is);
+}
+//@endcond
+
 }  // namespace policy
 }  // namespace pex
 }  // namespace lsst
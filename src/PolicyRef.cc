@@ -0,0 +1,205 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+
+
+/**
+ * @file PolicyRef.cc
+ * @ingroup pex
+ */
+
+#include "lsst/pex/policy/PolicyRef.h"
+#include "lsst/pex/policy/PolicyFile.h"
+#include "lsst/pex/policy/exceptions.h"
+#include "lsst/pex/exceptions.h"
+
+namespace pexExcept = lsst::pex::exceptions;
+
+namespace lsst {
+namespace pex {
+namespace policy {
+
+//@cond
+
+using detail::PolicyData;
+
+namespace {
+
+// translate the exceptions of PolicyData as Policy does
+
+template <typename T, typename Name>
+T getLast(const PolicyData& data, const Name& name, Policy::ValueType type) {
+    try {
+        return data.get<T>(name);
+    } catch (pexExcept::NotFoundError&) {
+        throw LSST_EXCEPT(NameNotFound, name);
+    } catch (pexExcept::TypeError&) {
+        throw LSST_EXCEPT(TypeError, name, std::string(Policy::typeName[type]));
+    }
+}
+
+template <typename T, typename Name>
+std::vector<T> getAll(const PolicyData& data, const Name& name, Policy::ValueType type) {
+    try {
+        return data.getArray<T>(name);
+    } catch (pexExcept::NotFoundError&) {
+        throw LSST_EXCEPT(NameNotFound, name);
+    } catch (pexExcept::TypeError&) {
+        throw LSST_EXCEPT(TypeError, name, std::string(Policy::typeName[type]));
+    }
+}
+
+template <typename T, typename Name>
+ArrayView<T> getView(const PolicyData& data, const Name& name, Policy::ValueType type) {
+    try {
+        return data.getView<T>(name);
+    } catch (pexExcept::NotFoundError&) {
+        throw LSST_EXCEPT(NameNotFound, name);
+    } catch (pexExcept::TypeError&) {
+        throw LSST_EXCEPT(TypeError, name, std::string(Policy::typeName[type]));
+    }
+}
+
+// pin for good the sub-policy a reference is taken to, so that it is not shared with copies
+
+template <typename Name>
+const PolicyData* pinSub(const PolicyData& data, const Name& name) {
+    try {
+        return data.pinIfUnshared(name, data.isPinned()).get();
+    } catch (pexExcept::NotFoundError&) {
+        throw LSST_EXCEPT(NameNotFound, name);
+    } catch (pexExcept::TypeError&) {
+        throw LSST_EXCEPT(TypeError, name, std::string(Policy::typeName[Policy::POLICY]));
+    }
+}
+
+template <typename Name>
+PolicyData* pinSub(PolicyData& data, const Name& name) {
+    try {
+        return data.pin(name).get();
+    } catch (pexExcept::NotFoundError&) {
+        throw LSST_EXCEPT(NameNotFound, name);
+    } catch (pexExcept::TypeError&) {
+        throw LSST_EXCEPT(TypeError, name, std::string(Policy::typeName[Policy::POLICY]));
+    }
+}
+
+template <typename Name>
+Policy::FilePtr toFile(const PolicyData::PersistablePtr& value, const Name& name) {
+    Policy::FilePtr file = std::dynamic_pointer_cast<PolicyFile>(value);
+    if (! file) throw LSST_EXCEPT(TypeError, name, std::string(Policy::typeName[Policy::FILE]));
+    return file;
+}
+
+template <typename Name>
+Policy::FilePtrArray toFiles(const std::vector<PolicyData::PersistablePtr>& values, const Name& name) {
+    Policy::FilePtrArray files;
+    for (std::size_t i = 0; i < values.size(); ++i) files.push_back(toFile(values[i], name));
+    return files;
+}
+
+template <typename Name, typename T>
+void addValue(PolicyData& data, const Name& name, const T& value) {
+    try {
+        data.add(name, value);
+    } catch (pexExcept::TypeError&) {
+        throw LSST_EXCEPT(TypeError, name, std::string(Policy::typeName[data.valueType(name)]));
+    }
+}
+
+}  // namespace
+
+// define a function taking a name and the same taking a PolicyKey
+#define POLICYREF_BOTH(RETURN, FUNC, QUALIFIER, BODY)                      \
+    RETURN FUNC(const std::string& name) QUALIFIER { BODY }                \
+    RETURN FUNC(const PolicyKey& name) QUALIFIER { BODY }
+
+ConstPolicyRef::ConstPolicyRef(const Policy& policy) : _data(policy._data.get()) {
+    PolicyData::pinIfExclusive(policy._data);
+}
+
+Policy::StringArray ConstPolicyRef::_names(bool topLevelOnly, int want) const {
+    Policy::StringArray out;
+    _data->names(out, topLevelOnly, want);
+    return out;
+}
+
+POLICYREF_BOTH(bool, ConstPolicyRef::getBool, const, return getLast<bool>(*_data, name, Policy::BOOL);)
+POLICYREF_BOTH(int, ConstPolicyRef::getInt, const, return getLast<int>(*_data, name, Policy::INT);)
+POLICYREF_BOTH(double, ConstPolicyRef::getDouble, const,
+               return getLast<double>(*_data, name, Policy::DOUBLE);)
+POLICYREF_BOTH(std::string, ConstPolicyRef::getString, const,
+               return getLast<std::string>(*_data, name, Policy::STRING);)
+POLICYREF_BOTH(Policy::FilePtr, ConstPolicyRef::getFile, const,
+               return toFile(getLast<PolicyData::PersistablePtr>(*_data, name, Policy::FILE), name);)
+POLICYREF_BOTH(ConstPolicyRef, ConstPolicyRef::getPolicy, const,
+               return ConstPolicyRef(pinSub(*_data, name));)
+
+POLICYREF_BOTH(Policy::BoolArray, ConstPolicyRef::getBoolArray, const,
+               return getAll<bool>(*_data, name, Policy::BOOL);)
+POLICYREF_BOTH(Policy::IntArray, ConstPolicyRef::getIntArray, const,
+               return getAll<int>(*_data, name, Policy::INT);)
+POLICYREF_BOTH(Policy::DoubleArray, ConstPolicyRef::getDoubleArray, const,
+               return getAll<double>(*_data, name, Policy::DOUBLE);)
+POLICYREF_BOTH(Policy::StringArray, ConstPolicyRef::getStringArray, const,
+               return getAll<std::string>(*_data, name, Policy::STRING);)
+POLICYREF_BOTH(Policy::FilePtrArray, ConstPolicyRef::getFileArray, const,
+               return toFiles(getAll<PolicyData::PersistablePtr>(*_data, name, Policy::FILE), name);)
+
+POLICYREF_BOTH(Policy::IntArrayView, ConstPolicyRef::getIntArrayView, const,
+               return getView<int>(*_data, name, Policy::INT);)
+POLICYREF_BOTH(Policy::DoubleArrayView, ConstPolicyRef::getDoubleArrayView, const,
+               return getView<double>(*_data, name, Policy::DOUBLE);)
+POLICYREF_BOTH(Policy::StringArrayView, ConstPolicyRef::getStringArrayView, const,
+               return getView<std::string>(*_data, name, Policy::STRING);)
+POLICYREF_BOTH(PolicyArrayView, ConstPolicyRef::getPolicyArrayView, const,
+               return PolicyArrayView(getView<PolicyData::Ptr>(*_data, name, Policy::POLICY));)
+
+Policy::Ptr ConstPolicyRef::copy() const { return Policy::Ptr(new Policy(_data->deepCopy())); }
+
+PolicyRef::PolicyRef(Policy& policy) : ConstPolicyRef(_exclusive(policy)) {}
+
+Policy& PolicyRef::_exclusive(Policy& policy) {
+    policy._detach();
+    policy._data->pinLevel();
+    return policy;
+}
+
+POLICYREF_BOTH(PolicyRef, PolicyRef::getPolicy, const,
+               return PolicyRef(pinSub(*_mutable(), name));)
+
+#define POLICYREF_UPDATE(T)                                                                          \
+    void PolicyRef::set(const std::string& name, T value) const { _mutable()->set(name, value); }   \
+    void PolicyRef::set(const PolicyKey& key, T value) const { _mutable()->set(key, value); }       \
+    void PolicyRef::add(const std::string& name, T value) const { addValue(*_mutable(), name, value); } \
+    void PolicyRef::add(const PolicyKey& key, T value) const { addValue(*_mutable(), key, value); }
+
+POLICYREF_UPDATE(bool)
+POLICYREF_UPDATE(int)
+POLICYREF_UPDATE(double)
+POLICYREF_UPDATE(const std::string&)
+
+//@endcond
+
+}  // namespace policy
+}  // namespace pex
+}  // namespace lsst
@@ -28,12 +28,42 @@
 
 #include "lsst/pex/policy/PolicySource.h"
 
+#include <cstring>
+
+#include <boost/regex.hpp>
+
 namespace lsst {
 namespace pex {
 namespace policy {
 
+namespace {
+
+const boost::regex CONTENTID("^\\s*#\\s*<\\?cfg\\s+\\w+(\\s+\\w+)*\\s*\\?>", boost::regex::icase);
+
+inline bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v'; }
+
+}  // namespace
+
 PolicySource::~PolicySource() {}
 
+bool PolicySource::leadingLine(const char* data, std::size_t size, std::string& line) {
+    const char* const end = data + size;
+    for (const char* p = data; p < end;) {
+        const char* eol = static_cast<const char*>(memchr(p, '\n', end - p));
+        if (!eol) eol = end;
+
+        const char* c = p;
+        while (c < eol && isSpace(*c)) ++c;
+        if (c < eol) {
+            line.assign(p, eol);
+            if (*c != '#' || boost::regex_search(line, CONTENTID)) return true;
+        }
+        p = eol + 1;
+    }
+    line.clear();
+    return false;
+}
+
 SupportedFormats::Ptr PolicySource::defaultFormats(new SupportedFormats());
 
 }  // namespace policy
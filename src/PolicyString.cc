@@ -41,8 +41,6 @@ namespace policy {
 //@cond
 
 using boost::regex;
-using boost::regex_match;
-using boost::regex_search;
 using lsst::pex::policy::paf::PAFParserFactory;
 using std::ifstream;
 using std::string;
@@ -86,27 +84,10 @@ PolicyString::PolicyString(const std::string& data, const SupportedFormats::Ptr&
  *                      characters of the source stream.
  */
 const string& PolicyString::getFormatName() {
-    // try reading the initial characters
-    std::istringstream is(_data);
-    if (is.fail()) {
-        PolStr_ERROR_MSG(msg, "failure opening input Policy string", _data);
-        throw LSST_EXCEPT(pexExcept::IoError, msg.str());
-    }
-
-    // skip over comments
+    // skip over blank lines and comments
     string line;
-    getline(is, line);
-    while (is.good() &&
-           (regex_match(line, SPACE_RE) || (regex_search(line, COMMENT) && !regex_search(line, COMMENT)))) {
-    }
-
-    if (is.fail()) {
-        PolStr_ERROR_MSG(msg, "failure reading input Policy string", _data);
-        throw LSST_EXCEPT(pexExcept::IoError, msg.str());
-    }
-    if (is.eof() &&
-        (regex_match(line, SPACE_RE) || (regex_search(line, COMMENT) && !regex_search(line, COMMENT)))) {
-        // empty file; let's just assume PAF (but don't cache the name).
+    if (!leadingLine(_data.data(), _data.size(), line)) {
+        // empty string; let's just assume PAF (but don't cache the name).
         return PAFParserFactory::FORMAT_NAME;
     }
     return cacheName(_formats->recognizeType(line));
@@ -132,12 +113,7 @@ void PolicyString::load(Policy& policy) {
 
     std::unique_ptr<PolicyParser> parser(pfactory->createParser(policy));
 
-    std::istringstream is(_data);
-    if (is.fail()) {
-        PolStr_ERROR_MSG(msg, "failure opening Policy string", _data);
-        throw LSST_EXCEPT(pexExcept::IoError, msg.str());
-    }
-    parser->parse(is);
+    parser->parse(_data.data(), _data.size());
 }
 
 //@endcond
@@ -0,0 +1,336 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+
+
+/**
+ * @file PolicyWatcher.cc
+ * @ingroup pex
+ */
+
+#include "lsst/pex/policy/PolicyWatcher.h"
+#include "lsst/pex/policy/DefaultPolicyFile.h"
+#include "lsst/pex/policy/PolicyFile.h"
+#include "lsst/pex/exceptions.h"
+
+#include "boost/filesystem/operations.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <list>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace fs = boost::filesystem;
+
+namespace lsst {
+namespace pex {
+namespace policy {
+
+//@cond
+
+namespace pexExcept = lsst::pex::exceptions;
+
+namespace {
+
+// the directory holding a file, as it is watched
+fs::path dirOf(const std::string& file) {
+    fs::path dir = fs::path(file).parent_path();
+    return dir.empty() ? fs::path(".") : dir;
+}
+
+// the name a file is known by: its name within the directory watched
+std::string keyOf(const std::string& file) { return (dirOf(file) / fs::path(file).filename()).string(); }
+
+#ifndef __linux__
+std::pair<std::time_t, std::uintmax_t> stampOf(const std::string& file) {
+    boost::system::error_code err;
+    std::time_t time = fs::last_write_time(file, err);
+    if (err) return std::make_pair(std::time_t(0), std::uintmax_t(0));
+    std::uintmax_t size = fs::file_size(file, err);
+    return std::make_pair(time, err ? std::uintmax_t(0) : size);
+}
+#endif
+
+int millisUntil(std::chrono::steady_clock::time_point deadline) {
+    long left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now())
+                        .count();
+    return left > 0 ? int(left) : 0;
+}
+
+}  // namespace
+
+PolicyWatcher::PolicyWatcher(const std::string& file, const fs::path& repository, int debounceMillis)
+        : PolicyWatcher(Policy::FilePtr(new PolicyFile(file)), repository, debounceMillis) {}
+
+PolicyWatcher::PolicyWatcher(const Policy::FilePtr& file, const fs::path& repository, int debounceMillis)
+        : _root(file), _repository(repository), _debounce(debounceMillis), _parsed(), _stamps(), _parses(0),
+          _lock(), _files(), _current(), _callbacks(), _onError(), _fd(-1), _dirs(), _thread(),
+          _stopping(false) {
+    // look for relative references as Policy::createPolicy() does
+    if (_repository.empty()) _repository = fs::path(file->getPath()).parent_path();
+
+#ifdef __linux__
+    _fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (_fd < 0)
+        throw LSST_EXCEPT(pexExcept::IoError, std::string("cannot watch policy files: ") + std::strerror(errno));
+#endif
+
+    try {
+        std::set<std::string> files;
+        _current = _load(*_root, _repository, files);
+        _files.swap(files);
+        _watch();
+    } catch (...) {
+#ifdef __linux__
+        ::close(_fd);
+#endif
+        throw;
+    }
+}
+
+PolicyWatcher::~PolicyWatcher() {
+    stop();
+#ifdef __linux__
+    if (_fd >= 0) ::close(_fd);
+#endif
+}
+
+Policy::ConstPtr PolicyWatcher::get() const {
+    std::lock_guard<std::mutex> lock(_lock);
+    return _current;
+}
+
+std::vector<std::string> PolicyWatcher::getFiles() const {
+    std::lock_guard<std::mutex> lock(_lock);
+    return std::vector<std::string>(_files.begin(), _files.end());
+}
+
+void PolicyWatcher::addCallback(const Callback& callback) {
+    std::lock_guard<std::mutex> lock(_lock);
+    _callbacks.push_back(callback);
+}
+
+void PolicyWatcher::setErrorHandler(const ErrorHandler& handler) {
+    std::lock_guard<std::mutex> lock(_lock);
+    _onError = handler;
+}
+
+bool PolicyWatcher::poll(int timeoutMillis) {
+    std::set<std::string> changed;
+    return _wait(timeoutMillis, changed) && _reload(changed);
+}
+
+void PolicyWatcher::start() {
+    if (_thread.joinable()) return;
+    _stopping.store(false);
+    _thread = std::thread([this]() {
+        while (! _stopping.load()) poll(100);
+    });
+}
+
+void PolicyWatcher::stop() {
+    _stopping.store(true);
+    if (_thread.joinable()) _thread.join();
+}
+
+/*
+ * load a file, reusing its contents if they were parsed before, and
+ * resolve the files it refers to, adding each file read to files
+ */
+Policy::Ptr PolicyWatcher::_load(const PolicyFile& file, const fs::path& repository,
+                                 std::set<std::string>& files) {
+    std::string key = keyOf(file.getPath());
+    files.insert(key);
+    Parsed::iterator it = _parsed.find(key);
+    if (it == _parsed.end()) {
+        Policy::Ptr parsed(new Policy());
+        // the file alone, read rather than mapped, since it may be changed
+        // as it is read; the files it refers to are resolved below
+        file.read(*parsed);
+        ++_parses;
+        it = _parsed.insert(std::make_pair(key, Policy::ConstPtr(parsed))).first;
+    }
+    // the copy shares levels with the parsed file, and so with the Policy
+    // current until now, which other threads may be reading
+    const Policy& parsed = *it->second;
+    Policy::Ptr policy(new Policy(parsed));
+
+    // a DefaultPolicyFile resolves references relative to its own repository
+    const DefaultPolicyFile* installed = dynamic_cast<const DefaultPolicyFile*>(&file);
+    _resolve(*policy, installed ? installed->getRepositoryPath() : repository, files);
+    return policy;
+}
+
+/*
+ * replace the file references in a policy by what the files hold, as
+ * Policy::loadPolicyFiles() does
+ */
+void PolicyWatcher::_resolve(Policy& policy, const fs::path& repository, std::set<std::string>& files) {
+    fs::path repos = repository.empty() ? fs::path(".") : repository;
+
+    std::list<std::string> names;
+    policy.fileNames(names, true);
+    for (std::list<std::string>::iterator it = names.begin(); it != names.end(); ++it) {
+        Policy::FilePtrArray refs = policy.getFileArray(*it);
+        Policy::PolicyPtrArray loaded;
+        for (Policy::FilePtrArray::iterator ref = refs.begin(); ref != refs.end(); ++ref) {
+            fs::path path = (*ref)->getPath();
+            if (path.is_complete())
+                loaded.push_back(_load(**ref, repos, files));
+            else
+                loaded.push_back(_load(PolicyFile((repos / path).string()), repos, files));
+        }
+        policy.remove(*it);
+        for (Policy::PolicyPtrArray::iterator pi = loaded.begin(); pi != loaded.end(); ++pi) policy.add(*it, *pi);
+    }
+
+    policy.policyNames(names, true);
+    for (std::list<std::string>::iterator it = names.begin(); it != names.end(); ++it) {
+        Policy::PolicyPtrArray subs = policy.getPolicyArray(*it);
+        for (Policy::PolicyPtrArray::iterator pi = subs.begin(); pi != subs.end(); ++pi)
+            _resolve(**pi, repos, files);
+    }
+}
+
+bool PolicyWatcher::_reload(const std::set<std::string>& changed) {
+    for (std::set<std::string>::const_iterator it = changed.begin(); it != changed.end(); ++it) _parsed.erase(*it);
+
+    std::set<std::string> files;
+    Policy::Ptr policy;
+    std::string error;
+    try {
+        policy = _load(*_root, _repository, files);
+    } catch (pexExcept::Exception& e) {
+        error = e.what();
+    }
+
+    std::vector<Callback> callbacks;
+    ErrorHandler onError;
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        if (policy) {
+            _files.swap(files);
+            _current = policy;
+            callbacks = _callbacks;
+        } else {
+            // also watch the files read before the error, one of which may be the one to fix
+            _files.insert(files.begin(), files.end());
+            onError = _onError;
+        }
+    }
+
+    // forget the files no longer read
+    for (Parsed::iterator it = _parsed.begin(); it != _parsed.end();) {
+        if (_files.count(it->first))
+            ++it;
+        else
+            _parsed.erase(it++);
+    }
+    _watch();
+
+    if (! policy) {
+        if (onError) onError(error);
+        return false;
+    }
+    for (std::vector<Callback>::iterator it = callbacks.begin(); it != callbacks.end(); ++it) (*it)(policy);
+    return true;
+}
+
+void PolicyWatcher::_watch() {
+#ifdef __linux__
+    const std::uint32_t events = IN_CLOSE_WRITE | IN_MODIFY | IN_CREATE | IN_DELETE | IN_MOVED_TO | IN_MOVED_FROM;
+    for (std::set<std::string>::const_iterator it = _files.begin(); it != _files.end(); ++it) {
+        std::string dir = dirOf(*it).string();
+        // a directory already watched gives the same watch again
+        int wd = ::inotify_add_watch(_fd, dir.c_str(), events);
+        if (wd >= 0) _dirs[wd] = dir;
+    }
+#else
+    _stamps.clear();
+    for (std::set<std::string>::const_iterator it = _files.begin(); it != _files.end(); ++it)
+        _stamps[*it] = stampOf(*it);
+#endif
+}
+
+/*
+ * wait for a file read to change, then until no file has changed for the
+ * debounce time, collecting the files changed
+ */
+bool PolicyWatcher::_wait(int timeoutMillis, std::set<std::string>& changed) {
+    std::chrono::steady_clock::time_point deadline =
+            std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMillis);
+#ifdef __linux__
+    struct pollfd ready = {_fd, POLLIN, 0};
+    for (;;) {
+        int n = ::poll(&ready, 1, changed.empty() ? millisUntil(deadline) : _debounce);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+
+        alignas(struct inotify_event) char buf[8192];
+        ssize_t size;
+        while ((size = ::read(_fd, buf, sizeof(buf))) > 0) {
+            for (char* p = buf; p < buf + size;) {
+                const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(p);
+                p += sizeof(struct inotify_event) + event->len;
+                if (event->mask & IN_Q_OVERFLOW) {
+                    // events were lost; any file may have changed
+                    changed.insert(_files.begin(), _files.end());
+                } else if (event->len > 0) {
+                    std::map<int, std::string>::const_iterator dir = _dirs.find(event->wd);
+                    if (dir == _dirs.end()) continue;
+                    std::string key = (fs::path(dir->second) / event->name).string();
+                    if (_files.count(key)) changed.insert(key);
+                }
+            }
+        }
+    }
+#else
+    for (;;) {
+        int wait = changed.empty() ? std::min(_debounce, millisUntil(deadline)) : _debounce;
+        std::this_thread::sleep_for(std::chrono::milliseconds(wait));
+        bool quiet = true;
+        for (std::set<std::string>::const_iterator it = _files.begin(); it != _files.end(); ++it) {
+            std::pair<std::time_t, std::uintmax_t> stamp = stampOf(*it);
+            if (stamp != _stamps[*it]) {
+                _stamps[*it] = stamp;
+                changed.insert(*it);
+                quiet = false;
+            }
+        }
+        if (quiet && (! changed.empty() || millisUntil(deadline) == 0)) break;
+    }
+#endif
+    return ! changed.empty();
+}
+
+//@endcond
+
+}  // namespace policy
+}  // namespace pex
+}  // namespace lsst
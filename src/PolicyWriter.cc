@@ -99,11 +99,11 @@ void PolicyWriter::write(const Policy& policy, bool doDecl) {
             if (tp == typeid(bool)) {
                 writeBools(*ni, policy.getBoolArray(*ni));
             } else if (tp == typeid(int)) {
-                writeInts(*ni, policy.getIntArray(*ni));
+                writeInts(*ni, policy.getIntArrayView(*ni));
             } else if (tp == typeid(double)) {
-                writeDoubles(*ni, policy.getDoubleArray(*ni));
+                writeDoubles(*ni, policy.getDoubleArrayView(*ni));
             } else if (tp == typeid(std::string)) {
-                writeStrings(*ni, policy.getStringArray(*ni));
+                writeStrings(*ni, policy.getStringArrayView(*ni));
             } else if (tp == daf::base::PropertySet::typeOfT<std::shared_ptr<daf::base::PropertySet>>()) {
                 writePolicies(*ni, policy.getPolicyArray(*ni));
             } else if (tp == daf::base::PropertySet::typeOfT<std::shared_ptr<daf::base::Persistable>>()) {
@@ -118,6 +118,18 @@ void PolicyWriter::write(const Policy& policy, bool doDecl) {
     }
 }
 
+void PolicyWriter::writeInts(const std::string& name, const Policy::IntArrayView& values) {
+    writeInts(name, Policy::IntArray(values.begin(), values.end()));
+}
+
+void PolicyWriter::writeDoubles(const std::string& name, const Policy::DoubleArrayView& values) {
+    writeDoubles(name, Policy::DoubleArray(values.begin(), values.end()));
+}
+
+void PolicyWriter::writeStrings(const std::string& name, const Policy::StringArrayView& values) {
+    writeStrings(name, Policy::StringArray(values.begin(), values.end()));
+}
+
 void PolicyWriter::writeBool(const std::string& name, bool value) {
     std::vector<bool> vals;
     vals.push_back(value);
@@ -0,0 +1,120 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+
+
+/**
+ * @file SharedPolicy.cc
+ * @ingroup pex
+ */
+
+#include "lsst/pex/policy/SharedPolicy.h"
+
+#include "lsst/pex/exceptions.h"
+
+
+namespace lsst {
+namespace pex {
+namespace policy {
+
+//@cond
+
+namespace pexExcept = lsst::pex::exceptions;
+
+namespace {
+
+// the stripe of reader counts the calling thread uses; threads take
+// stripes in turn, so that few share one
+unsigned stripe() {
+    static std::atomic<unsigned> next(0);
+    static thread_local unsigned mine = next.fetch_add(1);
+    return mine;
+}
+
+}  // namespace
+
+SharedPolicy::SharedPolicy(const Policy& policy) : SharedPolicy(policy.freeze()) {}
+
+SharedPolicy::SharedPolicy(const FrozenPolicy::ConstPtr& policy) : _current(0), _epoch(0), _publishing(), _retired() {
+    if (! policy) throw LSST_EXCEPT(pexExcept::InvalidParameterError, "SharedPolicy: null policy published");
+    for (unsigned p = 0; p < 2; ++p)
+        for (unsigned s = 0; s < STRIPES; ++s) _readers[p][s].count.store(0);
+    _current.store(new Version{policy, 1});
+}
+
+SharedPolicy::~SharedPolicy() {
+    for (std::size_t i = 0; i < _retired.size(); ++i) delete _retired[i].first;
+    delete _current.load();
+}
+
+SharedPolicy::Snapshot SharedPolicy::read() const {
+    // counted before the version is loaded, so a writer that swaps it out
+    // afterwards waits for this reader
+    std::atomic<long>& readers = _readers[_epoch.load() & 1][stripe() % STRIPES].count;
+    readers.fetch_add(1);
+    return Snapshot(&readers, _current.load());
+}
+
+std::uint64_t SharedPolicy::publish(const Policy& policy) {
+    if (policy.canValidate()) policy.validate();
+    return publish(policy.freeze());
+}
+
+std::uint64_t SharedPolicy::publish(const FrozenPolicy::ConstPtr& policy) {
+    if (! policy) throw LSST_EXCEPT(pexExcept::InvalidParameterError, "SharedPolicy: null policy published");
+    std::lock_guard<std::mutex> lock(_publishing);
+    std::uint64_t number = _current.load()->number + 1;
+    std::unique_ptr<const Version> next(new Version{policy, number});
+    _retired.reserve(_retired.size() + 1);
+    const Version* old = _current.exchange(next.release());
+
+    // Any reader still holding the old version counted itself before the
+    // exchange above, under the current parity or, if it read the epoch
+    // before the last advance, the other.  Each advance waits for the
+    // other parity to drain, so after two more the old version is free.
+    _retired.push_back(std::make_pair(old, _epoch.load() + 2));
+    for (int i = 0; i < 2 && _drained((_epoch.load() + 1) & 1); ++i) _epoch.fetch_add(1);
+
+    std::uint64_t epoch = _epoch.load();
+    std::vector<std::pair<const Version*, std::uint64_t> >::iterator kept = _retired.begin();
+    for (std::vector<std::pair<const Version*, std::uint64_t> >::iterator it = _retired.begin();
+         it != _retired.end(); ++it) {
+        if (it->second <= epoch)
+            delete it->first;
+        else
+            *kept++ = *it;
+    }
+    _retired.erase(kept, _retired.end());
+    return number;
+}
+
+bool SharedPolicy::_drained(unsigned parity) const {
+    for (unsigned s = 0; s < STRIPES; ++s)
+        if (_readers[parity][s].count.load() != 0) return false;
+    return true;
+}
+
+//@endcond
+
+}  // namespace policy
+}  // namespace pex
+}  // namespace lsst
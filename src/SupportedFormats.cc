@@ -28,6 +28,9 @@
 
 #include "lsst/pex/policy/SupportedFormats.h"
 #include "lsst/pex/policy/paf/PAFParserFactory.h"
+#include "lsst/pex/policy/binary/BinaryParserFactory.h"
+#include "lsst/pex/policy/json/JSONParserFactory.h"
+#include "lsst/pex/policy/xml/XMLParserFactory.h"
 #include "lsst/pex/exceptions.h"
 
 namespace lsst {
@@ -36,9 +39,15 @@ namespace policy {
 
 using lsst::pex::policy::PolicyParserFactory;
 using lsst::pex::policy::paf::PAFParserFactory;
+using lsst::pex::policy::binary::BinaryParserFactory;
+using lsst::pex::policy::json::JSONParserFactory;
+using lsst::pex::policy::xml::XMLParserFactory;
 
 void SupportedFormats::initDefaultFormats(SupportedFormats& sf) {
     sf.registerFormat(PolicyParserFactory::Ptr(new PAFParserFactory()));
+    sf.registerFormat(PolicyParserFactory::Ptr(new JSONParserFactory()));
+    sf.registerFormat(PolicyParserFactory::Ptr(new XMLParserFactory()));
+    sf.registerFormat(PolicyParserFactory::Ptr(new BinaryParserFactory()));
 }
 
 /**
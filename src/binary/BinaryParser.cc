@@ -0,0 +1,280 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file BinaryParser.cc
+ * @ingroup pex
+ */
+
+#include "lsst/pex/policy/binary/BinaryParser.h"
+#include "lsst/pex/policy/parserexceptions.h"
+#include "lsst/pex/policy/PolicyFile.h"
+#include <cstring>
+
+namespace lsst {
+namespace pex {
+namespace policy {
+namespace binary {
+
+//@cond
+
+using namespace std;
+using lsst::pex::policy::Policy;
+using lsst::pex::policy::PolicyParser;
+
+namespace {
+
+// thrown to abandon a parse once a problem has been recorded
+struct Abandon {};
+
+// read a record of type T at p, which need not be aligned
+template <typename T>
+inline T read(const char* p) {
+    T out;
+    memcpy(&out, p, sizeof(T));
+    return out;
+}
+
+// the size of one value of an Entry of the given type, or 0 if the type
+// is not known
+size_t valueSize(uint32_t type) {
+    switch (type) {
+    case BOOL_TYPE:
+        return 1;
+    case INT_TYPE:
+        return sizeof(int32_t);
+    case DOUBLE_TYPE:
+        return sizeof(double);
+    case STRING_TYPE:
+    case FILE_TYPE:
+        return sizeof(StringRef);
+    case POLICY_TYPE:
+        return sizeof(uint32_t);
+    default:
+        return 0;
+    }
+}
+
+}  // namespace
+
+const int BinaryParser::MAX_DEPTH = 512;
+
+/*
+ * create a parser to load a Policy
+ */
+BinaryParser::BinaryParser(Policy& policy)
+    : PolicyParser(policy), _name(), _data(0), _header(), _names(0), _policies(0), _entries(0),
+      _pool(0), _loaded(), _count(0), _depth(0)
+{ }
+BinaryParser::BinaryParser(Policy& policy, bool strict)
+    : PolicyParser(policy, strict), _name(), _data(0), _header(), _names(0), _policies(0),
+      _entries(0), _pool(0), _loaded(), _count(0), _depth(0)
+{ }
+
+/*
+ * delete this parser
+ */
+BinaryParser::~BinaryParser() { }
+
+/*
+ * parse the data found on the given stream
+ */
+int BinaryParser::parse(istream& is) {
+    string data;
+    char buf[1 << 16];
+    while (is.read(buf, sizeof(buf)) || is.gcount() > 0)
+        data.append(buf, is.gcount());
+    if (is.bad()) {
+        if (! _diagnostics) throw LSST_EXCEPT(ParserError, "read error", 0);
+        _diagnostics->report(0, 0, ParserDiagnostics::READ_ERROR);
+        return 0;
+    }
+    return parse(data.data(), data.size());
+}
+
+/*
+ * load compiled data held in memory
+ */
+int BinaryParser::parse(const char* data, size_t size) {
+    _count = 0;
+    _depth = 0;
+    _name.clear();
+    _loaded.clear();
+
+    try {
+        if (size < HEADER_OFFSET + sizeof(Header)) _corrupt("too short to hold a header");
+        _data = data + HEADER_OFFSET;
+        _header = read<Header>(_data);
+        if (memcmp(_header.magic, "PLCY", sizeof(_header.magic)) != 0)
+            _corrupt("header not found");
+        if (_header.byteOrder != ORDER_MARK)
+            _unsupported("data written on a machine of different byte order");
+        if (_header.version != VERSION) _unsupported("unknown version of the compiled format");
+        if (_header.size < sizeof(Header) || _header.size > size - HEADER_OFFSET)
+            _corrupt("data truncated");
+
+        _names = _table(_header.namesOffset, _header.nameCount, sizeof(StringRef), "name table");
+        _policies = _table(_header.policiesOffset, _header.policyCount, sizeof(PolicyRecord),
+                           "policy table");
+        _entries = _table(_header.entriesOffset, _header.entryCount, sizeof(Entry),
+                          "entry table");
+        _pool = _table(_header.poolOffset, _header.poolSize, 1, "string pool");
+        if (_header.policyCount == 0) _corrupt("no top-level policy");
+
+        _loaded.assign(_header.policyCount, false);
+        _policy(0);
+    } catch (Abandon&) {
+        // recorded in the diagnostics
+    }
+
+    // log count
+    return _count;
+}
+
+template <typename Send>
+bool BinaryParser::_send(Send send, int n) {
+    if (! _diagnostics) {
+        send(_events());
+        _count += n;
+        return true;
+    }
+    try {
+        send(_events());
+    } catch (lsst::pex::exceptions::Exception& ex) {
+        // a value the handler would not take, e.g. one of the wrong type
+        const char* what = ex.what();
+        if (! _diagnostics->report(0, 0, ParserDiagnostics::REJECTED_VALUE,
+                                   what, what + strlen(what)))
+            throw Abandon();
+        return false;
+    }
+    _count += n;
+    return true;
+}
+
+void BinaryParser::_policy(uint32_t index) {
+    if (index >= _header.policyCount) _corrupt("policy index out of range");
+    if (_loaded[index]) _corrupt("policy included more than once");
+    _loaded[index] = true;
+    // each level is a recursive call
+    if (_depth >= MAX_DEPTH) _corrupt("policies nested too deeply");
+    ++_depth;
+
+    PolicyRecord policy = read<PolicyRecord>(_policies + index * sizeof(PolicyRecord));
+    if (uint64_t(policy.firstEntry) + policy.entryCount > _header.entryCount)
+        _corrupt("policy entries out of range");
+
+    const string::size_type len = _name.size();
+    const char* p = _entries + policy.firstEntry * sizeof(Entry);
+    for (uint32_t i = 0; i < policy.entryCount; ++i, p += sizeof(Entry)) {
+        Entry entry = read<Entry>(p);
+        if (entry.name >= _header.nameCount) _corrupt("name index out of range");
+        if (len > 0) _name += '.';
+        _name += _string(_names + entry.name * sizeof(StringRef));
+        _entry(entry);
+        _name.resize(len);
+    }
+    --_depth;
+}
+
+void BinaryParser::_entry(const Entry& entry) {
+    const size_t size = valueSize(entry.type);
+    if (size == 0) _corrupt("unknown value type");
+    const char* p = _table(entry.offset, entry.count, size, "values");
+    const uint32_t n = entry.count;
+
+    switch (entry.type) {
+    case BOOL_TYPE:
+        for (uint32_t i = 0; i < n; ++i) {
+            bool value = p[i] != 0;
+            _send([&](PolicyHandler& h) { h.onBool(_name, value, 0); }, 1);
+        }
+        break;
+    case INT_TYPE:
+        if (n > 0) {
+            Policy::IntArray values(n);
+            memcpy(values.data(), p, n * size);
+            _send([&](PolicyHandler& h) { h.onInts(_name, values, 0); }, n);
+        }
+        break;
+    case DOUBLE_TYPE:
+        if (n > 0) {
+            Policy::DoubleArray values(n);
+            memcpy(values.data(), p, n * size);
+            _send([&](PolicyHandler& h) { h.onDoubles(_name, values, 0); }, n);
+        }
+        break;
+    case STRING_TYPE:
+        for (uint32_t i = 0; i < n; ++i) {
+            string value = _string(p + i * size);
+            _send([&](PolicyHandler& h) { h.onString(_name, value, 0); }, 1);
+        }
+        break;
+    case FILE_TYPE:
+        for (uint32_t i = 0; i < n; ++i) {
+            Policy::FilePtr value(new PolicyFile(_string(p + i * size)));
+            _send([&](PolicyHandler& h) { h.onFile(_name, value, 0); }, 1);
+        }
+        break;
+    case POLICY_TYPE:
+        for (uint32_t i = 0; i < n; ++i) {
+            uint32_t index = read<uint32_t>(p + i * size);
+            if (_send([&](PolicyHandler& h) { h.beginPolicy(_name, 0); }, 0)) {
+                _policy(index);
+                _send([&](PolicyHandler& h) { h.endPolicy(_name, 0); }, 0);
+            }
+        }
+        break;
+    }
+}
+
+const char* BinaryParser::_table(uint32_t offset, uint32_t count, size_t size, const char* what) {
+    if (offset < sizeof(Header) || offset + uint64_t(count) * size > _header.size) _corrupt(what);
+    return _data + offset;
+}
+
+string BinaryParser::_string(const char* p) {
+    StringRef ref = read<StringRef>(p);
+    if (uint64_t(ref.offset) + ref.length > _header.poolSize) _corrupt("string out of range");
+    return string(_pool + ref.offset, ref.length);
+}
+
+void BinaryParser::_corrupt(const char* what) {
+    if (_diagnostics) {
+        _diagnostics->report(0, 0, ParserDiagnostics::SYNTAX_ERROR, what, what + strlen(what));
+        throw Abandon();
+    }
+    string msg("Corrupt compiled policy data: ");
+    throw LSST_EXCEPT(FormatSyntaxError, msg + what);
+}
+
+void BinaryParser::_unsupported(const char* what) {
+    if (_diagnostics) {
+        _diagnostics->report(0, 0, ParserDiagnostics::SYNTAX_ERROR, what, what + strlen(what));
+        throw Abandon();
+    }
+    throw LSST_EXCEPT(UnsupportedSyntax, what);
+}
+
+//@endcond
+
+}}}}   // end lsst::pex::policy::binary
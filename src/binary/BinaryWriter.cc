@@ -0,0 +1,245 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file BinaryWriter.cc
+ * @ingroup pex
+ */
+#include "lsst/pex/policy/binary/BinaryWriter.h"
+#include "lsst/pex/policy/Policy.h"
+#include "lsst/pex/policy/PolicyFile.h"
+#include "lsst/pex/exceptions.h"
+
+#include <cstring>
+
+namespace lsst {
+namespace pex {
+namespace policy {
+namespace binary {
+
+//@cond
+using std::string;
+using std::uint32_t;
+using std::vector;
+using lsst::pex::policy::Policy;
+using lsst::pex::policy::PolicyWriter;
+
+static_assert(sizeof(int) == sizeof(std::int32_t), "ints are stored as 32-bit integers");
+
+const string BinaryWriter::CONTENT_ID("#<?cfg BINARY policy ?>");
+
+namespace {
+
+// the number of bytes needed to pad size to a multiple of align
+inline std::size_t padding(std::size_t size, std::size_t align) {
+    return (align - size % align) % align;
+}
+
+}  // namespace
+
+BinaryWriter::BinaryWriter(std::ostream *out)
+    : PolicyWriter(out), _policies(), _current(0), _nameIndex(), _names(), _strings(), _pool(),
+      _values()
+{ }
+BinaryWriter::BinaryWriter(const string& file)
+    : PolicyWriter(file), _policies(), _current(0), _nameIndex(), _names(), _strings(), _pool(),
+      _values()
+{ }
+BinaryWriter::BinaryWriter(const char *file)
+    : PolicyWriter(file), _policies(), _current(0), _nameIndex(), _names(), _strings(), _pool(),
+      _values()
+{ }
+
+/*
+ * delete this writer
+ */
+BinaryWriter::~BinaryWriter() { }
+
+/*
+ * write the contents of a policy to the attached stream
+ */
+void BinaryWriter::write(const Policy& policy, bool /*doDecl*/) {
+    if (_policies.empty()) _policies.resize(1);
+    _current = 0;
+    PolicyWriter::write(policy, false);
+    _flush();
+}
+
+void BinaryWriter::writeBools(const string& name, const Policy::BoolArray& values) {
+    vector<unsigned char> bytes(values.begin(), values.end());
+    _add(name, BOOL_TYPE, bytes.size(), bytes.data(), bytes.size(), 1);
+}
+
+void BinaryWriter::writeInts(const string& name, const Policy::IntArray& values) {
+    writeInts(name, Policy::IntArrayView(values));
+}
+
+void BinaryWriter::writeInts(const string& name, const Policy::IntArrayView& values) {
+    _add(name, INT_TYPE, values.size(), values.data(), values.size() * sizeof(int), sizeof(int));
+}
+
+void BinaryWriter::writeDoubles(const string& name, const Policy::DoubleArray& values) {
+    writeDoubles(name, Policy::DoubleArrayView(values));
+}
+
+void BinaryWriter::writeDoubles(const string& name, const Policy::DoubleArrayView& values) {
+    _add(name, DOUBLE_TYPE, values.size(), values.data(), values.size() * sizeof(double),
+         sizeof(double));
+}
+
+void BinaryWriter::writeStrings(const string& name, const Policy::StringArray& values) {
+    writeStrings(name, Policy::StringArrayView(values));
+}
+
+void BinaryWriter::writeStrings(const string& name, const Policy::StringArrayView& values) {
+    vector<StringRef> refs;
+    _refs(values, refs);
+    _add(name, STRING_TYPE, refs.size(), refs.data(), refs.size() * sizeof(StringRef),
+         sizeof(uint32_t));
+}
+
+void BinaryWriter::writePolicies(const string& name, const Policy::PolicyPtrArray& values) {
+    vector<uint32_t> indices;
+    std::size_t parent = _current;
+    for (Policy::PolicyPtrArray::const_iterator vi = values.begin(); vi != values.end(); ++vi) {
+        indices.push_back(_policies.size());
+        _policies.push_back(vector<Entry>());
+        _current = indices.back();
+        PolicyWriter::write(**vi, false);
+    }
+    _current = parent;
+    _add(name, POLICY_TYPE, indices.size(), indices.data(), indices.size() * sizeof(uint32_t),
+         sizeof(uint32_t));
+}
+
+void BinaryWriter::writeFiles(const string& name, const Policy::FilePtrArray& values) {
+    vector<string> paths;
+    for (Policy::FilePtrArray::const_iterator vi = values.begin(); vi != values.end(); ++vi)
+        paths.push_back((*vi)->getPath());
+    vector<StringRef> refs;
+    _refs(paths, refs);
+    _add(name, FILE_TYPE, refs.size(), refs.data(), refs.size() * sizeof(StringRef),
+         sizeof(uint32_t));
+}
+
+void BinaryWriter::_add(const string& name, ValueType type, std::size_t count, const void* data,
+                        std::size_t size, std::size_t align) {
+    if (_policies.empty()) _policies.resize(1);
+
+    std::map<string, uint32_t>::iterator found = _nameIndex.find(name);
+    if (found == _nameIndex.end()) {
+        found = _nameIndex.insert(std::make_pair(name, uint32_t(_names.size()))).first;
+        _names.push_back(_intern(name));
+    }
+
+    _values.append(padding(_values.size(), align), '\0');
+    Entry entry = { found->second, uint32_t(type), uint32_t(count), uint32_t(_values.size()) };
+    _values.append(static_cast<const char*>(data), size);
+    _policies[_current].push_back(entry);
+}
+
+void BinaryWriter::_refs(const Policy::StringArrayView& strs, vector<StringRef>& refs) {
+    refs.reserve(strs.size());
+    for (Policy::StringArrayView::const_iterator si = strs.begin(); si != strs.end(); ++si)
+        refs.push_back(_intern(*si));
+}
+
+StringRef BinaryWriter::_intern(const string& str) {
+    std::map<string, StringRef>::iterator found = _strings.find(str);
+    if (found != _strings.end()) return found->second;
+
+    StringRef ref = { uint32_t(_pool.size()), uint32_t(str.size()) };
+    _pool.append(str);
+    _strings.insert(std::make_pair(str, ref));
+    return ref;
+}
+
+void BinaryWriter::_flush() {
+    std::size_t entryCount = 0;
+    for (std::size_t i = 0; i < _policies.size(); ++i) entryCount += _policies[i].size();
+
+    // lay out the tables, then the values, then the pool
+    Header header;
+    std::memcpy(header.magic, "PLCY", 4);
+    header.version = VERSION;
+    header.byteOrder = ORDER_MARK;
+    std::size_t offset = sizeof(Header);
+    header.nameCount = _names.size();
+    header.namesOffset = offset;
+    offset += _names.size() * sizeof(StringRef);
+    header.policyCount = _policies.size();
+    header.policiesOffset = offset;
+    offset += _policies.size() * sizeof(PolicyRecord);
+    header.entryCount = entryCount;
+    header.entriesOffset = offset;
+    offset += entryCount * sizeof(Entry);
+    std::size_t valuesPad = padding(offset, sizeof(double));
+    std::size_t valuesOffset = offset + valuesPad;
+    offset = valuesOffset + _values.size();
+    header.poolOffset = offset;
+    header.poolSize = _pool.size();
+    offset += _pool.size();
+    std::size_t endPad = padding(offset, sizeof(double));
+    offset += endPad;
+    if (offset > 0xFFFFFFFFu)
+        throw LSST_EXCEPT(lsst::pex::exceptions::LengthError,
+                          "Policy too large for the compiled format");
+    header.size = offset;
+
+    string id(CONTENT_ID);
+    id.append(HEADER_OFFSET - 1 - id.size(), ' ').append(1, '\n');
+    _os->write(id.data(), id.size());
+    _os->write(reinterpret_cast<const char*>(&header), sizeof(header));
+    _os->write(reinterpret_cast<const char*>(_names.data()), _names.size() * sizeof(StringRef));
+    uint32_t first = 0;
+    for (std::size_t i = 0; i < _policies.size(); ++i) {
+        PolicyRecord ref = { first, uint32_t(_policies[i].size()) };
+        _os->write(reinterpret_cast<const char*>(&ref), sizeof(ref));
+        first += ref.entryCount;
+    }
+    for (std::size_t i = 0; i < _policies.size(); ++i) {
+        vector<Entry>::const_iterator ei;
+        for (ei = _policies[i].begin(); ei != _policies[i].end(); ++ei) {
+            Entry entry = *ei;
+            entry.offset += valuesOffset;
+            _os->write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+        }
+    }
+    const char zeros[sizeof(double)] = { 0 };
+    _os->write(zeros, valuesPad);
+    _os->write(_values.data(), _values.size());
+    _os->write(_pool.data(), _pool.size());
+    _os->write(zeros, endPad);
+    _os->flush();
+
+    // start again
+    _policies.clear();
+    _current = 0;
+    _nameIndex.clear();
+    _names.clear();
+    _strings.clear();
+    _pool.clear();
+    _values.clear();
+}
+
+//@endcond
+}}}} // end lsst::pex::policy::binary
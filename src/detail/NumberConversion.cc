@@ -0,0 +1,138 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file NumberConversion.cc
+ * @ingroup pex
+ */
+
+#include "lsst/pex/policy/detail/NumberConversion.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <climits>
+#include <cstdlib>
+#include <string>
+
+namespace lsst {
+namespace pex {
+namespace policy {
+namespace detail {
+
+//@cond
+
+using std::copy;
+using std::string;
+
+namespace {
+
+inline bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+// the powers of ten that a double represents exactly
+const double EXACT_POW10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+const int EXACT_POW10_MAX = 22;
+const int EXACT_DIGITS_MAX = 15;   // any 15-digit integer is exact, too
+const int EXPONENT_MAX = 100000;   // far beyond the range of a double
+
+// strtod() needs a terminated string; numerals are copied to the stack
+// unless they are unusually long.
+const int NUMERAL_MAX = 64;
+
+}  // namespace
+
+long toLong(const char* b, const char* e) {
+    bool neg = (*b == '-');
+    if (*b == '+' || *b == '-') ++b;
+
+    const unsigned long limit = neg ? static_cast<unsigned long>(LONG_MAX) + 1 : LONG_MAX;
+    unsigned long acc = 0;
+    for (; b < e; ++b) {
+        unsigned long d = *b - '0';
+        if (acc > (limit - d) / 10) return (neg) ? LONG_MIN : LONG_MAX;
+        acc = acc * 10 + d;
+    }
+    if (! neg) return long(acc);
+    return (acc == 0) ? 0 : -long(acc - 1) - 1;
+}
+
+// When the significant digits and the power of ten are both exactly
+// representable, a single multiply or divide gives the correctly rounded
+// result; otherwise defer to strtod().
+double toDouble(const char* b, const char* e) {
+#if FLT_EVAL_METHOD == 0
+    const char* p = b;
+    bool neg = (*p == '-');
+    if (*p == '+' || *p == '-') ++p;
+
+    unsigned long long mant = 0;
+    int digits = 0, exp10 = 0;
+    for (; p < e && isDigit(*p); ++p) {
+        if (digits > 0 || *p != '0') {
+            mant = mant * 10 + (*p - '0');
+            if (++digits > EXACT_DIGITS_MAX) break;
+        }
+    }
+    if (p < e && *p == '.' && digits <= EXACT_DIGITS_MAX) {
+        for (++p; p < e && isDigit(*p); ++p) {
+            --exp10;
+            if (digits > 0 || *p != '0') {
+                mant = mant * 10 + (*p - '0');
+                if (++digits > EXACT_DIGITS_MAX) break;
+            }
+        }
+    }
+    if (p < e && (*p == 'e' || *p == 'E') && digits <= EXACT_DIGITS_MAX) {
+        bool eneg = (*++p == '-');
+        if (*p == '+' || *p == '-') ++p;
+        int x = 0;
+        // saturate, so that absurd exponents fall through to strtod()
+        for (; p < e; ++p)
+            if (x < EXPONENT_MAX) x = x * 10 + (*p - '0');
+        exp10 += (eneg) ? -x : x;
+    }
+
+    if (p == e && digits <= EXACT_DIGITS_MAX) {
+        double d = double(mant);
+        if (mant == 0)
+            return (neg) ? -d : d;
+        if (exp10 >= 0 && exp10 <= EXACT_POW10_MAX)
+            return (neg) ? -(d * EXACT_POW10[exp10]) : d * EXACT_POW10[exp10];
+        if (exp10 < 0 && exp10 >= -EXACT_POW10_MAX)
+            return (neg) ? -(d / EXACT_POW10[-exp10]) : d / EXACT_POW10[-exp10];
+    }
+#endif
+
+    if (e - b >= NUMERAL_MAX) return strtod(string(b, e).c_str(), 0);
+    char buf[NUMERAL_MAX];
+    *copy(b, e, buf) = '\0';
+    return strtod(buf, 0);
+}
+
+//@endcond
+
+}  // namespace detail
+}  // namespace policy
+}  // namespace pex
+}  // namespace lsst
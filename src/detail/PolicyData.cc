@@ -0,0 +1,1117 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+
+/**
+ * @file PolicyData.cc
+ * @ingroup pex
+ */
+
+#include "lsst/pex/policy/detail/PolicyData.h"
+#include "lsst/pex/policy/detail/StringPool.h"
+#include "lsst/pex/policy/PolicyFile.h"
+#include "lsst/pex/exceptions.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <mutex>
+
+namespace pexExcept = lsst::pex::exceptions;
+
+namespace lsst {
+namespace pex {
+namespace policy {
+namespace detail {
+
+//@cond
+
+using lsst::daf::base::PropertySet;
+
+#define POLICYDATA_COLUMN(T, STORED, TYPE, MEMBER)                                    \
+    template <>                                                                       \
+    struct PolicyData::Column<T> {                                                    \
+        typedef STORED Stored;                                                        \
+        static const Type type = TYPE;                                                \
+        static Vector<STORED>& of(PolicyData& data) { return data.MEMBER; }           \
+        static const Vector<STORED>& of(const PolicyData& data) { return data.MEMBER; } \
+    };
+
+POLICYDATA_COLUMN(bool, char, BOOL, _bools)
+POLICYDATA_COLUMN(int, int, INT, _ints)
+POLICYDATA_COLUMN(double, double, DOUBLE, _doubles)
+POLICYDATA_COLUMN(std::string, std::string, STRING, _strings)
+POLICYDATA_COLUMN(PolicyData::Ptr, PolicyData::Ptr, POLICY, _policies)
+POLICYDATA_COLUMN(PolicyData::PersistablePtr, PolicyData::PersistablePtr, FILE, _files)
+
+namespace {
+
+// the number of dead values worth compacting away
+const std::size_t COMPACT_MIN = 32;
+
+// held while a const Policy pins levels or records views, and while
+// share() copies the pinned levels, which must not change meanwhile
+std::mutex pinMutex;
+
+// move count values starting at offset to the end of to, updating offset
+template <typename Vector>
+void moveValues(Vector& from, Vector& to, std::uint32_t& offset, std::uint32_t count) {
+    std::uint32_t start = to.size();
+    for (std::uint32_t k = 0; k < count; ++k) to.push_back(std::move(from[offset + k]));
+    offset = start;
+}
+
+// the hash of a word, as in the finalizer of MurmurHash3
+std::uint64_t mix(std::uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+// a 128-bit hash built up a word at a time in two lanes mixed
+// differently.  Bytes are read as little-endian words on any machine, so
+// the hash is the same everywhere.
+class Hasher {
+public:
+    explicit Hasher(std::uint64_t seed) : _a(seed ^ 0x9e3779b97f4a7c15ULL), _b(seed ^ 0xc2b2ae3d27d4eb4fULL) {}
+
+    void word(std::uint64_t w) {
+        _a = mix((_a ^ w) * 0x87c37b91114253d5ULL);
+        _b = mix((_b + w) * 0x4cf5ad432745937fULL + 0x52dce729);
+    }
+
+    void bytes(const std::string& str) {
+        const unsigned char* p = reinterpret_cast<const unsigned char*>(str.data());
+        std::size_t n = str.size();
+        word(n);
+        for (; n > 0; p += 8, n = n > 8 ? n - 8 : 0) {
+            std::uint64_t w = 0;
+            for (std::size_t k = 0; k < 8 && k < n; ++k) w |= std::uint64_t(p[k]) << (8 * k);
+            word(w);
+        }
+    }
+
+    std::uint64_t high() const { return mix(_a + 3 * _b); }
+    std::uint64_t low() const { return mix(_b ^ (_a >> 29 | _a << 35)); }
+
+private:
+    std::uint64_t _a;
+    std::uint64_t _b;
+};
+
+template <typename T>
+void copyValues(PolicyData& to, const PropertySet& from, const std::string& name) {
+    to.add(name, from.getArray<T>(name));
+}
+
+}  // namespace
+
+PolicyData::PolicyData()
+    : _arena(), _entries(), _index(), _bools(), _ints(), _doubles(), _strings(), _policies(), _files(),
+      _dead(0), _pinned(false), _pending(), _changes(0), _hashHigh(0), _hashLow(0), _hashStamp(0) { }
+
+PolicyData::PolicyData(const std::shared_ptr<PolicyArena>& arena)
+    : _arena(arena), _entries(ArenaAllocator<Entry>(arena.get())),
+      _index(ArenaAllocator<std::uint32_t>(arena.get())), _bools(ArenaAllocator<char>(arena.get())),
+      _ints(ArenaAllocator<int>(arena.get())), _doubles(ArenaAllocator<double>(arena.get())),
+      _strings(ArenaAllocator<std::string>(arena.get())), _policies(ArenaAllocator<Ptr>(arena.get())),
+      _files(ArenaAllocator<PersistablePtr>(arena.get())), _dead(0), _pinned(false), _pending(), _changes(0),
+      _hashHigh(0), _hashLow(0), _hashStamp(0) { }
+
+PolicyData::PolicyData(const PolicyData& other)
+    : _arena(), _entries(other._entries), _index(other._index), _bools(other._bools), _ints(other._ints),
+      _doubles(other._doubles), _strings(other._strings), _policies(other._policies),
+      _files(other._files), _dead(other._dead), _pinned(false), _pending(),
+      _changes(other._changes.load(std::memory_order_acquire)), _hashHigh(0), _hashLow(0), _hashStamp(0) {
+    // the copy is not pinned, so its version is its own count of changes
+    Fingerprint remembered;
+    if (other._remembered(remembered)) {
+        _hashHigh.store(remembered.getHigh(), std::memory_order_relaxed);
+        _hashLow.store(remembered.getLow(), std::memory_order_relaxed);
+        _hashStamp.store(_changes.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+}
+
+PolicyData::Ptr PolicyData::deepCopy() const {
+    Ptr copy(new PolicyData(*this));
+    for (Vector<Ptr>::iterator it = copy->_policies.begin(); it != copy->_policies.end(); ++it)
+        if (*it) *it = (*it)->deepCopy();
+    return copy;
+}
+
+PolicyData::Ptr PolicyData::share(const Ptr& data) {
+    std::lock_guard<std::mutex> lock(pinMutex);
+    return _copyPinned(data);
+}
+
+void PolicyData::detach(Ptr& data) {
+    if (data && ! data->isPinned() && data.use_count() > 1) data.reset(new PolicyData(*data));
+}
+
+void PolicyData::pinIfExclusive(const Ptr& data) {
+    std::lock_guard<std::mutex> lock(pinMutex);
+    if (isExclusive(data)) data->pinLevel();
+}
+
+const PolicyData::Ptr& PolicyData::pin(const std::string& name) { return _pin(name); }
+
+const PolicyData::Ptr& PolicyData::pin(const PolicyKey& key) { return _pin(key); }
+
+const PolicyData::Ptr& PolicyData::pinIfUnshared(const std::string& name, bool exclusive) const {
+    std::lock_guard<std::mutex> lock(pinMutex);
+    return _pinIfUnshared(name, exclusive);
+}
+
+const PolicyData::Ptr& PolicyData::pinIfUnshared(const PolicyKey& key, bool exclusive) const {
+    std::lock_guard<std::mutex> lock(pinMutex);
+    return _pinIfUnshared(key, exclusive);
+}
+
+void PolicyData::pinViews(const Ptr& data, const std::string& name, std::size_t first,
+                          const std::vector<std::shared_ptr<Ptr> >& slots, PendingViews& pending) {
+    std::lock_guard<std::mutex> lock(pinMutex);
+    bool exclusive = isExclusive(data);
+    data->_pinIfUnshared(name, exclusive);
+
+    // the last pinned level along the name, through which any change to
+    // the sub-policies must pass; a level below an unpinned one is not pinned
+    PendingViews* record = &pending;
+    if (exclusive) record = &data->_pendingViews();
+    const PolicyData* level = data.get();
+    std::size_t at = 0, from = 0;
+    Field field;
+    while (_split(name, at, field)) {
+        level = level->_sub(field);
+        if (! level || ! level->isPinned()) break;
+        record = &level->_pendingViews();
+        from = at;
+    }
+    for (std::size_t i = 0; i < slots.size(); ++i) {
+        const Ptr& sub = *slots[i];
+        if (! sub || sub->isPinned()) continue;
+        PendingView view = {slots[i], name.substr(from), first + i};
+        _record(*record, view);
+    }
+}
+
+void PolicyData::pinViews(PendingViews& pending) {
+    PendingViews views;
+    views.swap(pending);
+    for (PendingViews::const_iterator it = views.begin(); it != views.end(); ++it) {
+        std::shared_ptr<Ptr> slot = it->slot.lock();
+        if (! slot) continue;
+        try {
+            pin(it->name);
+        } catch (pexExcept::Exception&) {
+            continue;   // the name is gone, so the view keeps what it has
+        }
+        const PolicyData* level;
+        const Entry* entry = _lookup(it->name, &level);
+        if (it->index < entry->count) *slot = level->_policies[entry->offset + it->index];
+    }
+}
+
+int PolicyData::names(std::vector<std::string>& out, bool topLevelOnly, int want,
+                      const std::string& prefix) const {
+    int count = 0;
+    for (Vector<Entry>::const_iterator it = _entries.begin(); it != _entries.end(); ++it) {
+        int have = (it->type == POLICY) ? 1 : (it->type == FILE) ? 2 : 4;
+        if (have & want) {
+            out.push_back(prefix + *it->name);
+            ++count;
+        }
+        if (! topLevelOnly && it->type == POLICY) {
+            const Ptr& last = _policies[it->offset + it->count - 1];
+            if (last) count += last->names(out, false, want, prefix + *it->name + ".");
+        }
+    }
+    return count;
+}
+
+void PolicyData::flatten(std::vector<Flat>& out, const std::string& prefix) const {
+    for (Vector<Entry>::const_iterator it = _entries.begin(); it != _entries.end(); ++it) {
+        const void* values;
+        switch (it->type) {
+            case BOOL:
+                values = _bools.data() + it->offset;
+                break;
+            case INT:
+                values = _ints.data() + it->offset;
+                break;
+            case DOUBLE:
+                values = _doubles.data() + it->offset;
+                break;
+            case STRING:
+                values = _strings.data() + it->offset;
+                break;
+            case POLICY:
+                values = _policies.data() + it->offset;
+                break;
+            default:
+                values = _files.data() + it->offset;
+        }
+        Flat flat = {prefix + *it->name, Type(it->type), values, it->count};
+        out.push_back(flat);
+        if (it->type == POLICY) {
+            const Ptr& last = _policies[it->offset + it->count - 1];
+            if (last) last->flatten(out, flat.name + ".");
+        }
+    }
+}
+
+void PolicyData::diff(const PolicyData& other, std::vector<Difference>& out, const std::string& prefix) const {
+    if (this == &other) return;
+    for (Vector<Entry>::const_iterator it = _entries.begin(); it != _entries.end(); ++it) {
+        int i = other._find(_field(*it));
+        if (i < 0) {
+            Difference removed = {prefix + *it->name, Difference::REMOVED};
+            out.push_back(removed);
+            continue;
+        }
+        const Entry& theirs = other._entries[i];
+        if (it->type == POLICY && theirs.type == POLICY && it->count == 1 && theirs.count == 1) {
+            const Ptr& mine = _policies[it->offset];
+            const Ptr& sub = other._policies[theirs.offset];
+            if (mine == sub) continue;
+            if (mine && sub) {
+                mine->diff(*sub, out, prefix + *it->name + ".");
+                continue;
+            }
+        }
+        if (! _sameValues(*it, other, theirs)) {
+            Difference changed = {prefix + *it->name, Difference::CHANGED};
+            out.push_back(changed);
+        }
+    }
+    for (Vector<Entry>::const_iterator it = other._entries.begin(); it != other._entries.end(); ++it) {
+        if (_find(_field(*it)) < 0) {
+            Difference added = {prefix + *it->name, Difference::ADDED};
+            out.push_back(added);
+        }
+    }
+}
+
+bool PolicyData::equals(const PolicyData& other) const {
+    if (this == &other) return true;
+    if (_entries.size() != other._entries.size()) return false;
+    Fingerprint mine, theirs;
+    if (_remembered(mine) && other._remembered(theirs) && mine != theirs) return false;
+    for (Vector<Entry>::const_iterator it = _entries.begin(); it != _entries.end(); ++it) {
+        int i = other._find(_field(*it));
+        if (i < 0 || ! _sameValues(*it, other, other._entries[i])) return false;
+    }
+    return true;
+}
+
+Fingerprint PolicyData::fingerprint() const {
+    Fingerprint out;
+    if (_remembered(out)) return out;
+    std::uint64_t version = _version();
+
+    // each entry is hashed alone and the hashes summed, so that their
+    // order does not matter
+    std::uint64_t high = 0, low = 0;
+    for (Vector<Entry>::const_iterator it = _entries.begin(); it != _entries.end(); ++it) {
+        Hasher h(it->type);
+        h.bytes(*it->name);
+        h.word(it->count);
+        std::size_t b = it->offset, e = it->offset + it->count;
+        for (std::size_t i = b; i < e; ++i) {
+            switch (it->type) {
+                case BOOL:
+                    h.word(_bools[i] != 0);
+                    break;
+                case INT:
+                    h.word(std::uint64_t(std::int64_t(_ints[i])));
+                    break;
+                case DOUBLE: {
+                    double value = _doubles[i] == 0 ? 0.0 : _doubles[i];   // -0 == 0
+                    std::uint64_t bits;
+                    std::memcpy(&bits, &value, sizeof(bits));
+                    h.word(bits);
+                    break;
+                }
+                case STRING:
+                    h.bytes(_strings[i]);
+                    break;
+                case POLICY:
+                    if (_policies[i]) {
+                        Fingerprint sub = _policies[i]->fingerprint();
+                        h.word(sub.getHigh());
+                        h.word(sub.getLow());
+                    } else {
+                        h.word(0);
+                    }
+                    break;
+                default: {
+                    const PolicyFile* file = dynamic_cast<const PolicyFile*>(_files[i].get());
+                    if (file)
+                        h.bytes(file->getPath());
+                    else
+                        h.word(0);
+                }
+            }
+        }
+        high += h.high();
+        low += h.low();
+    }
+    Hasher level(_entries.size());
+    level.word(high);
+    level.word(low);
+    out = Fingerprint(level.high(), level.low());
+
+    _hashHigh.store(out.getHigh(), std::memory_order_relaxed);
+    _hashLow.store(out.getLow(), std::memory_order_relaxed);
+    _hashStamp.store(version + 1, std::memory_order_release);
+    return out;
+}
+
+void PolicyData::assign(const std::string& name, const PolicyData& other) {
+    const PolicyData* level;
+    const Entry* entry = other._lookup(name, &level);
+    if (! entry) {
+        remove(name);
+        return;
+    }
+    Field field;
+    PolicyData* to = _levelForUpdate(name, field);
+    std::size_t b = entry->offset, e = entry->offset + entry->count;
+    switch (entry->type) {
+        case BOOL:
+            to->_put<bool>(name, field, level->_bools.begin() + b, level->_bools.begin() + e, true);
+            break;
+        case INT:
+            to->_put<int>(name, field, level->_ints.begin() + b, level->_ints.begin() + e, true);
+            break;
+        case DOUBLE:
+            to->_put<double>(name, field, level->_doubles.begin() + b, level->_doubles.begin() + e, true);
+            break;
+        case STRING:
+            to->_put<std::string>(name, field, level->_strings.begin() + b, level->_strings.begin() + e, true);
+            break;
+        case POLICY: {
+            std::vector<Ptr> shared;
+            for (std::size_t i = b; i < e; ++i) shared.push_back(share(level->_policies[i]));
+            to->_put<Ptr>(name, field, shared.begin(), shared.end(), true);
+            break;
+        }
+        default:
+            to->_put<PersistablePtr>(name, field, level->_files.begin() + b, level->_files.begin() + e, true);
+    }
+}
+
+const std::type_info& PolicyData::typeOf(const std::string& name) const {
+    const PolicyData* level;
+    switch (_require(name, level).type) {
+        case BOOL:
+            return typeid(bool);
+        case INT:
+            return typeid(int);
+        case DOUBLE:
+            return typeid(double);
+        case STRING:
+            return typeid(std::string);
+        case POLICY:
+            return typeid(PropertySet::Ptr);
+        default:
+            return typeid(PersistablePtr);
+    }
+}
+
+template <typename T>
+T PolicyData::get(const std::string& name) const {
+    const PolicyData* level;
+    const Entry& entry = _require(name, level);
+    return level->_last<T>(entry, name);
+}
+
+template <typename T>
+T PolicyData::get(const PolicyKey& key) const {
+    const PolicyData* level;
+    const Entry& entry = _require(key, level);
+    return level->_last<T>(entry, key.getName());
+}
+
+template <typename T>
+std::vector<T> PolicyData::getArray(const std::string& name) const {
+    const PolicyData* level;
+    const Entry& entry = _require(name, level);
+    return level->_all<T>(entry, name);
+}
+
+template <typename T>
+std::vector<T> PolicyData::getArray(const PolicyKey& key) const {
+    const PolicyData* level;
+    const Entry& entry = _require(key, level);
+    return level->_all<T>(entry, key.getName());
+}
+
+template <typename T>
+ArrayView<T> PolicyData::getView(const std::string& name) const {
+    const PolicyData* level;
+    const Entry& entry = _require(name, level);
+    return level->_view<T>(entry, name);
+}
+
+template <typename T>
+ArrayView<T> PolicyData::getView(const PolicyKey& key) const {
+    const PolicyData* level;
+    const Entry& entry = _require(key, level);
+    return level->_view<T>(entry, key.getName());
+}
+
+template <typename T>
+void PolicyData::set(const std::string& name, const T& value) {
+    Field field;
+    _levelForUpdate(name, field)->_put<T>(name, field, &value, &value + 1, true);
+}
+
+template <typename T>
+void PolicyData::set(const PolicyKey& key, const T& value) {
+    Field field;
+    _levelForUpdate(key, field)->_put<T>(key.getName(), field, &value, &value + 1, true);
+}
+
+template <typename T>
+void PolicyData::add(const std::string& name, const T& value) {
+    Field field;
+    _levelForUpdate(name, field)->_put<T>(name, field, &value, &value + 1, false);
+}
+
+template <typename T>
+void PolicyData::add(const PolicyKey& key, const T& value) {
+    Field field;
+    _levelForUpdate(key, field)->_put<T>(key.getName(), field, &value, &value + 1, false);
+}
+
+template <typename T>
+void PolicyData::add(const std::string& name, const std::vector<T>& values) {
+    if (values.empty()) return;
+    Field field;
+    _levelForUpdate(name, field)->_put<T>(name, field, values.begin(), values.end(), false);
+}
+
+template <typename T>
+void PolicyData::add(const PolicyKey& key, const std::vector<T>& values) {
+    if (values.empty()) return;
+    Field field;
+    _levelForUpdate(key, field)->_put<T>(key.getName(), field, values.begin(), values.end(), false);
+}
+
+void PolicyData::remove(const std::string& name) {
+    Field field;
+    PolicyData* level = exists(name) ? _levelForUpdate(name, field, false) : 0;
+    if (level) level->_erase(field);
+}
+
+void PolicyData::remove(const PolicyKey& key) {
+    Field field;
+    PolicyData* level = exists(key) ? _levelForUpdate(key, field, false) : 0;
+    if (level) level->_erase(field);
+}
+
+std::size_t PolicyData::memoryUsage() const {
+    std::set<const PolicyData*> seen;
+    return _memoryUsage(seen);
+}
+
+std::size_t PolicyData::_memoryUsage(std::set<const PolicyData*>& seen) const {
+    if (! seen.insert(this).second) return 0;
+    std::size_t bytes = sizeof(*this) + _entries.capacity() * sizeof(Entry) +
+                        _index.capacity() * sizeof(std::uint32_t) + _bools.capacity() +
+                        _ints.capacity() * sizeof(int) + _doubles.capacity() * sizeof(double) +
+                        _strings.capacity() * sizeof(std::string) + _policies.capacity() * sizeof(Ptr) +
+                        _files.capacity() * sizeof(PersistablePtr);
+    for (Vector<std::string>::const_iterator it = _strings.begin(); it != _strings.end(); ++it) {
+        // count characters that are not held inside the string itself
+        const char* chars = it->data();
+        if (chars < reinterpret_cast<const char*>(&*it) || chars >= reinterpret_cast<const char*>(&*it + 1))
+            bytes += it->capacity() + 1;
+    }
+    for (Vector<Ptr>::const_iterator it = _policies.begin(); it != _policies.end(); ++it)
+        if (*it) bytes += (*it)->_memoryUsage(seen);
+    return bytes;
+}
+
+PropertySet::Ptr PolicyData::toPropertySet() const {
+    PropertySet::Ptr ps(new PropertySet());
+    for (Vector<Entry>::const_iterator it = _entries.begin(); it != _entries.end(); ++it) {
+        const std::string& name = *it->name;
+        std::size_t b = it->offset, e = it->offset + it->count;
+        for (std::size_t i = b; i < e; ++i) {
+            switch (it->type) {
+                case BOOL:
+                    ps->add(name, bool(_bools[i]));
+                    break;
+                case INT:
+                    ps->add(name, _ints[i]);
+                    break;
+                case DOUBLE:
+                    ps->add(name, _doubles[i]);
+                    break;
+                case STRING:
+                    ps->add(name, _strings[i]);
+                    break;
+                case POLICY:
+                    ps->add(name, _policies[i] ? _policies[i]->toPropertySet() : PropertySet::Ptr());
+                    break;
+                default:
+                    ps->add(name, _files[i]);
+            }
+        }
+    }
+    return ps;
+}
+
+PolicyData::Ptr PolicyData::fromPropertySet(const PropertySet& ps) {
+    Ptr data(new PolicyData());
+    std::vector<std::string> names = ps.names(true);
+    for (std::vector<std::string>::const_iterator it = names.begin(); it != names.end(); ++it) {
+        const std::type_info& type = ps.typeOf(*it);
+        if (type == typeid(bool)) {
+            copyValues<bool>(*data, ps, *it);
+        } else if (type == typeid(int)) {
+            copyValues<int>(*data, ps, *it);
+        } else if (type == typeid(double)) {
+            copyValues<double>(*data, ps, *it);
+        } else if (type == typeid(std::string)) {
+            copyValues<std::string>(*data, ps, *it);
+        } else if (type == typeid(PersistablePtr)) {
+            copyValues<PersistablePtr>(*data, ps, *it);
+        } else if (type == typeid(PropertySet::Ptr)) {
+            std::vector<PropertySet::Ptr> sets = ps.getArray<PropertySet::Ptr>(*it);
+            std::vector<Ptr> subs;
+            for (std::vector<PropertySet::Ptr>::const_iterator s = sets.begin(); s != sets.end(); ++s)
+                subs.push_back(*s ? fromPropertySet(**s) : Ptr());
+            data->add(*it, subs);
+        } else {
+            throw LSST_EXCEPT(pexExcept::TypeError, *it + " has a type a Policy cannot hold");
+        }
+    }
+    return data;
+}
+
+std::uint32_t PolicyData::hash(const char* b, const char* e) {
+    // FNV-1a
+    std::uint32_t hash = 2166136261u;
+    for (; b < e; ++b) hash = (hash ^ static_cast<unsigned char>(*b)) * 16777619u;
+    return hash;
+}
+
+bool PolicyData::_split(const std::string& name, std::size_t& at, Field& field) {
+    const char* b = name.data() + at;
+    const char* e = name.data() + name.size();
+    const char* dot = static_cast<const char*>(std::memchr(b, '.', e - b));
+    if (dot) e = dot;
+    Field next = {b, e, hash(b, e), 0};
+    field = next;
+    at = e - name.data() + 1;
+    return dot != 0;
+}
+
+bool PolicyData::_split(const PolicyKey& key, std::size_t& at, Field& field) {
+    field = _field(key._fields[at++]);
+    return at < key._fields.size();
+}
+
+PolicyData::Ptr PolicyData::_copyPinned(const Ptr& data) {
+    if (! data || ! data->isPinned()) return data;
+    Ptr copy(new PolicyData(*data));
+    for (Vector<Ptr>::iterator it = copy->_policies.begin(); it != copy->_policies.end(); ++it)
+        *it = _copyPinned(*it);
+    return copy;
+}
+
+template <typename Name>
+const PolicyData::Ptr& PolicyData::_pin(const Name& name) {
+    pinLevel();
+    PolicyData* level = this;
+    std::size_t at = 0;
+    Field field;
+    bool more;
+    do {
+        // a view waiting at this level is pinned before its sub-policies are detached
+        level->_pinPending();
+        more = _split(name, at, field);
+        int i = level->_find(field);
+        if (i < 0) {
+            const std::string& str = name;
+            throw LSST_EXCEPT(pexExcept::NotFoundError, str + " not found");
+        }
+        const Entry& entry = level->_entries[i];
+        if (entry.type != POLICY) {
+            const std::string& str = name;
+            if (more) throw LSST_EXCEPT(pexExcept::NotFoundError, str + " not found");
+            throw LSST_EXCEPT(pexExcept::TypeError, str);
+        }
+        // the last field pins all its sub-policies, the others only the last
+        Vector<Ptr>::iterator b = level->_policies.begin() + entry.offset;
+        Vector<Ptr>::iterator e = b + entry.count;
+        for (Vector<Ptr>::iterator it = more ? e - 1 : b; it != e; ++it) {
+            detach(*it);
+            if (*it) (*it)->pinLevel();
+        }
+        if (! more) return *(e - 1);
+        level = (e - 1)->get();
+    } while (level);
+    const std::string& str = name;
+    throw LSST_EXCEPT(pexExcept::NotFoundError, str + " not found");
+}
+
+template <typename Name>
+const PolicyData::Ptr& PolicyData::_pinIfUnshared(const Name& name, bool exclusive) const {
+    if (exclusive) pinLevel();
+    const PolicyData* level = this;
+    std::size_t at = 0;
+    Field field;
+    bool more;
+    do {
+        more = _split(name, at, field);
+        int i = level->_find(field);
+        if (i < 0) {
+            const std::string& str = name;
+            throw LSST_EXCEPT(pexExcept::NotFoundError, str + " not found");
+        }
+        const Entry& entry = level->_entries[i];
+        if (entry.type != POLICY) {
+            const std::string& str = name;
+            if (more) throw LSST_EXCEPT(pexExcept::NotFoundError, str + " not found");
+            throw LSST_EXCEPT(pexExcept::TypeError, str);
+        }
+        // a level below a shared one is shared too, unless it is pinned
+        Vector<Ptr>::const_iterator b = level->_policies.begin() + entry.offset;
+        Vector<Ptr>::const_iterator e = b + entry.count;
+        for (Vector<Ptr>::const_iterator it = more ? e - 1 : b; it != e; ++it)
+            if (*it && ((*it)->isPinned() || (exclusive && it->use_count() == 1))) (*it)->pinLevel();
+        if (! more) return *(e - 1);
+        level = (e - 1)->get();
+        exclusive = level && level->isPinned();
+    } while (level);
+    const std::string& str = name;
+    throw LSST_EXCEPT(pexExcept::NotFoundError, str + " not found");
+}
+
+PolicyData::PendingViews& PolicyData::_pendingViews() const {
+    if (! _pending) _pending.reset(new PendingViews());
+    return *_pending;
+}
+
+void PolicyData::_record(PendingViews& views, const PendingView& view) {
+    // drop the views no longer held before the list grows
+    if (views.size() == views.capacity()) {
+        PendingViews::iterator it = views.begin();
+        for (PendingViews::iterator kept = views.begin(); kept != views.end(); ++kept)
+            if (! kept->slot.expired()) *it++ = *kept;
+        views.erase(it, views.end());
+    }
+    views.push_back(view);
+}
+
+bool PolicyData::_matches(const Entry& entry, const Field& field) {
+    if (entry.hash != field.hash) return false;
+    // an interned field is the same name only if it is the same string
+    if (field.interned) return entry.name == field.interned;
+    std::size_t size = field.end - field.begin;
+    return entry.name->size() == size && std::memcmp(entry.name->data(), field.begin, size) == 0;
+}
+
+std::uint64_t PolicyData::_version() const {
+    std::uint64_t out = _changes.load(std::memory_order_acquire);
+    if (! isPinned()) return out;
+    for (Vector<Ptr>::const_iterator it = _policies.begin(); it != _policies.end(); ++it)
+        if (*it && (*it)->isPinned()) out += (*it)->_version();
+    return out;
+}
+
+bool PolicyData::_remembered(Fingerprint& out) const {
+    std::uint64_t stamp = _hashStamp.load(std::memory_order_acquire);
+    if (stamp == 0 || stamp != _version() + 1) return false;
+    out = Fingerprint(_hashHigh.load(std::memory_order_relaxed), _hashLow.load(std::memory_order_relaxed));
+    return true;
+}
+
+PolicyData::Field PolicyData::_field(const Entry& entry) {
+    const char* b = entry.name->data();
+    Field out = {b, b + entry.name->size(), entry.hash, entry.name};
+    return out;
+}
+
+bool PolicyData::_sameValues(const Entry& entry, const PolicyData& other, const Entry& otherEntry) const {
+    if (entry.type != otherEntry.type || entry.count != otherEntry.count) return false;
+    std::size_t b = entry.offset, e = entry.offset + entry.count, theirs = otherEntry.offset;
+    switch (entry.type) {
+        case BOOL:
+            return std::equal(_bools.begin() + b, _bools.begin() + e, other._bools.begin() + theirs);
+        case INT:
+            return std::equal(_ints.begin() + b, _ints.begin() + e, other._ints.begin() + theirs);
+        case DOUBLE:
+            return std::equal(_doubles.begin() + b, _doubles.begin() + e, other._doubles.begin() + theirs);
+        case STRING:
+            return std::equal(_strings.begin() + b, _strings.begin() + e, other._strings.begin() + theirs);
+        case POLICY:
+            for (std::size_t i = b; i < e; ++i) {
+                const Ptr& mine = _policies[i];
+                const Ptr& sub = other._policies[theirs++];
+                if (mine != sub && ! (mine && sub && mine->equals(*sub))) return false;
+            }
+            return true;
+        default:
+            for (std::size_t i = b; i < e; ++i) {
+                const PolicyFile* mine = dynamic_cast<const PolicyFile*>(_files[i].get());
+                const PolicyFile* file = dynamic_cast<const PolicyFile*>(other._files[theirs++].get());
+                if (mine != file && ! (mine && file && mine->getPath() == file->getPath())) return false;
+            }
+            return true;
+    }
+}
+
+PolicyData::Field PolicyData::_field(const PolicyKey::Field& field) {
+    const char* b = field.name->data();
+    Field out = {b, b + field.name->size(), field.hash, field.name};
+    return out;
+}
+
+int PolicyData::_find(const Field& field) const {
+    if (_index.empty()) {
+        for (std::size_t i = 0; i < _entries.size(); ++i)
+            if (_matches(_entries[i], field)) return int(i);
+        return -1;
+    }
+
+    std::size_t mask = _index.size() - 1;
+    for (std::size_t slot = field.hash & mask; _index[slot] != 0; slot = (slot + 1) & mask)
+        if (_matches(_entries[_index[slot] - 1], field)) return int(_index[slot] - 1);
+    return -1;
+}
+
+const PolicyData::Entry* PolicyData::_lookup(const std::string& name, const PolicyData** level) const {
+    Field field;
+    const PolicyData* found = _level(name, field);
+    int i = found ? found->_find(field) : -1;
+    if (i < 0) return 0;
+    if (level) *level = found;
+    return &found->_entries[i];
+}
+
+const PolicyData::Entry* PolicyData::_lookup(const PolicyKey& key, const PolicyData** level) const {
+    Field field;
+    const PolicyData* found = _level(key, field);
+    int i = found ? found->_find(field) : -1;
+    if (i < 0) return 0;
+    if (level) *level = found;
+    return &found->_entries[i];
+}
+
+template <typename Name>
+const PolicyData::Entry& PolicyData::_require(const Name& name, const PolicyData*& level) const {
+    const Entry* entry = _lookup(name, &level);
+    if (! entry) {
+        const std::string& str = name;
+        throw LSST_EXCEPT(pexExcept::NotFoundError, str + " not found");
+    }
+    return *entry;
+}
+
+const PolicyData* PolicyData::_sub(const Field& field) const {
+    int i = _find(field);
+    if (i < 0) return 0;
+    const Entry& entry = _entries[i];
+    if (entry.type != POLICY) return 0;
+    return _policies[entry.offset + entry.count - 1].get();
+}
+
+PolicyData* PolicyData::_subForUpdate(const Field& field, const std::string& name, std::size_t prefix,
+                                      bool create) {
+    _changed();
+    int i = _find(field);
+    if (i < 0) {
+        if (! create) return 0;
+        _policies.push_back(allocateShared<PolicyData>(_arena, _arena));
+        i = int(_insert(field, POLICY, _policies.size() - 1));
+        _entries[i].count = 1;
+        return _policies.back().get();
+    }
+    const Entry& entry = _entries[i];
+    PolicyData* sub = 0;
+    if (entry.type == POLICY) {
+        Ptr& last = _policies[entry.offset + entry.count - 1];
+        detach(last);
+        sub = last.get();
+    }
+    if (! sub && create)
+        throw LSST_EXCEPT(pexExcept::InvalidParameterError, name.substr(0, prefix) + " is not a Policy");
+    return sub;
+}
+
+const PolicyData* PolicyData::_level(const std::string& name, Field& field) const {
+    const char* b = name.data();
+    const char* e = b + name.size();
+    const PolicyData* level = this;
+    for (const char* dot; (dot = static_cast<const char*>(std::memchr(b, '.', e - b))) != 0; b = dot + 1) {
+        Field sub = {b, dot, hash(b, dot), 0};
+        level = level->_sub(sub);
+        if (! level) return 0;
+    }
+    Field last = {b, e, hash(b, e), 0};
+    field = last;
+    return level;
+}
+
+const PolicyData* PolicyData::_level(const PolicyKey& key, Field& field) const {
+    std::vector<PolicyKey::Field>::const_iterator it = key._fields.begin(), last = key._fields.end() - 1;
+    const PolicyData* level = this;
+    for (; it != last; ++it) {
+        level = level->_sub(_field(*it));
+        if (! level) return 0;
+    }
+    field = _field(*last);
+    return level;
+}
+
+PolicyData* PolicyData::_levelForUpdate(const std::string& name, Field& field, bool create) {
+    const char* b = name.data();
+    const char* e = b + name.size();
+    PolicyData* level = this;
+    for (const char* dot; (dot = static_cast<const char*>(std::memchr(b, '.', e - b))) != 0; b = dot + 1) {
+        Field sub = {b, dot, hash(b, dot), 0};
+        level = level->_subForUpdate(sub, name, dot - name.data(), create);
+        if (! level) return 0;
+    }
+    Field last = {b, e, hash(b, e), 0};
+    field = last;
+    return level;
+}
+
+PolicyData* PolicyData::_levelForUpdate(const PolicyKey& key, Field& field, bool create) {
+    std::vector<PolicyKey::Field>::const_iterator it = key._fields.begin(), last = key._fields.end() - 1;
+    PolicyData* level = this;
+    std::size_t prefix = 0;
+    for (; it != last; ++it) {
+        prefix += it->name->size();
+        level = level->_subForUpdate(_field(*it), key.getName(), prefix, create);
+        if (! level) return 0;
+        ++prefix;   // the dot
+    }
+    field = _field(*last);
+    return level;
+}
+
+template <typename T>
+T PolicyData::_last(const Entry& entry, const std::string& name) const {
+    if (entry.type != Column<T>::type) throw LSST_EXCEPT(pexExcept::TypeError, name);
+    return T(Column<T>::of(*this)[entry.offset + entry.count - 1]);
+}
+
+template <typename T>
+std::vector<T> PolicyData::_all(const Entry& entry, const std::string& name) const {
+    if (entry.type != Column<T>::type) throw LSST_EXCEPT(pexExcept::TypeError, name);
+    typename Vector<typename Column<T>::Stored>::const_iterator b =
+            Column<T>::of(*this).begin() + entry.offset;
+    return std::vector<T>(b, b + entry.count);
+}
+
+template <typename T>
+ArrayView<T> PolicyData::_view(const Entry& entry, const std::string& name) const {
+    if (entry.type != Column<T>::type) throw LSST_EXCEPT(pexExcept::TypeError, name);
+    const T* b = Column<T>::of(*this).data() + entry.offset;
+    return ArrayView<T>(b, b + entry.count);
+}
+
+template <typename T, typename Iter>
+void PolicyData::_put(const std::string& name, const Field& field, Iter b, Iter e, bool replace) {
+    Vector<typename Column<T>::Stored>& values = Column<T>::of(*this);
+    std::size_t n = std::distance(b, e);
+    _changed();
+    int i = _find(field);
+    if (i < 0) {
+        i = int(_insert(field, Column<T>::type, values.size()));
+    } else {
+        Entry& entry = _entries[i];
+        if (replace && entry.type == Column<T>::type && n <= entry.count) {
+            // overwrite in place
+            if (entry.type == POLICY) _dropPinned(entry.offset, n);
+            std::copy(b, e, values.begin() + entry.offset);
+            _release(Type(entry.type), entry.offset + n, entry.count - n);
+            entry.count = n;
+            _compact();
+            return;
+        }
+        if (replace) {
+            _release(Type(entry.type), entry.offset, entry.count);
+            entry.type = Column<T>::type;
+            entry.offset = values.size();
+            entry.count = 0;
+        } else if (entry.type != Column<T>::type) {
+            throw LSST_EXCEPT(pexExcept::TypeError, name + " has mismatched type");
+        } else if (entry.offset + entry.count != values.size()) {
+            // move the values to the end of the array, where they can grow
+            values.reserve(values.size() + entry.count + n);
+            std::uint32_t from = entry.offset;
+            for (std::uint32_t k = 0; k < entry.count; ++k) values.push_back(std::move(values[from + k]));
+            _dead += entry.count;
+            entry.offset = values.size() - entry.count;
+        }
+    }
+    values.insert(values.end(), b, e);
+    _entries[i].count += n;
+    _compact();
+}
+
+std::size_t PolicyData::_insert(const Field& field, Type type, std::size_t offset) {
+    const std::string* name =
+            field.interned ? field.interned : &StringPool::global().intern(field.begin, field.end);
+    Entry entry = {name, field.hash, std::uint32_t(type), std::uint32_t(offset), 0};
+    _entries.push_back(entry);
+    std::size_t n = _entries.size();
+    if (n > LINEAR_MAX) {
+        if (2 * n > _index.size())
+            _reindex();
+        else
+            _place(n - 1);
+    }
+    return n - 1;
+}
+
+void PolicyData::_erase(const Field& field) {
+    int i = _find(field);
+    if (i < 0) return;
+    _changed();
+    const Entry& entry = _entries[i];
+    _release(Type(entry.type), entry.offset, entry.count);
+    _entries.erase(_entries.begin() + i);
+    _reindex();
+    _compact();
+}
+
+void PolicyData::_place(std::size_t i) {
+    std::size_t mask = _index.size() - 1;
+    std::size_t slot = _entries[i].hash & mask;
+    while (_index[slot] != 0) slot = (slot + 1) & mask;
+    _index[slot] = i + 1;
+}
+
+void PolicyData::_reindex() {
+    _index.clear();
+    if (_entries.size() <= LINEAR_MAX) return;
+    std::size_t size = 16;
+    while (size < 2 * _entries.size()) size *= 2;
+    _index.assign(size, 0);
+    for (std::size_t i = 0; i < _entries.size(); ++i) _place(i);
+}
+
+void PolicyData::_dropPinned(std::size_t offset, std::size_t count) {
+    // a pinned sub-policy no longer counts toward this level's version
+    for (std::size_t i = offset; i < offset + count; ++i)
+        if (_policies[i] && _policies[i]->isPinned()) _advance(_policies[i]->_version());
+}
+
+void PolicyData::_release(Type type, std::size_t offset, std::size_t count) {
+    _dead += count;
+    if (type == POLICY) _dropPinned(offset, count);
+    for (std::size_t i = offset; i < offset + count; ++i) {
+        if (type == STRING)
+            std::string().swap(_strings[i]);
+        else if (type == POLICY)
+            _policies[i].reset();
+        else if (type == FILE)
+            _files[i].reset();
+    }
+}
+
+void PolicyData::_compact() {
+    std::size_t total = _bools.size() + _ints.size() + _doubles.size() + _strings.size() +
+                        _policies.size() + _files.size();
+    if (_dead < COMPACT_MIN || 2 * _dead <= total) return;
+
+    ArenaAllocator<char> arena(_arena.get());
+    Vector<char> bools(arena);
+    Vector<int> ints(arena);
+    Vector<double> doubles(arena);
+    Vector<std::string> strings(arena);
+    Vector<Ptr> policies(arena);
+    Vector<PersistablePtr> files(arena);
+    for (Vector<Entry>::iterator it = _entries.begin(); it != _entries.end(); ++it) {
+        switch (it->type) {
+            case BOOL:
+                moveValues(_bools, bools, it->offset, it->count);
+                break;
+            case INT:
+                moveValues(_ints, ints, it->offset, it->count);
+                break;
+            case DOUBLE:
+                moveValues(_doubles, doubles, it->offset, it->count);
+                break;
+            case STRING:
+                moveValues(_strings, strings, it->offset, it->count);
+                break;
+            case POLICY:
+                moveValues(_policies, policies, it->offset, it->count);
+                break;
+            default:
+                moveValues(_files, files, it->offset, it->count);
+        }
+    }
+    _bools.swap(bools);
+    _ints.swap(ints);
+    _doubles.swap(doubles);
+    _strings.swap(strings);
+    _policies.swap(policies);
+    _files.swap(files);
+    _dead = 0;
+}
+
+#define POLICYDATA_INSTANTIATE_NAMED(T, NAME)                               \
+    template T PolicyData::get<T>(const NAME&) const;                       \
+    template std::vector<T> PolicyData::getArray<T>(const NAME&) const;     \
+    template void PolicyData::set<T>(const NAME&, const T&);                \
+    template void PolicyData::add<T>(const NAME&, const T&);                \
+    template void PolicyData::add<T>(const NAME&, const std::vector<T>&);
+
+#define POLICYDATA_INSTANTIATE(T)                  \
+    POLICYDATA_INSTANTIATE_NAMED(T, std::string)   \
+    POLICYDATA_INSTANTIATE_NAMED(T, PolicyKey)
+
+POLICYDATA_INSTANTIATE(bool)
+POLICYDATA_INSTANTIATE(int)
+POLICYDATA_INSTANTIATE(double)
+POLICYDATA_INSTANTIATE(std::string)
+POLICYDATA_INSTANTIATE(PolicyData::Ptr)
+POLICYDATA_INSTANTIATE(PolicyData::PersistablePtr)
+
+#define POLICYDATA_INSTANTIATE_VIEW(T)                                 \
+    template ArrayView<T> PolicyData::getView<T>(const std::string&) const; \
+    template ArrayView<T> PolicyData::getView<T>(const PolicyKey&) const;
+
+POLICYDATA_INSTANTIATE_VIEW(int)
+POLICYDATA_INSTANTIATE_VIEW(double)
+POLICYDATA_INSTANTIATE_VIEW(std::string)
+POLICYDATA_INSTANTIATE_VIEW(PolicyData::Ptr)
+
+//@endcond
+
+}  // namespace detail
+}  // namespace policy
+}  // namespace pex
+}  // namespace lsst
@@ -0,0 +1,98 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file StringPool.cc
+ * @ingroup pex
+ */
+
+#include "lsst/pex/policy/detail/StringPool.h"
+
+#include <cstring>
+
+namespace lsst {
+namespace pex {
+namespace policy {
+namespace detail {
+
+//@cond
+
+StringPool::StringPool() : _mutex(), _index(), _strings(), _chars(0) { }
+
+const std::string& StringPool::intern(const char* b, const char* e) {
+    Key key = { b, std::size_t(e - b), 0 };
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::unordered_set<Key, Hash, Equal>::const_iterator found = _index.find(key);
+    if (found != _index.end()) return *found->str;
+
+    _strings.push_back(std::string(b, e));
+    const std::string& str = _strings.back();
+    key.data = str.data();
+    key.str = &str;
+    _index.insert(key);
+    _chars += str.size();
+    return str;
+}
+
+const std::string* StringPool::find(const char* b, const char* e) const {
+    Key key = { b, std::size_t(e - b), 0 };
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::unordered_set<Key, Hash, Equal>::const_iterator found = _index.find(key);
+    return (found == _index.end()) ? 0 : found->str;
+}
+
+std::size_t StringPool::size() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _strings.size();
+}
+
+std::size_t StringPool::chars() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _chars;
+}
+
+StringPool& StringPool::global() {
+    // never destroyed, so that it outlives any static that uses it
+    static StringPool* pool = new StringPool();
+    return *pool;
+}
+
+std::size_t StringPool::Hash::operator()(const Key& key) const {
+    // FNV-1a
+    std::size_t h = 14695981039346656037ULL;
+    for (const char *p = key.data, *e = key.data + key.size; p != e; ++p) {
+        h ^= static_cast<unsigned char>(*p);
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+bool StringPool::Equal::operator()(const Key& a, const Key& b) const {
+    return a.size == b.size && std::memcmp(a.data, b.data, a.size) == 0;
+}
+
+//@endcond
+
+}  // namespace detail
+}  // namespace policy
+}  // namespace pex
+}  // namespace lsst
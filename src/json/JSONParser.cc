@@ -0,0 +1,644 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file JSONParser.cc
+ * @ingroup pex
+ */
+
+#include "lsst/pex/policy/json/JSONParser.h"
+#include "lsst/pex/policy/parserexceptions.h"
+#include "lsst/pex/policy/detail/NumberConversion.h"
+#include <cstring>
+
+namespace lsst {
+namespace pex {
+namespace policy {
+namespace json {
+
+//@cond
+
+using namespace std;
+using lsst::pex::policy::Policy;
+using lsst::pex::policy::PolicyParser;
+using lsst::pex::policy::detail::toDouble;
+using lsst::pex::policy::detail::toLong;
+
+namespace {
+
+// thrown to abandon a parse once a problem has been recorded that the
+// parser cannot recover from, or the fail-fast threshold is reached
+struct Abandon {};
+
+inline bool isDigit(char c) { return c >= '0' && c <= '9'; }
+inline bool isWord(char c) {
+    return isDigit(c) || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+// true if name has the form of a PAF parameter name
+bool isName(const string& name) {
+    if (name.empty() || ! isWord(name[0])) return false;
+    for (string::const_iterator c = name.begin(); c != name.end(); ++c)
+        if (! isWord(*c) && *c != '.') return false;
+    return true;
+}
+
+// return the end of the keyword word at p, or 0 if it is not there
+const char* scanWord(const char* p, const char* e, const char* word) {
+    for (; *word; ++p, ++word)
+        if (p == e || *p != *word) return 0;
+    return (p < e && isWord(*p)) ? 0 : p;
+}
+
+// read four hex digits at p
+bool scanHex4(const char* p, const char* e, unsigned int& value) {
+    if (e - p < 4) return false;
+    value = 0;
+    for (int i = 0; i < 4; ++i, ++p) {
+        char c = *p;
+        unsigned int d;
+        if (c >= '0' && c <= '9') d = c - '0';
+        else if (c >= 'a' && c <= 'f') d = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') d = c - 'A' + 10;
+        else return false;
+        value = value * 16 + d;
+    }
+    return true;
+}
+
+void appendUtf8(string& out, unsigned int cp) {
+    if (cp < 0x80) {
+        out += char(cp);
+    } else if (cp < 0x800) {
+        out += char(0xC0 | (cp >> 6));
+        out += char(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += char(0xE0 | (cp >> 12));
+        out += char(0x80 | ((cp >> 6) & 0x3F));
+        out += char(0x80 | (cp & 0x3F));
+    } else {
+        out += char(0xF0 | (cp >> 18));
+        out += char(0x80 | ((cp >> 12) & 0x3F));
+        out += char(0x80 | ((cp >> 6) & 0x3F));
+        out += char(0x80 | (cp & 0x3F));
+    }
+}
+
+// the deepest that objects and arrays may nest.  Each level is a
+// recursive call, so deeper data is reported as a syntax error rather
+// than allowed to exhaust the stack.
+const int MAX_DEPTH = 512;
+
+// counts one more level of nesting for as long as it is in scope
+class Nesting {
+public:
+    explicit Nesting(int& depth) : _depth(depth) { ++_depth; }
+    ~Nesting() { --_depth; }
+
+private:
+    int& _depth;
+};
+
+// the types an array's elements may have
+enum ElementType { NONE, NUMBER, STRING, BOOL, OBJECT };
+
+ParserDiagnostics::Kind expected(ElementType type) {
+    switch (type) {
+    case NUMBER:
+        return ParserDiagnostics::EXPECTED_DOUBLE;
+    case BOOL:
+        return ParserDiagnostics::EXPECTED_BOOL;
+    case STRING:
+        return ParserDiagnostics::EXPECTED_STRING;
+    default:
+        return ParserDiagnostics::SYNTAX_ERROR;
+    }
+}
+
+}  // namespace
+
+/*
+ * create a parser to load a Policy
+ */
+JSONParser::JSONParser(Policy& policy)
+    : PolicyParser(policy), _name(), _key(), _str(), _ints(), _doubles(), _strs(), _bools(),
+      _p(0), _e(0), _line(0), _lineno(0), _count(0), _skipping(0), _depth(0)
+{ }
+JSONParser::JSONParser(Policy& policy, bool strict)
+    : PolicyParser(policy, strict), _name(), _key(), _str(), _ints(), _doubles(), _strs(),
+      _bools(), _p(0), _e(0), _line(0), _lineno(0), _count(0), _skipping(0), _depth(0)
+{ }
+
+/*
+ * delete this parser
+ */
+JSONParser::~JSONParser() { }
+
+/*
+ * parse the data found on the given stream
+ */
+int JSONParser::parse(istream& is) {
+    string data;
+    char buf[1 << 16];
+    while (is.read(buf, sizeof(buf)) || is.gcount() > 0)
+        data.append(buf, is.gcount());
+    if (is.bad()) {
+        if (! _diagnostics) throw LSST_EXCEPT(ParserError, "read error", 0);
+        _diagnostics->report(0, 0, ParserDiagnostics::READ_ERROR);
+        return 0;
+    }
+    return parse(data.data(), data.size());
+}
+
+/*
+ * parse JSON-encoded data held in memory
+ */
+int JSONParser::parse(const char* data, size_t size) {
+    _p = data;
+    _e = data + size;
+    _line = data;
+    _lineno = 1;
+    _count = 0;
+    _skipping = 0;
+    _depth = 0;
+    _name.clear();
+
+    // a UTF-8 byte order mark
+    if (size >= 3 && memcmp(data, "\xEF\xBB\xBF", 3) == 0) _p += 3;
+
+    try {
+        _skip();
+        if (_p == _e)
+            // no policy given
+            return _count;
+        if (*_p != '{') _syntaxError("expected '{' to open the policy");
+        ++_p;
+        _object();
+        _skip();
+        if (_p < _e) _syntaxError("expected the end of the data after the policy");
+    } catch (Abandon&) {
+        // recorded in the diagnostics
+    }
+
+    // log count
+    return _count;
+}
+
+template <typename Send>
+bool JSONParser::_send(Send send, int n) {
+    if (_skipping) return false;
+    if (! _diagnostics) {
+        send(_events());
+        _count += n;
+        return true;
+    }
+    try {
+        send(_events());
+    } catch (lsst::pex::exceptions::Exception& ex) {
+        // a value the handler would not take, e.g. one of the wrong type
+        const char* what = ex.what();
+        if (! _diagnostics->report(_lineno, 0, ParserDiagnostics::REJECTED_VALUE,
+                                   what, what + strlen(what)))
+            throw Abandon();
+        return false;
+    }
+    _count += n;
+    return true;
+}
+
+void JSONParser::_object() {
+    Nesting nesting(_depth);
+    if (_depth > MAX_DEPTH) _syntaxError("objects and arrays nested too deeply");
+    const string::size_type len = _name.size();
+    _skip();
+    if (_p < _e && *_p == '}') {
+        ++_p;
+        return;
+    }
+
+    for (;;) {
+        _skip();
+        if (_p == _e || *_p != '"') _syntaxError("expected a quoted parameter name");
+        const char* k = _p + 1;
+        _string(_key);
+        const char* ke = _p - 1;
+        _expect(':', "expected ':' after a parameter name");
+        _skip();
+
+        if (isName(_key)) {
+            if (len > 0) _name.append(1, '.');
+            _name.append(_key);
+            _value();
+            _name.resize(len);
+        } else {
+            _skipValue();
+            _problem(ParserDiagnostics::BAD_NAME, k, ke);
+        }
+
+        _skip();
+        if (_p < _e && *_p == ',') {
+            ++_p;
+            continue;
+        }
+        if (_p < _e && *_p == '}') {
+            ++_p;
+            return;
+        }
+        _syntaxError("expected ',' or '}'");
+    }
+}
+
+void JSONParser::_value() {
+    if (_p == _e) _syntaxError("expected a value");
+
+    const char* q;
+    bool isInt;
+    switch (*_p) {
+    case '{': {
+        int lineno = _lineno;
+        bool opened = _send([&](PolicyHandler& h) { h.beginPolicy(_name, lineno); }, 0);
+        if (! opened) ++_skipping;
+        ++_p;
+        _object();
+        if (opened) _send([&](PolicyHandler& h) { h.endPolicy(_name, _lineno); }, 0);
+        else --_skipping;
+        return;
+    }
+    case '[':
+        _array();
+        return;
+    case '"':
+        _string(_str);
+        _send([&](PolicyHandler& h) { h.onString(_name, _str, _lineno); }, 1);
+        return;
+    case 't':
+    case 'f':
+        if ((q = scanWord(_p, _e, "true")) || (q = scanWord(_p, _e, "false"))) {
+            bool value = (*_p == 't');
+            _p = q;
+            _send([&](PolicyHandler& h) { h.onBool(_name, value, _lineno); }, 1);
+            return;
+        }
+        break;
+    case 'n':
+        if ((q = scanWord(_p, _e, "null"))) {
+            // no value provided; ignore it.
+            _p = q;
+            return;
+        }
+        break;
+    default:
+        if ((q = _number(isInt))) {
+            const char* b = _p;
+            _p = q;
+            if (isInt) {
+                int value;
+                if (_int(b, q, value))
+                    _send([&](PolicyHandler& h) { h.onInt(_name, value, _lineno); }, 1);
+            } else {
+                double value = toDouble(b, q);
+                _send([&](PolicyHandler& h) { h.onDouble(_name, value, _lineno); }, 1);
+            }
+            return;
+        }
+        break;
+    }
+    _syntaxError("expected a value");
+}
+
+void JSONParser::_array() {
+    Nesting nesting(_depth);
+    if (_depth > MAX_DEPTH) _syntaxError("objects and arrays nested too deeply");
+    const bool collect = (_skipping == 0);
+    const int lineno = _lineno;
+    ElementType type = NONE;
+    bool isDouble = false;
+    if (collect) {
+        _ints.clear();
+        _doubles.clear();
+        _strs.clear();
+        _bools.clear();
+    }
+
+    ++_p;
+    _skip();
+    if (_p < _e && *_p == ']') {
+        ++_p;
+        return;
+    }
+
+    for (;;) {
+        _skip();
+        if (_p == _e) _syntaxError("expected a value");
+
+        const char* b = _p;
+        const char* q;
+        ElementType etype = NUMBER;
+        switch (*_p) {
+        case '{':
+            etype = OBJECT;
+            break;
+        case '"':
+            etype = STRING;
+            break;
+        case 't':
+        case 'f':
+            etype = BOOL;
+            break;
+        case '[':
+            _skipValue();
+            _problem(ParserDiagnostics::UNSUPPORTED_ARRAY, b, _p);
+            etype = NONE;
+            break;
+        case 'n':
+            if ((q = scanWord(_p, _e, "null"))) {
+                _p = q;
+                etype = NONE;
+            }
+            break;
+        }
+
+        if (etype == NONE) {
+            // nothing to load
+        } else if (type != NONE && etype != type) {
+            _skipValue();
+            _problem(expected(type), b, _p);
+        } else if (etype == OBJECT) {
+            // each element is sent as a sub-policy as it is read
+            type = OBJECT;
+            _value();
+        } else if (etype == STRING) {
+            type = STRING;
+            if (collect) {
+                _strs.push_back(string());
+                _string(_strs.back());
+            } else {
+                _string(_str);
+            }
+        } else if (etype == BOOL) {
+            type = BOOL;
+            if ((q = scanWord(_p, _e, "true")) || (q = scanWord(_p, _e, "false"))) {
+                if (collect) _bools.push_back(*_p == 't');
+                _p = q;
+            } else {
+                _syntaxError("expected a value");
+            }
+        } else {
+            type = NUMBER;
+            bool isInt;
+            if (! (q = _number(isInt))) _syntaxError("expected a value");
+            if (collect) {
+                if (isInt && ! isDouble) {
+                    int value;
+                    if (_int(_p, q, value)) _ints.push_back(value);
+                } else {
+                    if (! isDouble) {
+                        // load them all as doubles
+                        _doubles.assign(_ints.begin(), _ints.end());
+                        isDouble = true;
+                    }
+                    _doubles.push_back(toDouble(_p, q));
+                }
+            }
+            _p = q;
+        }
+
+        _skip();
+        if (_p < _e && *_p == ',') {
+            ++_p;
+            continue;
+        }
+        if (_p < _e && *_p == ']') {
+            ++_p;
+            break;
+        }
+        _syntaxError("expected ',' or ']'");
+    }
+
+    if (! collect) return;
+    if (type == NUMBER && isDouble) {
+        _send([&](PolicyHandler& h) { h.onDoubles(_name, _doubles, lineno); }, _doubles.size());
+    } else if (type == NUMBER && ! _ints.empty()) {
+        _send([&](PolicyHandler& h) { h.onInts(_name, _ints, lineno); }, _ints.size());
+    } else if (type == STRING) {
+        for (vector<string>::const_iterator s = _strs.begin(); s != _strs.end(); ++s)
+            _send([&](PolicyHandler& h) { h.onString(_name, *s, lineno); }, 1);
+    } else if (type == BOOL) {
+        for (vector<bool>::const_iterator v = _bools.begin(); v != _bools.end(); ++v) {
+            bool value = *v;
+            _send([&](PolicyHandler& h) { h.onBool(_name, value, lineno); }, 1);
+        }
+    }
+}
+
+void JSONParser::_skipValue() {
+    ++_skipping;
+    _value();
+    --_skipping;
+}
+
+void JSONParser::_string(string& out) {
+    const char* q = ++_p;
+    while (q < _e && *q != '"' && *q != '\\') {
+        if (*q == '\n') {
+            ++_lineno;
+            _line = q + 1;
+        }
+        ++q;
+    }
+    out.assign(_p, q);
+
+    while (q < _e && *q == '\\') {
+        if (++q == _e) break;
+        switch (*q++) {
+        case '"':
+            out += '"';
+            break;
+        case '\\':
+            out += '\\';
+            break;
+        case '/':
+            out += '/';
+            break;
+        case 'b':
+            out += '\b';
+            break;
+        case 'f':
+            out += '\f';
+            break;
+        case 'n':
+            out += '\n';
+            break;
+        case 'r':
+            out += '\r';
+            break;
+        case 't':
+            out += '\t';
+            break;
+        case 'u': {
+            unsigned int cp, low;
+            if (! scanHex4(q, _e, cp)) {
+                _p = q - 2;
+                _syntaxError("bad \\u escape in string");
+            }
+            q += 4;
+            if (cp >= 0xD800 && cp < 0xDC00 && _e - q >= 6 && q[0] == '\\' && q[1] == 'u' &&
+                scanHex4(q + 2, _e, low) && low >= 0xDC00 && low < 0xE000) {
+                // a surrogate pair
+                cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                q += 6;
+            }
+            appendUtf8(out, cp);
+            break;
+        }
+        default:
+            _p = q - 2;
+            _syntaxError("bad escape sequence in string");
+        }
+
+        const char* s = q;
+        while (q < _e && *q != '"' && *q != '\\') {
+            if (*q == '\n') {
+                ++_lineno;
+                _line = q + 1;
+            }
+            ++q;
+        }
+        out.append(s, q);
+    }
+
+    _p = q;
+    if (_p == _e) _syntaxError("unterminated string");
+    ++_p;
+}
+
+const char* JSONParser::_number(bool& isInt) {
+    const char* q = _p;
+    if (q < _e && *q == '-') ++q;
+    const char* d = q;
+    while (q < _e && isDigit(*q)) ++q;
+    if (q == d) return 0;
+    isInt = true;
+
+    if (q < _e && *q == '.') {
+        d = ++q;
+        while (q < _e && isDigit(*q)) ++q;
+        if (q == d) return 0;
+        isInt = false;
+    }
+    if (q < _e && (*q == 'e' || *q == 'E')) {
+        ++q;
+        if (q < _e && (*q == '+' || *q == '-')) ++q;
+        d = q;
+        while (q < _e && isDigit(*q)) ++q;
+        if (q == d) return 0;
+        isInt = false;
+    }
+    return q;
+}
+
+bool JSONParser::_int(const char* b, const char* e, int& value) {
+    long lval = toLong(b, e);
+    value = int(lval);
+    if (lval - value != 0) {
+        // longs are unsupported
+        _problem(ParserDiagnostics::UNSUPPORTED_LONG, b, e);
+        return false;
+    }
+    return true;
+}
+
+void JSONParser::_skip() {
+    while (_p < _e) {
+        switch (*_p) {
+        case '\n':
+            ++_lineno;
+            _line = ++_p;
+            break;
+        case ' ':
+        case '\t':
+        case '\r':
+            ++_p;
+            break;
+        case '#': {
+            // a comment, to the end of the line
+            const char* nl = static_cast<const char*>(memchr(_p, '\n', _e - _p));
+            _p = (nl) ? nl : _e;
+            break;
+        }
+        default:
+            return;
+        }
+    }
+}
+
+void JSONParser::_expect(char c, const char* what) {
+    _skip();
+    if (_p == _e || *_p != c) _syntaxError(what);
+    ++_p;
+}
+
+bool JSONParser::_problem(ParserDiagnostics::Kind kind, const char* b, const char* e) {
+    if (_skipping) return true;
+
+    // quote no more than the first line of the offending text
+    const char* nl = static_cast<const char*>(memchr(b, '\n', e - b));
+    if (nl) e = nl;
+
+    if (_diagnostics) {
+        int column = (b >= _line) ? int(b - _line) + 1 : 0;
+        if (! _diagnostics->report(_lineno, column, kind, b, e)) throw Abandon();
+        return true;
+    }
+    if (! _strict) return false;    // log message
+
+    string msg = ParserDiagnostics::describe(kind);
+    msg.append(b, e);
+    if (kind == ParserDiagnostics::UNSUPPORTED_LONG || kind == ParserDiagnostics::UNSUPPORTED_ARRAY)
+        throw LSST_EXCEPT(UnsupportedSyntax, msg, _lineno);
+    throw LSST_EXCEPT(FormatSyntaxError, msg, _lineno);
+}
+
+void JSONParser::_syntaxError(const char* what) {
+    if (_p >= _e) {
+        if (! _diagnostics) throw LSST_EXCEPT(EOFError, _lineno);
+        _diagnostics->report(_lineno, 0, ParserDiagnostics::UNEXPECTED_EOF);
+        throw Abandon();
+    }
+
+    const char* end = _p;
+    while (end < _e && *end != '\n' && *end != '\r') ++end;
+    if (_diagnostics) {
+        _diagnostics->report(_lineno, int(_p - _line) + 1, ParserDiagnostics::SYNTAX_ERROR, _p, end);
+        throw Abandon();
+    }
+
+    string msg = ParserDiagnostics::describe(ParserDiagnostics::SYNTAX_ERROR);
+    msg.append(what).append(", found: ");
+    if (size_t(end - _p) > ParserDiagnostics::EXCERPT_MAX) end = _p + ParserDiagnostics::EXCERPT_MAX;
+    msg.append(_p, end);
+    throw LSST_EXCEPT(FormatSyntaxError, msg, _lineno);
+}
+
+//@endcond
+
+}}}}   // end lsst::pex::policy::json
@@ -30,7 +30,16 @@
 #include "lsst/pex/policy/PolicyFile.h"
 #include "lsst/pex/policy/UrnPolicyFile.h"
 #include "lsst/pex/policy/parserexceptions.h"
+#include "lsst/pex/policy/detail/NumberConversion.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <map>
 #include <stdexcept>
+#include <thread>
+#include <typeinfo>
 
 namespace lsst {
 namespace pex {
@@ -42,46 +51,111 @@ namespace paf {
 using namespace std;
 using lsst::pex::policy::Policy;
 using lsst::pex::policy::PolicyParser;
-using boost::regex;
-using boost::match_results;
-using boost::regex_search;
-using boost::regex_match;
-using boost::smatch;
-
-const regex PAFParser::COMMENT_LINE("^\\s*#");
-const regex PAFParser::EMPTY_LINE("^(\\s*)$");
-const regex PAFParser::SPACE_SRCH("^(\\s+)");
-const regex PAFParser::PARAM_SRCH("^(\\s*)(\\w[\\w\\d\\.]*)\\s*:\\s*");
-const regex PAFParser::NAME_MTCH("\\w[\\w\\d]*(\\.\\w[\\w\\d])*");
-const regex PAFParser::OPEN_SRCH("^\\{\\s*");
-const regex PAFParser::CLOSE_SRCH("^\\s*\\}\\s*");
-const regex PAFParser::DOUBLE_VALUE
-    ("^([\\+\\-]?((((\\d+\\.\\d*)|(\\d*\\.\\d+))([eE][\\-\\+]?\\d{1,3})?)"
-     "|(\\d+[eE][\\-\\+]?\\d{1,3})))\\s*");
-const regex PAFParser::INT_VALUE("^([+-]?\\d+)\\s*");
-const regex PAFParser::ATRUE_VALUE("^([tT]rue)\\s*");
-const regex PAFParser::AFALSE_VALUE("^([fF]alse)\\s*");
-const regex PAFParser::QQSTRING_VALUE("^\"([^\"]*)\"\\s*");
-const regex PAFParser::QSTRING_VALUE("^'([^']*)'\\s*");
-const regex PAFParser::QQSTRING_START("^\"([^\"]*\\S)\\s*");
-const regex PAFParser::QSTRING_START("^'([^']*\\S)\\s*");
-const regex PAFParser::QQSTRING_EMPTYSTART("^\"\\s*$");
-const regex PAFParser::QSTRING_EMPTYSTART("^'\\s*$");
-const regex PAFParser::QQSTRING_END("^\\s*([^\"]*)\"\\s*");
-const regex PAFParser::QSTRING_END("^\\s*([^']*)'\\s*");
-const regex PAFParser::BARE_STRING_LINE("^\\s*(\\S(.*\\S)?)\\s*");
-const regex PAFParser::BARE_STRING("^\\s*([^#\\}\\s]([^#\\}]*[^#\\}\\s])?)\\s*[#}]?");
-const regex PAFParser::URN_VALUE("^@(urn\\:|@)");
-const regex PAFParser::FILE_VALUE("^@");
+using lsst::daf::base::Persistable;
+using lsst::pex::policy::detail::toDouble;
+using lsst::pex::policy::detail::toLong;
+
+namespace {
+
+/*
+ * Character classes and token scanners.  These reproduce the PAF grammar
+ * as originally written in terms of regular expressions:  whitespace is
+ * [ \t\n\v\f\r] and a word character is [A-Za-z0-9_].  Each scanner takes
+ * the range [p, e) and returns the end of the token found at p, or 0 if
+ * there is none.
+ */
+inline bool isSpace(char c) { return c == ' ' || (c >= '\t' && c <= '\r'); }
+inline bool isDigit(char c) { return c >= '0' && c <= '9'; }
+inline bool isWord(char c) {
+    return isDigit(c) || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+inline const char* skipSpace(const char* p, const char* e) {
+    while (p < e && isSpace(*p)) ++p;
+    return p;
+}
+
+// return the end of [b, e) with trailing whitespace removed
+inline const char* trimSpace(const char* b, const char* e) {
+    while (e > b && isSpace(e[-1])) --e;
+    return e;
+}
+
+inline const char* skipDigits(const char* p, const char* e) {
+    while (p < e && isDigit(*p)) ++p;
+    return p;
+}
+
+// [eE][-+]?\d{1,3}; returns p unchanged if there is no exponent
+const char* scanExponent(const char* p, const char* e) {
+    if (p == e || (*p != 'e' && *p != 'E')) return p;
+    const char* q = p + 1;
+    if (q < e && (*q == '+' || *q == '-')) ++q;
+    const char* d = q;
+    while (q < e && q - d < 3 && isDigit(*q)) ++q;
+    return (q > d) ? q : p;
+}
+
+// [+-]?((\d+\.\d*|\d*\.\d+)([eE][-+]?\d{1,3})?|\d+[eE][-+]?\d{1,3})
+const char* scanDouble(const char* p, const char* e) {
+    if (p < e && (*p == '+' || *p == '-')) ++p;
+    const char* d = skipDigits(p, e);
+    if (d < e && *d == '.') {
+        const char* f = skipDigits(d + 1, e);
+        if (d == p && f == d + 1) return 0;
+        return scanExponent(f, e);
+    }
+    if (d == p) return 0;
+    const char* x = scanExponent(d, e);
+    return (x > d) ? x : 0;
+}
+
+// [+-]?\d+
+const char* scanInt(const char* p, const char* e) {
+    if (p < e && (*p == '+' || *p == '-')) ++p;
+    const char* d = skipDigits(p, e);
+    return (d > p) ? d : 0;
+}
+
+// [tT]rue|[fF]alse
+const char* scanBool(const char* p, const char* e, bool& value) {
+    if (e - p >= 4 && (*p == 't' || *p == 'T') && equal(p + 1, p + 4, "rue")) {
+        value = true;
+        return p + 4;
+    }
+    if (e - p >= 5 && (*p == 'f' || *p == 'F') && equal(p + 1, p + 5, "alse")) {
+        value = false;
+        return p + 5;
+    }
+    return 0;
+}
+
+// true if [b, e) starts with "@urn:" or "@@", ignoring case
+bool isUrnValue(const char* b, const char* e) {
+    static const char urn[] = "@urn:";
+    if (e - b >= 2 && b[0] == '@' && b[1] == '@') return true;
+    if (e - b < 5) return false;
+    for (int i = 0; i < 5; ++i)
+        if (tolower(static_cast<unsigned char>(b[i])) != urn[i]) return false;
+    return true;
+}
+
+}  // namespace
 
 /*
  * create a parser to load a Policy
  */
 PAFParser::PAFParser(Policy& policy)
-    : PolicyParser(policy), _buffer(), _lineno(0), _depth(0)
+    : PolicyParser(policy), _path(), _open(), _name(), _ints(), _doubles(), _value(),
+      _strName(), _strValue(), _strLine(0), _quote(0), _index(), _indexed(false),
+      _carry(), _feeding(false), _threads(1), _dotted(false),
+      _line(0), _lineno(0), _count(0), _done(false)
 { }
 PAFParser::PAFParser(Policy& policy, bool strict)
-    : PolicyParser(policy, strict), _buffer(), _lineno(0), _depth(0)
+    : PolicyParser(policy, strict), _path(), _open(), _name(), _ints(), _doubles(), _value(),
+      _strName(), _strValue(), _strLine(0), _quote(0), _index(), _indexed(false),
+      _carry(), _feeding(false), _threads(1), _dotted(false),
+      _line(0), _lineno(0), _count(0), _done(false)
 { }
 
 /*
@@ -95,336 +169,501 @@ PAFParser::~PAFParser() { }
  * @return int   the number of values primitive values parsed.
  */
 int PAFParser::parse(istream& is) {
-    int count = _parseIntoPolicy(is, _pol);
+    string line;
+    _count = 0;
+    _indexed = false;
+
+    while (! _done && getline(is, line)) {
+        _lineno++;
+        _parseLine(line.data(), line.data() + line.size(), is.eof());
+    }
+    if (_done) return _count;
+
+    _endOfData();
+    if (! is.eof() && is.fail()) {
+        if (! _diagnostics) throw LSST_EXCEPT(ParserError, "read error", _lineno);
+        _diagnostics->report(_lineno, 0, ParserDiagnostics::READ_ERROR);
+    }
+
     // log count
+    return _count;
+}
+
+int PAFParser::parse(const char* data, size_t size) {
+    _count = 0;
+    if (_threads != 1 && size >= PARALLEL_MIN_SIZE && _parseParallel(data, size))
+        return _count;
 
-    return count;
+    _parseLines(data, data + size, true);
+    if (_done) return _count;
+
+    _endOfData();
+    return _count;
 }
 
-ios::iostate PAFParser::_nextLine(istream& is, string& line) {
-    if (_buffer.size() > 0) {
-        line = _buffer.front();
-        _buffer.pop_front();
+/*
+ * parse the next chunk of a document that arrives in pieces
+ */
+int PAFParser::feed(const char* data, size_t size) {
+    if (! _feeding) {
+        _count = 0;
+        _feeding = true;
     }
-    else {
-        line = "";
-        getline(is, line);
-        if (is.fail()) return is.rdstate();
-        if (is.eof() and line.length() == 0) return ios::eofbit;
+    const char* b = data;
+    const char* e = data + size;
+    if (_done) return _count;
+
+    // complete the line left over from the previous chunk
+    if (! _carry.empty()) {
+        const char* nl = static_cast<const char*>(memchr(b, '\n', e - b));
+        if (! nl) {
+            _carry.append(b, e);
+            return _count;
+        }
+        _carry.append(b, nl);
+        string line;
+        line.swap(_carry);
+        _indexed = false;
+        _lineno++;
+        _parseLine(line.data(), line.data() + line.size(), false);
+        b = nl + 1;
     }
-    _lineno++;
-    return ios::iostate(0);
+
+    if (! _done) b = _parseLines(b, e, false);
+    if (! _done) _carry.assign(b, e);
+    return _count;
 }
 
-void PAFParser::_pushBackLine(const string& line) {
-    _buffer.push_front(line);
-    _lineno--;
+/*
+ * signal the end of a document passed in with feed()
+ */
+int PAFParser::finish() {
+    string line;
+    line.swap(_carry);
+    _feeding = false;
+    if (_done) return _count;
+
+    if (! line.empty()) {
+        _indexed = false;
+        _lineno++;
+        _parseLine(line.data(), line.data() + line.size(), true);
+        if (_done) return _count;
+    }
+    _endOfData();
+    return _count;
 }
 
-int PAFParser::_parseIntoPolicy(istream& is, Policy& policy) {
+const char* PAFParser::_parseLines(const char* b, const char* e, bool final) {
+    _indexed = (size_t(e - b) <= StructuralIndex::MAX_SIZE);
+    if (_indexed) _index.build(b, e - b);
+
+    // split into lines exactly as getline() would
+    while (! _done && b < e) {
+        const char* nl = _find(b, e, '\n', '\n');
+        if (nl == e) {
+            if (final) {
+                _lineno++;
+                _parseLine(b, e, true);
+                b = e;
+            }
+            break;
+        }
+        _lineno++;
+        _parseLine(b, nl, false);
+        b = nl + 1;
+    }
+    _indexed = false;
+    return b;
+}
 
-    string line, name, value;
-    smatch matched;
-    int count = 0;
+namespace {
+
+// true if [b, e) opens a top-level sub-policy, i.e. "name: {" beginning
+// in the first column
+bool opensBlock(const char* b, const char* e) {
+    if (b == e || ! isWord(*b)) return false;
+    while (b < e && (isWord(*b) || *b == '.')) ++b;
+    b = skipSpace(b, e);
+    if (b == e || *b != ':') return false;
+    b = skipSpace(b + 1, e);
+    return (b < e && *b == '{');
+}
 
-    while (!_nextLine(is, line)) {
-        if (regex_search(line, COMMENT_LINE))
-            continue;
+// a piece of a buffer being parsed on its own
+struct Block {
+    const char* begin;
+    const char* end;
+    int lineno;                     // lines preceding the block
+    Policy policy;
+    std::unique_ptr<PAFParser> parser;
+    bool ok;
+};
+
+// append the values of a top-level name of from to the same name in to
+template <typename T>
+void splice(Policy& to, const Policy& from, const string& name) {
+    vector<T> values = from.getValueArray<T>(name);
+    for (typename vector<T>::const_iterator it = values.begin(); it != values.end(); ++it)
+        to.addValue<T>(name, *it);
+}
 
-        if (regex_search(line, matched, CLOSE_SRCH)) {
-            _depth--;
-            if (_depth < 0) {
-                string msg = "extra '}' character encountered.";
-                if (_strict) throw LSST_EXCEPT(FormatSyntaxError, msg, _lineno);
-                // log message
-            }
+void splice(Policy& to, const Policy& from, const string& name, Policy::ValueType type) {
+    if (type == Policy::BOOL)
+        splice<bool>(to, from, name);
+    else if (type == Policy::INT)
+        splice<int>(to, from, name);
+    else if (type == Policy::DOUBLE)
+        splice<double>(to, from, name);
+    else if (type == Policy::STRING)
+        splice<string>(to, from, name);
+    else if (type == Policy::POLICY)
+        splice<Policy::Ptr>(to, from, name);
+    else
+        splice<Policy::FilePtr>(to, from, name);
+}
 
-            _pushBackLine(matched.suffix());
-            return count;
+}  // namespace
+
+const size_t PAFParser::PARALLEL_MIN_SIZE = 1 << 16;
+
+bool PAFParser::_parseParallel(const char* data, size_t size) {
+    // only a fresh parser loading into a Policy without a Dictionary
+    if (_lineno != 0 || ! _open.empty() || _quote || _done || _handler || _diagnostics ||
+        _pol.canValidate())
+        return false;
+
+    int nthreads = _threads;
+    if (nthreads <= 0) nthreads = thread::hardware_concurrency();
+    if (nthreads < 2) return false;
+
+    // cut the buffer into roughly equal pieces at lines opening a
+    // top-level block
+    const char* e = data + size;
+    vector<Block> blocks(1);
+    blocks[0].begin = data;
+    blocks[0].lineno = 0;
+    size_t want = size / nthreads;
+    int lineno = 0;
+    for (const char* b = data; b < e; ++lineno) {
+        const char* nl = static_cast<const char*>(memchr(b, '\n', e - b));
+        if (! nl) nl = e;
+        if (size_t(b - data) >= want * blocks.size() && opensBlock(b, nl)) {
+            blocks.back().end = b;
+            blocks.push_back(Block());
+            blocks.back().begin = b;
+            blocks.back().lineno = lineno;
+            if (int(blocks.size()) == nthreads) break;
         }
-        else if (regex_search(line, matched, PARAM_SRCH)) {
-
-            name = matched.str(2);
-            if (! regex_search(name, NAME_MTCH)) {
-                string msg = "Not a legal names designation: ";
-                msg.append(name);
-                if (_strict)
-                    throw LSST_EXCEPT(FormatSyntaxError, msg, _lineno);
-                // log warning
-                continue;
+        b = (nl < e) ? nl + 1 : e;
+    }
+    blocks.back().end = e;
+    if (blocks.size() < 2) return false;
+
+    // parse each piece as if it were a whole file that starts at the
+    // right line
+    vector<thread> workers;
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        Block& blk = blocks[i];
+        blk.parser.reset(new PAFParser(blk.policy, _strict));
+        blk.parser->_lineno = blk.lineno;
+        blk.ok = false;
+        workers.push_back(thread([&blk]() {
+            try {
+                blk.parser->parse(blk.begin, blk.end - blk.begin);
+                blk.ok = true;
+            } catch (...) {
+                // parse serially to get the error exactly right
             }
+        }));
+    }
+    for (size_t i = 0; i < workers.size(); ++i) workers[i].join();
+
+    // Each piece but the last must leave the parser back at the top level;
+    // then, by induction, every piece was parsed exactly as it would have
+    // been serially.
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        const PAFParser& p = *blocks[i].parser;
+        if (! blocks[i].ok) return false;
+        if (i + 1 < blocks.size() && (p._done || ! p._open.empty())) return false;
+    }
 
-            value = matched.suffix();
-            count += _addValue(name, value, policy, is);
-        }
-        else if (! regex_search(line, matched, EMPTY_LINE)) {
-            string msg = "Bad parameter name format: " + line;
-            if (_strict)
-                throw LSST_EXCEPT(FormatSyntaxError, msg, _lineno);
-            // log warning
-            continue;
+    // The pieces can be added in order only if each name they share
+    // holds the same type throughout and was never given with a dotted
+    // (hierarchical) name, which would merge into an existing sub-policy.
+    vector<vector<string> > names(blocks.size());
+    vector<vector<Policy::ValueType> > types(blocks.size());
+    map<string, Policy::ValueType> seen;
+    bool dotted = false;
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        const Policy& from = blocks[i].policy;
+        dotted = dotted || blocks[i].parser->_dotted;
+        names[i] = from.names(true);
+        types[i].reserve(names[i].size());
+        for (vector<string>::const_iterator it = names[i].begin(); it != names[i].end(); ++it) {
+            Policy::ValueType type = from.getValueType(*it);
+            types[i].push_back(type);
+            pair<map<string, Policy::ValueType>::iterator, bool> t = seen.insert(make_pair(*it, type));
+            if (t.second && _pol.exists(*it)) t.first->second = _pol.getValueType(*it);
+            else if (t.second) continue;
+            if (dotted || t.first->second != type) return false;
         }
     }
-    if (! is.eof() && is.fail()) throw LSST_EXCEPT(ParserError, "read error", _lineno);
 
-    return count;
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        for (size_t j = 0; j < names[i].size(); ++j)
+            splice(_pol, blocks[i].policy, names[i][j], types[i][j]);
+        _count += blocks[i].parser->_count;
+    }
+    _lineno = blocks.back().parser->_lineno;
+    _done = blocks.back().parser->_done;
+    return true;
 }
 
-int PAFParser::_addValue(const string& propname, string& value,
-                         Policy& policy, istream& is)
-{
-    string element, msg;
-    smatch matched;
-    int count = 0;
+const char* PAFParser::_find(const char* p, const char* e, char c1, char c2) const {
+    if (_indexed) return _index.find(p, e, c1, c2);
+    while (p < e && *p != c1 && *p != c2) ++p;
+    return p;
+}
 
-    if (value.size() == 0 || regex_search(value, COMMENT_LINE))
-        // no value provide; ignore it.
-        return count;
+void PAFParser::_endOfData() {
+    if (_quote) {
+        // the data ended inside a multi-line string
+        if (_diagnostics) {
+            _diagnostics->report(_lineno, 0, ParserDiagnostics::UNTERMINATED_STRING);
+            _quote = 0;
+            return;
+        }
+        if (_strict) throw LSST_EXCEPT(EOFError, _lineno);
+        throw LSST_EXCEPT(ParserError, "read error", _lineno);
+    }
+}
 
-    if (regex_search(value, matched, OPEN_SRCH)) {
-        _depth++;
+bool PAFParser::_problem(ParserDiagnostics::Kind kind, const char* b, const char* e) {
+    if (_diagnostics) {
+        int column = (b && b >= _line && b <= e) ? int(b - _line) + 1 : 0;
+        if (! _diagnostics->report(_lineno, column, kind, b, e)) _done = true;
+        return true;
+    }
+    if (! _strict) return false;    // log message
+
+    string msg = ParserDiagnostics::describe(kind);
+    if (kind != ParserDiagnostics::EXTRA_BRACE) msg.append(b, e);
+    if (kind == ParserDiagnostics::UNSUPPORTED_LONG)
+        throw LSST_EXCEPT(UnsupportedSyntax, msg, _lineno);
+    throw LSST_EXCEPT(FormatSyntaxError, msg, _lineno);
+}
+
+void PAFParser::_parseLine(const char* b, const char* e, bool atEnd) {
+    if (! _diagnostics) {
+        _scanLine(b, e, atEnd);
+        return;
+    }
+    try {
+        _scanLine(b, e, atEnd);
+    } catch (lsst::pex::exceptions::Exception& ex) {
+        // a value the handler would not take, e.g. one of the wrong type
+        const char* what = ex.what();
+        if (! _diagnostics->report(_lineno, 0, ParserDiagnostics::REJECTED_VALUE,
+                                   what, what + strlen(what)))
+            _done = true;
+    }
+}
 
-        // make a sub-policy
-        Policy::Ptr subpolicy(new Policy());
-        policy.add(propname, subpolicy);
+void PAFParser::_scanLine(const char* b, const char* e, bool atEnd) {
+    _line = b;
+
+    if (_quote) {
+        // we are inside a multi-line string
+        _strValue.append(" ");
+        const char* q = _find(b, e, _quote, _quote);
+        if (q == e) {
+            const char* p = skipSpace(b, e);
+            _strValue.append(p, trimSpace(p, e));
+            return;
+        }
 
-        // look for extra stuff on the line
-        value = matched.suffix();
-        if (value.size() > 0 && ! regex_search(value, COMMENT_LINE))
-            _pushBackLine(value);
+        _strValue.append(skipSpace(b, q), q);
+        _quote = 0;
+        _events().onString(_strName, _strValue, _strLine);
+        _count++;
+        if (atEnd && _diagnostics)
+            _problem(ParserDiagnostics::UNEXPECTED_EOF, 0, 0);
+        else if (atEnd && _strict)
+            throw LSST_EXCEPT(EOFError, _lineno);
 
-        // fill in the sub-policy
-        count += _parseIntoPolicy(is, *subpolicy);
+        b = _addStrings(_strName, skipSpace(q + 1, e), e);
     }
-    else if (regex_search(value, matched, DOUBLE_VALUE)) {
-        do {
-            element = matched.str(1);
-            value = matched.suffix();
-
-            char *unparsed;
-            double d = strtod(element.c_str(), &unparsed);
-            if (unparsed && (*unparsed)) {
-                msg = "value contains unparsable non-numeric data: ";
-                msg.append(element);
-                if (_strict) throw LSST_EXCEPT(FormatSyntaxError, msg, _lineno);
-                break;
-            }
 
-            policy.add(propname, d);
-            count++;
-            if (value.size() > 0) {
-                if (regex_search(value,COMMENT_LINE)) {
-                    value.erase();
-                    break;
-                }
-                else if (regex_search(value, CLOSE_SRCH)) {
-                    _pushBackLine(value);
-                    return count;
+    // b marks the start of the text still to be scanned; it advances past
+    // each closing brace so that whatever follows it is treated as a line
+    // of its own.
+    while (b) {
+        const char* p = skipSpace(b, e);
+        if (p == e || *p == '#')
+            return;
+
+        if (*p == '}') {
+            if (_open.empty()) {
+                if (_problem(ParserDiagnostics::EXTRA_BRACE, p, p + 1)) {
+                    // skip it and look for more problems
+                    b = skipSpace(p + 1, e);
+                    continue;
                 }
+                _done = true;
+                return;
             }
-            else
-                break;
-        } while (regex_search(value, matched, DOUBLE_VALUE));
-
-        if (value.size() > 0) {
-            msg = "Expecting double value, found: ";
-            msg.append(value);
-            if (_strict) throw LSST_EXCEPT(FormatSyntaxError, msg, _lineno);
-            // log message
+            _events().endPolicy(_path, _lineno);
+            _path.resize(_open.back());
+            _open.pop_back();
+            b = skipSpace(p + 1, e);
+            continue;
+        }
+
+        // name: value
+        const char* n = p;
+        const char* colon = e;
+        if (isWord(*n)) {
+            while (n < e && (isWord(*n) || *n == '.')) ++n;
+            colon = skipSpace(n, e);
+        }
+        if (colon == e || *colon != ':') {
+            _problem(ParserDiagnostics::BAD_NAME, b, e);
+            return;
         }
+
+        if (_open.empty()) {
+            _name.assign(p, n);
+            if (find(p, n, '.') != n) _dotted = true;
+        } else {
+            _name.assign(_path).append(1, '.').append(p, n);
+        }
+        b = _addValue(_name, skipSpace(colon + 1, e), e);
     }
-    else if (regex_search(value, matched, INT_VALUE)) {
-        do {
-            element = matched.str(1);
-            value = matched.suffix();
-
-            char *unparsed;
-            long lval = strtol(element.c_str(), &unparsed, 10);
-            if (unparsed && (*unparsed)) {
-                msg = "value contains unparsable non-integer data: ";
-                msg.append(element);
-                if (_strict) throw LSST_EXCEPT(FormatSyntaxError, msg, _lineno);
-                continue;
-            }
+}
 
-            int ival = int(lval);
-            if (lval-ival != 0) {
-                // longs are unsupported
-                msg = "unsupported long integer value found: ";
-                msg.append(value);
-                if (_strict) throw LSST_EXCEPT(UnsupportedSyntax, msg, _lineno);
-                // log a message
-            }
+const char* PAFParser::_addValue(const string& propname, const char* v, const char* e) {
+    if (v == e || *v == '#')
+        // no value provide; ignore it.
+        return 0;
+
+    PolicyHandler& events = _events();
+    const char* q;
+    bool bval;
+
+    if (*v == '{') {
+        // open a sub-policy; the rest of the line goes into it
+        events.beginPolicy(propname, _lineno);
+        _open.push_back(_path.size());
+        _path = propname;
+        return skipSpace(v + 1, e);
+    }
+    else if ((q = scanDouble(v, e))) {
+        // convert the whole run of numbers, then add them all at once
+        _doubles.clear();
+        do {
+            _doubles.push_back(toDouble(v, q));
+            v = skipSpace(q, e);
+        } while (v < e && *v != '#' && *v != '}' && (q = scanDouble(v, e)));
 
-            policy.add(propname, ival);
-            count++;
+        events.onDoubles(propname, _doubles, _lineno);
+        _count += _doubles.size();
+        if (v == e || *v == '#') return 0;
+        if (*v == '}') return v;
 
-            if (value.size() > 0) {
-                if (regex_search(value,COMMENT_LINE)) {
-                    value.erase();
-                    break;
-                }
-                else if (regex_search(value, CLOSE_SRCH)) {
-                    _pushBackLine(value);
-                    return count;
-                }
-            }
-            else
-                break;
-        } while (regex_search(value, matched, INT_VALUE));
-
-        if (value.size() > 0) {
-            msg = "Expecting integer value, found: ";
-            msg.append(value);
-            if (_strict) throw LSST_EXCEPT(FormatSyntaxError, msg, _lineno);
-            // log message
-        }
+        _problem(ParserDiagnostics::EXPECTED_DOUBLE, v, e);
     }
-    else if (regex_search(value, matched, ATRUE_VALUE) ||
-             regex_search(value, matched, AFALSE_VALUE))
-    {
+    else if ((q = scanInt(v, e))) {
+        _ints.clear();
         do {
-            element = matched.str(1);
-            value = matched.suffix();
-            if (element[0] == 't' || element[0] == 'T')
-                policy.add(propname, true);
-            else
-                policy.add(propname, false);
-            count++;
-
-            if (value.size() > 0) {
-                if (regex_search(value,COMMENT_LINE)) {
-                    value.erase();
-                    break;
-                }
-                else if (regex_search(value, CLOSE_SRCH)) {
-                    _pushBackLine(value);
-                    return count;
+            long lval = toLong(v, q);
+            const char* num = v;
+            v = skipSpace(q, e);
+
+            int ival = int(lval);
+            if (lval-ival != 0) {
+                // longs are unsupported.  The exception message has always
+                // quoted the text after the number; diagnostics show it.
+                if (_diagnostics) {
+                    _problem(ParserDiagnostics::UNSUPPORTED_LONG, num, q);
+                } else {
+                    // keep the values that came before it if this throws
+                    if (_strict) events.onInts(propname, _ints, _lineno);
+                    _problem(ParserDiagnostics::UNSUPPORTED_LONG, v, e);
                 }
             }
-            else
-                break;
-        } while (regex_search(value, matched, ATRUE_VALUE) ||
-                 regex_search(value, matched, AFALSE_VALUE));
-
-        if (value.size() > 0) {
-            msg = "Expecting boolean value, found: ";
-            msg.append(value);
-            if (_strict)
-                throw LSST_EXCEPT(FormatSyntaxError, msg, _lineno);
-            // log message
-        }
+            _ints.push_back(ival);
+        } while (v < e && *v != '#' && *v != '}' && (q = scanInt(v, e)));
+
+        events.onInts(propname, _ints, _lineno);
+        _count += _ints.size();
+        if (v == e || *v == '#') return 0;
+        if (*v == '}') return v;
+
+        _problem(ParserDiagnostics::EXPECTED_INT, v, e);
     }
-    else if (value.at(0) == '\'' || value.at(0) == '"') {
-        // we are starting a string
+    else if ((q = scanBool(v, e, bval))) {
         do {
-            if (regex_search(value, matched, QQSTRING_VALUE) ||
-                regex_search(value, matched, QSTRING_VALUE))
-            {
-                element = matched.str(1);
-                value = matched.suffix();
+            events.onBool(propname, bval, _lineno);
+            _count++;
 
-                policy.add(propname, element);
-                count++;
+            v = skipSpace(q, e);
+            if (v == e || *v == '#') return 0;
+            if (*v == '}') return v;
+        } while ((q = scanBool(v, e, bval)));
 
-                if (value.size() > 0 && regex_search(value, COMMENT_LINE))
-                    value.erase();
-            }
-            else if (regex_search(value, matched, QQSTRING_EMPTYSTART) ||
-                     regex_search(value, matched, QQSTRING_START)        ) {
-                // start of multi-line string
-                element = (matched.size() > 1) ? matched.str(1) : "";
-                while (!_nextLine(is, value)) {
-                    element.append(" ");
-                    if (regex_search(value, matched, QQSTRING_END)) {
-                        element.append(matched.str(1));
-                        policy.add(propname, element);
-                        count++;
-                        value = matched.suffix();
-                        break;
-                    }
-                    else if (regex_search(value, matched, BARE_STRING_LINE)) {
-                        element.append(matched.str(1));
-                    }
-                }
-                if (is.eof()) {
-                    if (_strict) throw LSST_EXCEPT(EOFError, _lineno);
-                    // log message
-                }
-                if (is.fail())
-                    throw LSST_EXCEPT(ParserError, "read error", _lineno);
-            }
-            else if (regex_search(value, matched, QSTRING_EMPTYSTART) ||
-                     regex_match(value, matched, QSTRING_START)) {
-                // start of multi-line string
-                element = (matched.size() > 1) ? matched.str(1) : "";
-                while (!_nextLine(is, value)) {
-                    element.append(" ");
-                    if (regex_search(value, matched, QSTRING_END)) {
-                        element.append(matched.str(1));
-                        policy.add(propname, element);
-                        count++;
-                        value = matched.suffix();
-                        break;
-                    }
-                    else if (regex_match(value, matched, BARE_STRING_LINE)) {
-                        element.append(matched.str(1));
-                    }
-                }
-                if (is.eof()) {
-                    if (_strict) throw LSST_EXCEPT(EOFError, _lineno);
-                    // log message
-                }
-                if (is.fail())
-                    throw LSST_EXCEPT(ParserError, "read error", _lineno);
-            }
+        _problem(ParserDiagnostics::EXPECTED_BOOL, v, e);
+    }
+    else if (*v == '\'' || *v == '"') {
+        return _addStrings(propname, v, e);
+    }
+    else if (*v != '}') {
+        // a bare string runs to the first comment or closing brace
+        q = trimSpace(v, _find(v, e, '#', '}'));
 
-            if (value.size() > 0) {
-                if (regex_search(value,COMMENT_LINE)) {
-                    value.erase();
-                    break;
-                }
-                else if (regex_search(value, CLOSE_SRCH)) {
-                    _pushBackLine(value);
-                    return count;
-                }
-            }
-            else
-                break;
-        } while (value.size() > 0 &&
-                 (value.at(0) == '\'' || value.at(0) == '"'));
-
-        if (value.size() > 0) {
-            msg = "Expecting quoted string value, found: ";
-            msg.append(value);
-            if (_strict) throw LSST_EXCEPT(FormatSyntaxError, msg, _lineno);
-            // log message
+        if (isUrnValue(v, q)) {
+            events.onFile(propname, Policy::FilePtr(new UrnPolicyFile(string(v, q))), _lineno);
         }
-    }
-    else if (regex_search(value, matched, BARE_STRING)) {
-        string trimmed = matched.str(1);
-	string lowered(trimmed);
-	transform(lowered.begin(), lowered.end(), lowered.begin(), ::tolower);
-        int resume = matched.position(1) + matched.length(1);
-	if (regex_search(lowered, matched, URN_VALUE)) {
-	    policy.add(propname,
-		       Policy::FilePtr(new UrnPolicyFile(trimmed)));
-	}
-        else if (regex_search(trimmed, matched, FILE_VALUE)) {
-            policy.add(propname,
-		       Policy::FilePtr(new PolicyFile(matched.suffix().str())));
+        else if (*v == '@') {
+            events.onFile(propname, Policy::FilePtr(new PolicyFile(string(v+1, q))), _lineno);
         }
         else {
-            policy.add(propname, trimmed);
-        }
-        count++;
-        value = value.substr(resume);
-        if (regex_search(value, matched, CLOSE_SRCH)) {
-            _pushBackLine(value);
+            _value.assign(v, q);
+            events.onString(propname, _value, _lineno);
         }
+        _count++;
+
+        v = skipSpace(q, e);
+        if (v < e && *v == '}') return q;
     }
 
-    return count;
+    return 0;
+}
+
+const char* PAFParser::_addStrings(const string& propname, const char* v, const char* e) {
+    while (v < e) {
+        if (*v == '#') return 0;
+        if (*v == '}') return v;
+        if (*v != '\'' && *v != '"') {
+            _problem(ParserDiagnostics::EXPECTED_STRING, v, e);
+            return 0;
+        }
+
+        const char* q = _find(v + 1, e, *v, *v);
+        if (q == e) {
+            // start of multi-line string; it is finished by _scanLine()
+            _quote = *v;
+            _strName = propname;
+            _strLine = _lineno;
+            _strValue.assign(v + 1, trimSpace(v + 1, e));
+            return 0;
+        }
+
+        _value.assign(v + 1, q);
+        _events().onString(propname, _value, _lineno);
+        _count++;
+        v = skipSpace(q + 1, e);
+    }
+    return 0;
 }
 
 //@endcond
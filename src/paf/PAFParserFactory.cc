@@ -60,7 +60,9 @@ const regex
 PolicyParser* PAFParserFactory::createParser(Policy& policy,
                                              bool strict) const
 {
-    return new PAFParser(policy, strict);
+    PAFParser* parser = new PAFParser(policy, strict);
+    parser->setThreads(_threads);
+    return parser;
 }
 
 /*
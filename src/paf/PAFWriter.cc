@@ -62,9 +62,14 @@ void PAFWriter::writeBools(const std::string& name,
 }
 void PAFWriter::writeInts(const std::string& name,
                           const Policy::IntArray& values)
+{
+    writeInts(name, Policy::IntArrayView(values));
+}
+void PAFWriter::writeInts(const std::string& name,
+                          const Policy::IntArrayView& values)
 {
     (*_os) << _indent << name << ": ";
-    Policy::IntArray::const_iterator vi;
+    Policy::IntArrayView::const_iterator vi;
     for(vi = values.begin(); vi != values.end(); ++vi) {
         (*_os) << *vi;
         if (vi+1 != values.end()) (*_os) << " ";
@@ -73,9 +78,14 @@ void PAFWriter::writeInts(const std::string& name,
 }
 void PAFWriter::writeDoubles(const std::string& name,
                              const Policy::DoubleArray& values)
+{
+    writeDoubles(name, Policy::DoubleArrayView(values));
+}
+void PAFWriter::writeDoubles(const std::string& name,
+                             const Policy::DoubleArrayView& values)
 {
     (*_os) << _indent << name << ": ";
-    Policy::DoubleArray::const_iterator vi;
+    Policy::DoubleArrayView::const_iterator vi;
     for(vi = values.begin(); vi != values.end(); ++vi) {
         (*_os) << *vi;
         if (vi+1 != values.end()) (*_os) << " ";
@@ -84,8 +94,12 @@ void PAFWriter::writeDoubles(const std::string& name,
 }
 void PAFWriter::writeStrings(const std::string& name,
                              const Policy::StringArray& values) {
+    writeStrings(name, Policy::StringArrayView(values));
+}
+void PAFWriter::writeStrings(const std::string& name,
+                             const Policy::StringArrayView& values) {
     (*_os) << _indent << name << ": ";
-    Policy::StringArray::const_iterator vi;
+    Policy::StringArrayView::const_iterator vi;
     for(vi = values.begin(); vi != values.end(); ++vi) {
         (*_os) << '"' << *vi << '"';
         if (vi+1 != values.end()) (*_os) << " ";
@@ -0,0 +1,182 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file StructuralIndex.cc
+ * @ingroup pex
+ */
+
+#include "lsst/pex/policy/paf/StructuralIndex.h"
+
+#include <algorithm>
+#include <limits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PAF_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+namespace lsst {
+namespace pex {
+namespace policy {
+namespace paf {
+
+//@cond
+
+using namespace std;
+
+const size_t StructuralIndex::MAX_SIZE = numeric_limits<StructuralIndex::Offset>::max();
+
+namespace {
+
+typedef StructuralIndex::Offset Offset;
+
+inline bool isStructural(char c) {
+    return c == '\n' || c == '#' || c == '}' || c == '"' || c == '\'';
+}
+
+void indexScalar(const char* data, size_t begin, size_t end, vector<Offset>& out) {
+    for (size_t i = begin; i < end; ++i)
+        if (isStructural(data[i])) out.push_back(Offset(i));
+}
+
+#ifdef PAF_X86_SIMD
+
+// append the offsets of the bits set in mask, relative to base
+inline void appendMask(unsigned mask, size_t base, vector<Offset>& out) {
+    while (mask) {
+        out.push_back(Offset(base + __builtin_ctz(mask)));
+        mask &= mask - 1;
+    }
+}
+
+__attribute__((target("sse2")))
+void indexSse2(const char* data, size_t size, vector<Offset>& out) {
+    const __m128i nl = _mm_set1_epi8('\n'), hash = _mm_set1_epi8('#'), close = _mm_set1_epi8('}'),
+                  qq = _mm_set1_epi8('"'), q = _mm_set1_epi8('\'');
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x, nl), _mm_cmpeq_epi8(x, hash)),
+                                 _mm_or_si128(_mm_cmpeq_epi8(x, close),
+                                              _mm_or_si128(_mm_cmpeq_epi8(x, qq), _mm_cmpeq_epi8(x, q))));
+        appendMask(unsigned(_mm_movemask_epi8(m)), i, out);
+    }
+    indexScalar(data, i, size, out);
+}
+
+__attribute__((target("avx2")))
+void indexAvx2(const char* data, size_t size, vector<Offset>& out) {
+    const __m256i nl = _mm256_set1_epi8('\n'), hash = _mm256_set1_epi8('#'), close = _mm256_set1_epi8('}'),
+                  qq = _mm256_set1_epi8('"'), q = _mm256_set1_epi8('\'');
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i m = _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(x, nl), _mm256_cmpeq_epi8(x, hash)),
+                _mm256_or_si256(_mm256_cmpeq_epi8(x, close),
+                                _mm256_or_si256(_mm256_cmpeq_epi8(x, qq), _mm256_cmpeq_epi8(x, q))));
+        appendMask(unsigned(_mm256_movemask_epi8(m)), i, out);
+    }
+    indexScalar(data, i, size, out);
+}
+
+#endif
+
+}  // namespace
+
+bool StructuralIndex::supports(Isa isa) {
+#ifdef PAF_X86_SIMD
+    __builtin_cpu_init();
+#endif
+    switch (isa) {
+    case SCALAR:
+        return true;
+#ifdef PAF_X86_SIMD
+    case SSE2:
+        return __builtin_cpu_supports("sse2");
+    case AVX2:
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return false;
+    }
+}
+
+StructuralIndex::Isa StructuralIndex::bestIsa() {
+    static const Isa best = supports(AVX2) ? AVX2 : supports(SSE2) ? SSE2 : SCALAR;
+    return best;
+}
+
+string StructuralIndex::isaName(Isa isa) {
+    switch (isa) {
+    case SSE2:
+        return "SSE2";
+    case AVX2:
+        return "AVX2";
+    default:
+        return "scalar";
+    }
+}
+
+StructuralIndex::StructuralIndex(Isa isa)
+    : _isa(supports(isa) ? isa : bestIsa()), _data(0), _offsets(), _cursor(0)
+{ }
+
+void StructuralIndex::build(const char* data, size_t size) {
+    _data = data;
+    _offsets.clear();
+    _cursor = 0;
+    switch (_isa) {
+#ifdef PAF_X86_SIMD
+    case AVX2:
+        indexAvx2(data, size, _offsets);
+        break;
+    case SSE2:
+        indexSse2(data, size, _offsets);
+        break;
+#endif
+    default:
+        indexScalar(data, 0, size, _offsets);
+    }
+}
+
+const char* StructuralIndex::find(const char* p, const char* e, char c1, char c2) const {
+    Offset from = Offset(p - _data);
+    if (_cursor > 0 && _offsets[_cursor - 1] >= from) {
+        // searching behind the previous start: not the lexer's usual order
+        _cursor = lower_bound(_offsets.begin(), _offsets.begin() + _cursor, from)
+                - _offsets.begin();
+    }
+    while (_cursor < _offsets.size() && _offsets[_cursor] < from) ++_cursor;
+
+    for (size_t i = _cursor; i < _offsets.size(); ++i) {
+        const char* c = _data + _offsets[i];
+        if (c >= e) break;
+        if (*c == c1 || *c == c2) return c;
+    }
+    return e;
+}
+
+//@endcond
+
+}}}}   // end lsst::pex::policy::paf
@@ -0,0 +1,677 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file XMLParser.cc
+ * @ingroup pex
+ */
+
+#include "lsst/pex/policy/xml/XMLParser.h"
+#include "lsst/pex/policy/Dictionary.h"
+#include "lsst/pex/policy/PolicyFile.h"
+#include "lsst/pex/policy/UrnPolicyFile.h"
+#include "lsst/pex/policy/parserexceptions.h"
+#include "lsst/pex/policy/detail/NumberConversion.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace lsst {
+namespace pex {
+namespace policy {
+namespace xml {
+
+//@cond
+
+using namespace std;
+using lsst::pex::policy::Policy;
+using lsst::pex::policy::PolicyParser;
+using lsst::pex::policy::detail::toDouble;
+using lsst::pex::policy::detail::toLong;
+
+namespace {
+
+// thrown to abandon a parse once a problem has been recorded that the
+// parser cannot recover from, or the fail-fast threshold is reached
+struct Abandon {};
+
+inline bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+inline bool isDigit(char c) { return c >= '0' && c <= '9'; }
+inline bool isWord(char c) {
+    return isDigit(c) || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+// a simplified test for the characters of an XML name; any non-ASCII
+// byte is accepted
+inline bool isNameChar(char c) {
+    return isWord(c) || c == '-' || c == '.' || c == ':' || (c & 0x80);
+}
+
+// true if name has the form of a PAF parameter name
+bool isName(const string& name) {
+    if (name.empty() || ! isWord(name[0])) return false;
+    for (string::const_iterator c = name.begin(); c != name.end(); ++c)
+        if (! isWord(*c) && *c != '.') return false;
+    return true;
+}
+
+// true if [p, e) starts with s
+inline bool startsWith(const char* p, const char* e, const char* s) {
+    size_t n = strlen(s);
+    return size_t(e - p) >= n && memcmp(p, s, n) == 0;
+}
+
+const char* skipSpace(const char* p, const char* e) {
+    while (p < e && isSpace(*p)) ++p;
+    return p;
+}
+
+// the kinds of value a token of text can hold
+enum TokenKind { OTHER = 0, INT, DOUBLE, BOOL };
+
+// classify the token [b, e) as PAF would: [+-]?\d+ is an integer,
+// [+-]?(\d+\.?\d*|\.\d+)([eE][+-]?\d+)? a double and [tT]rue|[fF]alse a
+// boolean
+TokenKind tokenKind(const char* b, const char* e, bool& bval) {
+    if (e - b == 4 && (*b == 't' || *b == 'T') && equal(b + 1, e, "rue")) {
+        bval = true;
+        return BOOL;
+    }
+    if (e - b == 5 && (*b == 'f' || *b == 'F') && equal(b + 1, e, "alse")) {
+        bval = false;
+        return BOOL;
+    }
+
+    const char* p = b;
+    if (p < e && (*p == '+' || *p == '-')) ++p;
+    const char* d = p;
+    while (p < e && isDigit(*p)) ++p;
+    bool digits = (p > d);
+    if (p == e) return (digits) ? INT : OTHER;
+
+    if (*p == '.') {
+        d = ++p;
+        while (p < e && isDigit(*p)) ++p;
+        digits = digits || (p > d);
+    }
+    if (! digits) return OTHER;
+    if (p < e && (*p == 'e' || *p == 'E')) {
+        ++p;
+        if (p < e && (*p == '+' || *p == '-')) ++p;
+        d = p;
+        while (p < e && isDigit(*p)) ++p;
+        if (p == d) return OTHER;
+    }
+    return (p == e) ? DOUBLE : OTHER;
+}
+
+// true if [b, e) starts with "@urn:" or "@@", ignoring case
+bool isUrnValue(const char* b, const char* e) {
+    static const char urn[] = "@urn:";
+    if (e - b >= 2 && b[0] == '@' && b[1] == '@') return true;
+    if (e - b < 5) return false;
+    for (int i = 0; i < 5; ++i)
+        if (tolower(static_cast<unsigned char>(b[i])) != urn[i]) return false;
+    return true;
+}
+
+// read hex or decimal digits for a character reference
+bool readCodePoint(const char* b, const char* e, unsigned int& cp) {
+    int base = 10;
+    if (b < e && *b == 'x') {
+        base = 16;
+        ++b;
+    }
+    if (b == e || e - b > 8) return false;
+    cp = 0;
+    for (; b < e; ++b) {
+        char c = *b;
+        unsigned int d;
+        if (c >= '0' && c <= '9') d = c - '0';
+        else if (base == 16 && c >= 'a' && c <= 'f') d = c - 'a' + 10;
+        else if (base == 16 && c >= 'A' && c <= 'F') d = c - 'A' + 10;
+        else return false;
+        cp = cp * base + d;
+    }
+    return cp > 0 && cp <= 0x10FFFF;
+}
+
+void appendUtf8(string& out, unsigned int cp) {
+    if (cp < 0x80) {
+        out += char(cp);
+    } else if (cp < 0x800) {
+        out += char(0xC0 | (cp >> 6));
+        out += char(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += char(0xE0 | (cp >> 12));
+        out += char(0x80 | ((cp >> 6) & 0x3F));
+        out += char(0x80 | (cp & 0x3F));
+    } else {
+        out += char(0xF0 | (cp >> 18));
+        out += char(0x80 | ((cp >> 12) & 0x3F));
+        out += char(0x80 | ((cp >> 6) & 0x3F));
+        out += char(0x80 | (cp & 0x3F));
+    }
+}
+
+}  // namespace
+
+/*
+ * create a parser to load a Policy
+ */
+XMLParser::XMLParser(Policy& policy)
+    : PolicyParser(policy), _elements(), _depth(0), _name(), _tag(), _attrName(), _attrValue(),
+      _attrs(), _ints(), _doubles(), _dictionary(false), _rootDone(false),
+      _p(0), _e(0), _line(0), _lineno(0), _count(0)
+{ }
+XMLParser::XMLParser(Policy& policy, bool strict)
+    : PolicyParser(policy, strict), _elements(), _depth(0), _name(), _tag(), _attrName(),
+      _attrValue(), _attrs(), _ints(), _doubles(), _dictionary(false), _rootDone(false),
+      _p(0), _e(0), _line(0), _lineno(0), _count(0)
+{ }
+
+/*
+ * delete this parser
+ */
+XMLParser::~XMLParser() { }
+
+/*
+ * parse the data found on the given stream
+ */
+int XMLParser::parse(istream& is) {
+    string data;
+    char buf[1 << 16];
+    while (is.read(buf, sizeof(buf)) || is.gcount() > 0)
+        data.append(buf, is.gcount());
+    if (is.bad()) {
+        if (! _diagnostics) throw LSST_EXCEPT(ParserError, "read error", 0);
+        _diagnostics->report(0, 0, ParserDiagnostics::READ_ERROR);
+        return 0;
+    }
+    return parse(data.data(), data.size());
+}
+
+/*
+ * parse XML-encoded data held in memory
+ */
+int XMLParser::parse(const char* data, size_t size) {
+    _p = data;
+    _e = data + size;
+    _line = data;
+    _lineno = 1;
+    _count = 0;
+    _depth = 0;
+    _dictionary = false;
+    _rootDone = false;
+    _name.clear();
+
+    // a UTF-8 byte order mark
+    if (size >= 3 && memcmp(data, "\xEF\xBB\xBF", 3) == 0) _p += 3;
+
+    try {
+        while (_p < _e) {
+            const char* lt = static_cast<const char*>(memchr(_p, '<', _e - _p));
+            if (! lt) lt = _e;
+            if (lt > _p) {
+                _text(_p, lt, false);
+                _moveTo(lt);
+            }
+            if (_p == _e) break;
+
+            if (startsWith(_p, _e, "<!--")) {
+                _skipPast("-->");
+            } else if (startsWith(_p, _e, "<![CDATA[")) {
+                const char* b = _p + 9;
+                _skipPast("]]>");
+                _text(b, _p - 3, true);
+            } else if (startsWith(_p, _e, "<?")) {
+                _skipPast("?>");
+            } else if (startsWith(_p, _e, "<!")) {
+                // a document type declaration; an internal subset is skipped
+                const char* q = _p + 2;
+                while (q < _e && *q != '>' && *q != '[') ++q;
+                _moveTo(q);
+                if (q < _e && *q == '[') _skipPast("]");
+                _skipPast(">");
+            } else if (startsWith(_p, _e, "</")) {
+                _endTag();
+            } else {
+                _startTag();
+            }
+        }
+        if (_depth > 0) _syntaxError("unclosed element");
+    } catch (Abandon&) {
+        // recorded in the diagnostics
+    }
+
+    // log count
+    return _count;
+}
+
+template <typename Send>
+bool XMLParser::_send(Send send, int n) {
+    if (! _diagnostics) {
+        send(_events());
+        _count += n;
+        return true;
+    }
+    try {
+        send(_events());
+    } catch (lsst::pex::exceptions::Exception& ex) {
+        // a value the handler would not take, e.g. one of the wrong type
+        const char* what = ex.what();
+        if (! _diagnostics->report(_lineno, 0, ParserDiagnostics::REJECTED_VALUE,
+                                   what, what + strlen(what)))
+            throw Abandon();
+        return false;
+    }
+    _count += n;
+    return true;
+}
+
+void XMLParser::_startTag() {
+    if (_rootDone) _syntaxError("expected the end of the data after the root element");
+    ++_p;
+    _readName(_tag);
+
+    if (_elements.size() <= _depth) _elements.resize(_depth + 1);
+    Element& el = _elements[_depth];
+    el.tag = _tag;
+    el.nameLen = _name.size();
+    el.text.clear();
+    el.lineno = _lineno;
+    el.type = 0;
+    el.opened = false;
+    el.skip = (_depth > 1 && _elements[_depth - 1].skip);
+
+    // a parameter definition in a dictionary
+    bool definition = (_dictionary && _depth == 1 && _tag == "parameter");
+    string param;
+    _attrs.clear();
+
+    // the attributes
+    bool empty = false;
+    for (;;) {
+        _skipSpace();
+        if (_p == _e) _syntaxError("unterminated start tag");
+        if (*_p == '>') {
+            ++_p;
+            break;
+        }
+        if (*_p == '/') {
+            if (_p + 1 == _e || _p[1] != '>') _syntaxError("expected '>'");
+            _p += 2;
+            empty = true;
+            break;
+        }
+
+        _readName(_attrName);
+        _skipSpace();
+        if (_p == _e || *_p != '=') _syntaxError("expected '=' after an attribute name");
+        ++_p;
+        _skipSpace();
+        if (_p == _e || (*_p != '"' && *_p != '\'')) _syntaxError("expected a quoted attribute value");
+        const char* b = _p + 1;
+        const char* q = static_cast<const char*>(memchr(b, *_p, _e - b));
+        if (! q) {
+            _moveTo(_e);
+            _syntaxError("unterminated attribute value");
+        }
+        _attrValue.clear();
+        _decode(b, q, _attrValue);
+        _moveTo(q + 1);
+
+        if (_depth == 0) {
+            if (_tag == "Dictionary") _attrs.push_back(make_pair(_attrName, _attrValue));
+        } else if (definition) {
+            if (_attrName == "name") {
+                param = _attrValue;
+            } else {
+                _attrs.push_back(make_pair(_attrName, _attrValue));
+            }
+        } else if (_attrName == "t") {
+            if (_attrValue.size() != 1 || ! strchr("bidsfp", _attrValue[0])) {
+                // an unknown type; the element is not loaded
+                if (! el.skip)
+                    _problem(ParserDiagnostics::SYNTAX_ERROR, _attrValue.data(),
+                             _attrValue.data() + _attrValue.size());
+                el.skip = true;
+            } else {
+                el.type = _attrValue[0];
+            }
+        }
+    }
+
+    if (_depth == 0) {
+        // the root element; its name is not part of the parameter names
+        _dictionary = (_tag == "Dictionary");
+        ++_depth;
+        for (size_t i = 0; i < _attrs.size(); ++i) {
+            if (! isName(_attrs[i].first)) continue;
+            _name = _attrs[i].first;
+            const string& v = _attrs[i].second;
+            _values(v.data(), v.data() + v.size(), 0, _lineno);
+        }
+        _name.clear();
+        if (empty) _endElement();
+        return;
+    }
+
+    // the name of the parameter within the open policy
+    const string& local = (definition) ? param : _tag;
+    if (! el.skip) {
+        if (_depth > 1) _open(_elements[_depth - 1]);
+        if (! isName(local)) {
+            _problem(ParserDiagnostics::BAD_NAME, local.data(), local.data() + local.size());
+            el.skip = true;
+        }
+    }
+    if (! el.skip) {
+        if (definition) _name.assign(Dictionary::KW_DEFINITIONS).append(1, '.');
+        else if (! _name.empty()) _name.append(1, '.');
+        _name.append(local);
+    }
+    ++_depth;
+
+    if (definition && ! el.skip) {
+        _open(el);
+        string::size_type len = _name.size();
+        for (size_t i = 0; i < _attrs.size(); ++i) {
+            if (! isName(_attrs[i].first)) continue;
+            _name.append(1, '.').append(_attrs[i].first);
+            const string& v = _attrs[i].second;
+            _values(v.data(), v.data() + v.size(), 0, _lineno);
+            _name.resize(len);
+        }
+    }
+    if (empty) _endElement();
+}
+
+void XMLParser::_endTag() {
+    const char* b = _p;
+    _p += 2;
+    _readName(_tag);
+    if (_depth == 0 || _elements[_depth - 1].tag != _tag) {
+        _p = b;
+        _syntaxError("end tag does not match the open element");
+    }
+    _skipSpace();
+    if (_p == _e || *_p != '>') _syntaxError("expected '>'");
+    ++_p;
+    _endElement();
+}
+
+void XMLParser::_endElement() {
+    Element& el = _elements[_depth - 1];
+    if (_depth == 1) {
+        // the root element
+        _depth = 0;
+        _rootDone = true;
+        return;
+    }
+
+    if (! el.skip) {
+        if (el.opened) {
+            _send([&](PolicyHandler& h) { h.endPolicy(_name, _lineno); }, 0);
+        } else if (el.type == 'p') {
+            const char* b = el.text.data();
+            const char* e = b + el.text.size();
+            if (skipSpace(b, e) != e) _problem(ParserDiagnostics::SYNTAX_ERROR, b, e);
+            _open(el);
+            if (! el.skip) _send([&](PolicyHandler& h) { h.endPolicy(_name, _lineno); }, 0);
+        } else {
+            _values(el.text.data(), el.text.data() + el.text.size(), el.type, el.lineno);
+        }
+    }
+    _name.resize(el.nameLen);
+    --_depth;
+}
+
+void XMLParser::_open(Element& el) {
+    if (el.opened || el.skip) return;
+    el.opened = true;
+
+    // text beside the child elements, or a type other than "p"
+    const char* b = el.text.data();
+    const char* e = b + el.text.size();
+    if (skipSpace(b, e) != e) _problem(ParserDiagnostics::SYNTAX_ERROR, b, e);
+    if (el.type != 0 && el.type != 'p') _problem(ParserDiagnostics::SYNTAX_ERROR, &el.type, &el.type + 1);
+
+    if (! _send([&](PolicyHandler& h) { h.beginPolicy(_name, el.lineno); }, 0)) el.skip = true;
+}
+
+void XMLParser::_text(const char* b, const char* e, bool raw) {
+    if (_depth == 0) {
+        if (skipSpace(b, e) != e) {
+            _moveTo(skipSpace(b, e));
+            _syntaxError("text outside of the root element");
+        }
+        return;
+    }
+
+    Element& el = _elements[_depth - 1];
+    if (el.skip) return;
+    if (_depth == 1 || el.opened) {
+        // only whitespace may appear beside elements
+        const char* t = skipSpace(b, e);
+        if (t != e) {
+            if (! raw) _moveTo(t);
+            _problem(ParserDiagnostics::SYNTAX_ERROR, t, e);
+        }
+        return;
+    }
+
+    if (raw) el.text.append(b, e);
+    else _decode(b, e, el.text);
+}
+
+void XMLParser::_values(const char* b, const char* e, char type, int lineno) {
+    b = skipSpace(b, e);
+    while (e > b && isSpace(e[-1])) --e;
+
+    if (type == 0) {
+        if (b == e)
+            // no value provided; ignore it.
+            return;
+
+        // guess the type from the tokens
+        bool numbers = true, bools = true, doubles = false, bval;
+        for (const char* p = b; p < e && (numbers || bools);) {
+            const char* q = p;
+            while (q < e && ! isSpace(*q)) ++q;
+            TokenKind kind = tokenKind(p, q, bval);
+            if (kind != BOOL) bools = false;
+            if (kind != INT && kind != DOUBLE) numbers = false;
+            if (kind == DOUBLE) doubles = true;
+            p = skipSpace(q, e);
+        }
+        type = (bools) ? 'b' : (numbers && doubles) ? 'd' : (numbers) ? 'i' : 's';
+        if (type == 's' && *b == '@') type = 'f';
+    }
+
+    if (type == 's') {
+        string value(b, e);
+        _send([&](PolicyHandler& h) { h.onString(_name, value, lineno); }, 1);
+        return;
+    }
+    if (type == 'f') {
+        Policy::FilePtr file;
+        if (isUrnValue(b, e)) file.reset(new UrnPolicyFile(string(b, e)));
+        else file.reset(new PolicyFile(string((*b == '@') ? b + 1 : b, e)));
+        _send([&](PolicyHandler& h) { h.onFile(_name, file, lineno); }, 1);
+        return;
+    }
+
+    _ints.clear();
+    _doubles.clear();
+    for (const char* p = b; p < e;) {
+        const char* q = p;
+        while (q < e && ! isSpace(*q)) ++q;
+        bool bval;
+        TokenKind kind = tokenKind(p, q, bval);
+
+        if (type == 'b') {
+            if (kind == BOOL) _send([&](PolicyHandler& h) { h.onBool(_name, bval, lineno); }, 1);
+            else _problem(ParserDiagnostics::EXPECTED_BOOL, p, q);
+        } else if (type == 'd') {
+            if (kind == INT || kind == DOUBLE) _doubles.push_back(toDouble(p, q));
+            else _problem(ParserDiagnostics::EXPECTED_DOUBLE, p, q);
+        } else if (kind != INT) {
+            _problem(ParserDiagnostics::EXPECTED_INT, p, q);
+        } else {
+            long lval = toLong(p, q);
+            int ival = int(lval);
+            if (lval - ival != 0)
+                // longs are unsupported
+                _problem(ParserDiagnostics::UNSUPPORTED_LONG, p, q);
+            else
+                _ints.push_back(ival);
+        }
+        p = skipSpace(q, e);
+    }
+
+    if (! _doubles.empty())
+        _send([&](PolicyHandler& h) { h.onDoubles(_name, _doubles, lineno); }, _doubles.size());
+    if (! _ints.empty())
+        _send([&](PolicyHandler& h) { h.onInts(_name, _ints, lineno); }, _ints.size());
+}
+
+void XMLParser::_readName(string& out) {
+    const char* q = _p;
+    while (q < _e && isNameChar(*q)) ++q;
+    if (q == _p) _syntaxError("expected a name");
+    out.assign(_p, q);
+    _p = q;
+}
+
+void XMLParser::_decode(const char* b, const char* e, string& out) {
+    for (;;) {
+        const char* amp = static_cast<const char*>(memchr(b, '&', e - b));
+        if (! amp) {
+            out.append(b, e);
+            return;
+        }
+        out.append(b, amp);
+
+        const char* semi = static_cast<const char*>(memchr(amp, ';', e - amp));
+        const char* n = amp + 1;
+        unsigned int cp;
+        if (! semi) {
+            semi = amp;
+        } else if (startsWith(n, semi, "lt") && semi - n == 2) {
+            out += '<';
+        } else if (startsWith(n, semi, "gt") && semi - n == 2) {
+            out += '>';
+        } else if (startsWith(n, semi, "amp") && semi - n == 3) {
+            out += '&';
+        } else if (startsWith(n, semi, "quot") && semi - n == 4) {
+            out += '"';
+        } else if (startsWith(n, semi, "apos") && semi - n == 4) {
+            out += '\'';
+        } else if (*n == '#' && readCodePoint(n + 1, semi, cp)) {
+            appendUtf8(out, cp);
+        } else {
+            semi = amp;
+        }
+
+        if (semi == amp) {
+            // not a reference we know; keep the text
+            _problem(ParserDiagnostics::SYNTAX_ERROR, amp, std::min(e, amp + 10));
+            out += '&';
+        }
+        b = semi + 1;
+    }
+}
+
+void XMLParser::_skipSpace() {
+    while (_p < _e && isSpace(*_p)) {
+        if (*_p == '\n') {
+            ++_lineno;
+            _line = _p + 1;
+        }
+        ++_p;
+    }
+}
+
+void XMLParser::_moveTo(const char* q) {
+    for (;;) {
+        const char* nl = static_cast<const char*>(memchr(_p, '\n', q - _p));
+        if (! nl) break;
+        ++_lineno;
+        _line = _p = nl + 1;
+    }
+    _p = q;
+}
+
+void XMLParser::_skipPast(const char* s) {
+    size_t n = strlen(s);
+    const char* q = search(_p, _e, s, s + n);
+    if (q == _e) {
+        _moveTo(_e);
+        _syntaxError("unterminated markup");
+    }
+    _moveTo(q + n);
+}
+
+bool XMLParser::_problem(ParserDiagnostics::Kind kind, const char* b, const char* e) {
+    // quote no more than the first line of the offending text
+    const char* nl = static_cast<const char*>(memchr(b, '\n', e - b));
+    if (nl) e = nl;
+
+    if (_diagnostics) {
+        int column = (b >= _line && b <= _e) ? int(b - _line) + 1 : 0;
+        if (! _diagnostics->report(_lineno, column, kind, b, e)) throw Abandon();
+        return true;
+    }
+    if (! _strict) return false;    // log message
+
+    string msg = ParserDiagnostics::describe(kind);
+    msg.append(b, e);
+    if (kind == ParserDiagnostics::UNSUPPORTED_LONG)
+        throw LSST_EXCEPT(UnsupportedSyntax, msg, _lineno);
+    throw LSST_EXCEPT(FormatSyntaxError, msg, _lineno);
+}
+
+void XMLParser::_syntaxError(const char* what) {
+    if (_p >= _e) {
+        if (! _diagnostics) throw LSST_EXCEPT(EOFError, _lineno);
+        _diagnostics->report(_lineno, 0, ParserDiagnostics::UNEXPECTED_EOF);
+        throw Abandon();
+    }
+
+    const char* end = _p;
+    while (end < _e && *end != '\n' && *end != '\r') ++end;
+    if (_diagnostics) {
+        _diagnostics->report(_lineno, int(_p - _line) + 1, ParserDiagnostics::SYNTAX_ERROR, _p, end);
+        throw Abandon();
+    }
+
+    string msg = ParserDiagnostics::describe(ParserDiagnostics::SYNTAX_ERROR);
+    msg.append(what).append(", found: ");
+    if (size_t(end - _p) > ParserDiagnostics::EXCERPT_MAX) end = _p + ParserDiagnostics::EXCERPT_MAX;
+    msg.append(_p, end);
+    throw LSST_EXCEPT(FormatSyntaxError, msg, _lineno);
+}
+
+//@endcond
+
+}}}}   // end lsst::pex::policy::xml
@@ -0,0 +1,236 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+/**
+ * @file XMLParser_1.cc
+ *
+ * This test checks that a Policy written in the compiled format loads
+ * back unchanged, and that corrupt compiled data is reported.
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include "lsst/pex/policy/binary/BinaryParser.h"
+#include "lsst/pex/policy/binary/BinaryParserFactory.h"
+#include "lsst/pex/policy/binary/BinaryWriter.h"
+#include "lsst/pex/policy/paf/PAFWriter.h"
+#include "lsst/pex/policy.h"
+#include "lsst/pex/policy/PolicyFile.h"
+#include "lsst/pex/policy/PolicyString.h"
+#include "lsst/pex/policy/SupportedFormats.h"
+#include "lsst/pex/policy/parserexceptions.h"
+#include "lsst/pex/exceptions.h"
+#include "lsst/utils/Utils.h"
+
+using namespace std;
+using lsst::pex::policy::Policy;
+using lsst::pex::policy::PolicyFile;
+using lsst::pex::policy::PolicyString;
+using lsst::pex::policy::SupportedFormats;
+using lsst::pex::policy::ParserDiagnostics;
+using lsst::pex::policy::FormatSyntaxError;
+using lsst::pex::policy::UnsupportedSyntax;
+using lsst::pex::policy::binary::BinaryParser;
+using lsst::pex::policy::binary::BinaryParserFactory;
+using lsst::pex::policy::binary::BinaryWriter;
+using lsst::pex::policy::binary::HEADER_OFFSET;
+using lsst::pex::policy::paf::PAFWriter;
+
+#define Assert(b, m) tattle(b, m, __LINE__)
+
+void tattle(bool mustBeTrue, const string& failureMsg, int line) {
+    if (! mustBeTrue) {
+        ostringstream msg;
+        msg << __FILE__ << ':' << line << ":\n" << failureMsg << ends;
+        throw runtime_error(msg.str());
+    }
+}
+
+string dump(const Policy& p) {
+    PAFWriter writer;
+    writer.write(p);
+    return writer.toString();
+}
+
+string compile(const Policy& p) {
+    BinaryWriter writer;
+    writer.write(p);
+    return writer.toString();
+}
+
+string loadBinary(const string& data) {
+    Policy p;
+    BinaryParser parser(p);
+    parser.parse(data.data(), data.size());
+    return dump(p);
+}
+
+// return the message of the error raised by loading data, or "" if it
+// loads; anything other than a parser error fails the test
+string error(const string& data) {
+    try {
+        loadBinary(data);
+    } catch (FormatSyntaxError& ex) {
+        return ex.what();
+    } catch (UnsupportedSyntax& ex) {
+        return ex.what();
+    }
+    return "";
+}
+
+bool contains(const string& s, const string& sub) { return s.find(sub) != string::npos; }
+
+int main() {
+    string rootDir = lsst::utils::getPackageDir("pex_policy") + "/examples/";
+
+    // the examples round-trip
+    const char* examples[] = { "EventTransmitter_policy.paf", "EventTransmitter_dict.paf",
+                               "pipeline_policy.paf", "types.paf", "CacheManager_dict.paf" };
+    for (size_t i = 0; i < sizeof(examples) / sizeof(examples[0]); ++i) {
+        Policy p;
+        PolicyFile(rootDir + examples[i]).load(p);
+        string data = compile(p);
+        Assert(data.compare(0, BinaryWriter::CONTENT_ID.size(), BinaryWriter::CONTENT_ID) == 0,
+               "no content identifier");
+        Assert(loadBinary(data) == dump(p), string("wrong round trip for ") + examples[i]);
+
+        Policy q;
+        PolicyString str(data);
+        Assert(str.getFormatName() == BinaryParserFactory::FORMAT_NAME, "compiled string not recognized");
+        str.load(q);
+        Assert(dump(q) == dump(p), string("wrong string round trip for ") + examples[i]);
+    }
+
+    // all the value types, through a file
+    {
+        Policy p;
+        p.set("b", true);
+        p.add("b", false);
+        p.set("i", -7);
+        p.set("d", 2.5);
+        p.add("d", -1e300);
+        p.set("s", string("with\nnewline"));
+        p.add("s", string(""));
+        p.add("s", string("with\nnewline"));
+        p.set("f", Policy::FilePtr(new PolicyFile("other.paf")));
+        p.set("p.q.r", 3);
+        Policy::Ptr sub(new Policy());
+        sub->set("x", string("y"));
+        p.add("p", sub);
+        p.set("empty", Policy::Ptr(new Policy()));
+
+        string path("BinaryPolicy_1.pafc");
+        {
+            BinaryWriter writer(path);
+            writer.write(p);
+        }
+        PolicyFile file(path);
+        Assert(file.getFormatName() == BinaryParserFactory::FORMAT_NAME, "wrong format for .pafc file");
+        Policy q;
+        file.load(q);
+        remove(path.c_str());
+        Assert(dump(q) == dump(p), "wrong file round trip:\n" + dump(q) + "vs\n" + dump(p));
+        Assert(q.getFile("f")->getPath() == "other.paf", "wrong file path");
+        Assert(q.getStringArray("s")[2] == "with\nnewline", "wrong string");
+        Assert(q.getPolicyArray("p").size() == 2 && q.getString("p.x") == "y", "wrong policy array");
+        Assert(q.getPolicy("empty")->names().empty(), "empty policy not empty");
+    }
+
+    // values written before a policy are added to its top level
+    {
+        BinaryWriter writer;
+        writer.writeInt("n", 5);
+        Policy p;
+        p.set("m", 6);
+        writer.write(p);
+        Policy q;
+        PolicyString(writer.toString()).load(q);
+        Assert(q.getInt("n") == 5 && q.getInt("m") == 6, "written values lost");
+    }
+
+    // recognition
+    {
+        SupportedFormats formats;
+        SupportedFormats::initDefaultFormats(formats);
+        Assert(formats.supports("BINARY"), "BINARY not registered");
+        Assert(formats.recognizeType("#<?cfg BINARY policy ?>   ") == "BINARY", "content id not recognized");
+        Assert(formats.recognizeType("#<?cfg paf policy ?>") == "PAF", "PAF recognized as BINARY");
+    }
+
+    // corrupt data
+    Policy p;
+    PolicyFile(rootDir + "EventTransmitter_policy.paf").load(p);
+    string data = compile(p);
+    Assert(contains(error(data.substr(0, HEADER_OFFSET + 8)), "too short"), "short data");
+    Assert(contains(error(data.substr(0, data.size() - 8)), "truncated"), "truncated data");
+    {
+        string bad(data);
+        bad[HEADER_OFFSET] = 'X';
+        Assert(contains(error(bad), "header not found"), "bad magic");
+        bad = data;
+        bad[HEADER_OFFSET + 4] ^= 0x7F;
+        Assert(contains(error(bad), "unknown version"), "bad version");
+        bad = data;
+        swap(bad[HEADER_OFFSET + 8], bad[HEADER_OFFSET + 11]);
+        Assert(contains(error(bad), "byte order"), "wrong byte order");
+    }
+
+    // nesting is limited rather than allowed to exhaust the stack
+    {
+        string name("a");
+        for (int i = 1; i < BinaryParser::MAX_DEPTH; ++i) name += ".a";
+        Policy deepest, deeper;
+        deepest.set(name, 1);
+        deeper.set(name + ".a", 1);
+        Assert(error(compile(deepest)) == "", "deepest nesting rejected");
+        Assert(contains(error(compile(deeper)), "nested too deeply"), "unlimited nesting");
+    }
+
+    // damage to any byte is either harmless or reported
+    for (size_t i = HEADER_OFFSET; i < data.size(); ++i) {
+        string bad(data);
+        bad[i] ^= 0xA5;
+        try {
+            loadBinary(bad);
+        } catch (FormatSyntaxError&) {
+        } catch (UnsupportedSyntax&) {
+        } catch (lsst::pex::exceptions::Exception&) {
+            // a damaged value rejected by the Policy, e.g. a bad name
+        }
+    }
+
+    // diagnostics
+    {
+        Policy q;
+        ParserDiagnostics diag;
+        BinaryParser parser(q);
+        parser.setDiagnostics(&diag);
+        string bad(data.substr(0, data.size() - 8));
+        parser.parse(bad.data(), bad.size());
+        Assert(diag.getProblems().size() == 1 &&
+               diag.getProblems()[0].kind == ParserDiagnostics::SYNTAX_ERROR, "problem not recorded");
+    }
+
+    return 0;
+}
@@ -0,0 +1,226 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+
+
+/**
+ * @file Fingerprint_1.cc
+ *
+ * This test checks that Policy::fingerprint() depends on the names, types
+ * and values held but not on the order they were added in, that it stays
+ * the same from one run to the next, and that it changes with each change
+ * to a policy, however the change is made.
+ */
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include "lsst/pex/policy.h"
+#include "lsst/pex/exceptions.h"
+
+using namespace std;
+using lsst::pex::policy::Fingerprint;
+using lsst::pex::policy::Policy;
+using lsst::pex::policy::PolicyRef;
+
+#define Assert(b, m) tattle(b, m, __LINE__)
+
+void tattle(bool mustBeTrue, const string& failureMsg, int line) {
+    if (! mustBeTrue) {
+        ostringstream msg;
+        msg << __FILE__ << ':' << line << ":\n" << failureMsg << ends;
+        throw runtime_error(msg.str());
+    }
+}
+
+Policy::Ptr makePolicy() {
+    Policy::Ptr p(new Policy());
+    p->set("name", "warp");
+    p->set("stage.enabled", true);
+    p->set("stage.kernel.sigma", 1.5);
+    p->add("stage.kernel.widths", 3);
+    p->add("stage.kernel.widths", 5);
+    p->set("retries", 3);
+    Policy::Ptr step(new Policy());
+    step->set("order", 1);
+    p->add("steps", step);
+    return p;
+}
+
+int main() {
+    // the same values give the same fingerprint, in any order
+    {
+        Policy::Ptr p = makePolicy();
+        Policy q;
+        Policy::Ptr step(new Policy());
+        step->set("order", 1);
+        q.add("steps", step);
+        q.set("retries", 3);
+        q.add("stage.kernel.widths", 3);
+        q.set("stage.kernel.sigma", 1.5);
+        q.add("stage.kernel.widths", 5);
+        q.set("name", "warp");
+        q.set("stage.enabled", true);
+        Assert(p->fingerprint() == q.fingerprint(), "order changes the fingerprint");
+        Assert(p->freeze()->fingerprint() == p->fingerprint(), "frozen policy has another fingerprint");
+
+        // and the same in every run
+        Assert(p->fingerprint().toString() == "1d2375093882d9826c04172a7234e541",
+               "fingerprint is not stable: " + p->fingerprint().toString());
+    }
+
+    // each difference in names, types or values gives another
+    {
+        unordered_set<Fingerprint> seen;
+        Policy empty;
+        seen.insert(empty.fingerprint());
+        Policy p;
+        p.set("a", 1);
+        seen.insert(p.fingerprint());
+        p.set("a", 2);
+        seen.insert(p.fingerprint());
+        p.set("a", 2.0);
+        seen.insert(p.fingerprint());
+        p.set("a", true);
+        seen.insert(p.fingerprint());
+        p.set("a", "2");
+        seen.insert(p.fingerprint());
+        p.set("a", "");
+        seen.insert(p.fingerprint());
+        p.add("a", "");
+        seen.insert(p.fingerprint());
+        p.remove("a");
+        p.set("b", "");
+        seen.insert(p.fingerprint());
+        p.remove("b");
+        p.set("a.b", "");
+        seen.insert(p.fingerprint());
+        p.remove("a");
+        p.set("a", "b");
+        p.set("c", "d");
+        seen.insert(p.fingerprint());
+        p.set("a", "d");
+        p.set("c", "b");
+        seen.insert(p.fingerprint());
+        p.set("a", "bc");
+        p.set("c", "");
+        seen.insert(p.fingerprint());
+        Assert(seen.size() == 13, "different policies share a fingerprint");
+
+        Policy zero, negative;
+        zero.set("x", 0.0);
+        negative.set("x", -0.0);
+        Assert(zero.fingerprint() == negative.fingerprint(), "-0 and 0 differ");
+    }
+
+    // each change is seen, however it is made, and undoing it restores
+    // the fingerprint
+    {
+        Policy::Ptr p = makePolicy();
+        const Fingerprint original = p->fingerprint();
+        const Policy& view = *p;
+        Policy copy(view);
+        Assert(copy.fingerprint() == original, "copy has another fingerprint");
+
+        p->set("stage.kernel.sigma", 2.5);
+        Assert(p->fingerprint() != original, "change through the top not seen");
+        Assert(copy.fingerprint() == original, "change to the original seen in the copy");
+        p->set("stage.kernel.sigma", 1.5);
+        Assert(p->fingerprint() == original, "undoing a change not seen");
+
+        Policy::Ptr kernel = p->getPolicy("stage.kernel");
+        kernel->add("widths", 7);
+        Assert(p->fingerprint() != original, "change through a sub-policy not seen");
+        Policy::Ptr stage = p->getPolicy("stage");
+        stage->set("kernel.widths", 3);
+        stage->add("kernel.widths", 5);
+        Assert(p->fingerprint() == original, "undoing through a sub-policy not seen");
+
+        p->getPolicyArray("steps")[0]->set("order", 2);
+        Assert(p->fingerprint() != original, "change through a sub-policy array not seen");
+        p->getPolicyArray("steps")[0]->set("order", 1);
+        Assert(p->fingerprint() == original, "undoing through a sub-policy array not seen");
+
+        PolicyRef(*p).getPolicy("stage").set("enabled", false);
+        Assert(p->fingerprint() != original, "change through a PolicyRef not seen");
+        PolicyRef(*p).getPolicy("stage").set("enabled", true);
+        Assert(p->fingerprint() == original, "undoing through a PolicyRef not seen");
+
+        p->remove("stage.kernel");
+        Assert(p->fingerprint() != original, "removal not seen");
+        Assert(copy.fingerprint() == original, "removal from the original seen in the copy");
+        copy.set("stage.kernel.sigma", 2.5);
+        Assert(copy.fingerprint() != original, "change to a copy not seen");
+    }
+
+    // a pinned sub-policy that is removed takes its changes with it
+    // without hiding later ones, and one no longer referred to still counts
+    {
+        Policy p;
+        p.set("a.x", 1);
+        Policy::Ptr a = p.getPolicy("a");
+        a->set("x", 2);
+        a->set("x", 3);
+        p.fingerprint();
+        p.remove("a");
+        p.set("b", 1);
+        p.set("b", 2);
+        Policy q;
+        q.set("b", 2);
+        Assert(p.fingerprint() == q.fingerprint(), "change hidden by removing a pinned sub-policy");
+
+        p.set("a.x", 1);
+        a = p.getPolicy("a");
+        a->set("x", 2);
+        const Fingerprint before = p.fingerprint();
+        a.reset();
+        const Policy& view = p;
+        Policy copy(view);
+        Assert(p.fingerprint() == before && copy.fingerprint() == before, "fingerprint changed by copying");
+        p.set("a.x", 3);
+        Assert(p.fingerprint() != before && copy.fingerprint() == before, "change after dropping a view not seen");
+    }
+
+    // policies with sub-policies pinned in each have fingerprints of their own
+    {
+        Policy::Ptr p = makePolicy(), q = makePolicy();
+        Policy::Ptr pKernel = p->getPolicy("stage.kernel"), qKernel = q->getPolicy("stage.kernel");
+        const Fingerprint original = q->fingerprint();
+        pKernel->set("sigma", 2.5);
+        Assert(q->fingerprint() == original && p->fingerprint() != original, "change seen in another policy");
+        qKernel->set("sigma", 2.5);
+        Assert(q->fingerprint() == p->fingerprint(), "change through a sub-policy not seen");
+    }
+
+    // fingerprints already known tell policies apart in diff()
+    {
+        Policy::Ptr p = makePolicy(), q = makePolicy();
+        Assert(p->diff(*q).empty(), "equal policies differ");
+        q->set("stage.kernel.sigma", 2.0);
+        p->fingerprint();
+        q->fingerprint();
+        Assert(p->diff(*q).size() == 1, "known fingerprints hide a difference");
+    }
+
+    return 0;
+}
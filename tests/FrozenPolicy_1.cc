@@ -0,0 +1,185 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+
+/**
+ * @file FrozenPolicy_1.cc
+ *
+ * This test checks that a FrozenPolicy finds every value held by the
+ * Policy it was made from, as the Policy functions do, that it does not
+ * allocate doing so, that it is not changed with that Policy, and that
+ * many threads may read it at once.
+ */
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "lsst/pex/policy.h"
+#include "lsst/pex/exceptions.h"
+#include "countAllocations.h"
+
+using namespace std;
+using lsst::pex::policy::ConstPolicyRef;
+using lsst::pex::policy::FrozenPolicy;
+using lsst::pex::policy::NameNotFound;
+using lsst::pex::policy::Policy;
+using lsst::pex::policy::PolicyArrayView;
+using lsst::pex::policy::TypeError;
+
+#define Assert(b, m) tattle(b, m, __LINE__)
+
+void tattle(bool mustBeTrue, const string& failureMsg, int line) {
+    if (! mustBeTrue) {
+        ostringstream msg;
+        msg << __FILE__ << ':' << line << ":\n" << failureMsg << ends;
+        throw runtime_error(msg.str());
+    }
+}
+
+int main() {
+    Policy p;
+    p.set("stage.name", "warp");
+    p.set("stage.enabled", true);
+    p.set("stage.kernel.sigma", 1.5);
+    p.add("stage.kernel.widths", 3);
+    p.add("stage.kernel.widths", 5);
+    p.add("stage.labels", string("a label too long to be stored inside the string"));
+    for (int i = 0; i < 3; ++i) {
+        Policy::Ptr step(new Policy());
+        step->set("order", i);
+        p.add("steps", step);
+    }
+    p.set("top", 1);
+
+    // every value is found as the Policy finds it
+    {
+        FrozenPolicy::ConstPtr frozen = p.freeze();
+        Policy::StringArray names = p.names();
+        Assert(frozen->names() == names && frozen->size() == names.size(), "wrong names");
+        for (Policy::StringArray::const_iterator it = names.begin(); it != names.end(); ++it) {
+            Assert(frozen->exists(*it), *it + " not found");
+            Assert(frozen->getValueType(*it) == p.getValueType(*it), *it + " has the wrong type");
+            Assert(frozen->valueCount(*it) == p.valueCount(*it), *it + " has the wrong count");
+        }
+        Assert(frozen->getString("stage.name") == "warp" && frozen->getBool("stage.enabled"), "wrong values");
+        Assert(frozen->getDouble("stage.kernel.sigma") == 1.5 && frozen->getInt("top") == 1, "wrong values");
+        Assert(frozen->getIntArrayView("stage.kernel.widths").back() == 5, "wrong array");
+        Assert(frozen->getInt("steps.order") == 2 && frozen->getPolicyArrayView("steps").size() == 3,
+               "wrong sub-policies");
+        Assert(frozen->getPolicy("stage.kernel").getDouble("sigma") == 1.5, "wrong sub-policy reference");
+        Assert(frozen->getBoolArray("stage.enabled").size() == 1, "wrong bool array");
+
+        Assert(! frozen->exists("stage.kernel.sigm") && ! frozen->exists("") && ! frozen->exists("stage.") &&
+                       ! frozen->exists("stage.kernel.sigma.x"),
+               "name not held found");
+        Assert(frozen->valueCount("missing") == 0 && frozen->getValueType("missing") == Policy::UNDEF,
+               "wrong missing name");
+    }
+
+    // the same exceptions are thrown
+    {
+        FrozenPolicy::ConstPtr frozen = p.freeze();
+        try {
+            frozen->getInt("missing");
+            Assert(false, "missing name found");
+        } catch (NameNotFound&) {
+        }
+        try {
+            frozen->getInt("stage.name");
+            Assert(false, "wrong type returned");
+        } catch (TypeError&) {
+        }
+        try {
+            frozen->getPolicy("top");
+            Assert(false, "reference to a value that is not a Policy");
+        } catch (TypeError&) {
+        }
+    }
+
+    // values are found without allocating
+    {
+        FrozenPolicy::ConstPtr frozen = p.freeze();
+        const string sigma("stage.kernel.sigma"), name("stage.name"), widths("stage.kernel.widths"),
+                steps("steps"), missing("stage.missing");
+        long before = allocations;
+        double sum = frozen->getDouble(sigma) + frozen->getString(name).size();
+        sum += frozen->getIntArrayView(widths).size() + frozen->exists(missing);
+        for (PolicyArrayView::iterator it = frozen->getPolicyArrayView(steps).begin();
+             it != frozen->getPolicyArrayView(steps).end(); ++it)
+            sum += (*it).getInt("order");
+        long made = allocations - before;
+        Assert(made == 0, "a lookup allocated memory");
+        Assert(sum == 1.5 + 4 + 2 + 3, "wrong sum");
+    }
+
+    // the snapshot is not changed with the Policy, nor by its thawed copy
+    {
+        FrozenPolicy::ConstPtr frozen = p.freeze();
+        p.set("stage.kernel.sigma", 2.5);
+        p.set("added", 1);
+        Assert(frozen->getDouble("stage.kernel.sigma") == 1.5 && ! frozen->exists("added"),
+               "snapshot changed");
+
+        Policy::Ptr thawed = frozen->thaw();
+        thawed->set("stage.name", "psf");
+        Assert(frozen->getString("stage.name") == "warp" && thawed->getDouble("stage.kernel.sigma") == 1.5,
+               "thawed copy is shared");
+    }
+
+    // every name of a large policy is found, and no other
+    {
+        Policy big;
+        for (int i = 0; i < 5000; ++i) big.set("block" + to_string(i % 50) + ".p" + to_string(i), i);
+        FrozenPolicy::ConstPtr frozen = big.freeze();
+        Assert(frozen->size() == 5050, "wrong size");
+        for (int i = 0; i < 5000; ++i) {
+            string name = "block" + to_string(i % 50) + ".p" + to_string(i);
+            Assert(frozen->getInt(name) == i, name + " has the wrong value");
+            Assert(! frozen->exists(name + "x"), name + "x found");
+        }
+        Assert(Policy().freeze()->size() == 0 && ! Policy().freeze()->exists("a"), "empty policy");
+    }
+
+    // many threads may read one snapshot at once
+    {
+        Policy big;
+        for (int i = 0; i < 100; ++i) big.set("block" + to_string(i) + ".output.verbosity", i);
+        FrozenPolicy::ConstPtr frozen = big.freeze();
+        const int nthreads = 8;
+        vector<long> sums(nthreads, 0);
+        vector<thread> threads;
+        for (int t = 0; t < nthreads; ++t) {
+            threads.push_back(thread([&frozen, &sums, t]() {
+                vector<string> names;
+                for (int i = 0; i < 100; ++i) names.push_back("block" + to_string(i) + ".output.verbosity");
+                for (int rep = 0; rep < 200; ++rep)
+                    for (int i = 0; i < 100; ++i) sums[t] += frozen->getInt(names[i]);
+            }));
+        }
+        for (int t = 0; t < nthreads; ++t) threads[t].join();
+        for (int t = 0; t < nthreads; ++t) Assert(sums[t] == 200L * 99 * 100 / 2, "wrong sum in a thread");
+    }
+
+    return 0;
+}
@@ -0,0 +1,209 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+/**
+ * @file JSONParser_1.cc
+ *
+ * This test checks that JSON policy data is recognized and loaded like
+ * the equivalent PAF data, and that its errors are reported.
+ */
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include "lsst/pex/policy/json/JSONParser.h"
+#include "lsst/pex/policy/json/JSONParserFactory.h"
+#include "lsst/pex/policy/paf/PAFParser.h"
+#include "lsst/pex/policy/paf/PAFWriter.h"
+#include "lsst/pex/policy.h"
+#include "lsst/pex/policy/PolicyFile.h"
+#include "lsst/pex/policy/PolicyString.h"
+#include "lsst/pex/policy/SupportedFormats.h"
+#include "lsst/pex/policy/parserexceptions.h"
+#include "lsst/pex/exceptions.h"
+#include "lsst/utils/Utils.h"
+
+using namespace std;
+using lsst::pex::policy::Policy;
+using lsst::pex::policy::PolicyFile;
+using lsst::pex::policy::PolicyString;
+using lsst::pex::policy::SupportedFormats;
+using lsst::pex::policy::ParserDiagnostics;
+using lsst::pex::policy::json::JSONParser;
+using lsst::pex::policy::json::JSONParserFactory;
+using lsst::pex::policy::paf::PAFParser;
+using lsst::pex::policy::paf::PAFWriter;
+
+#define Assert(b, m) tattle(b, m, __LINE__)
+
+void tattle(bool mustBeTrue, const string& failureMsg, int line) {
+    if (! mustBeTrue) {
+        ostringstream msg;
+        msg << __FILE__ << ':' << line << ":\n" << failureMsg << ends;
+        throw runtime_error(msg.str());
+    }
+}
+
+string dump(Policy& p) {
+    PAFWriter writer;
+    writer.write(p);
+    return writer.toString();
+}
+
+string loadJson(const string& data, bool strict = true) {
+    Policy p;
+    JSONParser parser(p, strict);
+    parser.parse(data.data(), data.size());
+    return dump(p);
+}
+
+string loadPaf(const string& data) {
+    Policy p;
+    PAFParser parser(p);
+    parser.parse(data.data(), data.size());
+    return dump(p);
+}
+
+// return the message of the error raised by loading data
+string error(const string& data) {
+    try {
+        loadJson(data);
+    } catch (lsst::pex::exceptions::Exception& ex) {
+        return ex.what();
+    }
+    return "";
+}
+
+bool contains(const string& s, const string& sub) { return s.find(sub) != string::npos; }
+
+int main() {
+    string rootDir = lsst::utils::getPackageDir("pex_policy") + "/examples/";
+
+    // the examples
+    {
+        Policy p;
+        PolicyFile file(rootDir + "EventTransmitter_policy.json");
+        Assert(file.getFormatName() == JSONParserFactory::FORMAT_NAME, "wrong format for .json file");
+        file.load(p);
+        Assert(p.getBool("standalone"), "wrong standalone");
+        Assert(p.getDouble("threshold") == 4.5, "wrong threshold");
+        Assert(p.getIntArray("offsets").size() == 8, "repeated offsets not appended");
+        Assert(p.getIntArray("offsets")[5] == 3, "wrong offsets");
+        Assert(p.getString("receiver.logVerbosity") == "debug", "wrong receiver.logVerbosity");
+        Assert(p.getString("transmitter.serializationFormat") == "deluxe",
+               "wrong transmitter.serializationFormat");
+    }
+    {
+        Policy p(PolicyFile(rootDir + "pipeline_policy.json"));
+        Policy::StringArray stages = p.getStringArray("appStages");
+        Assert(stages.size() == 3 && stages[1] == "lsst.detection.pipeline.DetectionStage",
+               "wrong appStages");
+        Assert(p.getStringArray("stagePolicies")[2] == "policy/output_policy.paf",
+               "wrong stagePolicies");
+    }
+    {
+        Policy p(PolicyFile(rootDir + "EventTransmitter_dict.json"));
+        Assert(p.getString("target") == "EventTransmitter", "wrong target");
+        Policy::ConstPolicyPtrArray allowed =
+                p.getConstPolicyArray("definitions.standalone.allowed");
+        Assert(allowed.size() == 2, "array of objects not loaded as sub-policies");
+        Assert(allowed[1]->getBool("value"), "wrong allowed value");
+    }
+
+    // the mapping onto PAF
+    Assert(loadJson("{ \"a\": 1, \"b\": [1, 2.5], \"c\": [\"x\", \"y\"], \"d\": [true, false] }") ==
+           loadPaf("a: 1\nb: 1.0 2.5\nc: \"x\" \"y\"\nd: true false\n"), "wrong scalar/array mapping");
+    Assert(loadJson("{ \"a\": { \"b\": { \"c\": -3e2 } }, \"a\": { \"d\": \"e\" } }") ==
+           loadPaf("a: { b: { c: -300.0 } }\na: { d: \"e\" }\n"), "wrong sub-policy mapping");
+    Assert(loadJson("{ \"a.b\": 1, \"n\": null, \"e\": [] }") == loadPaf("a.b: 1\n"),
+           "wrong handling of dotted names, null or empty arrays");
+    {
+        Policy p;
+        JSONParser parser(p);
+        string data("# comment\n{ # another\n \"s\": \"q\\\"\\u00e9\\ud83d\\ude00\\n#\" }\n");
+        parser.parse(data.data(), data.size());
+        Assert(p.getString("s") == "q\"\xc3\xa9\xf0\x9f\x98\x80\n#", "wrong string decoding");
+    }
+    Assert(loadJson("") == "" && loadJson("# nothing\n") == "", "empty data not accepted");
+
+    // recognition
+    {
+        SupportedFormats formats;
+        SupportedFormats::initDefaultFormats(formats);
+        Assert(formats.supports("JSON"), "JSON not registered");
+        Assert(formats.recognizeType("{") == "JSON", "leading brace not recognized");
+        Assert(formats.recognizeType("#<?cfg JSON dictionary ?>") == "JSON", "content id not recognized");
+        Assert(formats.recognizeType("a: 1") == "PAF", "PAF recognized as JSON");
+
+        Policy p;
+        PolicyString str("{ \"x\": 7 }");
+        Assert(str.getFormatName() == "JSON", "JSON string not recognized");
+        str.load(p);
+        Assert(p.getInt("x") == 7, "JSON string not loaded");
+    }
+
+    // errors
+    Assert(contains(error("{ \"a\": 1,\n \"b\" 2 }"), "Policy Parsing Error:2: Syntax error: expected ':'"),
+           "missing colon: " + error("{ \"a\": 1,\n \"b\" 2 }"));
+    Assert(contains(error("{ \"a\": 1 \"b\": 2 }"), "expected ',' or '}'"), "missing comma");
+    Assert(contains(error("{ \"a\": [1, 2"), "Unexpected end"), "unexpected end: " + error("{ \"a\": [1, 2"));
+    Assert(contains(error("{ \"a b\": 1 }"), "Bad parameter name format: a b"), "bad name");
+    Assert(contains(error("{ \"a\": [1, \"x\"] }"), "Expecting double value, found: \"x\""), "mixed array");
+    Assert(contains(error("{ \"a\": [[1]] }"), "nested arrays are not supported"), "nested array");
+    Assert(contains(error("{ \"a\": 3000000000 }"), "unsupported long integer value found: 3000000000"),
+           "long integer");
+    Assert(contains(error("{ \"a\": 1 } x"), "end of the data"), "trailing text");
+    {
+        // nesting is limited rather than allowed to exhaust the stack
+        string shallow, deep;
+        for (int i = 0; i < 600; ++i) (i < 100 ? shallow : deep) += "{ \"a\": ";
+        deep = shallow + deep + "1" + string(600, '}');
+        shallow += "1" + string(100, '}');
+        Assert(error(shallow) == "", "shallow nesting rejected");
+        Assert(contains(error(deep), "nested too deeply"), "deep nesting: " + error(deep).substr(0, 80));
+        string arrays = "{ \"a\": " + string(100000, '[') + string(100000, ']') + " }";
+        Assert(contains(error(arrays), "nested too deeply"), "deep array nesting");
+    }
+    Assert(loadJson("{ \"a b\": 1, \"a\": [1, \"x\", 2, [3]], \"b\": 3000000000, \"c\": 2 }", false) ==
+           loadPaf("a: 1 2\nc: 2\n"), "non-strict mode does not skip bad values");
+    {
+        Policy p;
+        ParserDiagnostics diag;
+        JSONParser parser(p);
+        parser.setDiagnostics(&diag);
+        string data("{\n  \"a b\": 1,\n  \"a\": [1, \"x\"],\n  \"a\": true,\n  \"c\": 1\n  \"d\": 2\n}\n");
+        parser.parse(data.data(), data.size());
+        const vector<ParserDiagnostics::Problem>& problems = diag.getProblems();
+        Assert(problems.size() == 4, "wrong number of problems");
+        Assert(problems[0].kind == ParserDiagnostics::BAD_NAME && problems[0].line == 2 &&
+               problems[0].column == 4, "wrong bad name problem");
+        Assert(problems[1].kind == ParserDiagnostics::EXPECTED_DOUBLE && problems[1].line == 3 &&
+               problems[1].column == 12, "wrong mixed array problem");
+        Assert(problems[2].kind == ParserDiagnostics::REJECTED_VALUE && problems[2].line == 4,
+               "wrong rejected value problem");
+        Assert(problems[3].kind == ParserDiagnostics::SYNTAX_ERROR && problems[3].line == 6 &&
+               problems[3].column == 3, "wrong syntax error");
+        Assert(p.getInt("a") == 1 && p.getInt("c") == 1, "values lost with diagnostics");
+    }
+
+    return 0;
+}
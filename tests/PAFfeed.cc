@@ -0,0 +1,127 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file PAFfeed.cc
+ *
+ * This test checks that a PAF document pushed into PAFParser in chunks
+ * of any size loads exactly as when it is parsed in one piece.
+ */
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include "lsst/pex/policy/paf/PAFParser.h"
+#include "lsst/pex/policy/paf/PAFWriter.h"
+#include "lsst/pex/policy.h"
+#include "lsst/pex/exceptions.h"
+#include "lsst/utils/Utils.h"
+
+using namespace std;
+using lsst::pex::policy::Policy;
+using lsst::pex::policy::paf::PAFParser;
+using lsst::pex::policy::paf::PAFWriter;
+
+#define Assert(b, m) tattle(b, m, __LINE__)
+
+void tattle(bool mustBeTrue, const string& failureMsg, int line) {
+    if (! mustBeTrue) {
+        ostringstream msg;
+        msg << __FILE__ << ':' << line << ":\n" << failureMsg << ends;
+        throw runtime_error(msg.str());
+    }
+}
+
+string dump(Policy& p) {
+    PAFWriter writer;
+    writer.write(p);
+    return writer.toString();
+}
+
+// load data in one piece, returning the policy as PAF or the error
+string load(const string& data, int& count) {
+    Policy p;
+    PAFParser parser(p);
+    try {
+        count = parser.parse(data.data(), data.size());
+    } catch (lsst::pex::exceptions::Exception& ex) {
+        return string("error: ") + ex.what();
+    }
+    return dump(p);
+}
+
+// load data in chunks of the given size
+string feed(const string& data, size_t chunk, int& count) {
+    Policy p;
+    PAFParser parser(p);
+    try {
+        for (size_t i = 0; i < data.size(); i += chunk)
+            parser.feed(data.data() + i, min(chunk, data.size() - i));
+        count = parser.finish();
+    } catch (lsst::pex::exceptions::Exception& ex) {
+        return string("error: ") + ex.what();
+    }
+    return dump(p);
+}
+
+void compare(const string& data, const string& what) {
+    const size_t chunks[] = { 1, 2, 3, 7, 64, 4096 };
+    int want = -1;
+    string expected = load(data, want);
+    for (size_t i = 0; i < sizeof(chunks)/sizeof(chunks[0]); ++i) {
+        int got = -1;
+        ostringstream msg;
+        msg << what << ": chunks of " << chunks[i] << " loaded something different";
+        Assert(feed(data, chunks[i], got) == expected, msg.str());
+        Assert(got == want, msg.str() + " (count)");
+    }
+}
+
+int main() {
+    string rootDir = lsst::utils::getPackageDir("pex_policy") + "/examples/";
+    const char* files[] = { "EventTransmitter_policy.paf", "pipeline_policy.paf", "types.paf" };
+    for (size_t i = 0; i < sizeof(files)/sizeof(files[0]); ++i) {
+        ifstream in((rootDir + files[i]).c_str());
+        ostringstream data;
+        data << in.rdbuf();
+        compare(data.str(), files[i]);
+    }
+
+    compare("a: {\n  s: \"one\n  two\n  three\"\n  b: { c: 1 }\n}\nlast: 3", "multi-line");
+    compare("a: {\n  x: 1\n}\n}\nnot: read\n", "extra brace");
+    compare("a: 1\nbad line\n", "syntax error");
+    compare("s: \"never closed\n", "unterminated string");
+
+    // a parser can take several documents in turn
+    {
+        Policy p;
+        PAFParser parser(p);
+        parser.feed("a: 1\nb: ", 8);
+        Assert(parser.finish() == 1, "wrong count for first document");
+        parser.feed("c: 3", 4);
+        Assert(parser.finish() == 1, "wrong count for second document");
+        Assert(p.getInt("a") == 1 && p.getInt("c") == 3, "documents not loaded");
+    }
+
+    return 0;
+}
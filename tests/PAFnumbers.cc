@@ -0,0 +1,126 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file PAFnumbers.cc
+ *
+ * This test checks that PAF numbers are converted exactly as strtod()
+ * and strtol() would, and that arrays of numbers are loaded intact.
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include "lsst/pex/policy/paf/PAFParser.h"
+#include "lsst/pex/policy.h"
+#include "lsst/pex/policy/parserexceptions.h"
+
+using namespace std;
+using lsst::pex::policy::Policy;
+using lsst::pex::policy::UnsupportedSyntax;
+using lsst::pex::policy::paf::PAFParser;
+
+#define Assert(b, m) tattle(b, m, __LINE__)
+
+void tattle(bool mustBeTrue, const string& failureMsg, int line) {
+    if (! mustBeTrue) {
+        ostringstream msg;
+        msg << __FILE__ << ':' << line << ":\n" << failureMsg << ends;
+        throw runtime_error(msg.str());
+    }
+}
+
+void parse(Policy& p, const string& data, bool strict=true) {
+    PAFParser parser(p, strict);
+    parser.parse(data.data(), data.size());
+}
+
+int main() {
+    const char* doubles[] = {
+        "0.0", "-0.0", "1.5", ".5", "5.", "-.25e3", "1e5", "1E+123", "1e-300",
+        "0.1", "0.3", "3.141592653589793", "2.718281828459045235360287",
+        "123456789012345.6", "1234567890123456.7", "9007199254740993.0",
+        "1.7976931348623157e308", "4.9e-324", "0.000001234", "1e22", "1e23",
+        "-9.999999999999999e22", "00000000000000000000.5"
+    };
+    for (size_t i = 0; i < sizeof(doubles)/sizeof(doubles[0]); ++i) {
+        Policy p;
+        parse(p, string("x: ") + doubles[i] + "\n");
+        double want = strtod(doubles[i], 0), got = p.getDouble("x");
+        Assert(memcmp(&want, &got, sizeof(double)) == 0,
+               string("wrong value for ") + doubles[i]);
+    }
+
+    const char* ints[] = { "0", "-0", "+7", "2147483647", "-2147483648", "000123" };
+    for (size_t i = 0; i < sizeof(ints)/sizeof(ints[0]); ++i) {
+        Policy p;
+        parse(p, string("x: ") + ints[i] + "\n");
+        Assert(p.getInt("x") == int(strtol(ints[i], 0, 10)),
+               string("wrong value for ") + ints[i]);
+    }
+
+    // integers too big for an int are rejected in strict mode...
+    {
+        Policy p;
+        try {
+            parse(p, "x: 1 2 2147483648 4\n");
+            Assert(false, "failed to detect long integer");
+        } catch (UnsupportedSyntax&) { }
+        // ...after the values before them were loaded
+        Assert(p.valueCount("x") == 2, "values preceding long integer lost");
+    }
+
+    // a run of numbers spread over several lines
+    {
+        Policy p;
+        ostringstream data;
+        for (int line = 0; line < 10; ++line) {
+            data << "d: ";
+            for (int i = 0; i < 100; ++i) data << line * 100 + i << ".25 ";
+            data << "\ni: ";
+            for (int i = 0; i < 100; ++i) data << line * 100 + i << ' ';
+            data << "# comment\n";
+        }
+        parse(p, data.str());
+        Policy::DoubleArray d = p.getDoubleArray("d");
+        Policy::IntArray n = p.getIntArray("i");
+        Assert(d.size() == 1000 && n.size() == 1000, "wrong array length");
+        for (int k = 0; k < 1000; ++k) {
+            Assert(d[k] == k + 0.25, "wrong double array value");
+            Assert(n[k] == k, "wrong int array value");
+        }
+    }
+
+    // bulk add through the Policy API
+    {
+        Policy p;
+        p.add("x", 1);
+        Policy::IntArray more(3, 5);
+        p.add("x", more);
+        p.add("x", Policy::IntArray());
+        Assert(p.valueCount("x") == 4 && p.getIntArray("x")[3] == 5, "bulk add failed");
+    }
+
+    return 0;
+}
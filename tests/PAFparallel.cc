@@ -0,0 +1,119 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file PAFparallel.cc
+ *
+ * This test checks that parsing a large PAF buffer with several threads
+ * loads exactly what a serial parse does, and reports the same errors.
+ */
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include "lsst/pex/policy/paf/PAFParser.h"
+#include "lsst/pex/policy/paf/PAFWriter.h"
+#include "lsst/pex/policy.h"
+#include "lsst/pex/exceptions.h"
+
+using namespace std;
+using lsst::pex::policy::Policy;
+using lsst::pex::policy::paf::PAFParser;
+using lsst::pex::policy::paf::PAFWriter;
+
+#define Assert(b, m) tattle(b, m, __LINE__)
+
+void tattle(bool mustBeTrue, const string& failureMsg, int line) {
+    if (! mustBeTrue) {
+        ostringstream msg;
+        msg << __FILE__ << ':' << line << ":\n" << failureMsg << ends;
+        throw runtime_error(msg.str());
+    }
+}
+
+// parse data with the given number of threads, returning the loaded
+// policy as PAF, or the error message
+string load(const string& data, int threads, int& count) {
+    Policy p;
+    PAFParser parser(p);
+    parser.setThreads(threads);
+    try {
+        count = parser.parse(data.data(), data.size());
+    } catch (lsst::pex::exceptions::Exception& ex) {
+        return string("error: ") + ex.what();
+    }
+    PAFWriter writer;
+    writer.write(p);
+    return writer.toString();
+}
+
+void compare(const string& data, const string& what) {
+    int serial = -1, parallel = -1;
+    string want = load(data, 1, serial), got = load(data, 4, parallel);
+    Assert(got == want, what + ": parallel parse loaded something different");
+    Assert(parallel == serial, what + ": parallel parse counted differently");
+}
+
+// a policy of many top-level blocks; a few names are repeated
+string stages(int n) {
+    ostringstream out;
+    for (int i = 0; i < n; ++i) {
+        out << "stage" << i % (n - 10) << ": {\n"
+            << "    name: \"stage " << i << "\"\n"
+            << "    threshold: " << i * 0.5 << "\n"
+            << "    offsets: " << i << ' ' << i + 1 << ' ' << i + 2 << "\n"
+            << "    comment: \"spread over\n"
+            << "              two lines\"\n"
+            << "    output: {\n"
+            << "        enabled: true\n"
+            << "    }\n"
+            << "}\n"
+            << "count: " << i << "\n";
+    }
+    return out.str();
+}
+
+int main() {
+    string data = stages(2000);
+    Assert(data.size() >= PAFParser::PARALLEL_MIN_SIZE, "test data too small");
+    compare(data, "stages");
+
+    // a name used both as a value and a sub-policy
+    compare(data + "stage5: 3\n", "type conflict");
+
+    // a hierarchical name that adds to an earlier block
+    compare(data + "stage5.extra: 3\n", "dotted name");
+
+    // unindented nested blocks look like top-level ones
+    string flat;
+    for (size_t i = 0; i < data.size(); ++i)
+        if (data[i] != ' ' || (i > 0 && data[i-1] != '\n' && data[i-1] != ' ')) flat += data[i];
+    compare(flat, "unindented");
+
+    // errors must be reported at the same line
+    compare(data.substr(0, data.size() / 2) + "}\n" + data.substr(data.size() / 2),
+            "extra brace");
+    compare(data + "bad line\n", "syntax error");
+    compare(data + "unclosed: \"string\n", "unterminated string");
+
+    return 0;
+}
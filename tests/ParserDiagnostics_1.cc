@@ -0,0 +1,141 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file ParserDiagnostics_1.cc
+ *
+ * This test checks that a parser with a ParserDiagnostics set records
+ * every problem in its input without throwing.
+ */
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include "lsst/pex/policy/paf/PAFParser.h"
+#include "lsst/pex/policy/ParserDiagnostics.h"
+#include "lsst/pex/policy.h"
+
+using namespace std;
+using lsst::pex::policy::Policy;
+using lsst::pex::policy::ParserDiagnostics;
+using lsst::pex::policy::paf::PAFParser;
+
+#define Assert(b, m) tattle(b, m, __LINE__)
+
+void tattle(bool mustBeTrue, const string& failureMsg, int line) {
+    if (! mustBeTrue) {
+        ostringstream msg;
+        msg << __FILE__ << ':' << line << ":\n" << failureMsg << ends;
+        throw runtime_error(msg.str());
+    }
+}
+
+const string data =
+    "good: 1\n"
+    "bad line\n"
+    "x: 1.5 2.5 oops\n"
+    "n: 1 2147483648 3\n"
+    "}\n"
+    "flag: true maybe\n"
+    "good: \"wrong type\"\n"
+    "s: \"a\" b\n"
+    "last: 4\n"
+    "open: \"never closed\n";
+
+int parse(Policy& p, ParserDiagnostics& diag) {
+    PAFParser parser(p, true);
+    parser.setDiagnostics(&diag);
+    Assert(parser.getDiagnostics() == &diag, "diagnostics not set");
+    return parser.parse(data.data(), data.size());
+}
+
+int main() {
+    // every problem is found in one pass, in strict mode, without a throw
+    {
+        const int lines[] = { 2, 3, 4, 5, 6, 7, 8, 10 };
+        const int columns[] = { 1, 12, 6, 1, 12, 0, 8, 0 };
+        const ParserDiagnostics::Kind kinds[] = {
+            ParserDiagnostics::BAD_NAME, ParserDiagnostics::EXPECTED_DOUBLE,
+            ParserDiagnostics::UNSUPPORTED_LONG, ParserDiagnostics::EXTRA_BRACE,
+            ParserDiagnostics::EXPECTED_BOOL, ParserDiagnostics::REJECTED_VALUE,
+            ParserDiagnostics::EXPECTED_STRING, ParserDiagnostics::UNTERMINATED_STRING
+        };
+        const size_t n = sizeof(lines)/sizeof(lines[0]);
+
+        Policy p;
+        ParserDiagnostics diag;
+        parse(p, diag);
+        Assert(diag.getCount() == n, "wrong number of problems");
+        Assert(diag.getProblems().size() == n, "wrong number of problems kept");
+        for (size_t i = 0; i < n; ++i) {
+            const ParserDiagnostics::Problem& prob = diag.getProblems()[i];
+            ostringstream msg;
+            msg << "problem " << i << " (" << prob.getMessage() << ") at " << prob.line
+                << ':' << prob.column << ", kind " << prob.kind;
+            Assert(prob.line == lines[i] && prob.column == columns[i] && prob.kind == kinds[i],
+                   msg.str());
+        }
+        Assert(diag.getProblems()[0].getMessage() == "Bad parameter name format: bad line",
+               "wrong message");
+
+        // what could be loaded was
+        Assert(p.getInt("good") == 1 && p.getInt("last") == 4, "values lost");
+        Assert(p.getDoubleArray("x").size() == 2, "doubles before a problem lost");
+        Assert(p.getIntArray("n").size() == 3, "integers around a long lost");
+    }
+
+    // only cap problems are kept, but all are counted
+    {
+        Policy p;
+        ParserDiagnostics diag(3);
+        parse(p, diag);
+        Assert(diag.getProblems().size() == 3 && diag.getCount() == 8, "cap ignored");
+        Assert(! diag.failed(), "failed without a threshold");
+        Assert(p.getInt("last") == 4, "parse stopped at the cap");
+    }
+
+    // parsing stops at the fail-fast threshold
+    {
+        Policy p;
+        ParserDiagnostics diag(100, 2);
+        parse(p, diag);
+        Assert(diag.getCount() == 2 && diag.failed(), "fail-fast threshold ignored");
+        Assert(! p.exists("n") && ! p.exists("last"), "parse went on past the threshold");
+    }
+
+    // excerpts are kept short
+    {
+        Policy p;
+        ParserDiagnostics diag;
+        string longLine = "x: 1 " + string(1000, 'z') + "\n";
+        PAFParser parser(p);
+        parser.setDiagnostics(&diag);
+        parser.parse(longLine.data(), longLine.size());
+        Assert(diag.getCount() == 1 &&
+               diag.getProblems()[0].excerpt.size() == ParserDiagnostics::EXCERPT_MAX,
+               "excerpt not truncated");
+        diag.clear();
+        Assert(diag.getCount() == 0 && diag.getProblems().empty(), "clear failed");
+    }
+
+    return 0;
+}
@@ -0,0 +1,170 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+
+
+/**
+ * @file PolicyArena_1.cc
+ *
+ * This test checks that a policy loaded into a Policy created with a
+ * PolicyArena holds the same values as one loaded without, takes its
+ * storage from the arena with few calls to the heap, and keeps the arena
+ * for as long as any part of it is held.
+ */
+
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "lsst/pex/policy.h"
+#include "lsst/pex/exceptions.h"
+#include "countAllocations.h"
+
+using namespace std;
+using lsst::pex::policy::Policy;
+using lsst::pex::policy::PolicyArena;
+using lsst::pex::policy::PolicyString;
+
+#define Assert(b, m) tattle(b, m, __LINE__)
+
+void tattle(bool mustBeTrue, const string& failureMsg, int line) {
+    if (! mustBeTrue) {
+        ostringstream msg;
+        msg << __FILE__ << ':' << line << ":\n" << failureMsg << ends;
+        throw runtime_error(msg.str());
+    }
+}
+
+// a document of many small sub-policies
+string document() {
+    ostringstream out;
+    out << "#<?cfg paf policy ?>\n";
+    for (int i = 0; i < 500; ++i) {
+        out << "stage" << i << ": {\n"
+            << "    name: \"stage number " << i << " of the pipeline\"\n"
+            << "    enabled: " << (i % 2 ? "true" : "false") << "\n"
+            << "    kernel: {\n"
+            << "        sigma: " << i + 0.5 << "\n"
+            << "        widths: 3 5 " << i << "\n"
+            << "    }\n"
+            << "}\n";
+    }
+    return out.str();
+}
+
+void load(Policy& policy, const string& data) {
+    PolicyString source(data);
+    source.load(policy);
+}
+
+int main() {
+    string data = document();
+    {
+        Policy warm;
+        load(warm, data);   // intern the names first
+    }
+
+    // the values loaded are the same, with far fewer allocations
+    {
+        long before = allocations;
+        Policy heap;
+        load(heap, data);
+        long heapMade = allocations - before;
+
+        PolicyArena::Ptr arena(new PolicyArena());
+        before = allocations;
+        Policy policy(arena);
+        load(policy, data);
+        long arenaMade = allocations - before;
+
+        Assert(policy.fingerprint() == heap.fingerprint(), "arena policy holds other values");
+        Assert(policy.getString("stage7.name") == "stage number 7 of the pipeline", "wrong string");
+        Assert(policy.getIntArray("stage9.kernel.widths")[2] == 9, "wrong array");
+        Assert(policy.getArena() == arena && policy.getPolicy("stage3.kernel")->getArena() == arena,
+               "sub-policies do not use the arena");
+        Assert(! heap.getArena() && ! heap.getPolicy("stage3")->getArena(), "heap policy has an arena");
+        Assert(arena->getBytesAllocated() > 0 && arena->getChunkCount() > 0, "arena not used");
+        Assert(3 * arenaMade < heapMade,
+               "arena load made " + to_string(arenaMade) + " allocations, heap load " + to_string(heapMade));
+    }
+
+    // the arena lasts as long as any part of the policy
+    {
+        PolicyArena::Ptr arena(new PolicyArena());
+        weak_ptr<PolicyArena> held(arena);
+        Policy::Ptr kernel;
+        {
+            Policy policy(arena);
+            arena.reset();
+            load(policy, data);
+            kernel = policy.getPolicy("stage42.kernel");
+        }
+        Assert(! held.expired(), "arena released while a sub-policy is held");
+        Assert(kernel->getDouble("sigma") == 42.5, "sub-policy changed");
+        kernel.reset();
+        Assert(held.expired(), "arena not released");
+    }
+
+    // changes made to a copy do not use the arena
+    {
+        PolicyArena::Ptr arena(new PolicyArena());
+        Policy policy(arena);
+        load(policy, data);
+        const Policy& original = policy;
+        Policy copy(original);
+        copy.set("stage1.kernel.sigma", 9.0);
+        size_t used = arena->getBytesAllocated();
+        for (int i = 0; i < 100; ++i) copy.add("stage1.kernel.widths", i);
+        Assert(arena->getBytesAllocated() == used, "a copy grew the arena");
+        Assert(! copy.getArena() && ! copy.getPolicy("stage1.kernel")->getArena(), "a changed copy uses the arena");
+        Assert(policy.getDouble("stage1.kernel.sigma") == 1.5, "the original changed");
+    }
+
+    // threads may allocate from one arena at once
+    {
+        PolicyArena arena(1024);
+        vector<vector<char*> > blocks(4);
+        vector<thread> threads;
+        for (size_t t = 0; t < blocks.size(); ++t)
+            threads.push_back(thread([&arena, &blocks, t]() {
+                for (int i = 0; i < 1000; ++i) {
+                    char* p = static_cast<char*>(arena.allocate(24 + i % 100));
+                    p[0] = char(t);
+                    blocks[t].push_back(p);
+                }
+            }));
+        for (size_t t = 0; t < threads.size(); ++t) threads[t].join();
+        set<char*> distinct;
+        for (size_t t = 0; t < blocks.size(); ++t) {
+            for (size_t i = 0; i < blocks[t].size(); ++i) {
+                Assert(blocks[t][i][0] == char(t), "a block was handed out twice");
+                Assert(reinterpret_cast<size_t>(blocks[t][i]) % alignof(max_align_t) == 0, "block not aligned");
+                distinct.insert(blocks[t][i]);
+            }
+        }
+        Assert(distinct.size() == 4000, "blocks overlap");
+    }
+
+    return 0;
+}
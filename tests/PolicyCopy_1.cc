@@ -0,0 +1,272 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+
+
+/**
+ * @file PolicyCopy_1.cc
+ *
+ * This test checks that a copy of a Policy behaves as an independent
+ * deep copy although it shares its sub-policies until it or its original
+ * is changed, that sub-policies obtained from either remain views of it,
+ * that copying a large Policy takes constant time, and that a Policy may
+ * be copied and read from many threads at once.
+ */
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "lsst/pex/policy.h"
+#include "lsst/pex/exceptions.h"
+#include "countAllocations.h"
+
+using namespace std;
+using lsst::pex::policy::ConstPolicyRef;
+using lsst::pex::policy::Policy;
+using lsst::pex::policy::PolicyRef;
+
+#define Assert(b, m) tattle(b, m, __LINE__)
+
+void tattle(bool mustBeTrue, const string& failureMsg, int line) {
+    if (! mustBeTrue) {
+        ostringstream msg;
+        msg << __FILE__ << ':' << line << ":\n" << failureMsg << ends;
+        throw runtime_error(msg.str());
+    }
+}
+
+Policy::Ptr makePolicy() {
+    Policy::Ptr p(new Policy());
+    p->set("stage.name", "warp");
+    p->set("stage.kernel.sigma", 1.5);
+    p->add("stage.kernel.widths", 3);
+    p->add("stage.kernel.widths", 5);
+    Policy::Ptr step(new Policy());
+    step->set("order", 1);
+    p->add("steps", step);
+    step.reset(new Policy());
+    step->set("order", 2);
+    p->add("steps", step);
+    return p;
+}
+
+// copy through a const reference, since Policy(Policy&) makes a shallow copy
+Policy copyOf(const Policy& p) { return Policy(p); }
+
+int main() {
+    // a copy and its original may each be changed without affecting the other
+    {
+        Policy::Ptr original = makePolicy();
+        Policy copy = copyOf(*original);
+        copy.set("stage.kernel.sigma", 2.5);
+        copy.add("stage.kernel.widths", 7);
+        copy.remove("stage.name");
+        Assert(original->getDouble("stage.kernel.sigma") == 1.5, "original changed by setting the copy");
+        Assert(original->valueCount("stage.kernel.widths") == 2, "original changed by adding to the copy");
+        Assert(original->exists("stage.name"), "original changed by removing from the copy");
+
+        original->set("stage.kernel.order", 4);
+        original->getPolicyArray("steps")[0]->set("order", 10);
+        Assert(! copy.exists("stage.kernel.order"), "copy changed by setting the original");
+        Assert(copy.getPolicyArray("steps")[0]->getInt("order") == 1,
+               "copy changed through a sub-policy of the original");
+        Assert(copy.getDouble("stage.kernel.sigma") == 2.5 && copy.valueCount("stage.kernel.widths") == 3 &&
+                       ! copy.exists("stage.name"),
+               "copy lost its changes");
+
+        // copies of copies
+        Policy second = copyOf(copy);
+        Policy third = copyOf(second);
+        third.set("stage.kernel.sigma", 3.5);
+        Assert(second.getDouble("stage.kernel.sigma") == 2.5 && copy.getDouble("stage.kernel.sigma") == 2.5,
+               "a copy of a copy is shared");
+        second = third;
+        Assert(second.getDouble("stage.kernel.sigma") == 3.5, "assignment did not copy");
+        third.set("stage.kernel.sigma", 4.5);
+        Assert(second.getDouble("stage.kernel.sigma") == 3.5, "assignment shares");
+        second.set("stage.kernel.sigma", 5.5);
+        Assert(third.getDouble("stage.kernel.sigma") == 4.5, "assignment shares with the assigned policy");
+        const Policy& itself = second;
+        second = itself;
+        Assert(second.getDouble("stage.kernel.sigma") == 5.5, "self-assignment changed the policy");
+
+        // a view taken from either side of an assignment stays a view of its own policy
+        Policy::Ptr before = second.getPolicy("stage.kernel");
+        Policy::Ptr thirdKernel = third.getPolicy("stage.kernel");
+        second = third;
+        before->set("sigma", 6.5);
+        thirdKernel->set("order", 2);
+        Assert(second.getDouble("stage.kernel.sigma") == 4.5, "assigned policy changed through an old view");
+        Assert(third.getInt("stage.kernel.order") == 2 && ! second.exists("stage.kernel.order"),
+               "assigned policy changed through a view of the other");
+    }
+
+    // a sub-policy obtained before or after copying remains a view of its policy
+    {
+        Policy::Ptr original = makePolicy();
+        Policy::Ptr kernel = original->getPolicy("stage.kernel");
+        Policy copy = copyOf(*original);
+        kernel->set("sigma", 9.0);
+        Assert(original->getDouble("stage.kernel.sigma") == 9.0, "view lost by copying");
+        Assert(copy.getDouble("stage.kernel.sigma") == 1.5, "copy changed through a view of the original");
+
+        Policy::Ptr copyKernel = copy.getPolicy("stage.kernel");
+        copyKernel->set("sigma", 8.0);
+        Assert(copy.getDouble("stage.kernel.sigma") == 8.0, "view of the copy lost");
+        Assert(original->getDouble("stage.kernel.sigma") == 9.0, "original changed through a view of the copy");
+
+        Policy again = copyOf(*original);
+        original->set("stage.kernel.sigma", 7.0);
+        Assert(kernel->getDouble("sigma") == 7.0, "view does not see its policy");
+        Assert(again.getDouble("stage.kernel.sigma") == 9.0, "copy changed with the original");
+
+        PolicyRef ref(*original);
+        PolicyRef refKernel = ref.getPolicy("stage.kernel");
+        Policy fourth = copyOf(*original);
+        refKernel.set("sigma", 6.0);
+        Assert(original->getDouble("stage.kernel.sigma") == 6.0, "reference does not see its policy");
+        Assert(fourth.getDouble("stage.kernel.sigma") == 7.0, "copy changed through a reference");
+
+        const Policy& constCopy = fourth;
+        Policy::ConstPtr constKernel = constCopy.getPolicy("stage.kernel");
+        Assert(constKernel->getDouble("sigma") == 7.0, "wrong value through a const view");
+        fourth.set("stage.kernel.sigma", 5.0);
+        Assert(constKernel->getDouble("sigma") == 5.0, "const view does not see its policy");
+        Assert(original->getDouble("stage.kernel.sigma") == 6.0, "original changed through a const view");
+        Policy::ConstPolicyPtrArray constSteps = constCopy.getConstPolicyArray("steps");
+        fourth.getPolicyArray("steps")[0]->set("order", 3);
+        Assert(constSteps[0]->getInt("order") == 3, "const array view does not see its policy");
+        Assert(original->getPolicyArray("steps")[0]->getInt("order") == 1, "original changed with its copy");
+
+        // a const view of a sub-policy still shared sees changes made through a view above it
+        Policy fifth = copyOf(fourth);
+        Policy::Ptr stage = fifth.getPolicy("stage");
+        const Policy& constFifth = fifth;
+        Policy::ConstPtr fifthKernel = constFifth.getPolicy("stage.kernel");
+        stage->set("kernel.sigma", 4.0);
+        Assert(fifthKernel->getDouble("sigma") == 4.0, "const view does not see a change through a view");
+        Assert(fourth.getDouble("stage.kernel.sigma") == 5.0, "copy changed through a view of its copy");
+
+        // as does one taken from a policy whose data is all shared
+        Policy sixth = copyOf(copyOf(fourth));
+        const Policy& constSixth = sixth;
+        Policy::ConstPtr sixthKernel = constSixth.getPolicy("stage.kernel");
+        Policy::ConstPolicyPtrArray sixthSteps = constSixth.getConstPolicyArray("steps");
+        sixth.set("stage.kernel.sigma", 3.0);
+        sixth.getPolicyArray("steps")[1]->set("order", 4);
+        Assert(sixthKernel->getDouble("sigma") == 3.0, "const view of shared data does not see its policy");
+        Assert(sixthSteps[1]->getInt("order") == 4, "const array view of shared data does not see its policy");
+        Assert(fourth.getDouble("stage.kernel.sigma") == 5.0 && fourth.getPolicyArray("steps")[1]->getInt(
+                       "order") == 2,
+               "copy changed through a const view of its copy");
+    }
+
+    // a sub-policy set, added or shallow-copied stays shared with the policy it came from
+    {
+        Policy::Ptr sub(new Policy());
+        sub->set("a", 1);
+        Policy p;
+        p.set("sub", sub);
+        Policy copy = copyOf(p);
+        sub->set("a", 2);
+        Assert(p.getInt("sub.a") == 2, "sub-policy set is not shared");
+        Assert(copy.getInt("sub.a") == 1, "copy changed through a sub-policy set in the original");
+
+        Policy::Ptr original = makePolicy();
+        Policy alias(*original, false);
+        Policy copyOfAlias = copyOf(alias);
+        alias.set("stage.name", "psf");
+        Assert(original->getString("stage.name") == "psf", "shallow copy is not shared");
+        Assert(copyOfAlias.getString("stage.name") == "warp", "copy of a shallow copy is shared");
+
+        Policy deep(*original, true);
+        deep.set("stage.name", "detect");
+        Assert(original->getString("stage.name") == "psf", "deep copy is shared");
+    }
+
+    // copying a large policy allocates no more than copying an empty one
+    {
+        Policy big;
+        for (int i = 0; i < 10000; ++i) big.set("block" + to_string(i % 100) + ".p" + to_string(i), i);
+        const Policy& constBig = big;
+
+        const Policy none;
+        long before = allocations;
+        Policy::Ptr empty(new Policy(none));
+        long forEmpty = allocations - before;
+        before = allocations;
+        Policy::Ptr copy(new Policy(constBig));
+        long made = allocations - before;
+        Assert(made <= forEmpty, "copying a large policy allocated " + to_string(made));
+
+        // changing the copy copies only the levels along the name changed
+        before = allocations;
+        copy->set("block7.p7", -7);
+        made = allocations - before;
+        Assert(made < 20, "changing the copy allocated " + to_string(made));
+        Assert(big.getInt("block7.p7") == 7 && copy->getInt("block7.p7") == -7, "copy shared a change");
+        Assert(copy->getInt("block8.p8") == 8 && copy->names().size() == big.names().size(),
+               "copy lost values");
+    }
+
+    // many threads may copy a policy and take views of it at once
+    {
+        Policy::Ptr original = makePolicy();
+        Policy::Ptr kernel = original->getPolicy("stage.kernel");
+        const Policy& pinned = *original;
+        const Policy shared = copyOf(*makePolicy());
+        const int nthreads = 8;
+        vector<int> failures(nthreads, 0);
+        vector<thread> threads;
+        for (int t = 0; t < nthreads; ++t) {
+            threads.push_back(thread([&pinned, &shared, &failures, t]() {
+                for (int i = 0; i < 200; ++i) {
+                    const Policy& from = (i + t) % 2 ? pinned : shared;
+                    Policy copy(from);
+                    Policy::ConstPtr sub = from.getPolicy("stage.kernel");
+                    Policy::ConstPolicyPtrArray steps = from.getConstPolicyArray("steps");
+                    ConstPolicyRef ref(from);
+                    if (sub->getDouble("sigma") != 1.5 || steps.size() != 2 || steps[1]->getInt("order") != 2 ||
+                        ref.getString("stage.name") != "warp" || copy.getInt("stage.kernel.widths") != 5)
+                        ++failures[t];
+
+                    // a copy changed in one thread is seen through its own views only
+                    const Policy& constCopy = copy;
+                    Policy::ConstPtr copyKernel = constCopy.getPolicy("stage.kernel");
+                    copy.set("stage.kernel.sigma", double(i));
+                    if (copyKernel->getDouble("sigma") != double(i) || sub->getDouble("sigma") != 1.5)
+                        ++failures[t];
+                }
+            }));
+        }
+        for (int t = 0; t < nthreads; ++t) threads[t].join();
+        for (int t = 0; t < nthreads; ++t) Assert(failures[t] == 0, "wrong value in a thread");
+        Assert(original->getDouble("stage.kernel.sigma") == 1.5 && shared.getDouble("stage.kernel.sigma") == 1.5,
+               "policy changed through a copy made in a thread");
+        kernel->set("sigma", 2.5);
+        Assert(original->getDouble("stage.kernel.sigma") == 2.5, "view lost by copying in threads");
+    }
+
+    return 0;
+}
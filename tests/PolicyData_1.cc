@@ -0,0 +1,175 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file PolicyData_1.cc
+ *
+ * This test exercises the flat storage behind Policy:  lookups in levels
+ * large enough to be indexed, values growing and moving within the typed
+ * arrays, removal, sub-policies shared between policies, and conversion
+ * to and from PropertySet.
+ */
+
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include "lsst/pex/policy.h"
+#include "lsst/pex/policy/PolicyFile.h"
+#include "lsst/pex/exceptions.h"
+
+using namespace std;
+using lsst::pex::policy::Policy;
+using lsst::pex::policy::PolicyFile;
+using lsst::pex::policy::TypeError;
+using lsst::daf::base::Persistable;
+using lsst::daf::base::PropertySet;
+
+#define Assert(b, m) tattle(b, m, __LINE__)
+
+void tattle(bool mustBeTrue, const string& failureMsg, int line) {
+    if (! mustBeTrue) {
+        ostringstream msg;
+        msg << __FILE__ << ':' << line << ":\n" << failureMsg << ends;
+        throw runtime_error(msg.str());
+    }
+}
+
+string key(const string& prefix, int i) {
+    ostringstream out;
+    out << prefix << i;
+    return out.str();
+}
+
+// gives access to the PropertySet constructor
+class Converted : public Policy {
+public:
+    explicit Converted(const PropertySet::Ptr& ps) : Policy(ps) { }
+};
+
+int main() {
+    // a level large enough to be indexed
+    Policy p;
+    const int n = 1000;
+    for (int i = 0; i < n; ++i) {
+        p.set(key("int", i), i);
+        p.set(key("sub.str", i), key("value", i));
+    }
+    Assert(p.nameCount() == n + 1, "wrong name count");
+    for (int i = 0; i < n; ++i) {
+        Assert(p.getInt(key("int", i)) == i, "indexed lookup failed");
+        Assert(p.getString(key("sub.str", i)) == key("value", i), "hierarchical lookup failed");
+    }
+    Assert(! p.exists("int1000") && ! p.exists("sub.int1") && ! p.exists("int1.x"),
+           "found a name never set");
+
+    // names come back in the order they were first set
+    Policy::StringArray names = p.names(true);
+    Assert(names.size() == size_t(n + 1) && names[0] == "int0" && names[1] == "sub" &&
+           names[2] == "int1" && names.back() == "int999", "names out of order");
+    Assert(p.names(false).size() == size_t(2 * n + 1), "wrong number of hierarchical names");
+    Assert(p.paramNames(false).size() == size_t(2 * n), "wrong number of parameter names");
+
+    // values added to parameters not last in their array are moved, and
+    // the arrays compacted
+    Policy g;
+    for (int round = 0; round < 50; ++round)
+        for (int i = 0; i < 10; ++i) g.add(key("d", i), round + i * 0.5);
+    for (int i = 0; i < 10; ++i) {
+        Policy::DoubleArray d = g.getDoubleArray(key("d", i));
+        Assert(d.size() == 50, "lost values");
+        for (int round = 0; round < 50; ++round)
+            Assert(d[round] == round + i * 0.5, "values out of place");
+    }
+    g.add("flags", true);
+    g.add("flags", false);
+    g.add("words", "one");
+    g.add("flags", true);
+    g.add("words", "two");
+    Policy::BoolArray flags = g.getBoolArray("flags");
+    Assert(flags.size() == 3 && flags[0] && ! flags[1] && flags[2], "wrong bool values");
+    Assert(g.getStringArray("words").size() == 2 && g.getString("words") == "two",
+           "wrong string values");
+
+    // set replaces values, possibly with another type
+    g.set("d3", 1.5);
+    Assert(g.valueCount("d3") == 1 && g.getDouble("d3") == 1.5, "set did not replace values");
+    g.set("d4", "now a string");
+    Assert(g.isString("d4") && g.valueCount("d4") == 1, "set did not change type");
+    Assert(g.getDoubleArray("d5").size() == 50, "set disturbed another name");
+    try {
+        g.add("d4", 3);
+        Assert(false, "added a value of another type");
+    } catch (TypeError&) { }
+    try {
+        g.set("d4.x", 3);
+        Assert(false, "set a name within a non-policy");
+    } catch (lsst::pex::exceptions::InvalidParameterError&) { }
+
+    // removal
+    for (int i = 0; i < n; i += 2) p.remove(key("int", i));
+    p.remove("sub.str7");
+    p.remove("no.such.name");
+    Assert(p.nameCount() == n / 2 + 1, "wrong name count after removal");
+    for (int i = 0; i < n; ++i) Assert(p.exists(key("int", i)) == (i % 2 == 1), "wrong names removed");
+    Assert(! p.exists("sub.str7") && p.exists("sub.str8"), "wrong hierarchical name removed");
+    p.set("int0", -1);
+    Assert(p.getInt("int0") == -1 && p.names(true).back() == "int0", "name not restored");
+
+    // sub-policies are shared
+    Policy::Ptr sub = p.getPolicy("sub");
+    sub->set("added", 4);
+    Assert(p.getInt("sub.added") == 4, "change through a sub-policy not seen");
+    Policy::Ptr other(new Policy());
+    other->set("x", 1);
+    p.add("list", other);
+    p.add("list", Policy::Ptr(new Policy()));
+    other->set("x", 2);
+    Assert(p.getPolicyArray("list")[0]->getInt("x") == 2, "added sub-policy not shared");
+    Assert(! p.exists("list.x"), "hierarchical name not read from the last sub-policy");
+    Policy shallow(p, false);
+    Policy deep(p, true);
+    p.set("sub.added", 5);
+    Assert(shallow.getInt("sub.added") == 5, "shallow copy not shared");
+    Assert(deep.getInt("sub.added") == 4, "deep copy shared");
+
+    // types are reported as PropertySet reported them
+    p.set("file", Policy::FilePtr(new PolicyFile("test.paf")));
+    Assert(p.typeOf("sub") == typeid(PropertySet::Ptr), "wrong type for a Policy");
+    Assert(p.typeOf("file") == typeid(shared_ptr<Persistable>), "wrong type for a PolicyFile");
+    Assert(p.getValueType("file") == Policy::FILE && p.isFile("file"), "wrong value type for a file");
+    Assert(p.getFile("file")->getPath() == "test.paf", "wrong file");
+
+    // conversion to and from PropertySet copies the data
+    PropertySet::Ptr ps = g.asPropertySet();
+    Assert(ps->getArray<double>("d0").size() == 50 && ps->get<string>("words") == "two",
+           "wrong PropertySet values");
+    ps->set("words", string("changed"));
+    Assert(g.getString("words") == "two", "PropertySet shares data");
+    PropertySet::Ptr nested = p.toPropertySet();
+    Assert(nested->get<int>("sub.added") == 5, "wrong nested PropertySet value");
+    Converted back(nested);
+    Assert(back.getInt("sub.added") == 5 && back.getPolicyArray("list").size() == 2 &&
+           back.getFile("file")->getPath() == "test.paf", "wrong values from a PropertySet");
+
+    return 0;
+}
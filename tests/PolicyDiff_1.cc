@@ -0,0 +1,162 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+
+
+/**
+ * @file PolicyDiff_1.cc
+ *
+ * This test checks that Policy::diff() finds each name added, removed or
+ * changed between two policies, with its values on each side, that
+ * applying the result makes one policy equal to the other, and that the
+ * sub-policies two copies share are not looked into.
+ */
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include "lsst/pex/policy.h"
+#include "lsst/pex/exceptions.h"
+#include "countAllocations.h"
+
+using namespace std;
+using lsst::pex::policy::Policy;
+using lsst::pex::policy::PolicyDiff;
+
+#define Assert(b, m) tattle(b, m, __LINE__)
+
+void tattle(bool mustBeTrue, const string& failureMsg, int line) {
+    if (! mustBeTrue) {
+        ostringstream msg;
+        msg << __FILE__ << ':' << line << ":\n" << failureMsg << ends;
+        throw runtime_error(msg.str());
+    }
+}
+
+// the kind of change listed for a name, or -1 if it is not listed
+int kindOf(const PolicyDiff& patch, const string& name) {
+    for (PolicyDiff::ChangeList::const_iterator it = patch.getChanges().begin(); it != patch.getChanges().end();
+         ++it)
+        if (it->name == name) return it->kind;
+    return -1;
+}
+
+Policy::Ptr makePolicy() {
+    Policy::Ptr p(new Policy());
+    p->set("name", "warp");
+    p->set("stage.enabled", true);
+    p->set("stage.kernel.sigma", 1.5);
+    p->add("stage.kernel.widths", 3);
+    p->add("stage.kernel.widths", 5);
+    p->set("stage.output.format", "fits");
+    p->set("retries", 3);
+    Policy::Ptr step(new Policy());
+    step->set("order", 1);
+    p->add("steps", step);
+    step.reset(new Policy());
+    step->set("order", 2);
+    p->add("steps", step);
+    return p;
+}
+
+int main() {
+    // each kind of difference is found, with the values on each side
+    {
+        Policy::Ptr older = makePolicy(), newer = makePolicy();
+        Assert(older->diff(*newer).empty(), "equal policies differ");
+
+        newer->set("stage.kernel.sigma", 2.5);
+        newer->add("stage.kernel.widths", 7);
+        newer->set("stage.kernel.order", 4);
+        newer->remove("stage.output");
+        newer->set("retries", "none");
+        newer->getPolicyArray("steps")[1]->set("order", 3);
+        newer->set("added.deeply.nested", 1.0);
+
+        PolicyDiff patch = older->diff(*newer);
+        Assert(patch.size() == 7, "wrong number of differences: " + to_string(patch.size()));
+        Assert(kindOf(patch, "stage.kernel.sigma") == PolicyDiff::CHANGED, "changed value not found");
+        Assert(kindOf(patch, "stage.kernel.widths") == PolicyDiff::CHANGED, "changed array not found");
+        Assert(kindOf(patch, "stage.kernel.order") == PolicyDiff::ADDED, "added value not found");
+        Assert(kindOf(patch, "stage.output") == PolicyDiff::REMOVED, "removed sub-policy not found");
+        Assert(kindOf(patch, "retries") == PolicyDiff::CHANGED, "changed type not found");
+        Assert(kindOf(patch, "steps") == PolicyDiff::CHANGED, "changed sub-policy array not found");
+        Assert(kindOf(patch, "added") == PolicyDiff::ADDED, "added sub-policy not found");
+        Assert(kindOf(patch, "stage.enabled") == -1 && kindOf(patch, "stage") == -1, "unchanged name listed");
+
+        const Policy& before = patch.getOldValues();
+        const Policy& after = patch.getNewValues();
+        Assert(before.getDouble("stage.kernel.sigma") == 1.5 && after.getDouble("stage.kernel.sigma") == 2.5,
+               "wrong changed values");
+        Assert(before.valueCount("stage.kernel.widths") == 2 && after.getIntArray("stage.kernel.widths")[2] == 7,
+               "wrong changed array");
+        Assert(! before.exists("stage.kernel.order") && after.getInt("stage.kernel.order") == 4,
+               "wrong added values");
+        Assert(before.getString("stage.output.format") == "fits" && ! after.exists("stage.output"),
+               "wrong removed values");
+        Assert(before.getInt("retries") == 3 && after.getString("retries") == "none", "wrong retyped values");
+        Assert(after.getPolicyArray("steps")[1]->getInt("order") == 3, "wrong sub-policy array");
+        Assert(! before.exists("name") && ! after.exists("name"), "unchanged value held");
+
+        // applying the differences makes the older policy equal to the newer
+        Policy::Ptr view = older->getPolicy("stage.kernel");
+        older->apply(patch);
+        Assert(older->diff(*newer).empty(), "applied policy differs");
+        Assert(view->getDouble("sigma") == 2.5, "applied change not seen through a sub-policy");
+
+        // and the reverse diff undoes it
+        older->apply(newer->diff(*makePolicy()));
+        Assert(older->diff(*makePolicy()).empty(), "reverse diff does not undo");
+    }
+
+    // a patch may be applied to a copy, leaving the original alone
+    {
+        Policy::Ptr older = makePolicy(), newer = makePolicy();
+        newer->set("stage.kernel.sigma", 9.0);
+        const Policy& original = *older;
+        Policy copy(original);
+        copy.apply(older->diff(*newer));
+        Assert(copy.getDouble("stage.kernel.sigma") == 9.0 && older->getDouble("stage.kernel.sigma") == 1.5,
+               "patching a copy changed its original");
+    }
+
+    // the sub-policies copies share are not looked into
+    {
+        Policy big;
+        for (int i = 0; i < 100000; ++i) big.set("block" + to_string(i % 1000) + ".p" + to_string(i), i);
+        const Policy& original = big;
+        Policy copy(original);
+        copy.set("block7.p7", -7);
+        copy.remove("block8.p8");
+
+        long before = allocations;
+        PolicyDiff patch = big.diff(copy);
+        long made = allocations - before;
+        Assert(patch.size() == 2 && kindOf(patch, "block7.p7") == PolicyDiff::CHANGED &&
+                       kindOf(patch, "block8.p8") == PolicyDiff::REMOVED,
+               "wrong differences between copies");
+        Assert(made < 100, "diff of copies allocated " + to_string(made));
+    }
+
+    return 0;
+}
@@ -0,0 +1,178 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file PolicyFile_1.cc
+ *
+ * This test checks that PolicyFile recognizes the format of files that
+ * start with blank lines and comments, and that loading a file opens it
+ * only once, whether or not its format is already known.  Opens are
+ * counted with inotify, so that part of the test only runs on Linux.
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include "boost/filesystem.hpp"
+#include "lsst/pex/policy.h"
+#include "lsst/pex/policy/PolicyFile.h"
+#include "lsst/pex/policy/PolicyString.h"
+#include "lsst/pex/policy/paf/PAFParserFactory.h"
+#include "lsst/pex/exceptions.h"
+
+#ifdef __linux__
+#include <errno.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+using lsst::pex::policy::Policy;
+using lsst::pex::policy::PolicyFile;
+using lsst::pex::policy::PolicyParserFactory;
+using lsst::pex::policy::PolicyString;
+using lsst::pex::policy::paf::PAFParserFactory;
+namespace fs = boost::filesystem;
+
+#define Assert(b, m) tattle(b, m, __LINE__)
+
+void tattle(bool mustBeTrue, const string& failureMsg, int line) {
+    if (! mustBeTrue) {
+        ostringstream msg;
+        msg << __FILE__ << ':' << line << ":\n" << failureMsg << ends;
+        throw runtime_error(msg.str());
+    }
+}
+
+void write(const fs::path& file, const string& data) {
+    ofstream out(file.string().c_str());
+    out << data;
+}
+
+// counts the times the files in a directory are opened
+class OpenCounter {
+public:
+#ifdef __linux__
+    explicit OpenCounter(const fs::path& dir) : _fd(inotify_init1(IN_NONBLOCK)) {
+        if (_fd >= 0 && inotify_add_watch(_fd, dir.string().c_str(), IN_OPEN) < 0) {
+            close(_fd);
+            _fd = -1;
+        }
+    }
+    ~OpenCounter() {
+        if (_fd >= 0) close(_fd);
+    }
+
+    bool works() const { return _fd >= 0; }
+
+    // return the number of opens since the last call
+    int count() {
+        int n = 0;
+        char buf[4096];
+        for (;;) {
+            ssize_t len = read(_fd, buf, sizeof(buf));
+            if (len <= 0) break;
+            for (char* p = buf; p < buf + len; p += sizeof(inotify_event) + ((inotify_event*)p)->len)
+                if (((inotify_event*)p)->mask & IN_OPEN) ++n;
+        }
+        return n;
+    }
+
+private:
+    int _fd;
+#else
+    explicit OpenCounter(const fs::path&) {}
+    bool works() const { return false; }
+    int count() { return 0; }
+#endif
+};
+
+int main() {
+    fs::path dir = fs::temp_directory_path() / fs::unique_path("PolicyFile_1_%%%%%%%%");
+    fs::create_directories(dir);
+
+    // format recognition skips blank lines and comments
+    write(dir / "blank.paf", "\n\n# a comment\n\na: 1\n");
+    write(dir / "json", "\n   \n# a comment\n{ \"a\": 1 }\n");
+    write(dir / "declared", "\n#<?cfg JSON policy ?>\n{ \"a\": 2 }\n");
+    write(dir / "comments", "\n# nothing but\n# comments\n");
+    write(dir / "plain", "a: 3\n");
+    {
+        PolicyFile f((dir / "json").string());
+        Assert(f.getFormatName() == "JSON", "JSON after comments not recognized: " + f.getFormatName());
+        Policy p;
+        f.load(p);
+        Assert(p.getInt("a") == 1, "wrong value");
+    }
+    Assert(PolicyFile((dir / "declared").string()).getFormatName() == "JSON", "content id not recognized");
+    Assert(PolicyFile((dir / "comments").string()).getFormatName() == "PAF", "empty file not taken as PAF");
+    Assert(PolicyFile((dir / "plain").string()).getFormatName() == "PAF", "PAF not recognized");
+    Assert(PolicyString("\n\n# a comment\n{ \"a\": 1 }").getFormatName() == "JSON",
+           "JSON string after comments not recognized");
+    Assert(PolicyString("\n\n").getFormatName() == "PAF", "empty string not taken as PAF");
+
+    // a forced format is reported without reading the file
+    {
+        PolicyParserFactory::Ptr paf(new PAFParserFactory());
+        PolicyFile f((dir / "json").string(), paf);
+        Assert(f.getFormatName() == "PAF", "forced format not reported");
+    }
+
+    // each load opens the file once
+    OpenCounter opens(dir);
+    if (opens.works()) {
+        Policy p;
+        PolicyFile((dir / "blank.paf").string()).load(p);
+        Assert(opens.count() == 1, "file with an extension opened more than once");
+
+        PolicyFile json((dir / "json").string());
+        json.load(p);
+        Assert(opens.count() == 1, "file of unknown format opened more than once");
+        Assert(json.getFormatName() == "JSON", "recognized format not cached");
+        Assert(opens.count() == 0, "cached format not used");
+        json.load(p);
+        Assert(opens.count() == 1, "reloaded file opened more than once");
+
+        PolicyFile fresh((dir / "declared").string());
+        Assert(fresh.getFormatName() == "JSON", "content id not recognized");
+        Assert(opens.count() == 1, "format recognized with more than one open");
+        Policy q;
+        fresh.load(q);
+        Assert(opens.count() == 1, "file opened again to recognize its format");
+        Assert(q.getInt("a") == 2, "wrong value");
+    }
+
+    // a missing file
+    bool thrown = false;
+    try {
+        Policy p;
+        PolicyFile((dir / "missing").string()).load(p);
+    } catch (lsst::pex::exceptions::IoError& ex) {
+        thrown = string(ex.what()).find("failure opening Policy file") != string::npos;
+    }
+    Assert(thrown, "missing file not reported");
+
+    fs::remove_all(dir);
+    return 0;
+}
@@ -0,0 +1,138 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file PolicyHandler_1.cc
+ *
+ * This test checks the events a PAFParser sends to a PolicyHandler.
+ */
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "lsst/pex/policy/paf/PAFParser.h"
+#include "lsst/pex/policy/PolicyHandler.h"
+#include "lsst/pex/policy/PolicyFile.h"
+#include "lsst/pex/policy.h"
+
+using namespace std;
+using lsst::pex::policy::Policy;
+using lsst::pex::policy::PolicyHandler;
+using lsst::pex::policy::paf::PAFParser;
+
+#define Assert(b, m) tattle(b, m, __LINE__)
+
+void tattle(bool mustBeTrue, const string& failureMsg, int line) {
+    if (! mustBeTrue) {
+        ostringstream msg;
+        msg << __FILE__ << ':' << line << ":\n" << failureMsg << ends;
+        throw runtime_error(msg.str());
+    }
+}
+
+// records each event as "line kind name=value"
+class Recorder : public PolicyHandler {
+public:
+    vector<string> events;
+
+    void record(int lineno, const string& kind, const string& name, const string& value = "") {
+        ostringstream out;
+        out << lineno << ' ' << kind << ' ' << name;
+        if (! value.empty()) out << '=' << value;
+        events.push_back(out.str());
+    }
+
+    virtual void beginPolicy(const string& name, int lineno) { record(lineno, "begin", name); }
+    virtual void endPolicy(const string& name, int lineno) { record(lineno, "end", name); }
+    virtual void onBool(const string& name, bool value, int lineno) {
+        record(lineno, "bool", name, value ? "true" : "false");
+    }
+    virtual void onInt(const string& name, int value, int lineno) {
+        ostringstream v;
+        v << value;
+        record(lineno, "int", name, v.str());
+    }
+    virtual void onDouble(const string& name, double value, int lineno) {
+        ostringstream v;
+        v << value;
+        record(lineno, "double", name, v.str());
+    }
+    virtual void onString(const string& name, const string& value, int lineno) {
+        record(lineno, "string", name, value);
+    }
+    virtual void onFile(const string& name, const Policy::FilePtr& value, int lineno) {
+        record(lineno, "file", name, value->getPath());
+    }
+};
+
+int main() {
+    const string data =
+        "standalone: true\n"
+        "offsets: 1 14\n"
+        "receiver.logVerbosity: \"debug\"\n"
+        "transmitter: {\n"
+        "   threshold: 4.5\n"
+        "   note: \"spread over\n"
+        "          two lines\"\n"
+        "   output: { file: @out.paf }\n"
+        "}\n";
+    const char* expected[] = {
+        "1 bool standalone=true",
+        "2 int offsets=1",
+        "2 int offsets=14",
+        "3 string receiver.logVerbosity=debug",
+        "4 begin transmitter",
+        "5 double transmitter.threshold=4.5",
+        "6 string transmitter.note=spread over two lines",
+        "8 begin transmitter.output",
+        "8 file transmitter.output.file=out.paf",
+        "8 end transmitter.output",
+        "9 end transmitter"
+    };
+    const size_t nexpected = sizeof(expected)/sizeof(expected[0]);
+
+    Policy p;
+    Recorder recorder;
+    PAFParser parser(p);
+    parser.setHandler(&recorder);
+    Assert(&parser.getHandler() == &recorder, "handler not set");
+    int count = parser.parse(data.data(), data.size());
+
+    Assert(count == 7, "wrong value count");
+    Assert(p.names().empty(), "policy loaded while a handler was set");
+    Assert(recorder.events.size() == nexpected, "wrong number of events");
+    for (size_t i = 0; i < nexpected; ++i)
+        Assert(recorder.events[i] == expected[i],
+               "expected \"" + string(expected[i]) + "\", got \"" + recorder.events[i] + "\"");
+
+    // the default handler loads the policy as before
+    Policy q;
+    PAFParser loader(q);
+    loader.parse(data.data(), data.size());
+    Assert(q.getBool("standalone") && q.getIntArray("offsets").size() == 2, "top level not loaded");
+    Assert(q.getString("receiver.logVerbosity") == "debug", "dotted name not loaded");
+    Assert(q.getDouble("transmitter.threshold") == 4.5, "sub-policy not loaded");
+    Assert(q.getFile("transmitter.output.file")->getPath() == "out.paf", "file not loaded");
+
+    return 0;
+}
@@ -0,0 +1,134 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file PolicyKey_1.cc
+ *
+ * This test checks that the Policy functions taking a PolicyKey behave
+ * the same as those taking the name it was made from.
+ */
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "lsst/pex/policy.h"
+#include "lsst/pex/exceptions.h"
+
+using namespace std;
+using lsst::pex::policy::NameNotFound;
+using lsst::pex::policy::Policy;
+using lsst::pex::policy::PolicyKey;
+using lsst::pex::policy::TypeError;
+
+#define Assert(b, m) tattle(b, m, __LINE__)
+
+void tattle(bool mustBeTrue, const string& failureMsg, int line) {
+    if (! mustBeTrue) {
+        ostringstream msg;
+        msg << __FILE__ << ':' << line << ":\n" << failureMsg << ends;
+        throw runtime_error(msg.str());
+    }
+}
+
+int main() {
+    const PolicyKey sigma("stage.kernel.sigma");
+    const PolicyKey kernel("stage.kernel");
+    const PolicyKey width("stage.kernel.width");
+    const PolicyKey name("name");
+
+    Assert(sigma.getName() == "stage.kernel.sigma", "wrong name");
+    Assert(sigma.getFieldCount() == 3 && name.getFieldCount() == 1, "wrong field count");
+
+    // values set by name are seen by key, and vice versa
+    {
+        Policy p;
+        p.set("stage.kernel.sigma", 1.5);
+        Assert(p.exists(sigma) && p.isDouble(sigma) && ! p.isInt(sigma), "key not found");
+        Assert(p.getDouble(sigma) == 1.5, "wrong value by key");
+        Assert(p.isPolicy(kernel) && p.getValueType(kernel) == Policy::POLICY, "wrong type");
+        Assert(! p.exists(width) && p.valueCount(width) == 0, "missing key found");
+
+        p.set(width, 7);
+        Assert(p.getInt("stage.kernel.width") == 7, "value set by key not found by name");
+        p.add(width, 9);
+        Assert(p.isArray(width) && p.getIntArray(width).size() == 2, "value not added by key");
+        p.set(name, "warp");
+        Assert(p.getString("name") == "warp" && p.getString(name) == "warp", "wrong string");
+        p.add(name, string("psf"));
+        Assert(p.getStringArray(name)[1] == "psf", "wrong string array");
+
+        p.getPolicy(kernel)->set("order", 3);
+        Assert(p.getInt("stage.kernel.order") == 3, "sub-policy is not a view");
+
+        p.remove(sigma);
+        Assert(! p.exists("stage.kernel.sigma") && p.exists(width), "wrong name removed");
+    }
+
+    // one key may be used with many policies, whatever their layout
+    {
+        Policy a, b;
+        a.set("stage.kernel.sigma", 1.0);
+        for (int i = 0; i < 20; ++i) b.set("stage.p" + to_string(i), i);
+        b.set("stage.kernel.sigma", 2.0);
+        Assert(a.getDouble(sigma) == 1.0 && b.getDouble(sigma) == 2.0, "wrong policy searched");
+        b.add(PolicyKey("stage.ratios"), Policy::DoubleArray(3, 0.5));
+        Assert(b.getDoubleArray("stage.ratios").size() == 3, "array not added by key");
+    }
+
+    // the same exceptions are thrown
+    {
+        Policy p;
+        p.set("stage.kernel", 1);
+        try {
+            p.getDouble(sigma);
+            Assert(false, "missing key found");
+        } catch (NameNotFound& e) {
+        }
+        try {
+            p.getDouble(kernel);
+            Assert(false, "wrong type returned");
+        } catch (TypeError& e) {
+        }
+        try {
+            p.set(sigma, 1.0);
+            Assert(false, "set through a parameter that is not a Policy");
+        } catch (lsst::pex::exceptions::InvalidParameterError& e) {
+            Assert(string(e.what()).find("stage.kernel is not a Policy") != string::npos, e.what());
+        }
+        try {
+            p.add(kernel, string("wide"));
+            Assert(false, "added a value of the wrong type");
+        } catch (TypeError& e) {
+        }
+    }
+
+    // a key converts to its name
+    {
+        Policy p;
+        p.set("name", 1);
+        const string& asName = name;
+        Assert(p.getInt(asName) == 1 && p.str(name) == "1", "key does not convert to its name");
+    }
+
+    return 0;
+}
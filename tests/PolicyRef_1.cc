@@ -0,0 +1,151 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file PolicyRef_1.cc
+ *
+ * This test checks that PolicyRef and ConstPolicyRef read and change a
+ * Policy as the Policy functions do, and that many threads may read
+ * through them at once.
+ */
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "lsst/pex/policy.h"
+#include "lsst/pex/exceptions.h"
+
+using namespace std;
+using lsst::pex::policy::ConstPolicyRef;
+using lsst::pex::policy::NameNotFound;
+using lsst::pex::policy::Policy;
+using lsst::pex::policy::PolicyKey;
+using lsst::pex::policy::PolicyRef;
+using lsst::pex::policy::TypeError;
+
+#define Assert(b, m) tattle(b, m, __LINE__)
+
+void tattle(bool mustBeTrue, const string& failureMsg, int line) {
+    if (! mustBeTrue) {
+        ostringstream msg;
+        msg << __FILE__ << ':' << line << ":\n" << failureMsg << ends;
+        throw runtime_error(msg.str());
+    }
+}
+
+int main() {
+    Policy p;
+    p.set("stage.name", "warp");
+    p.set("stage.enabled", true);
+    p.set("stage.kernel.sigma", 1.5);
+    p.add("stage.kernel.widths", 3);
+    p.add("stage.kernel.widths", 5);
+    p.set("top", 1);
+
+    // the read functions give what the Policy functions give
+    {
+        ConstPolicyRef stage = p.getPolicyRef("stage");
+        Assert(stage.getString("name") == "warp" && stage.getBool("enabled"), "wrong values");
+        Assert(stage.getDouble("kernel.sigma") == p.getDouble("stage.kernel.sigma"), "wrong nested value");
+        Assert(stage.getIntArray("kernel.widths") == p.getIntArray("stage.kernel.widths"), "wrong array");
+        Assert(stage.getPolicy("kernel").getIntArrayView("widths").back() == 5, "wrong view");
+        Assert(stage.isPolicy("kernel") && stage.isArray("kernel.widths") && ! stage.exists("top"),
+               "wrong queries");
+        Assert(string(stage.getTypeName("enabled")) == "bool", "wrong type name");
+        Assert(stage.getDouble(PolicyKey("kernel.sigma")) == 1.5, "wrong value by key");
+
+        Policy::StringArray names = stage.names();
+        Policy::StringArray expected = p.getPolicy("stage")->names();
+        Assert(names == expected && names.size() == 5, "wrong names");
+        Assert(stage.paramNames(true).size() == 2 && stage.policyNames().size() == 1, "wrong names");
+
+        ConstPolicyRef top(p);
+        Assert(top.getInt("top") == 1 && top.getPolicy("stage.kernel").getDouble("sigma") == 1.5,
+               "wrong values from the top");
+    }
+
+    // the same exceptions are thrown
+    {
+        ConstPolicyRef stage = p.getPolicyRef("stage");
+        try {
+            stage.getInt("missing");
+            Assert(false, "missing name found");
+        } catch (NameNotFound&) {
+        }
+        try {
+            stage.getInt("name");
+            Assert(false, "wrong type returned");
+        } catch (TypeError&) {
+        }
+        try {
+            p.getPolicyRef("top");
+            Assert(false, "reference to a value that is not a Policy");
+        } catch (TypeError&) {
+        }
+        try {
+            p.getPolicyRef("stage").add("name", 1);
+            Assert(false, "added a value of the wrong type");
+        } catch (TypeError&) {
+        }
+    }
+
+    // changes made through a PolicyRef are seen by the Policy
+    {
+        PolicyRef kernel = p.getPolicyRef("stage.kernel");
+        kernel.set("order", 3);
+        kernel.add("widths", 7);
+        kernel.set("method", "lanczos");
+        kernel.remove("sigma");
+        Assert(p.getInt("stage.kernel.order") == 3 && p.getIntArray("stage.kernel.widths").size() == 3,
+               "change not seen");
+        Assert(p.getString("stage.kernel.method") == "lanczos" && ! p.exists("stage.kernel.sigma"),
+               "change not seen");
+
+        Policy::Ptr copy = kernel.copy();
+        copy->set("order", 4);
+        Assert(p.getInt("stage.kernel.order") == 3 && copy->getInt("order") == 4, "copy is shared");
+    }
+
+    // many threads may read through references at once
+    {
+        Policy big;
+        for (int i = 0; i < 100; ++i) big.set("block" + to_string(i) + ".output.verbosity", i);
+        const int nthreads = 8;
+        vector<long> sums(nthreads, 0);
+        vector<thread> threads;
+        for (int t = 0; t < nthreads; ++t) {
+            threads.push_back(thread([&big, &sums, t]() {
+                const Policy& reader = big;
+                for (int rep = 0; rep < 200; ++rep)
+                    for (int i = 0; i < 100; ++i)
+                        sums[t] += reader.getPolicyRef("block" + to_string(i)).getPolicy("output").getInt(
+                                "verbosity");
+            }));
+        }
+        for (int t = 0; t < nthreads; ++t) threads[t].join();
+        for (int t = 0; t < nthreads; ++t) Assert(sums[t] == 200L * 99 * 100 / 2, "wrong sum in a thread");
+    }
+
+    return 0;
+}
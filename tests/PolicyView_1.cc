@@ -0,0 +1,153 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file PolicyView_1.cc
+ *
+ * This test checks that array views and policy references return the
+ * values held by a Policy without allocating, and that the functions
+ * using them internally give the same results as before.
+ */
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "lsst/pex/policy.h"
+#include "lsst/pex/policy/paf/PAFWriter.h"
+#include "lsst/pex/exceptions.h"
+#include "countAllocations.h"
+
+using namespace std;
+using lsst::pex::policy::ConstPolicyRef;
+using lsst::pex::policy::NameNotFound;
+using lsst::pex::policy::Policy;
+using lsst::pex::policy::PolicyArrayView;
+using lsst::pex::policy::TypeError;
+using lsst::pex::policy::paf::PAFWriter;
+
+#define Assert(b, m) tattle(b, m, __LINE__)
+
+void tattle(bool mustBeTrue, const string& failureMsg, int line) {
+    if (! mustBeTrue) {
+        ostringstream msg;
+        msg << __FILE__ << ':' << line << ":\n" << failureMsg << ends;
+        throw runtime_error(msg.str());
+    }
+}
+
+int main() {
+    Policy p;
+    for (int i = 0; i < 1000; ++i) {
+        p.add("data.samples", i * 0.5);
+        p.add("data.indices", i);
+    }
+    p.add("data.labels", string("red"));
+    p.add("data.labels", string("a label too long to be stored inside the string"));
+    for (int i = 0; i < 3; ++i) {
+        Policy::Ptr stage(new Policy());
+        stage->set("order", i);
+        stage->set("kernel.sigma", 1.5 * i);
+        p.add("stages", stage);
+    }
+
+    // views hold the same values as the arrays, and are made without allocating
+    {
+        long before = allocations;
+        Policy::DoubleArrayView samples = p.getDoubleArrayView("data.samples");
+        Policy::IntArrayView indices = p.getIntArrayView("data.indices");
+        Policy::StringArrayView labels = p.getStringArrayView("data.labels");
+        double sum = 0;
+        for (Policy::DoubleArrayView::iterator it = samples.begin(); it != samples.end(); ++it) sum += *it;
+        long made = allocations - before;
+        Assert(made == 0, "a view allocated memory");
+
+        Assert(samples.size() == 1000 && sum == 0.5 * 999 * 1000 / 2, "wrong double values");
+        Policy::IntArray copy = p.getIntArray("data.indices");
+        Assert(vector<int>(indices.begin(), indices.end()) == copy, "wrong int values");
+        Assert(labels.size() == 2 && labels[0] == "red" && labels.back().size() == 47, "wrong strings");
+    }
+
+    // sub-policies may be visited without a Policy for each
+    {
+        long before = allocations;
+        PolicyArrayView stages = p.getPolicyArrayView("stages");
+        ConstPolicyRef top(p);
+        double sigmas = 0;
+        int orders = 0;
+        for (PolicyArrayView::iterator it = stages.begin(); it != stages.end(); ++it) {
+            ConstPolicyRef stage = *it;
+            orders += stage.getInt("order");
+            sigmas += stage.getPolicy("kernel").getDouble("sigma");
+        }
+        orders += top.getPolicy("stages").getInt("order");
+        long made = allocations - before;
+        Assert(made == 0, "a policy reference allocated memory");
+
+        Assert(stages.size() == 3 && orders == 5 && sigmas == 4.5, "wrong sub-policy values");
+        Assert(top.getIntArrayView("data.indices").size() == 1000, "wrong view through a reference");
+        Assert(top.isArray("stages") && top.getValueType("stages") == Policy::POLICY, "wrong type");
+    }
+
+    // views raise the same exceptions as arrays
+    {
+        try {
+            p.getIntArrayView("data.missing");
+            Assert(false, "view of a missing name");
+        } catch (NameNotFound&) {
+        }
+        try {
+            p.getIntArrayView("data.samples");
+            Assert(false, "view of the wrong type");
+        } catch (TypeError&) {
+        }
+        try {
+            ConstPolicyRef(p).getPolicy("data.labels");
+            Assert(false, "reference to a value that is not a Policy");
+        } catch (TypeError&) {
+        }
+    }
+
+    // the views used in writing, printing and merging give the same results
+    {
+        Policy small;
+        small.add("ints", 1);
+        small.add("ints", 2);
+        small.set("doubles", 0.25);
+        small.add("names", string("a"));
+        small.add("names", string("b"));
+        ostringstream out;
+        PAFWriter writer(&out);
+        writer.write(small);
+        Assert(out.str() == "ints: 1 2\ndoubles: 0.25\nnames: \"a\" \"b\"\n", out.str());
+        Assert(small.str("ints") == "1, 2" && small.str("names") == "\"a\", \"b\"", small.str("names"));
+
+        Policy merged;
+        merged.set("doubles", 1.0);
+        Assert(merged.mergeDefaults(small) == 2, "wrong number merged");
+        Assert(merged.getIntArray("ints").size() == 2 && merged.getDouble("doubles") == 1.0 &&
+                       merged.getStringArray("names")[1] == "b",
+               "wrong values merged");
+    }
+
+    return 0;
+}
@@ -0,0 +1,185 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+
+
+/**
+ * @file PolicyWatcher_1.cc
+ *
+ * This test checks that a PolicyWatcher loads a policy file and the files
+ * it refers to, that it loads them again when any of them is changed,
+ * parsing only those changed and only once for a burst of changes, that
+ * it keeps the policy it has when a change cannot be parsed, and that
+ * threads can read the policies it loads while files are rewritten.
+ */
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "lsst/pex/policy.h"
+#include "lsst/pex/exceptions.h"
+
+using namespace std;
+using lsst::pex::policy::Policy;
+using lsst::pex::policy::PolicyWatcher;
+
+#define Assert(b, m) tattle(b, m, __LINE__)
+
+void tattle(bool mustBeTrue, const string& failureMsg, int line) {
+    if (! mustBeTrue) {
+        ostringstream msg;
+        msg << __FILE__ << ':' << line << ":\n" << failureMsg << ends;
+        throw runtime_error(msg.str());
+    }
+}
+
+void write(const string& path, const string& contents) {
+    ofstream out(path.c_str());
+    out << "#<?cfg paf policy ?>\n" << contents;
+}
+
+int main() {
+    char tmpl[] = "/tmp/PolicyWatcher_1.XXXXXX";
+    Assert(mkdtemp(tmpl) != 0, "cannot make a directory");
+    const string dir(tmpl);
+    write(dir + "/root.paf", "count: 1\nstage: @stage.paf\noutput: @output.paf\n");
+    write(dir + "/stage.paf", "threshold: 1.5\nkernel: @kernel.paf\n");
+    write(dir + "/kernel.paf", "width: 3\n");
+    write(dir + "/output.paf", "verbosity: 2\n");
+
+    int failures = 0;
+    try {
+        PolicyWatcher watcher(dir + "/root.paf", "", 50);
+        Policy::ConstPtr current = watcher.get();
+        Assert(current->getInt("count") == 1 && current->getDouble("stage.threshold") == 1.5 &&
+                       current->getInt("stage.kernel.width") == 3 && current->getInt("output.verbosity") == 2,
+               "wrong values loaded");
+        Assert(watcher.getFiles().size() == 4 && watcher.getParseCount() == 4, "wrong files loaded");
+
+        atomic<int> delivered(0);
+        int errors = 0;
+        watcher.addCallback([&](const Policy::ConstPtr& p) {
+            ++delivered;
+            current = p;
+        });
+        watcher.setErrorHandler([&](const string&) { ++errors; });
+        Assert(! watcher.poll(100), "reloaded without a change");
+
+        // only the file changed is parsed again
+        write(dir + "/output.paf", "verbosity: 5\n");
+        Assert(watcher.poll(5000), "change not seen");
+        Assert(delivered == 1 && current == watcher.get(), "new policy not delivered");
+        Assert(current->getInt("output.verbosity") == 5 && current->getInt("stage.kernel.width") == 3,
+               "wrong values reloaded");
+        Assert(watcher.getParseCount() == 5, "unchanged files parsed again");
+
+        // a burst of changes is loaded once
+        for (int i = 4; i <= 8; ++i) {
+            write(dir + "/kernel.paf", "width: " + to_string(i) + "\n");
+            this_thread::sleep_for(chrono::milliseconds(5));
+        }
+        Assert(watcher.poll(5000), "burst not seen");
+        Assert(delivered == 2 && watcher.getParseCount() == 6, "burst loaded more than once");
+        Assert(current->getInt("stage.kernel.width") == 8, "burst loaded before its end");
+
+        // a file replaced, as editors do, is seen
+        write(dir + "/stage.paf.new", "threshold: 2.5\nkernel: @kernel.paf\n");
+        Assert(rename((dir + "/stage.paf.new").c_str(), (dir + "/stage.paf").c_str()) == 0, "rename failed");
+        Assert(watcher.poll(5000) && current->getDouble("stage.threshold") == 2.5, "replaced file not seen");
+
+        // a change that cannot be parsed keeps the current policy
+        write(dir + "/output.paf", "verbosity: 1 2:\n");
+        Assert(! watcher.poll(5000) && errors == 1, "error not reported");
+        Assert(watcher.get() == current && current->getInt("output.verbosity") == 5, "policy changed by an error");
+        write(dir + "/output.paf", "verbosity: 6\nextra: @extra.paf\n");
+        write(dir + "/extra.paf", "level: 1\n");
+        Assert(watcher.poll(5000) && current->getInt("output.verbosity") == 6, "fix not seen");
+        Assert(current->getInt("output.extra.level") == 1 && watcher.getFiles().size() == 5,
+               "new reference not loaded");
+
+        // the watching thread sees changes to a file newly referred to
+        int before = delivered;
+        watcher.start();
+        write(dir + "/extra.paf", "level: 2\n");
+        for (int i = 0; i < 500 && delivered == before; ++i) this_thread::sleep_for(chrono::milliseconds(10));
+        watcher.stop();
+        Assert(delivered == before + 1 && watcher.get()->getInt("output.extra.level") == 2,
+               "change not seen by the thread");
+
+        // threads read through get() while files are truncated and rewritten
+        atomic<bool> done(false);
+        atomic<int> bad(0);
+        atomic<long> reads(0);
+        vector<thread> readers;
+        for (int t = 0; t < 4; ++t) {
+            readers.push_back(thread([&]() {
+                while (! done.load()) {
+                    try {
+                        Policy::ConstPtr p = watcher.get();
+                        Policy::ConstPtr kernel = p->getPolicy("stage")->getPolicy("kernel");
+                        int width = kernel->getInt("width");
+                        Policy copy(*p);
+                        if (p->getInt("stage.kernel.width") != width ||
+                            p->getConstPolicyArray("stage.kernel")[0]->getInt("width") != width ||
+                            copy.getPolicy("stage.kernel")->getInt("width") != width ||
+                            p->getInt("output.extra.level") != 2)
+                            ++bad;
+                        ++reads;
+                    } catch (exception&) {
+                        ++bad;
+                    }
+                }
+            }));
+        }
+        before = delivered;
+        watcher.start();
+        for (int i = 10; i < 20; ++i) {
+            write(dir + "/kernel.paf", "width: " + to_string(i) + "\n");
+            this_thread::sleep_for(chrono::milliseconds(100));
+        }
+        for (int i = 0; i < 500 && watcher.get()->getInt("stage.kernel.width") != 19; ++i)
+            this_thread::sleep_for(chrono::milliseconds(10));
+        watcher.stop();
+        done.store(true);
+        for (vector<thread>::iterator it = readers.begin(); it != readers.end(); ++it) it->join();
+        Assert(bad == 0 && reads > 0, "inconsistent policy read during reloads");
+        Assert(delivered > before && watcher.get()->getInt("stage.kernel.width") == 19,
+               "changes not seen while read");
+    } catch (exception& e) {
+        cerr << e.what() << endl;
+        failures = 1;
+    }
+
+    const char* files[] = {"root.paf", "stage.paf", "kernel.paf", "output.paf", "extra.paf"};
+    for (int i = 0; i < 5; ++i) remove((dir + "/" + files[i]).c_str());
+    rmdir(dir.c_str());
+    return failures;
+}
@@ -0,0 +1,164 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+
+
+/**
+ * @file SharedPolicy_1.cc
+ *
+ * This test checks that a SharedPolicy serves each version published to
+ * it, whole, to readers in many threads while new versions are published,
+ * that versions replaced are freed once no longer read, that reading
+ * allocates nothing, and that an invalid policy is not published.
+ */
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "lsst/pex/policy.h"
+#include "lsst/pex/exceptions.h"
+#include "countAllocations.h"
+
+using namespace std;
+using lsst::pex::policy::Dictionary;
+using lsst::pex::policy::FrozenPolicy;
+using lsst::pex::policy::Policy;
+using lsst::pex::policy::SharedPolicy;
+using lsst::pex::policy::ValidationError;
+
+#define Assert(b, m) tattle(b, m, __LINE__)
+
+void tattle(bool mustBeTrue, const string& failureMsg, int line) {
+    if (! mustBeTrue) {
+        ostringstream msg;
+        msg << __FILE__ << ':' << line << ":\n" << failureMsg << ends;
+        throw runtime_error(msg.str());
+    }
+}
+
+// a version in which both values equal n
+Policy version(int n) {
+    Policy p;
+    p.set("service.first", n);
+    p.set("service.second", n);
+    p.set("service.label", "version " + to_string(n));
+    return p;
+}
+
+int main() {
+    // each version published is read whole, and one held is kept
+    {
+        SharedPolicy shared(version(1));
+        Assert(shared.getVersion() == 1, "wrong first version number");
+        {
+            SharedPolicy::Snapshot snap = shared.read();
+            Assert(snap->getInt("service.first") == 1 && snap.getVersion() == 1, "wrong first version");
+        }
+
+        FrozenPolicy::ConstPtr held = shared.get();
+        Assert(shared.publish(version(2)) == 2, "wrong number published");
+        SharedPolicy::Snapshot snap = shared.read();
+        Assert(snap->getInt("service.first") == 2 && snap->getString("service.label") == "version 2",
+               "new version not read");
+        Assert(held->getInt("service.first") == 1, "held version changed");
+    }
+
+    // a version replaced is freed once no snapshot of it remains
+    {
+        FrozenPolicy::ConstPtr first = version(1).freeze();
+        SharedPolicy shared(first);
+        {
+            SharedPolicy::Snapshot snap = shared.read();
+            shared.publish(version(2));
+            Assert(first.use_count() > 1, "version freed while read");
+            Assert(snap->getInt("service.first") == 1, "snapshot changed");
+        }
+        shared.publish(version(3));
+        Assert(first.use_count() == 1, "version replaced not freed");
+    }
+
+    // reading allocates nothing
+    {
+        SharedPolicy shared(version(3));
+        const string first("service.first");
+        long sum = 0;
+        long before = allocations;
+        for (int i = 0; i < 100; ++i) {
+            SharedPolicy::Snapshot snap = shared.read();
+            sum += snap->getInt(first);
+        }
+        long made = allocations - before;
+        Assert(made == 0, "reading allocated memory");
+        Assert(sum == 300, "wrong sum");
+    }
+
+    // a policy that its dictionary rejects is not published
+    {
+        Policy definitions;
+        definitions.set("definitions.count.type", "int");
+        definitions.set("definitions.count.minOccurs", 1);
+        Dictionary dict(definitions);
+        Policy invalid(true, dict);
+
+        SharedPolicy shared(version(1));
+        try {
+            shared.publish(invalid);
+            Assert(false, "invalid policy published");
+        } catch (ValidationError&) {
+        }
+        Assert(shared.getVersion() == 1 && shared.read()->getInt("service.first") == 1,
+               "version changed by an invalid policy");
+
+        invalid.set("count", 2);
+        Assert(shared.publish(invalid) == 2 && shared.read()->getInt("count") == 2, "valid policy not published");
+    }
+
+    // readers in many threads see whole versions, in order, while they are published
+    {
+        SharedPolicy shared(version(0));
+        const int nthreads = 8, nversions = 200;
+        vector<string> failures(nthreads);
+        vector<thread> threads;
+        for (int t = 0; t < nthreads; ++t) {
+            threads.push_back(thread([&shared, &failures, t]() {
+                const string first("service.first"), second("service.second");
+                long last = 0;
+                while (last < nversions) {
+                    SharedPolicy::Snapshot snap = shared.read();
+                    int a = snap->getInt(first);
+                    if (a != snap->getInt(second) || long(snap.getVersion()) != a + 1)
+                        failures[t] = "mixed versions read";
+                    if (a < last) failures[t] = "versions read out of order";
+                    last = a;
+                }
+            }));
+        }
+        for (int n = 1; n <= nversions; ++n) shared.publish(version(n));
+        for (int t = 0; t < nthreads; ++t) threads[t].join();
+        for (int t = 0; t < nthreads; ++t) Assert(failures[t].empty(), failures[t]);
+        Assert(shared.getVersion() == nversions + 1, "wrong last version number");
+    }
+
+    return 0;
+}
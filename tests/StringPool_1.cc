@@ -0,0 +1,119 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file StringPool_1.cc
+ *
+ * This test checks that a StringPool holds each distinct string once,
+ * including when strings are interned from several threads, and that
+ * Dictionary keywords are still recognized through the global pool.
+ */
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "lsst/pex/policy/detail/StringPool.h"
+#include "lsst/pex/policy.h"
+#include "lsst/pex/policy/PolicyString.h"
+#include "lsst/pex/exceptions.h"
+
+using namespace std;
+using lsst::pex::policy::Dictionary;
+using lsst::pex::policy::DictionaryError;
+using lsst::pex::policy::Policy;
+using lsst::pex::policy::PolicyString;
+using lsst::pex::policy::detail::StringPool;
+
+#define Assert(b, m) tattle(b, m, __LINE__)
+
+void tattle(bool mustBeTrue, const string& failureMsg, int line) {
+    if (! mustBeTrue) {
+        ostringstream msg;
+        msg << __FILE__ << ':' << line << ":\n" << failureMsg << ends;
+        throw runtime_error(msg.str());
+    }
+}
+
+int main() {
+    {
+        StringPool pool;
+        const string& a = pool.intern("minOccurs");
+        string copy("minOccurs");
+        Assert(&pool.intern(copy) == &a, "equal strings not shared");
+        Assert(&pool.intern("maxOccurs") != &a, "different strings shared");
+        Assert(pool.intern(string("a\0b", 3)).size() == 3, "embedded null lost");
+        Assert(&pool.intern("") == &pool.intern(string()), "empty string not shared");
+        Assert(pool.find("minOccurs") == &a, "interned string not found");
+        Assert(pool.find("default") == 0, "string found that was never interned");
+        Assert(pool.size() == 4 && pool.chars() == 21, "wrong size");
+
+        // references stay valid as the pool grows
+        for (int i = 0; i < 10000; ++i) pool.intern("name" + to_string(i));
+        Assert(a == "minOccurs" && &pool.intern("minOccurs") == &a, "interned string moved");
+    }
+
+    // several threads interning the same strings get the same copies
+    {
+        StringPool pool;
+        const int nthreads = 4, nnames = 2000;
+        vector<vector<const string*> > got(nthreads);
+        vector<thread> threads;
+        for (int t = 0; t < nthreads; ++t) {
+            threads.push_back(thread([&, t]() {
+                for (int i = 0; i < nnames; ++i) {
+                    int n = (i * (t + 1)) % nnames;
+                    got[t].push_back(&pool.intern("key" + to_string(n)));
+                    Assert(*got[t].back() == "key" + to_string(n), "wrong string interned");
+                }
+            }));
+        }
+        for (thread& th : threads) th.join();
+        Assert(pool.size() == size_t(nnames), "strings interned more than once");
+        for (int t = 1; t < nthreads; ++t)
+            for (int i = 0; i < nnames; ++i)
+                Assert(got[t][i] == pool.find("key" + to_string((i * (t + 1)) % nnames)),
+                       "threads given different copies");
+    }
+
+    // Dictionary keywords
+    {
+        Policy p;
+        PolicyString("definitions: {\n  good: {\n    type: int\n    minOccurs: 1\n    maxOccurs: 2\n"
+                     "    description: \"ok\"\n  }\n}\n").load(p);
+        Dictionary d(p);
+        Assert(d.getDefinitions()->exists("good.type"), "definition lost");
+
+        Policy bad;
+        PolicyString("definitions: {\n  bad: {\n    min_occurs: 1\n  }\n}\n").load(bad);
+        bool thrown = false;
+        try {
+            Dictionary bd(bad);
+        } catch (DictionaryError& ex) {
+            thrown = string(ex.what()).find("min_occurs") != string::npos;
+        }
+        Assert(thrown, "unknown keyword not reported");
+    }
+
+    return 0;
+}
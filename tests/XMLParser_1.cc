@@ -0,0 +1,189 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+/**
+ * @file XMLParser_1.cc
+ *
+ * This test checks that XML policy data is recognized and loaded like
+ * the equivalent PAF data, and that its errors are reported.
+ */
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include "lsst/pex/policy/xml/XMLParser.h"
+#include "lsst/pex/policy/xml/XMLParserFactory.h"
+#include "lsst/pex/policy/paf/PAFParser.h"
+#include "lsst/pex/policy/paf/PAFWriter.h"
+#include "lsst/pex/policy.h"
+#include "lsst/pex/policy/PolicyFile.h"
+#include "lsst/pex/policy/PolicyString.h"
+#include "lsst/pex/policy/SupportedFormats.h"
+#include "lsst/pex/exceptions.h"
+#include "lsst/utils/Utils.h"
+
+using namespace std;
+using lsst::pex::policy::Dictionary;
+using lsst::pex::policy::Policy;
+using lsst::pex::policy::PolicyFile;
+using lsst::pex::policy::PolicyString;
+using lsst::pex::policy::SupportedFormats;
+using lsst::pex::policy::ParserDiagnostics;
+using lsst::pex::policy::xml::XMLParser;
+using lsst::pex::policy::xml::XMLParserFactory;
+using lsst::pex::policy::paf::PAFParser;
+using lsst::pex::policy::paf::PAFWriter;
+
+#define Assert(b, m) tattle(b, m, __LINE__)
+
+void tattle(bool mustBeTrue, const string& failureMsg, int line) {
+    if (! mustBeTrue) {
+        ostringstream msg;
+        msg << __FILE__ << ':' << line << ":\n" << failureMsg << ends;
+        throw runtime_error(msg.str());
+    }
+}
+
+string dump(Policy& p) {
+    PAFWriter writer;
+    writer.write(p);
+    return writer.toString();
+}
+
+string loadXml(const string& data, bool strict = true) {
+    Policy p;
+    XMLParser parser(p, strict);
+    parser.parse(data.data(), data.size());
+    return dump(p);
+}
+
+string loadPaf(const string& data) {
+    Policy p;
+    PAFParser parser(p);
+    parser.parse(data.data(), data.size());
+    return dump(p);
+}
+
+// return the message of the error raised by loading data
+string error(const string& data) {
+    try {
+        loadXml(data);
+    } catch (lsst::pex::exceptions::Exception& ex) {
+        return ex.what();
+    }
+    return "";
+}
+
+bool contains(const string& s, const string& sub) { return s.find(sub) != string::npos; }
+
+int main() {
+    string rootDir = lsst::utils::getPackageDir("pex_policy") + "/examples/";
+
+    // the examples
+    {
+        Policy p;
+        PolicyFile file(rootDir + "EventTransmitter_policy.xml");
+        Assert(file.getFormatName() == XMLParserFactory::FORMAT_NAME, "wrong format for .xml file");
+        file.load(p);
+        Assert(p.getBool("standalone"), "wrong standalone");
+        Assert(p.getDouble("threshold") == 4.5, "wrong threshold");
+        Assert(p.getIntArray("offsets").size() == 8, "repeated offsets not appended");
+        Assert(p.getIntArray("offsets")[7] == 313, "wrong offsets");
+        Assert(p.getString("receiver.logVerbosity") == "debug", "wrong receiver.logVerbosity");
+        Assert(p.getString("transmitter.serializationFormat") == "deluxe",
+               "wrong transmitter.serializationFormat");
+        Assert(! p.exists("target"), "attributes of <Policy> loaded");
+    }
+    {
+        Dictionary d(PolicyFile(rootDir + "EventTransmitter_dict.xml"));
+        Assert(d.getString("target") == "EventTransmitter", "wrong target");
+        Assert(d.getDefinitions()->getString("standalone.type") == "int", "wrong type");
+        Assert(d.getDefinitions()->getInt("standalone.minOccurs") == 1, "wrong minOccurs");
+        Assert(d.getDefinitions()->getInt("standalone.default") == 0, "wrong default");
+        Policy::ConstPolicyPtrArray allowed = d.getDefinitions()->getConstPolicyArray("standalone.allowed");
+        Assert(allowed.size() == 2 && allowed[1]->getInt("value") == 1, "wrong allowed values");
+        Assert(contains(allowed[0]->getString("description"), "event services"), "wrong description");
+    }
+
+    // the mapping onto PAF
+    Assert(loadXml("<Policy><a>1 2</a><b>1 2.5</b><c>x y</c><d>true False</d><e t='s'>3</e>"
+                   "<f t='d'>1</f><g/><h></h><i t='p'/></Policy>") ==
+           loadPaf("a: 1 2\nb: 1.0 2.5\nc: \"x y\"\nd: true false\ne: \"3\"\nf: 1.0\ni: { }\n"),
+           "wrong value mapping");
+    Assert(loadXml("<Policy>\n <a> <b> <c>-3e2</c> </b> </a>\n <a><d>&lt;&amp;&#x41;&#66;&quot;</d></a>\n"
+                   " <!-- a comment --> <e><![CDATA[<x>]]></e>\n</Policy>\n") ==
+           loadPaf("a: { b: { c: -300.0 } }\na: { d: '<&AB\"' }\ne: \"<x>\"\n"),
+           "wrong sub-policy or text mapping");
+    Assert(loadXml("") == "" && loadXml("<?xml version='1.0'?>\n<!-- nothing -->\n") == "",
+           "empty data not accepted");
+
+    // recognition
+    {
+        SupportedFormats formats;
+        SupportedFormats::initDefaultFormats(formats);
+        Assert(formats.supports("XML"), "XML not registered");
+        Assert(formats.recognizeType("<?xml version=\"1.0\"?>") == "XML", "XML declaration not recognized");
+        Assert(formats.recognizeType("<?cfg XML policy ?>") == "XML", "content id not recognized");
+        Assert(formats.recognizeType("a: 1") == "PAF", "PAF recognized as XML");
+
+        Policy p;
+        PolicyString str("<Policy><x>7</x></Policy>");
+        Assert(str.getFormatName() == "XML", "XML string not recognized");
+        str.load(p);
+        Assert(p.getInt("x") == 7, "XML string not loaded");
+    }
+
+    // errors
+    Assert(contains(error("<Policy>\n<a>1</b>\n</Policy>"),
+                    "Policy Parsing Error:2: Syntax error: end tag does not match"),
+           "mismatched tags: " + error("<Policy>\n<a>1</b>\n</Policy>"));
+    Assert(contains(error("<Policy><a>1</a>"), "Unexpected end"), "unclosed root");
+    Assert(contains(error("<Policy><a-b>1</a-b></Policy>"), "Bad parameter name format: a-b"), "bad name");
+    Assert(contains(error("<Policy><a t='i'>1 x</a></Policy>"), "Expecting integer value, found: x"),
+           "bad integer");
+    Assert(contains(error("<Policy><a>3000000000</a></Policy>"), "unsupported long integer value found"),
+           "long integer");
+    Assert(contains(error("<Policy/><Policy/>"), "after the root element"), "two roots");
+    Assert(loadXml("<Policy><a-b>1</a-b><a t='i'>1 x 2</a><b t='q'>3</b><c>2</c></Policy>", false) ==
+           loadPaf("a: 1 2\nc: 2\n"), "non-strict mode does not skip bad values");
+    {
+        Policy p;
+        ParserDiagnostics diag;
+        XMLParser parser(p);
+        parser.setDiagnostics(&diag);
+        string data("<Policy>\n  <a-b>1</a-b>\n  <a t='i'>1 x</a>\n  <a t='b'>true</a>\n"
+                    "  <c>1</c>\n  <d>2</e>\n</Policy>\n");
+        parser.parse(data.data(), data.size());
+        const vector<ParserDiagnostics::Problem>& problems = diag.getProblems();
+        Assert(problems.size() == 4, "wrong number of problems");
+        Assert(problems[0].kind == ParserDiagnostics::BAD_NAME && problems[0].line == 2,
+               "wrong bad name problem");
+        Assert(problems[1].kind == ParserDiagnostics::EXPECTED_INT && problems[1].line == 3 &&
+               problems[1].excerpt == "x", "wrong bad integer problem");
+        Assert(problems[2].kind == ParserDiagnostics::REJECTED_VALUE && problems[2].line == 4,
+               "wrong rejected value problem");
+        Assert(problems[3].kind == ParserDiagnostics::SYNTAX_ERROR && problems[3].line == 6 &&
+               problems[3].column == 7, "wrong syntax error");
+        Assert(p.getInt("a") == 1 && p.getInt("c") == 1, "values lost with diagnostics");
+    }
+
+    return 0;
+}
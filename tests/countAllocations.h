@@ -0,0 +1,69 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+
+/**
+ * @file countAllocations.h
+ *
+ * Replacements for the global operator new and delete that count the
+ * allocations a test program makes, for tests that check how often an
+ * operation goes to the heap.  Include it in one file of a test program
+ * only.  Every form of new and delete is replaced, so that storage is
+ * always released by the function that matches the one that allocated it.
+ */
+#ifndef LSST_PEX_POLICY_TESTS_COUNTALLOCATIONS_H
+#define LSST_PEX_POLICY_TESTS_COUNTALLOCATIONS_H
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// the number of allocations made so far, by any thread
+static std::atomic<long> allocations(0);
+
+// GCC inlines these at new and delete expressions and then takes the
+// malloc() and free() in them for a mismatch with the operator new or
+// delete of the expression, so they are kept out of line.
+#if defined(__GNUC__)
+#define COUNT_ALLOCATIONS_NOINLINE __attribute__((noinline))
+#else
+#define COUNT_ALLOCATIONS_NOINLINE
+#endif
+
+COUNT_ALLOCATIONS_NOINLINE void* operator new(std::size_t size) {
+    ++allocations;
+    void* p = std::malloc(size ? size : 1);
+    if (! p) throw std::bad_alloc();
+    return p;
+}
+
+COUNT_ALLOCATIONS_NOINLINE void* operator new[](std::size_t size) { return operator new(size); }
+
+COUNT_ALLOCATIONS_NOINLINE void operator delete(void* p) noexcept { std::free(p); }
+
+COUNT_ALLOCATIONS_NOINLINE void operator delete[](void* p) noexcept { std::free(p); }
+
+COUNT_ALLOCATIONS_NOINLINE void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+COUNT_ALLOCATIONS_NOINLINE void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+#endif // LSST_PEX_POLICY_TESTS_COUNTALLOCATIONS_H